@@ -9,18 +9,23 @@
 #include <iostream>
 #include <fstream>
 
+#include <boost/date_time/posix_time/posix_time_types.hpp>
 #include <boost/filesystem.hpp>
 #include <boost/program_options.hpp>
+#include <boost/thread/thread.hpp>
 
 #include "logging.h"
 #include "utility.h"
 
 #include "mathtext.h"
+#include "BrailleTranslationCache.h"
 #include "MathExceptions.h"
 #include "MathSourceFile.h"
 #include "MathDocument.h"
 #include "MathInterpreter.h"
 #include "LaTeXRenderer.h"
+#include "LibLouisContext.h"
+#include "MathRenderPipeline.h"
 #include "UEBRenderer.h"
 
 using namespace std;
@@ -42,7 +47,19 @@ int main (const int argc, const char **argv)
   string latexOutputFilename;
   bool generateBraille = false;
   int brailleLineLength = 0;
+  unsigned numThreads = 0;
+  unsigned long maxNesting = 1000;
+  unsigned maxMessages = 0;
+  size_t maxInputLine = 0;
+  size_t maxElements = 0;
+  size_t maxOutput = 0;
+  unsigned timeLimit = 0;
+  bool keepGoing = false;
+  bool foldMessages = false;
+  bool batchTranslation = false;
+  bool haveErrors = false;
   string brfOutputFilename;
+  string louisDataPath;
 
   LOG_INFO << endl;
   LOG_INFO << "=====================================================";
@@ -58,10 +75,51 @@ int main (const int argc, const char **argv)
        po::value(&brfOutputFilename)->implicit_value (string()),
        "Generate a braille file (default: input name + .BRF)")
 
+      ("louis-path",
+       po::value(&louisDataPath)->default_value("."),
+       "Where liblouis looks for its braille tables")
+
+      ("batch-text",
+       "Translate the text of the document to braille in batches")
+
       ("line-length", 
        po::value<int>(&brailleLineLength)->default_value(0), 
        "Maximum length of a braille line (default: no limit)")
 
+      ("threads,j",
+       po::value<unsigned>(&numThreads)->default_value(0),
+       "Number of threads used to interpret the document (0: one per processor)")
+
+      ("max-nesting",
+       po::value<unsigned long>(&maxNesting)->default_value(1000),
+       "Deepest nesting of groups, fractions, etc. allowed")
+
+      ("max-input-line",
+       po::value<size_t>(&maxInputLine)->default_value(0),
+       "Longest input line allowed, including continuation lines (0: no limit)")
+
+      ("max-elements",
+       po::value<size_t>(&maxElements)->default_value(0),
+       "Most elements an input line may be interpreted into (0: no limit)")
+
+      ("max-output",
+       po::value<size_t>(&maxOutput)->default_value(0),
+       "Largest output file allowed, in bytes (0: no limit)")
+
+      ("time-limit",
+       po::value<unsigned>(&timeLimit)->default_value(0),
+       "Seconds allowed for the translation (0: no limit)")
+
+      ("max-messages",
+       po::value<unsigned>(&maxMessages)->default_value(0),
+       "Most messages of each kind to list (0: no limit)")
+
+      ("fold-messages",
+       "List identical messages for different lines once, with a count")
+
+      ("keep-going,k",
+       "Report every error in the document instead of stopping at the first")
+
       ("latex,l",
        po::value(&latexOutputFilename)->implicit_value (string()),
        "Generate a LaTeX/print file (default: input name + .TEX)")
@@ -96,6 +154,10 @@ int main (const int argc, const char **argv)
       generateLaTeX = (vm.count("latex"));
       if (generateLaTeX && latexOutputFilename.empty())
 	latexOutputFilename = remove_file_extension (inputFilename) + ".tex";
+
+      keepGoing = (vm.count("keep-going"));
+      foldMessages = (vm.count("fold-messages"));
+      batchTranslation = (vm.count("batch-text"));
     }
     catch(std::exception &e) {
       cerr << "Command line error: " << e.what() << endl << endl;
@@ -104,19 +166,125 @@ int main (const int argc, const char **argv)
       return 2;
     }
 
+    // Load the braille tables now, rather than while rendering
+    LibLouisContext::get().setDataPath (louisDataPath);
+    if (generateBraille)
+      LibLouisContext::get().warmUp();
+
+    boost::posix_time::ptime deadline;
+    if (timeLimit > 0)
+      deadline = boost::posix_time::microsec_clock::universal_time() + boost::posix_time::seconds(timeLimit);
+
     MathSourceFile srcfile;
     MathDocument doc;
     MathInterpreter interp(srcfile, doc);
+    if (maxInputLine > 0)
+      srcfile.setMaxLineLength (maxInputLine);
     srcfile.loadFromFile(inputFilename);
 
     std::vector<std::string> renderCommands;
     LaTeXRenderer::getInterpreterCommandList (renderCommands);
     UEBRenderer::getInterpreterCommandList (renderCommands);
     interp.registerCommands (renderCommands);
+    interp.setThreadCount (numThreads);
+    interp.setErrorRecovery (keepGoing);
+    interp.setMaxNestingDepth (maxNesting);
+    if (maxElements > 0)
+      interp.setMaxElements (maxElements);
+    interp.setDeadline (deadline);
+    if (maxMessages > 0)
+      interp.setMessageLimit (maxMessages);
+    interp.setMessageFolding (foldMessages);
+
+    // The output files are rendered while the document is being
+    // interpreted, so open them up front
+    ofstream latexOutput;
+    if (generateLaTeX) {
+      latexOutput.open(latexOutputFilename.c_str());
+      if (!latexOutput.is_open()) {
+	cerr << "error: unable to open '" << latexOutputFilename << "' for writing!" << endl;
+	return 2;
+      }
+    }
 
-    try {
-      interp.interpret();
-    } catch (MathInterpreterException &e) {
+    ofstream brailleOutput;
+    if (generateBraille) {
+      brailleOutput.open(brfOutputFilename.c_str());
+      if (!brailleOutput.is_open()) {
+	cerr << "error: unable to open '" << brfOutputFilename << "' for writing!" << endl;
+	return 2;
+      }
+    }
+
+    bool interpreted = true;
+    {
+      LaTeXRenderer ltr;
+      UEBRenderer ueb;
+      MathRenderPipeline pipeline;
+      MathRendererSink sink;
+
+      // Every line is rendered to each output as it is interpreted: on
+      // threads of their own if there are cores to spare, otherwise
+      // one after the other on this thread
+      const bool useThreads = (numThreads != 1 && boost::thread::hardware_concurrency() > 1);
+
+      ltr.setMaxNestingDepth (maxNesting);
+      ueb.setMaxNestingDepth (maxNesting);
+      ltr.setDeadline (deadline);
+      ueb.setDeadline (deadline);
+      if (maxOutput > 0) {
+	ltr.setMaxOutputBytes (maxOutput);
+	ueb.setMaxOutputBytes (maxOutput);
+      }
+
+      if (generateLaTeX) {
+	if (useThreads)
+	  pipeline.addRenderer (ltr, latexOutput);
+	else
+	  sink.addRenderer (ltr, latexOutput);
+      }
+
+      if (generateBraille) {
+	if (brailleLineLength > 0)
+	  ueb.enableLineWrapping (brailleLineLength);
+	// Worksheets repeat the same bits of prose over and over
+	ueb.setTranslationCache (boost::shared_ptr<BrailleTranslationCache>(new BrailleTranslationCache()));
+	ueb.setBatchTranslation (batchTranslation);
+	if (useThreads)
+	  pipeline.addRenderer (ueb, brailleOutput);
+	else
+	  sink.addRenderer (ueb, brailleOutput);
+      }
+
+      try {
+	try {
+	  if (useThreads)
+	    interp.interpret(pipeline);
+	  else
+	    interp.interpret(sink);
+	} catch (MathInterpreterException &e) {
+	  interpreted = false;
+	}
+
+	if (interpreted && useThreads)
+	  pipeline.finish();
+	else if (interpreted)
+	  sink.finish();
+      } catch (MathRenderException &e) {
+	// Do not leave partly rendered output behind
+	if (generateLaTeX) {
+	  latexOutput.close();
+	  remove(latexOutputFilename.c_str());
+	}
+	if (generateBraille) {
+	  brailleOutput.close();
+	  remove(brfOutputFilename.c_str());
+	}
+	throw;
+      }
+    }
+
+    if (!interpreted) {
       cout << "An error occurred and translation of your document was stopped." << endl;
       if (!interp.haveMessages()) {
 	cout << "The cause of the problem could not be determined." << endl;
@@ -129,6 +297,18 @@ int main (const int argc, const char **argv)
 	     ++it) {
 	  cout << "- " << *it << endl;
 	}
+	if (interp.getSuppressedMessageCount() > 0)
+	  cout << interp.getSuppressedMessageCount() << " more message(s) not listed" << endl;
+      }
+
+      // Do not leave partly rendered output behind
+      if (generateLaTeX) {
+	latexOutput.close();
+	remove(latexOutputFilename.c_str());
+      }
+      if (generateBraille) {
+	brailleOutput.close();
+	remove(brfOutputFilename.c_str());
       }
 
       return 1;
@@ -142,66 +322,27 @@ int main (const int argc, const char **argv)
 	   it != msgs.end();
 	   ++it) {
 	cout << "- " << *it << endl;
+	if (it->getCategory() == MathInterpreterMsg::MI_ERROR)
+	  haveErrors = true;
       }
+      if (interp.getSuppressedMessageCount() > 0)
+	cout << interp.getSuppressedMessageCount() << " more message(s) not listed" << endl;
     }
 
     if (generateLaTeX) {
-      LOG_INFO << endl << "====================== LaTeX Render ===================" << endl;
-
-      LaTeXRenderer ltr;
-      std::string output;
-      output = ltr.renderDocument(doc);
-
-      LOG_INFO << endl << "^^^^^^^^^^^^^^^^^^^^^^^^^^ LATEX ^^^^^^^^^^^^^^^^^^^^^^" << endl;
-      LOG_INFO << output;
-      LOG_INFO << endl << "vvvvvvvvvvvvvvvvvvvvvvvvvv LATEX vvvvvvvvvvvvvvvvvvvvvv" << endl;
-
-      ofstream ofs;
-      ofs.open(latexOutputFilename.c_str());
-      if (!ofs.is_open()) {
-	cerr << "error: unable to open '" << latexOutputFilename << "' for writing!" << endl;
-	return 2;
-      }
-
-      ofs << output;
-      if (!ofs.good()) {
+      latexOutput.close();
+      if (latexOutput.fail()) {
 	cerr << "error occurred while writing to '" << latexOutputFilename << "'!" << endl;
-	ofs.close();
 	return 2;
       }
-
-      ofs.close();
     }
 
     if (generateBraille) {
-      LOG_INFO << endl << "====================== UEB Render ===================" << endl;
-
-      std::string output;
-      UEBRenderer ueb;
-      if (brailleLineLength > 0)
-	ueb.enableLineWrapping (brailleLineLength);
-      output = ueb.renderDocument(doc);
-
-      LOG_INFO << endl << "^^^^^^^^^^^^^^^^^^^^^^^^^^  UEB  ^^^^^^^^^^^^^^^^^^^^^^" << endl;
-
-      LOG_INFO << output;
-      LOG_INFO << endl << "vvvvvvvvvvvvvvvvvvvvvvvvvv  UEB  vvvvvvvvvvvvvvvvvvvvvv" << endl;
-
-      ofstream ofs;
-      ofs.open(brfOutputFilename.c_str());
-      if (!ofs.is_open()) {
-	cerr << "error: unable to open '" << brfOutputFilename << "' for writing!" << endl;
-	return 2;
-      }
-
-      ofs << output;
-      if (!ofs.good()) {
+      brailleOutput.close();
+      if (brailleOutput.fail()) {
 	cerr << "error occurred while writing to '" << brfOutputFilename << "'!" << endl;
-	ofs.close();
 	return 2;
       }
-
-      ofs.close();
     }
   }
   catch (MathDocumentException &e) {
@@ -234,6 +375,10 @@ int main (const int argc, const char **argv)
     return 2;
   }
 
+  // With --keep-going, errors do not stop the translation but are still a
+  // failure as far as the caller is concerned
+  if (haveErrors)
+    return 1;
 
   return 0;
 }
@@ -0,0 +1,97 @@
+/**
+ * @file BrailleTranslationCache.h
+ * Header file for the cache of text translated to braille, shared between
+ * renderers
+ *
+ * @copyright Copyright 2015 Anthony Tibbs
+ * This project is released under the GNU General Public License.
+*/
+
+#ifndef __BRAILLE_TRANSLATION_CACHE_H__
+#define __BRAILLE_TRANSLATION_CACHE_H__
+
+#include <list>
+#include <string>
+#include <vector>
+#include <boost/cstdint.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/unordered_map.hpp>
+
+#include "UEBRenderer.h"
+
+/**
+ * Remembers the braille that liblouis produced for pieces of text, so that
+ * text seen before (prose repeated throughout a worksheet, for example)
+ * need not be translated again.
+ *
+ * Entries hold the finished braille, after any corrections made to what
+ * liblouis returned, along with the wrapping hints for it.  They are keyed
+ * on the translation table, the text, and whether wrapping hints were
+ * wanted.  The least recently used entries are dropped once the
+ * (approximate) memory used goes over the limit.
+ *
+ * A cache may be shared by any number of renderers, on any number of
+ * threads.
+ */
+class BrailleTranslationCache
+{
+ public:
+  /**
+   * Usage figures, as returned by getStatistics()
+   */
+  struct Statistics {
+    Statistics ();
+    double getHitRate (void) const;
+
+    unsigned long hits;
+    unsigned long misses;
+    unsigned long evictions;
+    size_t entries;
+    size_t bytesUsed;
+    boost::uint64_t microsecondsSaved; // translation time of the hits
+  };
+
+  BrailleTranslationCache (const size_t maxBytes = 4 * 1024 * 1024);
+
+  bool lookup (const std::string &table, const std::string &text,
+	       const bool withHints, std::string &braille,
+	       std::vector<UEBRenderer::WrapHint> &hints);
+  void store (const std::string &table, const std::string &text,
+	      const bool withHints, const std::string &braille,
+	      const std::vector<UEBRenderer::WrapHint> &hints,
+	      const unsigned long microseconds);
+  void clear (void);
+  Statistics getStatistics (void) const;
+
+ protected:
+  struct Key {
+    std::string table;
+    std::string text;
+    bool withHints;
+
+    bool operator== (const Key &other) const;
+  };
+
+  struct KeyHash {
+    size_t operator() (const Key &key) const;
+  };
+
+  struct Entry {
+    Key key;
+    std::string braille;
+    std::vector<UEBRenderer::WrapHint> hints; // offsets into braille
+    size_t bytes;
+    unsigned long microseconds;
+  };
+
+  typedef std::list<Entry> EntryList;
+  typedef boost::unordered_map<Key, EntryList::iterator, KeyHash> EntryIndex;
+
+  mutable boost::mutex m_mutex;
+  size_t m_maxBytes;
+  EntryList m_entries; // most recently used first
+  EntryIndex m_index;
+  Statistics m_stats;
+};
+
+#endif /* __BRAILLE_TRANSLATION_CACHE_H__ */
@@ -0,0 +1,59 @@
+/**
+ * @file CharClass.h
+ * Header file for scanning strings for characters from a small set.
+ *
+ * @copyright Copyright 2015 Anthony Tibbs
+ * This project is released under the GNU General Public License.
+*/
+
+#ifndef __CHAR_CLASS_H__
+#define __CHAR_CLASS_H__
+
+#include <string>
+#include <boost/cstdint.hpp>
+
+// Classes of up to this many characters are scanned 16 bytes at a time
+// where SSE2 is available; larger ones fall back to the bitmap
+#define CHAR_CLASS_SIMD_MEMBERS 8
+
+/**
+ * A set of (byte-sized) characters, held as a 256-bit bitmap so that
+ * membership is a single lookup, with functions to scan a string for the
+ * first character in (or not in) the set.
+ *
+ * Replaces repeated std::string::find() calls against a list of
+ * candidates, e.g.
+ * @code
+ * static const CharClass SPECIAL("#\\_^{}");
+ * size_t pos = SPECIAL.find (text);
+ * @endcode
+ */
+class CharClass
+{
+ protected:
+  boost::uint32_t m_bits [8];
+  char m_members [CHAR_CLASS_SIMD_MEMBERS];
+  unsigned m_numMembers;
+
+ public:
+  CharClass ();
+  explicit CharClass (const char *members);
+  explicit CharClass (const std::string &members);
+
+  CharClass &add (const char c);
+  CharClass &add (const std::string &members);
+
+  /** Returns true if 'c' is in the set */
+  bool contains (const char c) const {
+    const unsigned char u = (unsigned char) c;
+    return (m_bits [u >> 5] >> (u & 31)) & 1;
+  }
+
+  size_t find (const std::string &subject, const size_t pos = 0) const;
+  size_t findNot (const std::string &subject, const size_t pos = 0) const;
+  bool matchesAll (const std::string &subject) const;
+  CharClass presentIn (const std::string &subject) const;
+  bool empty (void) const;
+};
+
+#endif /* __CHAR_CLASS_H__ */
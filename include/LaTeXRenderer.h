@@ -95,16 +95,27 @@ class LaTeXRenderer : public MathRenderer
   bool doingInternalRender (void) const;
   void endInternalRender (void);
 
-  std::string renderMathContent (const std::string &s);
-  std::string renderTextContent (const std::string &s);
+  void renderArgument (const MDEVector &v, const std::string &open,
+		       const std::string &close, std::string &output);
+  void finishArgument (const size_t start, const size_t argumentStart,
+		       const std::string &close, std::string &output);
+  void renderContents (const MDEVector &v, const std::string &open,
+		       std::string &output);
+  void endNested (const std::string &close, std::string &output);
+
+  void beginMathContent (std::string &output);
+  void renderMathContent (const std::string &s, std::string &output);
+  void renderTextContent (const std::string &s, std::string &output);
 
  public:
   LaTeXRenderer();
 
-  std::string renderDocument (const MathDocument &document);
+  std::string beginDocument (void);
+  std::string endDocument (void);
 
   static void getInterpreterCommandList (std::vector<std::string> &cmdlist);
   static std::string makeLaTeXSafe (const std::string &input);
+  static void makeLaTeXSafe (const std::string &input, std::string &output);
 
   DECL_RENDER_FUNC(SourceLine);
   DECL_RENDER_FUNC(Command);
@@ -115,6 +126,7 @@ class LaTeXRenderer : public MathRenderer
 
   DECL_RENDER_FUNC(TextBlock);
   DECL_RENDER_FUNC(MathBlock);
+  DECL_RENDER_FUNC(Error);
   DECL_RENDER_FUNC(Number);
   DECL_RENDER_FUNC(Group);
 
@@ -0,0 +1,60 @@
+/**
+ * @file LibLouisContext.h
+ * Header file for the process-wide use of the liblouis library
+ *
+ * @copyright Copyright 2015 Anthony Tibbs
+ * This project is released under the GNU General Public License.
+*/
+
+#ifndef __LIBLOUIS_CONTEXT_H__
+#define __LIBLOUIS_CONTEXT_H__
+
+#include <set>
+#include <string>
+#include <boost/noncopyable.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include "liblouis-mt.h"
+
+/**
+ * Looks after the liblouis library for the whole process.
+ *
+ * liblouis compiles each translation table the first time it is used, and
+ * keeps it until lou_free() is called.  Tables are shared by everything in
+ * the process, so they are only freed when the process ends (or when the
+ * data path they were loaded from changes), rather than whenever a
+ * renderer goes away.  Renderers are then cheap to create and destroy.
+ *
+ * liblouis is not safe to use from several threads at once, so all
+ * translations go through here, one at a time.
+ */
+class LibLouisContext : private boost::noncopyable
+{
+ public:
+  static LibLouisContext &get (void);
+
+  void setDataPath (const std::string &path);
+  std::string getDataPath (void) const;
+  void warmUp (const std::string &table = LIBLOUIS_UEB_G1_TABLE);
+  bool translate (const std::string &table, const ll_widechar *input,
+		  unsigned &inputLength, ll_widechar *output,
+		  unsigned &outputLength);
+  void release (void);
+  unsigned long getTableLoadCount (void) const;
+
+ protected:
+  LibLouisContext ();
+  ~LibLouisContext ();
+
+  bool translateLocked (const std::string &table, const ll_widechar *input,
+			unsigned &inputLength, ll_widechar *output,
+			unsigned &outputLength);
+
+  mutable boost::mutex m_mutex;
+  std::string m_dataPath;
+  bool m_isDataPathSet; // whether liblouis has been given m_dataPath
+  std::set<std::string> m_loadedTables; // since tables were last freed
+  unsigned long m_tableLoadCount;
+};
+
+#endif /* __LIBLOUIS_CONTEXT_H__ */
@@ -11,11 +11,31 @@
 
 #include "MathDocumentElements.h"
 
+/**
+ * Receives an interpreted document one source line at a time, in order,
+ * as the lines are interpreted (see MathInterpreter::interpret()).  This
+ * lets the output be consumed, e.g. rendered, without ever holding the
+ * whole document in memory.
+ */
+class MathDocumentSink
+{
+ public:
+  virtual ~MathDocumentSink();
+
+  /**
+   * Called once for each source line.
+   *
+   * @param [in] elements The elements for the line, beginning with its
+   *             MDE_SourceLine, exactly as they would appear in a
+   *             MathDocument
+   */
+  virtual void addLine (const MDEVector &elements) = 0;
+};
 
 /**
  * A MathDocument holds the contents of an interpreted math file.
  */
-class MathDocument
+class MathDocument : public MathDocumentSink
 {
  protected:
    /**
@@ -29,6 +49,9 @@ class MathDocument
   const MDEVector &getDocument (void) const;
   void addElementPtr (MathDocumentElementPtr element);
   void addElements (const MDEVector &elements);
+  virtual void addLine (const MDEVector &elements);
+  void replaceElements (const size_t first, const size_t count,
+			const MDEVector &elements);
 };
 
 #endif /* __MATH_DOCUMENT_H__ */
@@ -192,6 +192,20 @@ class MDE_MathBlock : public MDE_GenericText
   virtual std::string getString (void) const;
 };
 
+/**
+ * Source text that could not be interpreted.  Only produced when the
+ * interpreter is recovering from errors (see
+ * MathInterpreter::setErrorRecovery()); the problem itself is described by
+ * the interpreter's error messages.
+ */
+class MDE_Error : public MDE_GenericText
+{
+ public:
+  MDE_Error(const std::string &contents);
+
+  virtual std::string getString (void) const;
+};
+
 /**
  * A number or set of digits.  Left-hand-side (whole numbers) and
  * right-hand-side (decimal portion) are separately stored in case a
@@ -233,7 +247,7 @@ class MDE_Group : public MathDocumentElement
  public:
   MDE_Group(const EnclosureType encl, const MDEVector &content);
 
-  MDEVector getContents (void) const;
+  const MDEVector &getContents (void) const;
   EnclosureType getType (void) const;
 
   virtual std::string getString (void) const;
@@ -370,7 +384,7 @@ class MDE_Modifier : public MathDocumentElement
 
   MDE_Modifier (const Modifier m, const MDEVector arg);
   Modifier getModifier (void) const;
-  MDEVector getArgument (void) const;
+  const MDEVector &getArgument (void) const;
 
   virtual std::string getString (void) const;
   static const std::string &getModifierName (const Modifier m);
@@ -394,8 +408,8 @@ class MDE_Root : public MathDocumentElement
  public:
   MDE_Root(const MDEVector idx, const MDEVector contents);
 
-  MDEVector getIndex(void) const;
-  MDEVector getArgument(void) const;
+  const MDEVector &getIndex(void) const;
+  const MDEVector &getArgument(void) const;
 
   virtual std::string getString (void) const;
 };
@@ -409,8 +423,8 @@ class MDE_Summation : public MathDocumentElement
  public:
   MDE_Summation(const MDEVector lower, const MDEVector upper);
 
-  MDEVector getLowerBound (void) const;
-  MDEVector getUpperBound (void) const;
+  const MDEVector &getLowerBound (void) const;
+  const MDEVector &getUpperBound (void) const;
 
   virtual std::string getString (void) const;
 };
@@ -426,8 +440,8 @@ class MDE_Fraction : public MathDocumentElement
  public:
   MDE_Fraction(const MDEVector num, const MDEVector den);
 
-  MDEVector getNumerator (void) const;
-  MDEVector getDenominator (void) const;
+  const MDEVector &getNumerator (void) const;
+  const MDEVector &getDenominator (void) const;
 
   virtual std::string getString (void) const;
 };
@@ -441,7 +455,7 @@ class MDE_Exponent : public MathDocumentElement
  public:
   MDE_Exponent(const MDEVector exponent);
 
-  MDEVector getValue (void) const;
+  const MDEVector &getValue (void) const;
 
   virtual std::string getString (void) const;
 };
@@ -454,7 +468,7 @@ class MDE_Subscript : public MathDocumentElement
  public:
   MDE_Subscript(const MDEVector subscript);
 
-  MDEVector getValue (void) const;
+  const MDEVector &getValue (void) const;
 
   virtual std::string getString (void) const;
 };
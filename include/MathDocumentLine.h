@@ -29,7 +29,7 @@ class MathDocumentLine
 		    const unsigned long source_linenumber2,
 		    const std::string &text);
 
-  std::string getFilename (void) const;
+  const std::string &getFilename (void) const;
   unsigned long getStartLineNumber (void) const;
   unsigned long getEndLineNumber (void) const;
   std::string getContent (void) const;
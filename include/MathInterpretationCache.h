@@ -0,0 +1,97 @@
+/**
+ * @file MathInterpretationCache.h
+ * Header file for the cache of interpreted lines shared between
+ * interpreters
+ *
+ * @copyright Copyright 2015 Anthony Tibbs
+ * This project is released under the GNU General Public License.
+*/
+
+#ifndef __MATH_INTERPRETATION_CACHE_H__
+#define __MATH_INTERPRETATION_CACHE_H__
+
+#include <list>
+#include <string>
+#include <vector>
+#include <boost/cstdint.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/unordered_map.hpp>
+
+#include "MathDocumentElements.h"
+#include "MathInterpreterMsg.h"
+
+/**
+ * Remembers the elements and messages produced for source lines, so that
+ * a line seen before (in this document or another one) need not be
+ * interpreted again.
+ *
+ * Entries are keyed on the line's content, the block mode it was
+ * interpreted in, and the set of commands registered with the
+ * interpreter.  The least recently used entries are dropped once the
+ * (approximate) memory used goes over the limit.
+ *
+ * A cache may be shared by any number of interpreters, on any number of
+ * threads.
+ */
+class MathInterpretationCache
+{
+ public:
+  /**
+   * Usage figures, as returned by getStatistics()
+   */
+  struct Statistics {
+    Statistics ();
+    double getHitRate (void) const;
+
+    unsigned long hits;
+    unsigned long misses;
+    unsigned long evictions;
+    size_t entries;
+    size_t bytesUsed;
+    boost::uint64_t microsecondsSaved; // interpretation time of the hits
+  };
+
+  MathInterpretationCache (const size_t maxBytes = 16 * 1024 * 1024);
+
+  bool lookup (const std::string &content, const bool inTextBlock,
+	       const size_t commandSet, MDEVector &elements,
+	       std::vector<MathInterpreterMsg> &messages);
+  void store (const std::string &content, const bool inTextBlock,
+	      const size_t commandSet, const MDEVector &elements,
+	      const std::vector<MathInterpreterMsg> &messages,
+	      const unsigned long microseconds);
+  void clear (void);
+  Statistics getStatistics (void) const;
+
+ protected:
+  struct Key {
+    std::string content;
+    bool inTextBlock;
+    size_t commandSet;
+
+    bool operator== (const Key &other) const;
+  };
+
+  struct KeyHash {
+    size_t operator() (const Key &key) const;
+  };
+
+  struct Entry {
+    Key key;
+    MDEVector elements;
+    std::vector<MathInterpreterMsg> messages;
+    size_t bytes;
+    unsigned long microseconds;
+  };
+
+  typedef std::list<Entry> EntryList;
+  typedef boost::unordered_map<Key, EntryList::iterator, KeyHash> EntryIndex;
+
+  mutable boost::mutex m_mutex;
+  size_t m_maxBytes;
+  EntryList m_entries; // most recently used first
+  EntryIndex m_index;
+  Statistics m_stats;
+};
+
+#endif /* __MATH_INTERPRETATION_CACHE_H__ */
@@ -10,11 +10,20 @@
 #ifndef __MATH_INTERPRETER_H__
 #define __MATH_INTERPRETER_H__
 
+#include <map>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+#include <boost/function.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/unordered_map.hpp>
+#include <boost/unordered_set.hpp>
+
 #include "MathDocument.h"
 #include "MathDocumentElements.h"
 #include "MathInterpreterMsg.h"
 #include "MathSourceFile.h"
 
+class MathInterpretationCache;
+
 /**
  * Macros to help with message adding
  */
@@ -27,13 +36,36 @@
 #define MSG_ERROR(code,msg) addMessage(MathInterpreterMsg::MI_ERROR, MathInterpreterMsg::code, msg)
 #define MSG_ERRORX(code) addMessage(MathInterpreterMsg::MI_ERROR, MathInterpreterMsg::code)
 
+/**
+ * Starts the details of a message, to which arguments are added with '%'
+ * (see MathInterpreterMsg::Detail).  'format' must be a string literal.
+ */
+#define MSG_DETAIL(format) MathInterpreterMsg::Detail(format)
+
+/**
+ * Gives up on the construct being interpreted, once the problem has been
+ * reported with MSG_ERROR.  Throws MathInterpreterException unless error
+ * recovery is enabled, in which case the interpret function returns and
+ * the rest of the line is skipped (see setErrorRecovery()).
+ */
+#define INTERPRET_FAIL() { if (!m_recoverFromErrors) { BOOST_THROW_EXCEPTION (MathInterpreterException()); } m_lineFailed = true; return false; }
+
+/**
+ * Interprets a MathSourceFile into a MathDocument.
+ *
+ * All working state lives in the instance, so separate interpreters may be
+ * used on different threads at the same time, even when they share a
+ * source file, as long as each one writes to its own MathDocument.  A
+ * single instance must only be used by one thread at a time; interpret()
+ * starts and joins its own worker threads (see setThreadCount()).
+ */
 class MathInterpreter
 {
  protected:
   const MathSourceFile &m_src;
   MathDocument &m_doc;
   std::vector<MathInterpreterMsg> m_messages;
-  std::vector<std::string> m_knownCommands;
+  boost::unordered_set<std::string> m_knownCommands;
 
   /* Translation "current status" parameters */
   const MathDocumentLine *m_pCurLine;
@@ -41,9 +73,74 @@ class MathInterpreter
   bool m_inTextMode; // whether translator is currently seeing 'text'
   bool m_isStartOfLine;
   unsigned long m_blockBeganLineNum; // line at which current block began
+  unsigned long m_recursionLevel; // number of buffers on the frame stack
+
+  /* Error recovery: see setErrorRecovery() */
+  bool m_recoverFromErrors;
+  bool m_lineFailed; // an error was found; abandon the rest of the line
+
+  /* Nested constructs (groups, fractions, etc.) are interpreted on an
+   * explicit stack of buffers rather than by recursion, so that deeply
+   * nested input cannot overflow the call stack: see interpretBuffer() */
+  typedef boost::function<MathDocumentElementPtr (const std::vector<MDEVector> &)> ElementMaker;
+  struct BufferFrame {
+    std::string buffer;
+    size_t pos;
+    std::string catchBuffer;
+    MDEVector elements;
+    size_t constructStart; // where the construct being interpreted began
+    ElementMaker make; // ... builds it from its interpreted buffers
+    std::vector<std::string> nestedBuffers;
+    std::vector<MDEVector> nestedElements;
+  };
+  std::vector<BufferFrame> m_frames; // kept between lines to reuse the space
+  unsigned long m_maxNestingDepth; // see setMaxNestingDepth()
+
+  /* Resource limits for untrusted input: see setMaxElements() and
+   * setDeadline() */
+  size_t m_maxElements;
+  size_t m_numLineElements; // elements interpreted so far on this line
+  boost::posix_time::ptime m_deadline;
+  unsigned m_stepsToDeadlineCheck;
+  bool countElements (BufferFrame &frame, const size_t numElements);
+  void checkDeadline (void);
+  void enterBuffer (std::string &buffer);
+  void interpretNextItem (BufferFrame &frame);
+  void flushCatchBuffer (BufferFrame &frame);
+  bool interpretNested (const ElementMaker &make, const std::string &buffer);
+  bool interpretNested (const ElementMaker &make, const std::string &buffer1,
+			const std::string &buffer2);
+
+  /* Parallel interpretation support */
+  struct LineJob;
+  struct LineQueue;
+  unsigned m_numThreads; // worker threads used by interpret(); 0 = automatic
+  size_t getThreadCountFor (const size_t numLines) const;
+  void interpretJobs (std::vector<LineJob> &jobs, const size_t numThreads) const;
+  void scanBlockModes (std::vector<LineJob> &jobs) const;
+  void runLineJobs (LineQueue &queue) const;
+
+  /* Incremental re-interpretation support: what the last interpret() (and
+   * any reinterpretLines() since) produced for each source line */
+  struct LineState {
+    bool inTextBlock;
+    unsigned long blockBeganLineNum;
+    size_t numElements; // including the MDE_SourceLine
+    std::vector<MathInterpreterMsg> messages;
+  };
+  std::vector<LineState> m_lineStates;
+  size_t m_docOffset; // where this interpreter's output starts in m_doc
+  size_t m_msgOffset; // ... and in m_messages
+  void discardResults (void);
+
+  /* Cache of interpreted lines, possibly shared with other interpreters */
+  boost::shared_ptr<MathInterpretationCache> m_cache;
+  size_t getCommandSetHash (void) const;
+  bool interpretLineFromCache (const MathDocumentLine &mdl,
+			       MDEVector &elements, const size_t commandSet);
 
   /* Interpretation functions */
-  void interpretLine (const MathDocumentLine &mdl);
+  void interpretLine (const MathDocumentLine &mdl, MDEVector &elements);
   MDEVector interpretBuffer (const std::string &buffer);
   bool interpretCommand (MDEVector &target, const std::string &src, size_t &i);
   bool interpretNumber (MDEVector &target, const std::string &src, size_t &i);
@@ -64,8 +161,7 @@ class MathInterpreter
 
   /* Support functions */
   void sniffTextForMath (const std::string &buffer);
-  bool extractItem (std::string &target, const std::string &src, size_t &i,
-		    const std::string &terminators = ",+/*=<>()[]{} ~@#!");
+  bool extractItem (std::string &target, const std::string &src, size_t &i);
   bool extractGroup (std::string &target, const std::string &src, size_t &i,
 		     const std::string &groupOpen = "(",
 		     const std::string &groupClose = ")",
@@ -78,16 +174,43 @@ class MathInterpreter
   /* Reporting functions */
   void addMessage (const MathInterpreterMsg::Category category,
 		   const MathInterpreterMsg::Code msgCode,
-		   const std::string &msg = std::string());
+		   const MathInterpreterMsg::Detail &detail = MathInterpreterMsg::Detail());
+  const boost::shared_ptr<const std::string> &getFilenameRef (const MathDocumentLine &mdl);
+
+  /* Messages are kept per line as they are made, then published to
+   * m_messages subject to setMessageLimit() and setMessageFolding() */
+  boost::shared_ptr<const std::string> m_filenameRef; // see getFilenameRef()
+  size_t m_messageLimit;
+  std::map<MathInterpreterMsg::Code, size_t> m_codeMessageLimits;
+  bool m_foldMessages;
+  std::map<MathInterpreterMsg::Code, size_t> m_messageCounts;
+  std::map<MathInterpreterMsg::Code, size_t> m_suppressedCounts;
+  boost::unordered_multimap<size_t, size_t> m_messageIndex; // content hash -> m_messages index
+  void publishMessages (const std::vector<MathInterpreterMsg> &messages);
+  bool foldMessage (const MathInterpreterMsg &message, const size_t hash);
+  void restartMessageCounts (void);
 
  public:
   MathInterpreter(const MathSourceFile &srcFile, MathDocument &targetDoc);
   void interpret (void);
+  void interpret (MathDocumentSink &sink);
+  void setThreadCount (const unsigned numThreads);
+  void setErrorRecovery (const bool recover);
+  void setMaxNestingDepth (const unsigned long maxDepth);
+  void setMaxElements (const size_t maxElements);
+  void setDeadline (const boost::posix_time::ptime &deadline);
+  void reinterpretLines (const std::vector<size_t> &changedLines);
+  void setCache (const boost::shared_ptr<MathInterpretationCache> &cache);
   void registerCommand (const std::string &cmd);
   void registerCommands (const std::vector<std::string> &commands);
   bool isCommand (const std::string &cmd) const;
+  void setMessageLimit (const size_t maxMessages);
+  void setMessageLimit (const MathInterpreterMsg::Code code, const size_t maxMessages);
+  void setMessageFolding (const bool fold);
   bool haveMessages (void) const;
   const std::vector<MathInterpreterMsg> &getMessages (void) const;
+  size_t getSuppressedMessageCount (void) const;
+  size_t getSuppressedMessageCount (const MathInterpreterMsg::Code code) const;
 };
 
 #endif /* __MATH_INTERPRETER_H__ */
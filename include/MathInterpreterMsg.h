@@ -11,6 +11,9 @@
 
 #include <string>
 #include <iostream>
+#include <boost/container/small_vector.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/variant.hpp>
 
 /**
  * A single message generated by the math interpreter
@@ -30,26 +33,65 @@ class MathInterpreterMsg
 		 SUBSCRIPT_NOT_TERMINATED,
 		 ROOT_INDEX_NOT_TERMINATED,
 		 ROOT_NOT_TERMINATED,
+		 SUMMATION_LOWER_BOUND_NOT_TERMINATED,
+		 SUMMATION_UPPER_BOUND_NOT_TERMINATED,
 		 MODIFIER_MISSING_ARGUMENT,
 		 MODIFIER_NOT_TERMINATED,
 		 MODIFIER_ROOT_REQUIRES_PARENS,
-                 GROUP_NOT_TERMINATED} Code;
+                 GROUP_NOT_TERMINATED,
+		 NESTING_TOO_DEEP,
+		 TOO_MANY_ELEMENTS,
+		 TIME_LIMIT_EXCEEDED} Code;
+
+  /**
+   * The details of a message: a boost::format string, which must be a
+   * literal (only the pointer is kept), and the arguments for it.  They
+   * are only put together when the message is displayed, e.g.
+   *   MSG_ERROR(ROOT_NOT_TERMINATED, MSG_DETAIL("text in root: '%s'") % argument)
+   */
+  class Detail
+  {
+  public:
+    typedef boost::variant<long, unsigned long, char, std::string> Arg;
+    typedef boost::container::small_vector<Arg, 2> Args;
+
+    Detail (const char *format = NULL) : m_format(format) {}
+
+    Detail &operator% (const std::string &arg) { m_args.push_back (arg); return *this; }
+    Detail &operator% (const char *arg) { m_args.push_back (std::string(arg)); return *this; }
+    Detail &operator% (const char arg) { m_args.push_back (arg); return *this; }
+    Detail &operator% (const int arg) { m_args.push_back (long(arg)); return *this; }
+    Detail &operator% (const long arg) { m_args.push_back (arg); return *this; }
+    Detail &operator% (const unsigned arg) { m_args.push_back ((unsigned long)arg); return *this; }
+    Detail &operator% (const unsigned long arg) { m_args.push_back (arg); return *this; }
+
+    bool empty (void) const { return (m_format == NULL); }
+    std::string str (void) const;
+    size_t hash (void) const;
+    size_t getByteSize (void) const;
+    bool operator== (const Detail &other) const;
+
+  protected:
+    const char *m_format;
+    Args m_args;
+  };
 
  protected:
   Category m_category;
   Code m_code;
-  std::string m_filename;
+  boost::shared_ptr<const std::string> m_filename; // shared by a file's messages
   unsigned long m_line1;
   unsigned long m_line2;
-  std::string m_message;
+  Detail m_detail;
+  unsigned long m_repeats; // identical messages folded into this one
 
  public:
   MathInterpreterMsg (const MathInterpreterMsg::Category category,
 		      const MathInterpreterMsg::Code msgCode,
-		      const std::string &source_filename,
+		      const boost::shared_ptr<const std::string> &source_filename,
 		      const unsigned long source_linenumber1,
 		      const unsigned long source_linenumber2,
-		      const std::string &msg);
+		      const Detail &detail = Detail());
 
   MathInterpreterMsg::Category getCategory (void) const;
   MathInterpreterMsg::Code getCode (void) const;
@@ -58,6 +100,16 @@ class MathInterpreterMsg
   unsigned long getEndLineNumber (void) const;
   std::string getMessage (void) const;
   std::string getFormattedMessage(void) const;
+  unsigned long getRepeatCount (void) const;
+  size_t getByteSize (void) const;
+
+  size_t hashContent (void) const;
+  bool hasSameContent (const MathInterpreterMsg &other) const;
+  void addRepeat (void);
+
+  void setLocation (const boost::shared_ptr<const std::string> &source_filename,
+		    const unsigned long source_linenumber1,
+		    const unsigned long source_linenumber2);
 
   friend std::ostream &operator<<(std::ostream &os, const MathInterpreterMsg &mdm);
 };
@@ -0,0 +1,54 @@
+/**
+ * @file MathRenderPipeline.h
+ * Header file for rendering a document on separate threads while it is
+ * being interpreted.
+ *
+ * @copyright Copyright 2015 Anthony Tibbs
+ * This project is released under the GNU General Public License.
+*/
+
+#ifndef __MATH_RENDER_PIPELINE_H__
+#define __MATH_RENDER_PIPELINE_H__
+
+#include <ostream>
+#include <vector>
+#include <boost/shared_ptr.hpp>
+
+#include "MathDocument.h"
+#include "MathRenderer.h"
+
+/**
+ * A MathDocumentSink that passes each interpreted line on to one or more
+ * renderers, each running on its own thread and writing to its own output
+ * stream, so that interpretation and rendering overlap.
+ *
+ * Each renderer is fed through a bounded, lock-free queue of lines.  If a
+ * renderer falls behind and its queue fills up, addLine() waits for it, so
+ * memory use stays bounded however long the document is.
+ *
+ * Usage: call addRenderer() for each output, pass the pipeline to
+ * MathInterpreter::interpret(MathDocumentSink &), then call finish().  A
+ * pipeline destroyed without finish() leaves its outputs unfinished.
+ */
+class MathRenderPipeline : public MathDocumentSink
+{
+ protected:
+  struct Stage;
+  std::vector<boost::shared_ptr<Stage> > m_stages;
+  size_t m_queueLength;
+  bool m_started;
+  bool m_finished;
+
+  void start (void);
+  static void runStage (Stage &stage);
+
+ public:
+  MathRenderPipeline (const size_t queueLength = 256);
+  ~MathRenderPipeline ();
+
+  void addRenderer (MathRenderer &renderer, std::ostream &os);
+  virtual void addLine (const MDEVector &elements);
+  void finish (void);
+};
+
+#endif /* __MATH_RENDER_PIPELINE_H__ */
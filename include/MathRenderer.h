@@ -10,9 +10,13 @@
 #ifndef __MATH_RENDERER_H__
 #define __MATH_RENDERER_H__
 
-#include "MathDocumentElements.h"
+#include <ostream>
+#include <vector>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+#include <boost/function.hpp>
 
-class MathDocument;
+#include "MathDocument.h"
+#include "MathDocumentElements.h"
 
 /**
  * Helper macro to quickly define virtual render functions for each element type.
@@ -20,26 +24,79 @@ class MathDocument;
  * @param [in] class Name of the MathDocumentElement-derived class type
  * @internal
  */
-#define DECL_RENDER_FUNC(class) std::string render##class (const MDE_##class *e)
+#define DECL_RENDER_FUNC(class) void render##class (const MDE_##class *e, std::string &output)
 
 /**
  * An abstract base class providing the framework for rendering math
  * documents to external formats. The base implementation takes care of looping 
  * through the document and calling render* methods as required.
  *
+ * Each render* method appends to an output buffer passed in by the caller,
+ * so that nested elements are rendered straight into the output of the
+ * element that contains them rather than into strings of their own.
+ *
+ * A render* method does not render the elements nested in it itself:
+ * it asks for them with renderNested(), and anything that has to come after
+ * them with scheduleStep().  They are rendered, in the order asked for, once
+ * the method returns, so that documents of any nesting depth can be
+ * rendered without recursion.
+ *
  * @note If new element types are added, new DECL_RENDER_FUNC() lines are needed 
  *       here as well!
  */
 class MathRenderer
 {
+protected:
+  /**
+   * Part of rendering an element that has to wait until elements nested in
+   * it have been rendered: see scheduleStep().
+   */
+  typedef boost::function<void (std::string &)> RenderStep;
+
+  /* Nested elements (groups, fractions, etc.) are rendered from an explicit
+   * stack of work rather than by recursion, so that deeply nested documents
+   * cannot overflow the call stack: see renderNested() */
+  struct RenderTask {
+    RenderTask () : elements(NULL), next(0), element(NULL), depth(0) {}
+
+    const MDEVector *elements; // elements to render in turn...
+    size_t next; // ... the next of which to render
+    const MathDocumentElement *element; // or a single element
+    MathDocumentElementPtr elementRef; // keeps an element this refers to alive
+    RenderStep step; // or a step to run
+    unsigned long depth; // nesting depth of the elements
+  };
+  std::vector<RenderTask> renderTasks; // kept between calls to reuse the space
+  std::vector<RenderTask> scheduledTasks; // by the task being run
+
+  unsigned long renderDepth; // nesting depth of the elements being rendered
+  unsigned long maxNestingDepth; // see setMaxNestingDepth()
+  size_t maxOutputBytes; // see setMaxOutputBytes()
+  size_t outputBytes; // ... and the output counted towards it so far
+  boost::posix_time::ptime deadline; // see setDeadline()
+  unsigned elementsToDeadlineCheck;
+
+  void renderNested(const MDEVector &v);
+  void renderNested(const MathDocumentElementPtr &e);
+  void scheduleStep(const RenderStep &step);
+  void runRenderTasks(const RenderTask &first, std::string &output);
+  void dispatchElement(const MathDocumentElement *e, std::string &output);
+
+  void checkNestingDepth(const unsigned long depth) const;
+  void checkOutputSize(const size_t pendingBytes) const;
+  void checkDeadline(void);
+
 public:
   MathRenderer();
+  void setMaxNestingDepth(const unsigned long maxDepth);
+  void setMaxOutputBytes(const size_t maxBytes);
+  void setDeadline(const boost::posix_time::ptime &deadline);
 
   /**
    * Render callback for MDE_SourceLine elements.
    * 
    * @param [in] e Source element to be rendered
-   * @return std::string containing a fully rendered version of the element
+   * @param [out] output Buffer to append the rendered element to
    */
   virtual DECL_RENDER_FUNC(SourceLine) = 0;
 
@@ -47,7 +104,7 @@ public:
   * Render callback for MDE_Command elements.
   *
   * @param [in] e Source element to be rendered
-  * @return std::string containing a fully rendered version of the element
+  * @param [out] output Buffer to append the rendered element to
   * @note "Command" elements typically change interpreter/rendering behaviour but
   *       may not in and of themselves generate output.
   */
@@ -57,7 +114,7 @@ public:
   * Render callback for MDE_MathModeMarker elements.
   *
   * @param [in] e Source element to be rendered
-  * @return std::string containing a fully rendered version of the element
+  * @param [out] output Buffer to append the rendered element to
   * @note Mode marker elements typically change interpreter/rendering behaviour but
   *       may not in and of themselves generate output.
   */
@@ -67,7 +124,7 @@ public:
   * Render callback for MDE_TextModeMarker elements.
   *
   * @param [in] e Source element to be rendered
-  * @return std::string containing a fully rendered version of the element
+  * @param [out] output Buffer to append the rendered element to
   * @note Mode marker elements typically change interpreter/rendering behaviour but
   *       may not in and of themselves generate output.
   */
@@ -77,7 +134,7 @@ public:
   * Render callback for MDE_LineBreak elements.
   *
   * @param [in] e Source element to be rendered
-  * @return std::string containing a fully rendered version of the element
+  * @param [out] output Buffer to append the rendered element to
   */
   virtual DECL_RENDER_FUNC(LineBreak) = 0;
 
@@ -85,7 +142,7 @@ public:
   * Render callback for MDE_TextBlock elements.
   *
   * @param [in] e Source element to be rendered
-  * @return std::string containing a fully rendered version of the element
+  * @param [out] output Buffer to append the rendered element to
   */
   virtual DECL_RENDER_FUNC(TextBlock) = 0;
 
@@ -93,15 +150,26 @@ public:
   * Render callback for MDE_MathBlock elements.
   *
   * @param [in] e Source element to be rendered
-  * @return std::string containing a fully rendered version of the element
+  * @param [out] output Buffer to append the rendered element to
   */
   virtual DECL_RENDER_FUNC(MathBlock) = 0;
 
+  /**
+  * Render callback for MDE_Error elements.
+  *
+  * Renders source text that the interpreter could not make sense of and
+  * skipped over while recovering from an error.
+  *
+  * @param [in] e Source element to be rendered
+  * @param [out] output Buffer to append the rendered element to
+  */
+  virtual DECL_RENDER_FUNC(Error) = 0;
+
   /**
   * Render callback for MDE_Number elements.
   *
   * @param [in] e Source element to be rendered
-  * @return std::string containing a fully rendered version of the element
+  * @param [out] output Buffer to append the rendered element to
   */
   virtual DECL_RENDER_FUNC(Number) = 0;
 
@@ -112,7 +180,7 @@ public:
   * including rendering of any enclosed or nested elements. 
   *
   * @param [in] e Source element to be rendered
-  * @return std::string containing a fully rendered version of the element
+  * @param [out] output Buffer to append the rendered element to
   */
   virtual DECL_RENDER_FUNC(Group) = 0;
 
@@ -120,7 +188,7 @@ public:
   * Render callback for MDE_ItemNumber elements.
   *
   * @param [in] e Source element to be rendered
-  * @return std::string containing a fully rendered version of the element
+  * @param [out] output Buffer to append the rendered element to
   */
   virtual DECL_RENDER_FUNC(ItemNumber) = 0;
 
@@ -128,7 +196,7 @@ public:
   * Render callback for MDE_OperatorNumber elements.
   *
   * @param [in] e Source element to be rendered
-  * @return std::string containing a fully rendered version of the element
+  * @param [out] output Buffer to append the rendered element to
   */
   virtual DECL_RENDER_FUNC(Operator) = 0;
 
@@ -136,7 +204,7 @@ public:
   * Render callback for MDE_Comparator elements.
   *
   * @param [in] e Source element to be rendered
-  * @return std::string containing a fully rendered version of the element
+  * @param [out] output Buffer to append the rendered element to
   */
   virtual DECL_RENDER_FUNC(Comparator) = 0;
 
@@ -144,7 +212,7 @@ public:
   * Render callback for MDE_GreekLetter elements.
   *
   * @param [in] e Source element to be rendered
-  * @return std::string containing a fully rendered version of the element
+  * @param [out] output Buffer to append the rendered element to
   */
   virtual DECL_RENDER_FUNC(GreekLetter) = 0;
 
@@ -152,7 +220,7 @@ public:
   * Render callback for MDE_Symbol elements.
   *
   * @param [in] e Source element to be rendered
-  * @return std::string containing a fully rendered version of the element
+  * @param [out] output Buffer to append the rendered element to
   */
   virtual DECL_RENDER_FUNC(Symbol) = 0;
 
@@ -165,7 +233,7 @@ public:
   * applicable modifiers will be rendered by this function.
   * 
   * @param [in] e Source element to be rendered
-  * @return std::string containing a fully rendered version of the element
+  * @param [out] output Buffer to append the rendered element to
   */
   virtual DECL_RENDER_FUNC(Modifier) = 0;
 
@@ -175,7 +243,7 @@ public:
   * Renders a root symbol, including all elements which are under the root.
   *
   * @param [in] e Source element to be rendered
-  * @return std::string containing a fully rendered version of the element
+  * @param [out] output Buffer to append the rendered element to
   */
   virtual DECL_RENDER_FUNC(Root) = 0;
 
@@ -185,7 +253,7 @@ public:
   * Renders a summation (sigma) symbol, including any lower/upper bounds.
   *
   * @param [in] e Source element to be rendered
-  * @return std::string containing a fully rendered version of the element
+  * @param [out] output Buffer to append the rendered element to
   */
   virtual DECL_RENDER_FUNC(Summation) = 0;
 
@@ -196,7 +264,7 @@ public:
   * numerator and denominator accordingly.
   *
   * @param [in] e Source element to be rendered
-  * @return std::string containing a fully rendered version of the element
+  * @param [out] output Buffer to append the rendered element to
   */
   virtual DECL_RENDER_FUNC(Fraction) = 0;
 
@@ -207,7 +275,7 @@ public:
   * are in the exponent/superscript.
   *
   * @param [in] e Source element to be rendered
-  * @return std::string containing a fully rendered version of the element
+  * @param [out] output Buffer to append the rendered element to
   */
   virtual DECL_RENDER_FUNC(Exponent) = 0;
 
@@ -218,13 +286,56 @@ public:
   * are in the subscript itself.
   *
   * @param [in] e Source element to be rendered
-  * @return std::string containing a fully rendered version of the element
+  * @param [out] output Buffer to append the rendered element to
   */
   virtual DECL_RENDER_FUNC(Subscript) = 0;
     
-  virtual std::string renderDocument(const MathDocument &document);
-  virtual std::string renderVector(const MDEVector &v);
-  virtual std::string renderElement(const MathDocumentElement *e);
+  std::string renderDocument(const MathDocument &document);
+  virtual void renderDocument(const MathDocument &document, std::ostream &os);
+  virtual std::string beginDocument(void);
+  virtual void renderLines(const MDEVector &elements, std::string &output);
+  virtual std::string endDocument(void);
+  std::string renderVector(const MDEVector &v);
+  virtual void renderVector(const MDEVector &v, std::string &output);
+  std::string renderElement(const MathDocumentElement *e);
+  virtual void renderElement(const MathDocumentElement *e, std::string &output);
+};
+
+/**
+ * Renders a document as it is being interpreted: each line passed to the
+ * sink is rendered straight away and written to an output stream, so the
+ * document as a whole never needs to be kept.
+ *
+ * A sink may render to several formats at once: each line is handed to
+ * every renderer in turn, each writing to its own stream, so the document
+ * is interpreted and walked just once however many outputs are made.
+ * Unlike MathRenderPipeline, everything happens on the calling thread.
+ *
+ * Each renderer's beginDocument() output is written when it is added (by
+ * the constructor or addRenderer()); call finish() once the last line has
+ * been added.
+ */
+class MathRendererSink : public MathDocumentSink
+{
+ protected:
+  /**
+   * A renderer and the stream its output goes to.
+   */
+  struct Target {
+    MathRenderer *renderer;
+    std::ostream *os;
+  };
+
+  std::vector<Target> m_targets;
+  std::string m_buffer; // reused for each line's output
+
+ public:
+  MathRendererSink ();
+  MathRendererSink (MathRenderer &renderer, std::ostream &os);
+
+  void addRenderer (MathRenderer &renderer, std::ostream &os);
+  virtual void addLine (const MDEVector &elements);
+  void finish (void);
 };
 
 #endif /* __MATH_RENDERER_H__ */
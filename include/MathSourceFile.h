@@ -18,6 +18,8 @@
 class MathSourceFile
 {
  public:
+  MathSourceFile ();
+
   /**
    * Initiate processing of a math document from the given file.
    */
@@ -31,8 +33,24 @@ class MathSourceFile
 
   const std::vector<MathDocumentLine> &getDocument (void) const;
 
+  /**
+   * Replace the content of one logical line (e.g. after an edit), keeping
+   * its file name and line numbers.
+   */
+  void replaceLine (const size_t index, const std::string &content);
+
+  /**
+   * Limit the length of a logical line (after continuation lines have
+   * been joined); longer lines are refused with an exception.
+   */
+  void setMaxLineLength (const size_t maxLength);
+
  protected:
   std::vector<MathDocumentLine> m_document;
+  size_t m_maxLineLength;
+
+  void checkLineLength (const std::string &filename, const unsigned long lineNumber,
+			const size_t length) const;
 
   /**
    * Pull document text into the m_document buffer.
@@ -9,26 +9,21 @@
 #ifndef __UEB_RENDERER_H__
 #define __UEB_RENDERER_H__
 
-#include <stack>
+#include <map>
 #include <string>
+#include <vector>
+#include <boost/shared_ptr.hpp>
+#include "liblouis-mt.h"
 #include "MathRenderer.h"
 
+class BrailleTranslationCache;
+
 /**
  * Default line length for braille output; 0 disables wrapping altogether.
  * @see UEBRenderer::maxLineLength
  */
 #define UEB_DEFAULT_LINE_LEN 0
 
-// UEB math/text mode indicators
-#define UEB_MATH_BLOCK_BEGIN "<|@M@|>"
-#define UEB_TEXT_BLOCK_BEGIN "<|@T@|>"
-
-// UEB wrapping markers
-#define UEB_WORDWRAP_INDLEN  7
-#define UEB_WORDWRAP_PRI1    "<|@1@|>"
-#define UEB_WORDWRAP_PRI2    "<|@2@|>"
-#define UEB_WORDWRAP_PRI3    "<|@3@|>"
-
 // Technical braille symbols
 #define UEB_CAPITAL_SIGN     BD_6
 #define UEB_CONTINUATION     BD_5
@@ -134,12 +129,33 @@
  * One of the more complicated aspects of this rendering is taking care of 
  * line breaks, to ensure that the mathematical statements are wrapped to 
  * new lines at appropriate places. To facilitate this, suitable wrapping 
- * points are marked in the interim output (UEB_WORDWRAP_PRIx macros), 
- * and then the entire document is word-wrapped in one pass at the end of
- * the render. 
+ * points are recorded alongside the interim output (UEBRenderer::WrapHint), 
+ * and the braille is word-wrapped as it is rendered, a line being output
+ * as soon as it is full.
  */
 class UEBRenderer : public MathRenderer
 {
+ public:
+  /**
+   * Kinds of hints recorded alongside the rendered braille for wrapping.
+   */
+  typedef enum {
+    BREAK_PRI1, ///< Best place to break a line (e.g. before a comparator)
+    BREAK_PRI2, ///< Good place to break a line (e.g. before an operator)
+    BREAK_PRI3, ///< Last resort place to break a line (e.g. before a number)
+    MATH_BLOCK_BEGIN, ///< A math block begins (runover lines are indented)
+    TEXT_BLOCK_BEGIN ///< A text block begins (runover lines are not indented)
+  } WrapHintType;
+
+  /**
+   * A place to break a line, or a change of block mode, in the rendered
+   * braille.
+   */
+  struct WrapHint {
+    size_t offset; ///< Offset of the braille character the hint comes before
+    WrapHintType type; ///< What the hint marks
+  };
+
  protected:
    /** 
     * Sets the maximum line length for each line of braille.
@@ -199,9 +215,10 @@ class UEBRenderer : public MathRenderer
   UEBRenderStatus status;
 
   /**
-   * A stack of saved status flags for the rendering engine.
+   * A stack of saved status flags for the rendering engine, one for each
+   * nested rendering operation under way (see beginInternalRender()).
    */
-  std::stack<UEBRenderStatus> statusStack;
+  std::vector<UEBRenderStatus> statusStack;
 
   /**
   * Counts the rendering nesting level: for example, if rendering a numerator
@@ -216,28 +233,153 @@ class UEBRenderer : public MathRenderer
   bool doingInternalRender (void) const;
   void endInternalRender (void);
 
-  std::string stripWrappingIndicators(const std::string &input) const;
+  /**
+   * Braille rendered by the current call to renderLines(), waiting to be
+   * word wrapped.
+   */
+  std::string unwrappedBraille;
+
+  /**
+   * The part of the current braille line that has not been output yet:
+   * everything after its last runover break.
+   */
+  std::string wrapLine;
+
+  /**
+   * Length of the current braille line so far, including any runover
+   * indentation.
+   */
+  size_t wrapLineLength;
+
+  /**
+   * Last places in wrapLine that the line could be broken, by priority
+   * (std::string::npos if there are none).
+   */
+  size_t wrapBreaks [3];
+
+  /**
+   * The line break and runover indentation that come before wrapLine, or
+   * NULL if wrapLine starts a line of the document.  It is only output
+   * along with what follows it, as a break with nothing but whitespace
+   * before it replaces the previous break.
+   */
+  const char *wrapContinuation;
+
+  /**
+   * TRUE if any of the current braille line has been wrapped.
+   */
+  bool isWrapLineStarted;
 
-  std::string translateToBraille (const std::string &s);
-  std::string translateBrailleLetterIndicators (const std::string &s);
-  std::string translateBraillePunctuation (const std::string &s);
+  /**
+   * TRUE if the line being word wrapped is part of a text block, which
+   * changes how runover lines are indented.
+   */
+  bool isWrappingTextBlock;
 
-  std::string renderMathContent (const std::string &s);
-  std::string renderTextContent (const std::string &s);
+  /**
+   * Hints for unwrappedBraille, in order of offset.  These are kept out of
+   * the braille itself, so that it never has to be searched for them or
+   * cleaned of them.
+   */
+  std::vector<WrapHint> wrapHints;
+
+  bool hintsApplyTo (const std::string &output) const;
+  void addWrapHint (const std::string &output, const WrapHintType type);
+  void insertBraille (std::string &output, const size_t pos, const char *s);
+  void eraseBraille (std::string &output, const size_t pos, const size_t n);
+  void trimLeftFrom (std::string &output, const size_t start);
+  void trimFrom (std::string &output, const size_t start);
+
+  void wrapBraille (std::string &output);
+  void breakWrapLine (std::string &output);
+  void endWrapLine (std::string &output);
+
+  /* Cache of translated text, possibly shared with other renderers */
+  boost::shared_ptr<BrailleTranslationCache> translationCache;
+
+  /**
+   * Buffers for text being translated by liblouis, and the braille it
+   * returns, kept from one translation to the next.
+   */
+  std::vector<ll_widechar> louisInput, louisOutput;
+  void translateText (const std::string &s, std::string &braille);
+  bool translateTextChunk (const std::string &s, std::string &braille);
+
+  /**
+   * TRUE if the text in the lines being rendered is translated up front,
+   * in as few calls to liblouis as possible.
+   * @see UEBRenderer::setBatchTranslation
+   */
+  bool isBatchTranslating;
+
+  /**
+   * Braille for the text in the lines being rendered (as liblouis returned
+   * it), translated in batches before rendering them.
+   */
+  std::map<std::string, std::string> batchedTranslations;
+
+  /**
+   * Braille that liblouis gives for the separator put between pieces of
+   * text in a batch, or empty if it has not been worked out yet.
+   */
+  std::string batchSeparatorBraille;
+
+  /**
+   * Lines held back while translating text in batches, until there are
+   * enough of them to translate together.
+   */
+  MDEVector heldLines;
+
+  void renderBrailleLines (const MDEVector &elements, std::string &output);
+  void renderHeldLines (std::string &output);
+  void translateTextBatches (const MDEVector &elements);
+  void translateTextBatch (const std::vector<std::string> &texts);
+
+  void translateToBraille (const std::string &s, std::string &output);
+
+  void finishGroup (const size_t contentsStart, const char *closeChar,
+		    std::string &output);
+  void finishModifier (const MDE_Modifier *e, const bool isItem,
+		       const size_t start, std::string &output);
+  void renderRootArgument (const MDE_Root *e, const size_t rootStart,
+			   std::string &output);
+  void finishRoot (const size_t rootStart, std::string &output);
+  void renderBound (const MDEVector &v, const char *position,
+		    std::string &output);
+  void finishBound (const bool isItem, const size_t boundStart,
+		    std::string &output);
+  void finishSummation (std::string &output);
+  void renderDenominator (const MDE_Fraction *e, const bool simpleFraction,
+			  const size_t fractionStart, const size_t fractionHints,
+			  std::string &output);
+  void finishFraction (const bool simpleFraction, const size_t fractionStart,
+		       const size_t fractionHints, const size_t denominatorStart,
+		       std::string &output);
+  void finishScript (const bool isItem, const size_t start, const char *func,
+		     std::string &output);
+
+  void finishMathContent (std::string &output, const size_t start);
+  void finishTextContent (const std::string &braille, std::string &output,
+			  const bool withHints);
+  void renderMathContent (const std::string &s, std::string &output);
+  void renderTextContent (const std::string &s, std::string &output);
 
  public:
   UEBRenderer();
-  ~UEBRenderer();
 
   static void getInterpreterCommandList (std::vector<std::string> &cmdlist);
 
   static bool isBrailleItem (const MDEVector &v);
   static bool isSimpleFraction (const MDE_Fraction &frac);
-  std::string renderDocument (const MathDocument &document);
+  std::string beginDocument (void);
+  void renderLines (const MDEVector &elements, std::string &output);
+  std::string endDocument (void);
 
   void disableLineWrapping (void);
   void enableLineWrapping (const unsigned length);
   bool isWrappingEnabled (void) const;
+  void setTranslationCache (const boost::shared_ptr<BrailleTranslationCache> &cache);
+  void setBatchTranslation (const bool batch);
 
   DECL_RENDER_FUNC(SourceLine);
   DECL_RENDER_FUNC(Command);
@@ -248,6 +390,7 @@ class UEBRenderer : public MathRenderer
 
   DECL_RENDER_FUNC(TextBlock);
   DECL_RENDER_FUNC(MathBlock);
+  DECL_RENDER_FUNC(Error);
   DECL_RENDER_FUNC(Number);
   DECL_RENDER_FUNC(Group);
 
@@ -55,7 +55,9 @@
 #define ll_widechar unsigned short int
 #define ll_formtype unsigned char
 
-void strToWideCharString(const std::string &str, ll_widechar *outString, unsigned &outLength);
+// Conversion between UTF-8 and the UTF-16 used by LibLouis
+bool strToWideCharString(const std::string &str, ll_widechar *outString,
+			 const unsigned maxLength, unsigned &outLength);
 void wideCharStringToStr(const ll_widechar *str, const unsigned inLength, std::string &outString);
 
 // Tables to use
@@ -65,6 +67,10 @@ void wideCharStringToStr(const ll_widechar *str, const unsigned inLength, std::s
 // we cannot exceed that here.
 #define LIBLOUIS_MAXSTRING 512
 
+// Longest piece of text sent to LibLouis at once, leaving plenty of room
+// in the buffer for the braille to grow.
+#define LIBLOUIS_MAXCHUNK (LIBLOUIS_MAXSTRING / 2)
+
 #ifdef _WIN32
 #define IMPORTDLL __declspec(dllimport)
 #define STDCALL __stdcall
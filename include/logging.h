@@ -37,16 +37,17 @@ BOOST_LOG_GLOBAL_LOGGER(logger, boost::log::sources::severity_logger_mt<boost::l
 
 // to allow for easier-to-read logs, we automatically insert 2 spaces for
 // every level of indentation that the application has indicated.  These
-// functions are used to increase/decrease the indentation level.
+// functions are used to increase/decrease the indentation level.  Each
+// thread has its own indentation level.
 void logIncreaseIndent (void);
 void logDecreaseIndent (void);
 void logResetIndent (void);
-extern int logIndentLevel;
+int logGetIndent (void);
 
 // just a helper macro used by the macros below - don't use it in your code
 #define BLOG(severity) BOOST_LOG_SEV(logger::get(),boost::log::trivial::severity)
 
-#define LOG(severity) BLOG(severity) << Whitespace(logIndentLevel)
+#define LOG(severity) BLOG(severity) << Whitespace(logGetIndent())
 
 // ===== log macros =====
 #define LOG_TRACE   LOG(trace)
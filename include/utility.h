@@ -9,6 +9,8 @@
 #ifndef __UTILITY_H__
 #define __UTILITY_H__
 
+#include "CharClass.h"
+
 /**
  * Removes the extension (.XXX) from a filename, if there is one
  */
@@ -40,5 +42,6 @@ bool isOneOf (const char subject, const std::string &candidates);
  * in 'candidates'.
  */
 bool containsOnly (const std::string &subject, const std::string &candidates);
+bool containsOnly (const std::string &subject, const CharClass &candidates);
 
 #endif /* __UTILITY_H__ */
@@ -0,0 +1,209 @@
+/**
+ * @file CharClass.cpp
+ * Scans strings for characters from a small set.
+ *
+ * @copyright Copyright 2015 Anthony Tibbs
+ * This project is released under the GNU General Public License.
+*/
+
+#include <cstring>
+
+#include "CharClass.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define CHAR_CLASS_USE_SSE2
+#include <emmintrin.h>
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace {
+#ifdef CHAR_CLASS_USE_SSE2
+  /**
+   * Returns the index of the lowest set bit in a non-zero mask.
+   */
+  unsigned lowestSetBit (const unsigned mask)
+  {
+#if defined(__GNUC__)
+    return __builtin_ctz (mask);
+#elif defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward (&index, mask);
+    return index;
+#else
+    unsigned index = 0;
+    while (!(mask & (1u << index)))
+      index++;
+    return index;
+#endif
+  }
+
+  /**
+   * Scans 'data' 16 bytes at a time, comparing each block against every
+   * member of the class.  Stops at the first block holding a member, or
+   * at the last whole block.
+   *
+   * @param pos Updated to where the scan stopped
+   * @return true if a member was found (at 'pos')
+   */
+  bool findSSE2 (const char *data, const size_t length, size_t &pos,
+		 const char *members, const unsigned numMembers)
+  {
+    __m128i broadcast [CHAR_CLASS_SIMD_MEMBERS];
+    for (unsigned n = 0; n < numMembers; n++)
+      broadcast [n] = _mm_set1_epi8 (members [n]);
+
+    for (; pos + 16 <= length; pos += 16) {
+      const __m128i block = _mm_loadu_si128 (reinterpret_cast<const __m128i *>(data + pos));
+      __m128i hits = _mm_setzero_si128();
+      for (unsigned n = 0; n < numMembers; n++)
+	hits = _mm_or_si128 (hits, _mm_cmpeq_epi8 (block, broadcast [n]));
+
+      const unsigned mask = (unsigned) _mm_movemask_epi8 (hits);
+      if (mask) {
+	pos += lowestSetBit (mask);
+	return true;
+      }
+    }
+
+    return false;
+  }
+#endif
+}
+
+/* ========================= PUBLIC FUNCTIONS ============================== */
+
+/**
+ * Creates an empty set.
+ */
+CharClass::CharClass ()
+  : m_numMembers(0)
+{
+  std::memset (m_bits, 0, sizeof(m_bits));
+}
+
+/**
+ * Creates a set holding each of the characters in 'members'.
+ */
+CharClass::CharClass (const char *members)
+  : m_numMembers(0)
+{
+  std::memset (m_bits, 0, sizeof(m_bits));
+  for (; *members; members++)
+    add (*members);
+}
+
+CharClass::CharClass (const std::string &members)
+  : m_numMembers(0)
+{
+  std::memset (m_bits, 0, sizeof(m_bits));
+  add (members);
+}
+
+/**
+ * Adds a character to the set.
+ */
+CharClass &CharClass::add (const char c)
+{
+  if (contains (c))
+    return *this;
+
+  const unsigned char u = (unsigned char) c;
+  m_bits [u >> 5] |= (boost::uint32_t) 1 << (u & 31);
+  if (m_numMembers < CHAR_CLASS_SIMD_MEMBERS)
+    m_members [m_numMembers] = c;
+  m_numMembers++;
+
+  return *this;
+}
+
+/**
+ * Adds each of the characters in 'members' to the set.
+ */
+CharClass &CharClass::add (const std::string &members)
+{
+  for (size_t pos = 0; pos < members.length(); pos++)
+    add (members [pos]);
+
+  return *this;
+}
+
+/**
+ * Finds the first character of 'subject', at or after 'pos', that is in
+ * the set.
+ *
+ * @return Its position, or std::string::npos if there is none
+ */
+size_t CharClass::find (const std::string &subject, size_t pos) const
+{
+  const char *data = subject.data();
+  const size_t length = subject.length();
+
+#ifdef CHAR_CLASS_USE_SSE2
+  if (m_numMembers <= CHAR_CLASS_SIMD_MEMBERS && pos < length &&
+      findSSE2 (data, length, pos, m_members, m_numMembers))
+    return pos;
+#endif
+
+  for (; pos < length; pos++) {
+    if (contains (data [pos]))
+      return pos;
+  }
+
+  return std::string::npos;
+}
+
+/**
+ * Finds the first character of 'subject', at or after 'pos', that is not
+ * in the set.
+ *
+ * @return Its position, or std::string::npos if there is none
+ */
+size_t CharClass::findNot (const std::string &subject, size_t pos) const
+{
+  const char *data = subject.data();
+  const size_t length = subject.length();
+
+  for (; pos < length; pos++) {
+    if (!contains (data [pos]))
+      return pos;
+  }
+
+  return std::string::npos;
+}
+
+/**
+ * Returns true if every character of 'subject' is in the set (including
+ * when 'subject' is empty).
+ */
+bool CharClass::matchesAll (const std::string &subject) const
+{
+  return (findNot (subject) == std::string::npos);
+}
+
+/**
+ * Returns the members of this set that appear anywhere in 'subject', found
+ * in a single pass over it.
+ */
+CharClass CharClass::presentIn (const std::string &subject) const
+{
+  CharClass present;
+  const char *data = subject.data();
+
+  for (size_t pos = 0; pos < subject.length(); pos++) {
+    if (contains (data [pos]) && !present.contains (data [pos]))
+      present.add (data [pos]);
+  }
+
+  return present;
+}
+
+/**
+ * Returns true if the set has no members.
+ */
+bool CharClass::empty (void) const
+{
+  return (m_numMembers == 0);
+}
@@ -0,0 +1,148 @@
+/**
+ * @file LibLouisContext.cpp
+ * Process-wide use of the liblouis library
+ *
+ * @copyright Copyright 2015 Anthony Tibbs
+ * This project is released under the GNU General Public License.
+*/
+
+#include <boost/thread/lock_guard.hpp>
+
+#include "LibLouisContext.h"
+#include "logging.h"
+
+LibLouisContext::LibLouisContext ()
+  : m_dataPath("."), m_isDataPathSet(false), m_tableLoadCount(0)
+{
+}
+
+LibLouisContext::~LibLouisContext ()
+{
+  lou_free();
+}
+
+/**
+ * Returns the one liblouis context for the process.
+ */
+LibLouisContext &LibLouisContext::get (void)
+{
+  static LibLouisContext context;
+  return context;
+}
+
+/**
+ * Sets where liblouis looks for its translation tables.  Tables that have
+ * already been loaded are freed, so that they are loaded again from the
+ * new location.
+ *
+ * @param path liblouis data path (default: the current directory)
+ */
+void LibLouisContext::setDataPath (const std::string &path)
+{
+  boost::lock_guard<boost::mutex> lock (m_mutex);
+
+  if (path == m_dataPath)
+    return;
+
+  m_dataPath = path;
+  m_isDataPathSet = false;
+  m_loadedTables.clear();
+  lou_free();
+}
+
+/**
+ * Returns where liblouis looks for its translation tables.
+ */
+std::string LibLouisContext::getDataPath (void) const
+{
+  boost::lock_guard<boost::mutex> lock (m_mutex);
+  return m_dataPath;
+}
+
+/**
+ * Loads a translation table ahead of its first use, so that the time
+ * taken to compile it is not spent in the middle of rendering.
+ *
+ * @param table Name of the table to load
+ */
+void LibLouisContext::warmUp (const std::string &table)
+{
+  const ll_widechar input [] = { 'a', 0 };
+  ll_widechar output [LIBLOUIS_MAXSTRING];
+  unsigned inputLength = 1, outputLength = LIBLOUIS_MAXSTRING;
+
+  boost::lock_guard<boost::mutex> lock (m_mutex);
+
+  if (!m_loadedTables.count(table))
+    translateLocked (table, input, inputLength, output, outputLength);
+}
+
+/**
+ * Translates text to braille with lou_translateString().
+ *
+ * @param table Name of the translation table to use
+ * @param input Text to translate
+ * @param inputLength Length of the text; receives the number of
+ *        characters translated, which is less than the whole text if the
+ *        braille did not fit
+ * @param output Buffer for the braille
+ * @param outputLength Size of the buffer; receives the length of the
+ *        braille
+ * @return false if liblouis failed to translate the text
+ */
+bool LibLouisContext::translate (const std::string &table,
+				 const ll_widechar *input, unsigned &inputLength,
+				 ll_widechar *output, unsigned &outputLength)
+{
+  boost::lock_guard<boost::mutex> lock (m_mutex);
+  return translateLocked (table, input, inputLength, output, outputLength);
+}
+
+/**
+ * @copydoc LibLouisContext::translate
+ *
+ * The caller must hold m_mutex.
+ */
+bool LibLouisContext::translateLocked (const std::string &table,
+				       const ll_widechar *input, unsigned &inputLength,
+				       ll_widechar *output, unsigned &outputLength)
+{
+  if (!m_isDataPathSet) {
+    lou_setDataPath (const_cast<char *>(m_dataPath.c_str()));
+    m_isDataPathSet = true;
+  }
+
+  if (m_loadedTables.insert(table).second) {
+    LOG_TRACE << "* liblouis is loading table '" << table << "' from '" << m_dataPath << "'";
+    m_tableLoadCount++;
+  }
+
+  return (lou_translateString (table.c_str(), input, (int *)&inputLength,
+			       output, (int *)&outputLength,
+			       NULL /* no typeform checking */,
+			       NULL /* don't care about spacing info */,
+			       0 /* no modes set */) != 0);
+}
+
+/**
+ * Frees the translation tables that liblouis has loaded.  They are loaded
+ * again when they are next used.
+ */
+void LibLouisContext::release (void)
+{
+  boost::lock_guard<boost::mutex> lock (m_mutex);
+
+  m_loadedTables.clear();
+  lou_free();
+}
+
+/**
+ * Returns the number of times a translation table has been loaded (or, as
+ * far as can be told, would have been: liblouis loads a table the first
+ * time it is used after being freed).
+ */
+unsigned long LibLouisContext::getTableLoadCount (void) const
+{
+  boost::lock_guard<boost::mutex> lock (m_mutex);
+  return m_tableLoadCount;
+}
@@ -6,8 +6,15 @@
  * This project is released under the GNU General Public License.
 */
 
+#include <algorithm>
+#include <cassert>
+
 #include "MathDocument.h"
 
+MathDocumentSink::~MathDocumentSink()
+{
+}
+
 /**
  * Sets up a new, blank math document
  */
@@ -47,3 +54,41 @@ void MathDocument::addElements (const MDEVector &elements)
 {
   m_document.insert(m_document.end(), elements.begin(), elements.end());
 }
+
+/**
+ * @copydoc MathDocumentSink::addLine
+ *
+ * Collecting the lines in a MathDocument gives the same result as
+ * interpreting straight into it.
+ */
+void MathDocument::addLine (const MDEVector &elements)
+{
+  addElements (elements);
+}
+
+/**
+ * Replaces a run of elements in the document with a new series of elements,
+ * which need not be of the same length.
+ *
+ * @param [in] first Index of the first element to be replaced
+ * @param [in] count Number of elements to be replaced
+ * @param [in] elements Elements to put in their place
+ */
+void MathDocument::replaceElements (const size_t first, const size_t count,
+				    const MDEVector &elements)
+{
+  assert (first + count <= m_document.size());
+
+  // Overwrite what we can in place, and only shift the rest of the
+  // document if the number of elements changes
+  const size_t common = std::min (count, elements.size());
+  std::copy (elements.begin(), elements.begin() + common,
+	     m_document.begin() + first);
+
+  if (count > common)
+    m_document.erase (m_document.begin() + first + common,
+		      m_document.begin() + first + count);
+  else
+    m_document.insert (m_document.begin() + first + common,
+		       elements.begin() + common, elements.end());
+}
@@ -30,7 +30,7 @@ MathDocumentLine::MathDocumentLine (const std::string &source_filename,
  *
  * @return Filename associated with this line
  */
-std::string MathDocumentLine::getFilename (void) const
+const std::string &MathDocumentLine::getFilename (void) const
 {
   return m_filename;
 }
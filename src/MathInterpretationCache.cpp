@@ -0,0 +1,175 @@
+/**
+ * @file MathInterpretationCache.cpp
+ * Implementation of the cache of interpreted lines
+ *
+ * @copyright Copyright 2015 Anthony Tibbs
+ * This project is released under the GNU General Public License.
+*/
+
+#include <boost/functional/hash.hpp>
+#include <boost/thread/lock_guard.hpp>
+
+#include "MathInterpretationCache.h"
+
+// Rough memory cost of one element of a cached line.  Elements can nest
+// (fractions, groups, etc.), so this is only an estimate.
+#define ELEMENT_BYTES_ESTIMATE 128
+
+MathInterpretationCache::Statistics::Statistics ()
+  : hits(0), misses(0), evictions(0), entries(0), bytesUsed(0),
+    microsecondsSaved(0)
+{
+}
+
+/**
+ * Returns the fraction (0 to 1) of lookups that found an entry.
+ */
+double MathInterpretationCache::Statistics::getHitRate (void) const
+{
+  if (hits + misses == 0)
+    return 0;
+
+  return (double)hits / (hits + misses);
+}
+
+bool MathInterpretationCache::Key::operator== (const Key &other) const
+{
+  return (inTextBlock == other.inTextBlock &&
+	  commandSet == other.commandSet &&
+	  content == other.content);
+}
+
+size_t MathInterpretationCache::KeyHash::operator() (const Key &key) const
+{
+  size_t seed = boost::hash_value(key.content);
+  boost::hash_combine (seed, key.inTextBlock);
+  boost::hash_combine (seed, key.commandSet);
+  return seed;
+}
+
+/**
+ * Sets up an empty cache.
+ *
+ * @param maxBytes Approximate upper limit on the memory used by entries
+ */
+MathInterpretationCache::MathInterpretationCache (const size_t maxBytes)
+  : m_maxBytes(maxBytes)
+{
+}
+
+/**
+ * Looks for a previously interpreted line.
+ *
+ * @param content Content of the line
+ * @param inTextBlock Whether the line is inside a text block
+ * @param commandSet Hash of the commands registered with the interpreter
+ * @param elements Receives the elements for the line, if found
+ * @param messages Receives the messages for the line, if found; these
+ *        still carry the location of the line they were first produced for
+ * @return true if the line was found
+ */
+bool MathInterpretationCache::lookup (const std::string &content,
+				      const bool inTextBlock,
+				      const size_t commandSet,
+				      MDEVector &elements,
+				      std::vector<MathInterpreterMsg> &messages)
+{
+  Key key;
+  key.content = content;
+  key.inTextBlock = inTextBlock;
+  key.commandSet = commandSet;
+
+  boost::lock_guard<boost::mutex> lock (m_mutex);
+
+  EntryIndex::iterator it = m_index.find(key);
+  if (it == m_index.end()) {
+    m_stats.misses++;
+    return false;
+  }
+
+  // Move to the front of the LRU list
+  m_entries.splice (m_entries.begin(), m_entries, it->second);
+
+  const Entry &entry = *it->second;
+  elements.insert (elements.end(), entry.elements.begin(), entry.elements.end());
+  messages.insert (messages.end(), entry.messages.begin(), entry.messages.end());
+
+  m_stats.hits++;
+  m_stats.microsecondsSaved += entry.microseconds;
+  return true;
+}
+
+/**
+ * Adds an interpreted line to the cache, dropping the least recently used
+ * entries if that takes it over its memory limit.
+ *
+ * @param microseconds How long the line took to interpret; hits on the
+ *        entry count this much towards the time saved
+ */
+void MathInterpretationCache::store (const std::string &content,
+				     const bool inTextBlock,
+				     const size_t commandSet,
+				     const MDEVector &elements,
+				     const std::vector<MathInterpreterMsg> &messages,
+				     const unsigned long microseconds)
+{
+  Entry entry;
+  entry.key.content = content;
+  entry.key.inTextBlock = inTextBlock;
+  entry.key.commandSet = commandSet;
+  entry.elements = elements;
+  entry.messages = messages;
+  entry.microseconds = microseconds;
+
+  // The content is held twice: in the entry, and in the index
+  entry.bytes = sizeof(Entry) + 2 * content.length() +
+    elements.size() * ELEMENT_BYTES_ESTIMATE;
+  for (std::vector<MathInterpreterMsg>::const_iterator it = messages.begin();
+       it != messages.end(); ++it)
+    entry.bytes += it->getByteSize();
+
+  if (entry.bytes > m_maxBytes)
+    return;
+
+  boost::lock_guard<boost::mutex> lock (m_mutex);
+
+  // Another interpreter may have stored the same line in the meantime
+  if (m_index.count(entry.key))
+    return;
+
+  m_entries.push_front (entry);
+  m_index [entry.key] = m_entries.begin();
+  m_stats.bytesUsed += entry.bytes;
+
+  while (m_stats.bytesUsed > m_maxBytes) {
+    const Entry &oldest = m_entries.back();
+    m_stats.bytesUsed -= oldest.bytes;
+    m_stats.evictions++;
+    m_index.erase (oldest.key);
+    m_entries.pop_back();
+  }
+
+  m_stats.entries = m_entries.size();
+}
+
+/**
+ * Removes all entries (the statistics are kept).
+ */
+void MathInterpretationCache::clear (void)
+{
+  boost::lock_guard<boost::mutex> lock (m_mutex);
+
+  m_index.clear();
+  m_entries.clear();
+  m_stats.entries = 0;
+  m_stats.bytesUsed = 0;
+}
+
+/**
+ * Returns a snapshot of the cache's usage figures.
+ */
+MathInterpretationCache::Statistics MathInterpretationCache::getStatistics (void) const
+{
+  boost::lock_guard<boost::mutex> lock (m_mutex);
+  return m_stats;
+}
@@ -6,17 +6,90 @@
  * This project is released under the GNU General Public License.
 */
 
+#include <algorithm>
 #include <string>
 #include <boost/algorithm/string.hpp>
+#include <boost/bind.hpp>
+#include <boost/exception_ptr.hpp>
 #include <boost/foreach.hpp>
-#include <boost/format.hpp>
+#include <boost/functional/hash.hpp>
+#include <boost/thread.hpp>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+#include "CharClass.h"
 #include "logging.h"
 
 #include "MathExceptions.h"
+#include "MathInterpretationCache.h"
 #include "MathInterpreter.h"
 
 namespace ba = boost::algorithm;
 
+// When the thread count is automatic, each thread should have at least this
+// many lines to interpret
+#define MIN_LINES_PER_THREAD 64
+
+// Default for setMaxNestingDepth()
+#define DEFAULT_MAX_NESTING_DEPTH 1000
+
+// Message limit meaning "no limit"; see setMessageLimit()
+#define NO_MESSAGE_LIMIT ((size_t)-1)
+
+// Element limit meaning "no limit"; see setMaxElements()
+#define NO_ELEMENT_LIMIT ((size_t)-1)
+
+// The deadline (see setDeadline()) is checked once every this many items
+// interpreted, since reading the clock costs more than most items do
+#define DEADLINE_CHECK_INTERVAL 256
+
+namespace {
+  // Characters that end an item (a semi-colon is also skipped); see
+  // extractItem()
+  const CharClass ITEM_TERMINATORS (",+/*=<>()[]{} ~@#!;");
+
+  // ... and after an item's first character, a minus sign as well
+  const CharClass ITEM_TERMINATORS_AFTER_FIRST = CharClass(ITEM_TERMINATORS).add ('-');
+
+  // Characters that suggest a text block holds math; see sniffTextForMath()
+  const CharClass SUSPECT_MATH_CHARS ("@~#<>=_^|");
+
+  // Characters that mean anything in text mode: mode changes, and the '$$'
+  // that begins a command; see interpretNextItem()
+  const CharClass TEXT_MODE_CHARS ("$&");
+
+  /**
+   * Returns true if 'mdl' switches between text and math blocks ('&&' while
+   * in a math block, or '$$' while in a text block).
+   */
+  bool togglesBlockMode (const MathDocumentLine &mdl, const bool inTextBlock)
+  {
+    const std::string content = mdl.getContent();
+    return (inTextBlock ? content == "$$" : content == "&&");
+  }
+
+  /**
+   * Determines whether a line is an '&&' or '$$' that repeats the current
+   * block mode: the only kind of line whose interpretation depends on
+   * where the block began (which its warning names).
+   */
+  bool repeatsBlockMode (const MathDocumentLine &mdl, const bool inTextBlock)
+  {
+    const std::string content = mdl.getContent();
+    return (inTextBlock ? content == "&&" : content == "$$");
+  }
+
+  /**
+   * Creates the MDE_SourceLine element that precedes a line's elements in
+   * the document.
+   */
+  MathDocumentElementPtr makeSourceLine (const MathDocumentLine &mdl)
+  {
+    return boost::make_shared<MDE_SourceLine>(mdl.getFilename(),
+					      mdl.getStartLineNumber(),
+					      mdl.getEndLineNumber(),
+					      mdl.getContent());
+  }
+}
+
 /* ========================= PUBLIC FUNCTION =============================== */
 
 /**
@@ -27,15 +100,53 @@ namespace ba = boost::algorithm;
  */
 MathInterpreter::MathInterpreter (const MathSourceFile &srcFile,
 				  MathDocument &targetDoc)
-  : m_src(srcFile), m_doc(targetDoc)
+  : m_src(srcFile), m_doc(targetDoc), m_pCurLine(NULL),
+    m_recursionLevel(0), m_recoverFromErrors(false), m_lineFailed(false),
+    m_maxNestingDepth(DEFAULT_MAX_NESTING_DEPTH),
+    m_maxElements(NO_ELEMENT_LIMIT), m_numLineElements(0), m_stepsToDeadlineCheck(0),
+    m_numThreads(0), m_docOffset(0), m_msgOffset(0),
+    m_messageLimit(NO_MESSAGE_LIMIT), m_foldMessages(false)
 {
 }
 
+/**
+ * Work item for a single source line.  The block mode in effect at the
+ * start of the line is settled by scanBlockModes() before any line is
+ * interpreted; the results are filled in by whichever worker claims it.
+ */
+struct MathInterpreter::LineJob {
+  LineJob () : line(NULL), inTextBlock(false), blockBeganLineNum(1) {}
+
+  const MathDocumentLine *line;
+  bool inTextBlock;
+  unsigned long blockBeganLineNum;
+
+  MDEVector elements;
+  std::vector<MathInterpreterMsg> messages;
+  boost::exception_ptr error;
+};
+
+/**
+ * Lines waiting to be interpreted.  Workers claim the next unclaimed line
+ * as soon as they finish their previous one, so a few expensive lines do
+ * not hold up an otherwise idle thread.
+ */
+struct MathInterpreter::LineQueue {
+  LineQueue (std::vector<LineJob> &j)
+    : jobs(j), nextJob(0), firstFailure(j.size()) {}
+
+  std::vector<LineJob> &jobs;
+  boost::mutex mutex;
+  size_t nextJob;
+  size_t firstFailure; // lines past a failed one need not be interpreted
+};
+
 
 /**
  * Interprets a source document
  *
- * @throw MathInterpreterException when parse or interpretation errors arise
+ * @throw MathInterpreterException when parse or interpretation errors arise,
+ *        unless error recovery is enabled
  */
 void MathInterpreter::interpret (void)
 {
@@ -48,14 +159,37 @@ void MathInterpreter::interpret (void)
   m_blockBeganLineNum = 1;
 
   const std::vector<MathDocumentLine> &srcDoc = m_src.getDocument();
-  for (std::vector<MathDocumentLine>::const_iterator it = srcDoc.begin();
-       it != srcDoc.end(); ++it) {
+  std::vector<LineJob> jobs (srcDoc.size());
+  scanBlockModes (jobs);
+
+  m_lineStates.clear();
+  m_docOffset = m_doc.getDocument().size();
+  m_msgOffset = m_messages.size();
+  restartMessageCounts();
+
+  interpretJobs (jobs, getThreadCountFor (jobs.size()));
+
+  // Merge the results in source order.  If a line failed, everything up to
+  // and including its messages is kept, exactly as if the lines had been
+  // interpreted one after another.
+  for (std::vector<LineJob>::iterator it = jobs.begin();
+       it != jobs.end(); ++it) {
+    m_doc.addElementPtr (makeSourceLine (*it->line));
+    m_doc.addElements (it->elements);
+    publishMessages (it->messages);
+
+    if (it->error) {
+      m_lineStates.clear();
+      logDecreaseIndent();
+      boost::rethrow_exception (it->error);
+    }
 
-    m_doc.addElementPtr (boost::make_shared<MDE_SourceLine>(it->getFilename(),
-							    it->getStartLineNumber(),
-							    it->getEndLineNumber(),
-							    it->getContent()));
-    interpretLine(*it);
+    LineState state;
+    state.inTextBlock = it->inTextBlock;
+    state.blockBeganLineNum = it->blockBeganLineNum;
+    state.numElements = it->elements.size() + 1;
+    m_lineStates.push_back (state);
+    m_lineStates.back().messages.swap (it->messages);
   }
 
   logDecreaseIndent();
@@ -70,6 +204,68 @@ void MathInterpreter::interpret (void)
   }
 }
 
+/**
+ * Interprets a source document, passing each line to 'sink' as soon as it
+ * has been interpreted instead of adding it to the document.  Lines are
+ * delivered in order, and only a limited number of them are held in memory
+ * at any time, however long the document is.
+ *
+ * Since no document is kept, reinterpretLines() cannot be used to update
+ * the results afterwards.
+ *
+ * @param sink Receives the interpreted lines
+ * @throw MathInterpreterException when parse or interpretation errors arise,
+ *        unless error recovery is enabled; the lines before the one that
+ *        failed, and the failed line's MDE_SourceLine, have been delivered
+ */
+void MathInterpreter::interpret (MathDocumentSink &sink)
+{
+  LOG_TRACE << "enter MathInterpreter::interpret(sink)";
+  logIncreaseIndent();
+
+  m_inTextMode = false;
+  m_inTextBlock = false;
+  m_blockBeganLineNum = 1;
+  m_lineStates.clear();
+  m_msgOffset = m_messages.size();
+  restartMessageCounts();
+
+  const std::vector<MathDocumentLine> &srcDoc = m_src.getDocument();
+  std::vector<LineJob> jobs (srcDoc.size());
+  scanBlockModes (jobs);
+
+  // Lines are interpreted a batch at a time, with each thread getting
+  // roughly its minimum share of a batch, so that the first lines reach
+  // the sink quickly and memory use does not grow with the document
+  const size_t numThreads = getThreadCountFor (jobs.size());
+  const size_t batchSize = std::max<size_t> (numThreads, 1) * MIN_LINES_PER_THREAD;
+
+  for (size_t first = 0; first < jobs.size(); first += batchSize) {
+    const size_t last = std::min (first + batchSize, jobs.size());
+    std::vector<LineJob> batch (jobs.begin() + first, jobs.begin() + last);
+    interpretJobs (batch, std::min (numThreads, batch.size()));
+
+    for (std::vector<LineJob>::const_iterator it = batch.begin();
+	 it != batch.end(); ++it) {
+      MDEVector elements;
+      elements.reserve (it->elements.size() + 1);
+      elements.push_back (makeSourceLine (*it->line));
+      elements.insert (elements.end(), it->elements.begin(), it->elements.end());
+      publishMessages (it->messages);
+
+      sink.addLine (elements);
+
+      if (it->error) {
+	logDecreaseIndent();
+	boost::rethrow_exception (it->error);
+      }
+    }
+  }
+
+  logDecreaseIndent();
+  LOG_TRACE << "exit MathInterpreter::interpret(sink)";
+}
+
 /**
  * Called, typically by a renderer, to add a command to the 'known' commands
  * list.
@@ -77,7 +273,7 @@ void MathInterpreter::interpret (void)
 void MathInterpreter::registerCommand (const std::string &cmd)
 {
   assert (!isCommand(cmd));
-  m_knownCommands.push_back(cmd);
+  m_knownCommands.insert(cmd);
   LOG_TRACE << "MathInterpreter::registerCommand(" << cmd << ")";
 }
 
@@ -94,7 +290,397 @@ void MathInterpreter::registerCommands (const std::vector<std::string> &commands
  */
 bool MathInterpreter::isCommand (const std::string &cmd) const
 {
-  return (std::count(m_knownCommands.begin(), m_knownCommands.end(), cmd) == 1);
+  return (m_knownCommands.count(cmd) == 1);
+}
+
+/**
+ * Sets the number of threads used to interpret the lines of a document.
+ *
+ * @param numThreads Number of worker threads; 0 (the default) uses up to
+ *        one per hardware thread, 1 interprets the document on the
+ *        calling thread
+ */
+void MathInterpreter::setThreadCount (const unsigned numThreads)
+{
+  m_numThreads = numThreads;
+}
+
+/**
+ * Sets whether interpretation carries on after an error.
+ *
+ * Normally the first error (an unterminated fraction, an unknown command,
+ * etc.) stops interpretation with a MathInterpreterException.  With error
+ * recovery enabled, no exception is thrown: the error is still reported
+ * as a message, the rest of the offending line is placed in the document
+ * as an MDE_Error element, and interpretation resumes with the next line.
+ * This finds every error in a document in a single pass.
+ *
+ * @param recover true to recover from errors, false (the default) to stop
+ *        at the first one
+ */
+void MathInterpreter::setErrorRecovery (const bool recover)
+{
+  m_recoverFromErrors = recover;
+}
+
+/**
+ * Sets how deeply groups, fractions, roots, etc. may be nested inside one
+ * another.  A construct nested more deeply is reported as an error, which
+ * keeps pathological input from exhausting memory.  The limit is also
+ * worth matching to the renderers' (see MathRenderer::setMaxNestingDepth()),
+ * which do recurse.
+ *
+ * @param maxDepth Deepest nesting allowed (1000 by default)
+ */
+void MathInterpreter::setMaxNestingDepth (const unsigned long maxDepth)
+{
+  m_maxNestingDepth = maxDepth;
+}
+
+/**
+ * Limits the number of elements (numbers, operators, groups, etc.) that a
+ * single line may be interpreted into, counting those nested in groups,
+ * fractions, etc.  A line with more is reported as an error, like any
+ * other, once the limit is reached, so a huge line of untrusted input
+ * cannot tie up the interpreter or exhaust memory.
+ *
+ * @param maxElements Most elements allowed in a line; by default there is
+ *        no limit
+ */
+void MathInterpreter::setMaxElements (const size_t maxElements)
+{
+  m_maxElements = maxElements;
+}
+
+/**
+ * Sets a time by which interpretation must be finished.  The clock is
+ * checked as lines are interpreted, every so often, and once the deadline
+ * has passed interpretation stops with a TIME_LIMIT_EXCEEDED message and
+ * a MathInterpreterException, even if error recovery is enabled.
+ *
+ * @param deadline Time (in UTC) by which to finish; not_a_date_time (the
+ *        default) for no deadline
+ */
+void MathInterpreter::setDeadline (const boost::posix_time::ptime &deadline)
+{
+  m_deadline = deadline;
+}
+
+/**
+ * Brings the document and messages up to date after some lines of the
+ * source file have been changed (see MathSourceFile::replaceLine()),
+ * re-interpreting only the lines that need it.
+ *
+ * Besides the changed lines themselves, this includes any following lines
+ * whose block mode changes because an '&&' or '$$' line was added or
+ * removed, up to the point where the old and new block modes agree again.
+ * Lines whose mode is unchanged are only re-interpreted if they are an
+ * '&&' or '$$' in a block that now begins elsewhere.
+ *
+ * If no successful interpret() has been done, or if one of the lines
+ * cannot be interpreted, the whole document is interpreted again.
+ *
+ * @param changedLines Indexes (into MathSourceFile::getDocument()) of the
+ *        lines that have changed
+ * @throw MathInterpreterException when parse or interpretation errors arise
+ */
+void MathInterpreter::reinterpretLines (const std::vector<size_t> &changedLines)
+{
+  const std::vector<MathDocumentLine> &srcDoc = m_src.getDocument();
+
+  if (m_lineStates.size() != srcDoc.size()) {
+    LOG_TRACE << "* no previous interpretation to update";
+    discardResults();
+    interpret();
+    return;
+  }
+
+  std::vector<size_t> changed (changedLines);
+  std::sort (changed.begin(), changed.end());
+  changed.erase (std::unique(changed.begin(), changed.end()), changed.end());
+  if (changed.empty())
+    return;
+
+  LOG_TRACE << "enter MathInterpreter::reinterpretLines (" << changed.size() << " changed)";
+  logIncreaseIndent();
+
+  // Work out which lines need to be interpreted again, and in which block
+  // mode.  Once an unchanged line starts in the same mode as before, in a
+  // block that began at the same line, the lines after it are unaffected
+  // until the next changed line.
+  std::vector<LineJob> jobs;
+  std::vector<size_t> jobLines;
+  std::vector<size_t>::const_iterator nextChanged = changed.begin();
+  size_t n = *nextChanged;
+  bool inTextBlock = m_lineStates [n].inTextBlock;
+  unsigned long blockBeganLineNum = m_lineStates [n].blockBeganLineNum;
+
+  assert (changed.back() < srcDoc.size());
+  while (n < srcDoc.size()) {
+    const bool isChanged = (nextChanged != changed.end() && *nextChanged == n);
+    if (isChanged)
+      ++nextChanged;
+
+    const LineState &state = m_lineStates [n];
+    if (!isChanged && state.inTextBlock == inTextBlock &&
+	state.blockBeganLineNum == blockBeganLineNum) {
+      if (nextChanged == changed.end())
+	break;
+
+      n = *nextChanged;
+      inTextBlock = m_lineStates [n].inTextBlock;
+      blockBeganLineNum = m_lineStates [n].blockBeganLineNum;
+      continue;
+    }
+
+    if (isChanged || state.inTextBlock != inTextBlock ||
+	repeatsBlockMode(srcDoc [n], inTextBlock)) {
+      LineJob job;
+      job.line = &srcDoc [n];
+      job.inTextBlock = inTextBlock;
+      job.blockBeganLineNum = blockBeganLineNum;
+      jobs.push_back (job);
+      jobLines.push_back (n);
+    } else {
+      // Only where its block began has changed, which this line does not
+      // depend on
+      m_lineStates [n].blockBeganLineNum = blockBeganLineNum;
+    }
+
+    if (togglesBlockMode(srcDoc [n], inTextBlock)) {
+      inTextBlock = !inTextBlock;
+      blockBeganLineNum = srcDoc [n].getStartLineNumber();
+    }
+    n++;
+  }
+
+  LOG_TRACE << "* re-interpreting " << jobs.size() << " lines";
+  LineQueue queue (jobs);
+  runLineJobs (queue);
+
+  for (std::vector<LineJob>::const_iterator it = jobs.begin();
+       it != jobs.end(); ++it) {
+    if (it->error) {
+      LOG_TRACE << "* line could not be interpreted; starting over";
+      logDecreaseIndent();
+      discardResults();
+      interpret();
+      return;
+    }
+  }
+
+  // Find where each line's elements start in the document
+  std::vector<size_t> offsets (srcDoc.size());
+  size_t offset = m_docOffset;
+  for (size_t line = 0; line < srcDoc.size(); line++) {
+    offsets [line] = offset;
+    offset += m_lineStates [line].numElements;
+  }
+
+  // Splice in runs of consecutive lines, last run first, so that the
+  // offsets of the runs still to be done stay valid
+  size_t runEnd = jobs.size();
+  while (runEnd > 0) {
+    size_t runBegin = runEnd - 1;
+    while (runBegin > 0 && jobLines [runBegin - 1] + 1 == jobLines [runBegin])
+      runBegin--;
+
+    MDEVector elements;
+    size_t oldCount = 0;
+    for (size_t j = runBegin; j < runEnd; j++) {
+      LineJob &job = jobs [j];
+      LineState &state = m_lineStates [jobLines [j]];
+
+      elements.push_back (makeSourceLine (*job.line));
+      elements.insert (elements.end(), job.elements.begin(), job.elements.end());
+
+      oldCount += state.numElements;
+      state.inTextBlock = job.inTextBlock;
+      state.blockBeganLineNum = job.blockBeganLineNum;
+      state.numElements = job.elements.size() + 1;
+      state.messages.swap (job.messages);
+    }
+
+    m_doc.replaceElements (offsets [jobLines [runBegin]], oldCount, elements);
+    runEnd = runBegin;
+  }
+
+  m_messages.erase (m_messages.begin() + m_msgOffset, m_messages.end());
+  restartMessageCounts();
+  for (std::vector<LineState>::const_iterator it = m_lineStates.begin();
+       it != m_lineStates.end(); ++it)
+    publishMessages (it->messages);
+
+  logDecreaseIndent();
+  LOG_TRACE << "exit MathInterpreter::reinterpretLines";
+}
+
+/**
+ * Works out how many threads to use for interpreting 'numLines' lines.
+ */
+size_t MathInterpreter::getThreadCountFor (const size_t numLines) const
+{
+  // Starting a thread costs more than interpreting a typical line, so when
+  // left to decide, only bring in extra threads for longer documents.
+  size_t numThreads = m_numThreads;
+  if (numThreads == 0) {
+    numThreads = std::min<size_t> (boost::thread::hardware_concurrency(),
+				   numLines / MIN_LINES_PER_THREAD);
+  }
+
+  return std::min (numThreads, numLines);
+}
+
+/**
+ * Interprets each of 'jobs', on the calling thread or spread across
+ * 'numThreads' worker threads.
+ */
+void MathInterpreter::interpretJobs (std::vector<LineJob> &jobs,
+				     const size_t numThreads) const
+{
+  LineQueue queue (jobs);
+  if (numThreads <= 1) {
+    runLineJobs (queue);
+  } else {
+    LOG_TRACE << "* interpreting " << jobs.size() << " lines on " << numThreads << " threads";
+
+    boost::thread_group workers;
+    for (size_t n = 0; n < numThreads; n++)
+      workers.create_thread (boost::bind(&MathInterpreter::runLineJobs, this, boost::ref(queue)));
+    workers.join_all();
+  }
+}
+
+/**
+ * Determines the block mode in effect at the start of each line.
+ *
+ * Text and math blocks (toggled by '&&' and '$$' lines) are the only state
+ * carried from one line to the next, so settling them in a quick
+ * sequential pass lets the lines themselves be interpreted in any order.
+ * The switch lines are still handled, and warned about, by interpretLine().
+ */
+void MathInterpreter::scanBlockModes (std::vector<LineJob> &jobs) const
+{
+  const std::vector<MathDocumentLine> &srcDoc = m_src.getDocument();
+  bool inTextBlock = m_inTextBlock;
+  unsigned long blockBeganLineNum = m_blockBeganLineNum;
+
+  assert (jobs.size() == srcDoc.size());
+  for (size_t n = 0; n < srcDoc.size(); n++) {
+    const MathDocumentLine &mdl = srcDoc [n];
+    LineJob &job = jobs [n];
+
+    job.line = &mdl;
+    job.inTextBlock = inTextBlock;
+    job.blockBeganLineNum = blockBeganLineNum;
+
+    if (togglesBlockMode(mdl, inTextBlock)) {
+      inTextBlock = !inTextBlock;
+      blockBeganLineNum = mdl.getStartLineNumber();
+    }
+  }
+}
+
+/**
+ * Worker loop: claims lines from 'queue' one at a time and interprets them
+ * until none are left.  Each worker uses its own interpreter so that the
+ * per-line state and messages are never shared between threads.
+ */
+void MathInterpreter::runLineJobs (LineQueue &queue) const
+{
+  MathInterpreter worker (m_src, m_doc);
+  worker.m_knownCommands = m_knownCommands;
+  worker.m_cache = m_cache;
+  worker.m_recoverFromErrors = m_recoverFromErrors;
+  worker.m_maxNestingDepth = m_maxNestingDepth;
+  worker.m_maxElements = m_maxElements;
+  worker.m_deadline = m_deadline;
+
+  const size_t commandSet = (m_cache ? getCommandSetHash() : 0);
+
+  for (;;) {
+    size_t n;
+    {
+      boost::lock_guard<boost::mutex> lock (queue.mutex);
+      if (queue.nextJob >= queue.jobs.size() || queue.nextJob > queue.firstFailure)
+	return;
+      n = queue.nextJob++;
+    }
+
+    LineJob &job = queue.jobs [n];
+    worker.m_inTextBlock = job.inTextBlock;
+    worker.m_blockBeganLineNum = job.blockBeganLineNum;
+
+    try {
+      if (!worker.interpretLineFromCache (*job.line, job.elements, commandSet))
+	worker.interpretLine (*job.line, job.elements);
+    } catch (...) {
+      job.error = boost::current_exception();
+
+      boost::lock_guard<boost::mutex> lock (queue.mutex);
+      queue.firstFailure = std::min (queue.firstFailure, n);
+    }
+
+    job.messages.swap (worker.m_messages);
+    worker.m_messages.clear();
+  }
+}
+
+/**
+ * Removes everything this interpreter has added to the document and the
+ * messages list, ready for the document to be interpreted from scratch.
+ */
+void MathInterpreter::discardResults (void)
+{
+  m_doc.replaceElements (m_docOffset, m_doc.getDocument().size() - m_docOffset,
+			 MDEVector());
+  m_messages.erase (m_messages.begin() + m_msgOffset, m_messages.end());
+  restartMessageCounts();
+  m_lineStates.clear();
+}
+
+/**
+ * Limits the number of messages kept for each message code.  Past the
+ * limit, messages with that code are only counted (see
+ * getSuppressedMessageCount()), which keeps a document with thousands of
+ * instances of the same problem cheap to report on.
+ *
+ * Limits apply to each interpretation of the document (each interpret(),
+ * and the whole document again after reinterpretLines()).
+ *
+ * @param maxMessages Most messages kept for any code without a limit of its
+ *        own; by default there is no limit
+ */
+void MathInterpreter::setMessageLimit (const size_t maxMessages)
+{
+  m_messageLimit = maxMessages;
+}
+
+/**
+ * Limits the number of messages kept with a particular code, overriding
+ * the limit for all codes.
+ *
+ * @param code Message code to limit
+ * @param maxMessages Most messages with 'code' kept
+ */
+void MathInterpreter::setMessageLimit (const MathInterpreterMsg::Code code,
+				       const size_t maxMessages)
+{
+  m_codeMessageLimits [code] = maxMessages;
+}
+
+/**
+ * Sets whether identical messages (the same code and details, for
+ * different lines) are folded together.  If so, only the first one is
+ * kept, and MathInterpreterMsg::getRepeatCount() says how many more there
+ * were.  Folded messages do not count towards the message limits.
+ *
+ * @param fold true to fold identical messages, false (the default) to keep
+ *        them all
+ */
+void MathInterpreter::setMessageFolding (const bool fold)
+{
+  m_foldMessages = fold;
 }
 
 /**
@@ -113,15 +699,107 @@ const std::vector<MathInterpreterMsg> &MathInterpreter::getMessages (void) const
   return m_messages;
 }
 
+/**
+ * Returns the number of messages left out because of the message limits
+ * (see setMessageLimit()).
+ */
+size_t MathInterpreter::getSuppressedMessageCount (void) const
+{
+  size_t count = 0;
+  for (std::map<MathInterpreterMsg::Code, size_t>::const_iterator it = m_suppressedCounts.begin();
+       it != m_suppressedCounts.end(); ++it)
+    count += it->second;
+
+  return count;
+}
+
+/**
+ * Returns the number of messages with 'code' left out because of the
+ * message limits.
+ */
+size_t MathInterpreter::getSuppressedMessageCount (const MathInterpreterMsg::Code code) const
+{
+  std::map<MathInterpreterMsg::Code, size_t>::const_iterator it = m_suppressedCounts.find (code);
+  return (it != m_suppressedCounts.end() ? it->second : 0);
+}
+
+/**
+ * Sets a cache of interpreted lines, which may be shared with other
+ * interpreters.  Lines found in the cache are not interpreted again, and
+ * lines that are interpreted are added to it.
+ *
+ * @param cache The cache to use, or an empty pointer for none
+ */
+void MathInterpreter::setCache (const boost::shared_ptr<MathInterpretationCache> &cache)
+{
+  m_cache = cache;
+}
+
+/**
+ * Returns a hash identifying the set of registered commands and the
+ * nesting and element limits, which can change how a line is interpreted.
+ */
+size_t MathInterpreter::getCommandSetHash (void) const
+{
+  std::vector<std::string> commands (m_knownCommands.begin(), m_knownCommands.end());
+  std::sort (commands.begin(), commands.end());
+  size_t hash = boost::hash_range (commands.begin(), commands.end());
+  boost::hash_combine (hash, m_maxNestingDepth);
+  boost::hash_combine (hash, m_maxElements);
+  return hash;
+}
+
+/**
+ * Interprets a single line using the cache of interpreted lines, if there
+ * is one: the results are taken from the cache if the line has been seen
+ * before, and are otherwise worked out and added to it.
+ *
+ * Block mode switches ('&&' and '$$') are cheap to interpret and depend on
+ * more than the line itself, so they are never cached.
+ *
+ * @return false if there is no cache or the line cannot be cached, in
+ *         which case nothing has been done
+ */
+bool MathInterpreter::interpretLineFromCache (const MathDocumentLine &mdl,
+					      MDEVector &elements,
+					      const size_t commandSet)
+{
+  const std::string content = mdl.getContent();
+  if (!m_cache || content == "&&" || content == "$$")
+    return false;
+
+  if (m_cache->lookup(content, m_inTextBlock, commandSet, elements, m_messages)) {
+    LOG_TRACE << "* interpretation of (" << content << ") found in cache";
+    for (std::vector<MathInterpreterMsg>::iterator it = m_messages.begin();
+	 it != m_messages.end(); ++it)
+      it->setLocation (getFilenameRef(mdl), mdl.getStartLineNumber(), mdl.getEndLineNumber());
+
+    return true;
+  }
+
+  boost::posix_time::ptime started = boost::posix_time::microsec_clock::universal_time();
+  interpretLine (mdl, elements);
+  boost::posix_time::time_duration elapsed = boost::posix_time::microsec_clock::universal_time() - started;
+
+  // A line that only got through because errors are being recovered from
+  // must not be handed to an interpreter that expects an exception
+  if (m_lineFailed)
+    return true;
+
+  m_cache->store (content, m_inTextBlock, commandSet, elements, m_messages,
+		  elapsed.total_microseconds());
+  return true;
+}
+
 /**
  * Interprets a single line in the document
  *
  * @param mdl A single line in the document
+ * @param elements Receives the elements making up the line
  */
-void MathInterpreter::interpretLine (const MathDocumentLine &mdl)
+void MathInterpreter::interpretLine (const MathDocumentLine &mdl,
+				     MDEVector &elements)
 {
-  MDEVector elements;
-
   LOG_TRACE << "enter MathInterpreter::interpretLine(" << mdl << ")";
   logIncreaseIndent();
 
@@ -131,6 +809,7 @@ void MathInterpreter::interpretLine (const MathDocumentLine &mdl)
   /* Set defaults for this line */
   m_inTextMode = m_inTextBlock;
   m_isStartOfLine = true;
+  m_lineFailed = false;
 
   /*
    * MAIN MODE SWITCHES
@@ -142,9 +821,9 @@ void MathInterpreter::interpretLine (const MathDocumentLine &mdl)
       m_inTextMode = true;
       m_blockBeganLineNum  = mdl.getStartLineNumber();
 
-      m_doc.addElementPtr (boost::make_shared<MDE_TextModeMarker>(MDE_TextModeMarker::BLOCK_MARKER));
+      elements.push_back (boost::make_shared<MDE_TextModeMarker>(MDE_TextModeMarker::BLOCK_MARKER));
     } else {
-      MSG_WARNING(NESTED_TEXT_MODE, boost::str(boost::format("text block began at line %u") % m_blockBeganLineNum));
+      MSG_WARNING(NESTED_TEXT_MODE, MSG_DETAIL("text block began at line %u") % m_blockBeganLineNum);
     }
 
     goto EOL;
@@ -156,9 +835,9 @@ void MathInterpreter::interpretLine (const MathDocumentLine &mdl)
       m_inTextBlock = false;
       m_inTextMode = false;
       m_blockBeganLineNum = mdl.getStartLineNumber();
-      m_doc.addElementPtr (boost::make_shared<MDE_MathModeMarker>(MDE_MathModeMarker::BLOCK_MARKER));
+      elements.push_back (boost::make_shared<MDE_MathModeMarker>(MDE_MathModeMarker::BLOCK_MARKER));
     } else {
-      MSG_WARNING(NESTED_MATH_MODE, boost::str(boost::format("math block began at line %u") % m_blockBeganLineNum));
+      MSG_WARNING(NESTED_MATH_MODE, MSG_DETAIL("math block began at line %u") % m_blockBeganLineNum);
     }
 
     goto EOL;
@@ -175,8 +854,6 @@ void MathInterpreter::interpretLine (const MathDocumentLine &mdl)
   }
   LOG_TRACE << "--------------------------";
 
-  m_doc.addElements(elements);
-
  EOL:
   logDecreaseIndent();
   LOG_TRACE << "exit MathInterpreter::interpretLine";
@@ -185,125 +862,323 @@ void MathInterpreter::interpretLine (const MathDocumentLine &mdl)
 /**
  * Interprets the selected text and returns an array of
  * document elements.
+ *
+ * Constructs with nested buffers (groups, fractions, etc.) are not
+ * interpreted recursively: the buffers being worked on are kept on an
+ * explicit stack, m_frames.  The buffer at the top of the stack is
+ * interpreted one item at a time; when an item turns out to have nested
+ * buffers (see interpretNested()), each of them is pushed onto the stack
+ * and interpreted in turn, and the construct is then built from the
+ * results.  The depth of nesting is therefore limited only by
+ * setMaxNestingDepth(), not by the size of the call stack.
  */
-#define PUSH_CATCH_BUFFER { if (!boost::trim_copy(catch_buffer).empty()) { elements.push_back (makeGeneric(catch_buffer)); } catch_buffer.erase(); }
-
-#define ATTEMPT(class) { if (interpret##class (temp_elements, buffer, i)) { PUSH_CATCH_BUFFER; elements.insert (elements.end(), temp_elements.begin(), temp_elements.end()); goto NextChar; } }
-
 MDEVector MathInterpreter::interpretBuffer (const std::string &buffer)
 {
-  static unsigned long interpreter_recursion_level = 0;
-  std::string catch_buffer;
   MDEVector elements;
 
-  interpreter_recursion_level++;
-  LOG_TRACE << "enter interpretBuffer lvl " << interpreter_recursion_level << " (" << buffer << ")";
-  logIncreaseIndent();
+  // Nothing more is interpreted on a line once an error has been found
+  if (m_lineFailed)
+    return elements;
+
+  // An exception from the last line may have left buffers on the stack
+  m_recursionLevel = 0;
+  m_numLineElements = 0;
+  std::string lineBuffer (buffer);
+  enterBuffer (lineBuffer);
+
+  for (;;) {
+    BufferFrame &frame = m_frames [m_recursionLevel - 1];
+    const size_t numNested = frame.nestedElements.size();
+
+    if (m_lineFailed) {
+      // Recovering from an error: keep what was interpreted before the
+      // failed construct and skip the rest.  The outermost buffer holds
+      // everything that the nested ones were working on, so it records
+      // what was skipped.
+      flushCatchBuffer (frame);
+      if (m_recursionLevel == 1) {
+	LOG_TRACE << "* abandoning line at pos " << frame.constructStart;
+	frame.elements.push_back (boost::make_shared<MDE_Error>(frame.buffer.substr(frame.constructStart)));
+      }
+    } else if (numNested < frame.nestedBuffers.size()) {
+      // Interpret the next buffer nested in the current construct.  Note
+      // that 'frame' does not survive enterBuffer().
+      std::string nested;
+      nested.swap (frame.nestedBuffers [numNested]);
+      enterBuffer (nested);
+      continue;
+    } else if (numNested > 0) {
+      // ... and once they are all done, add the construct itself
+      flushCatchBuffer (frame);
+      frame.elements.push_back (frame.make (frame.nestedElements));
+      frame.nestedBuffers.clear();
+      frame.nestedElements.clear();
+      countElements (frame, 1);
+      continue;
+    } else if (frame.pos < frame.buffer.length()) {
+      checkDeadline();
+
+      const size_t numElements = frame.elements.size();
+      interpretNextItem (frame);
+      countElements (frame, frame.elements.size() - numElements);
+      continue;
+    } else
+      flushCatchBuffer (frame);
+
+    // This buffer is finished: hand its elements to the construct that it
+    // is nested in, if any
+    m_recursionLevel--;
+    logDecreaseIndent();
+    LOG_TRACE << "exit interpretBuffer";
+
+    if (m_recursionLevel == 0) {
+      elements.swap (frame.elements);
+      break;
+    }
 
-  for (size_t i = 0; i < buffer.length(); /* i++ done below */) {
-    MDEVector temp_elements;
+    BufferFrame &outer = m_frames [m_recursionLevel - 1];
+    outer.nestedElements.push_back (MDEVector());
+    outer.nestedElements.back().swap (frame.elements);
+  }
 
-    char c = buffer[i];
-    LOG_TRACE << "At pos " << i << ", char '" << c << "', " << (m_inTextBlock ? "T" : "M") << (m_inTextMode ? "t" : "m");
-    logIncreaseIndent();
+  return elements;
+}
 
-    if (m_isStartOfLine) {
-      ATTEMPT(Command);
-    }
+/**
+ * Counts elements added to 'frame' towards the limit on elements per line
+ * (see setMaxElements()), giving up on the line once it is exceeded.
+ *
+ * @return false if the limit has been exceeded
+ * @throw MathInterpreterException if the limit has been exceeded and
+ *        error recovery is not enabled
+ */
+bool MathInterpreter::countElements (BufferFrame &frame, const size_t numElements)
+{
+  m_numLineElements += numElements;
+  if (m_lineFailed || m_numLineElements <= m_maxElements)
+    return true;
 
-    /**
-     * Mode changes: text to math or math to text. Dump what we have up to
-     * this point whenever there is a mode change.
-     */
-    if (c == '$') {
-      // Do not consider `$ to be a math mode change: this is a dollar sign
-      if (!m_inTextMode && i > 0 && buffer [i - 1] == '`')
-        goto DefaultAction;
-
-      if (m_inTextMode) {
-	      LOG_TRACE << "* entering math mode; pushing '" << catch_buffer << "'";
-	      PUSH_CATCH_BUFFER;
-	      m_inTextMode = false;
-	      elements.push_back (boost::make_shared<MDE_MathModeMarker>(MDE_MathModeMarker::SEGMENT_MARKER));
-      } else {
-	      LOG_TRACE << "! attempt to enter math mode while in math mode";
-	      MSG_WARNINGX(NESTED_MATH_MODE);
-      }
+  // The line is skipped from here on, whichever buffer this is
+  frame.constructStart = frame.pos;
+  MSG_ERROR(TOO_MANY_ELEMENTS, MSG_DETAIL("more than %u elements") % m_maxElements);
+  INTERPRET_FAIL();
+}
 
-      goto AdvanceNextChar;
-    }
+/**
+ * Stops interpretation if the deadline (see setDeadline()) has passed.
+ * The clock is only read every DEADLINE_CHECK_INTERVAL calls.
+ *
+ * @throw MathInterpreterException if the deadline has passed
+ */
+void MathInterpreter::checkDeadline (void)
+{
+  if (m_deadline.is_special() || m_stepsToDeadlineCheck-- > 0)
+    return;
 
-    if (c == '&') {
-      if (!m_inTextMode) {
-        LOG_TRACE << "* entering text mode; pushing '" << catch_buffer << "'";
-        PUSH_CATCH_BUFFER;
-        m_inTextMode = true;
-        elements.push_back(boost::make_shared<MDE_TextModeMarker>(MDE_TextModeMarker::SEGMENT_MARKER));
-      }
-      else {
-        LOG_TRACE << "! attempt to enter math mode while in text mode";
-        MSG_WARNINGX(NESTED_TEXT_MODE);
-      }
+  m_stepsToDeadlineCheck = DEADLINE_CHECK_INTERVAL;
+  if (boost::posix_time::microsec_clock::universal_time() <= m_deadline)
+    return;
 
-      goto AdvanceNextChar;
-    }
+  MSG_ERRORX(TIME_LIMIT_EXCEEDED);
+  BOOST_THROW_EXCEPTION (MathInterpreterException() <<
+			 mdx_error_info("Time limit exceeded"));
+}
 
-    // If this is the first thing we're seeing on the line, check to see
-    // if the first blob appears to be an 'item number' (as might appear
-    // in homework).
-    if (m_isStartOfLine && !m_inTextMode) {
-      ATTEMPT(ItemNumber);
-      
-      // Don't consider the line to have started until we see a non-space character.
-      if (!isspace(c))
-        m_isStartOfLine = false;
+/**
+ * Pushes a buffer to be interpreted onto the stack.  The frames above the
+ * top of the stack are kept, and reused, so that the space they have
+ * allocated does not have to be allocated again for every line.
+ *
+ * @param buffer Text to interpret; its contents are taken over (leaving it
+ *        empty), so it must not belong to another frame
+ */
+void MathInterpreter::enterBuffer (std::string &buffer)
+{
+  if (m_recursionLevel == m_frames.size())
+    m_frames.push_back (BufferFrame());
+
+  BufferFrame &frame = m_frames [m_recursionLevel++];
+  frame.buffer.swap (buffer);
+  frame.pos = 0;
+  frame.catchBuffer.erase();
+  frame.elements.clear();
+  frame.constructStart = 0;
+  frame.nestedBuffers.clear();
+  frame.nestedElements.clear();
+
+  LOG_TRACE << "enter interpretBuffer lvl " << m_recursionLevel << " (" << frame.buffer << ")";
+  logIncreaseIndent();
+}
+
+/**
+ * Called by an interpret function which has found a construct with nested
+ * buffers (the contents of a group, the numerator and denominator of a
+ * fraction, etc.) to have them interpreted.  This happens after the
+ * interpret function returns, one buffer after another, at which point
+ * 'make' is called with their elements to build the construct.
+ *
+ * @param make Builds the construct's element from the elements of each of
+ *        the buffers, in order
+ * @return true, or false if the construct is nested too deeply (see
+ *         setMaxNestingDepth() and INTERPRET_FAIL())
+ */
+bool MathInterpreter::interpretNested (const ElementMaker &make,
+				       const std::string &buffer)
+{
+  if (m_recursionLevel > m_maxNestingDepth) {
+    MSG_ERROR(NESTING_TOO_DEEP, MSG_DETAIL("more than %u levels") % m_maxNestingDepth);
+    INTERPRET_FAIL();
+  }
+
+  BufferFrame &frame = m_frames [m_recursionLevel - 1];
+  frame.make = make;
+  frame.nestedBuffers.push_back (buffer);
+  return true;
+}
+
+bool MathInterpreter::interpretNested (const ElementMaker &make,
+				       const std::string &buffer1,
+				       const std::string &buffer2)
+{
+  if (!interpretNested (make, buffer1))
+    return false;
+
+  m_frames [m_recursionLevel - 1].nestedBuffers.push_back (buffer2);
+  return true;
+}
+
+/**
+ * Interprets the next item (a number, a group, a single character of
+ * text, etc.) in the buffer at the top of the stack.
+ */
+#define ATTEMPT(class) { const size_t start = i; const bool handled = interpret##class (temp_elements, buffer, i); if (m_lineFailed || !frame.nestedBuffers.empty()) { frame.constructStart = start; goto NextChar; } if (handled) { flushCatchBuffer (frame); elements.insert (elements.end(), temp_elements.begin(), temp_elements.end()); goto NextChar; } }
+
+void MathInterpreter::interpretNextItem (BufferFrame &frame)
+{
+  const std::string &buffer = frame.buffer;
+  size_t &i = frame.pos;
+  std::string &catch_buffer = frame.catchBuffer;
+  MDEVector &elements = frame.elements;
+
+  // In text mode, everything up to the next mode change or command is
+  // plain text, so it is taken in one go rather than a character at a time
+  if (m_inTextMode) {
+    size_t end = TEXT_MODE_CHARS.find (buffer, i);
+    if (end == std::string::npos)
+      end = buffer.length();
+
+    if (end > i) {
+      LOG_TRACE << "At pos " << i << ", " << (end - i) << " chars of text";
+      catch_buffer.append (buffer, i, end - i);
+      i = end;
+      return;
     }
+  }
 
-    if (m_inTextMode)
-      goto HandleTextBlocks;
+  MDEVector temp_elements;
 
-    ATTEMPT(Group);
-    ATTEMPT(Operator);
-    ATTEMPT(Number);
-    ATTEMPT(Comparator);
-    ATTEMPT(GreekLetter);
-    ATTEMPT(Modifier); // Do this before symbols so `CJ gets matched
-    ATTEMPT(Symbol);
-    ATTEMPT(Fraction);
-    ATTEMPT(Root); // do this before a subscript to avoid confusion
-    ATTEMPT(Summation);
-    ATTEMPT(Exponent);
-    ATTEMPT(Subscript);
+  char c = buffer[i];
+  LOG_TRACE << "At pos " << i << ", char '" << c << "', " << (m_inTextBlock ? "T" : "M") << (m_inTextMode ? "t" : "m");
+  logIncreaseIndent();
 
-    goto DefaultAction;
+  if (m_isStartOfLine) {
+    ATTEMPT(Command);
+  }
 
-  HandleTextBlocks:
-    ;
+  /**
+   * Mode changes: text to math or math to text. Dump what we have up to
+   * this point whenever there is a mode change.
+   */
+  if (c == '$') {
+    // Do not consider `$ to be a math mode change: this is a dollar sign
+    if (!m_inTextMode && i > 0 && buffer [i - 1] == '`')
+      goto DefaultAction;
+
+    if (m_inTextMode) {
+      LOG_TRACE << "* entering math mode; pushing '" << catch_buffer << "'";
+      flushCatchBuffer (frame);
+      m_inTextMode = false;
+      elements.push_back (boost::make_shared<MDE_MathModeMarker>(MDE_MathModeMarker::SEGMENT_MARKER));
+    } else {
+      LOG_TRACE << "! attempt to enter math mode while in math mode";
+      MSG_WARNINGX(NESTED_MATH_MODE);
+    }
 
-  DefaultAction:
-    ;
+    goto AdvanceNextChar;
+  }
 
-    /**
-     * Default action: Save the unknown character to be added later as a
-     * generic text/math block.
-     */
-    catch_buffer.push_back (c);
+  if (c == '&') {
+    if (!m_inTextMode) {
+      LOG_TRACE << "* entering text mode; pushing '" << catch_buffer << "'";
+      flushCatchBuffer (frame);
+      m_inTextMode = true;
+      elements.push_back(boost::make_shared<MDE_TextModeMarker>(MDE_TextModeMarker::SEGMENT_MARKER));
+    }
+    else {
+      LOG_TRACE << "! attempt to enter math mode while in text mode";
+      MSG_WARNINGX(NESTED_TEXT_MODE);
+    }
 
-  AdvanceNextChar:
-    i++;
+    goto AdvanceNextChar;
+  }
 
-  NextChar:
-    logDecreaseIndent();
-    continue;
+  // If this is the first thing we're seeing on the line, check to see
+  // if the first blob appears to be an 'item number' (as might appear
+  // in homework).
+  if (m_isStartOfLine && !m_inTextMode) {
+    ATTEMPT(ItemNumber);
+    
+    // Don't consider the line to have started until we see a non-space character.
+    if (!isspace(c))
+      m_isStartOfLine = false;
   }
 
-  PUSH_CATCH_BUFFER;
+  if (m_inTextMode)
+    goto HandleTextBlocks;
+
+  ATTEMPT(Group);
+  ATTEMPT(Operator);
+  ATTEMPT(Number);
+  ATTEMPT(Comparator);
+  ATTEMPT(GreekLetter);
+  ATTEMPT(Modifier); // Do this before symbols so `CJ gets matched
+  ATTEMPT(Symbol);
+  ATTEMPT(Fraction);
+  ATTEMPT(Root); // do this before a subscript to avoid confusion
+  ATTEMPT(Summation);
+  ATTEMPT(Exponent);
+  ATTEMPT(Subscript);
+
+  goto DefaultAction;
+
+ HandleTextBlocks:
+  ;
+
+ DefaultAction:
+  ;
+
+  /**
+   * Default action: Save the unknown character to be added later as a
+   * generic text/math block.
+   */
+  catch_buffer.push_back (c);
 
-  interpreter_recursion_level--;
+ AdvanceNextChar:
+  i++;
 
+ NextChar:
   logDecreaseIndent();
-  LOG_TRACE << "exit interpretBuffer";
-  return elements;
+}
+
+/**
+ * Adds the characters collected so far in a buffer, if there are any, to
+ * its elements as a generic text/math block.
+ */
+void MathInterpreter::flushCatchBuffer (BufferFrame &frame)
+{
+  if (!boost::trim_copy(frame.catchBuffer).empty())
+    frame.elements.push_back (makeGeneric(frame.catchBuffer));
+  frame.catchBuffer.erase();
 }
 
 /**
@@ -330,35 +1205,42 @@ MathDocumentElementPtr MathInterpreter::makeGeneric (const std::string &buffer)
  * might contain mathematical material.  If it does, a warning is added to
  * the processing log.
  */
-#define CONTAINS(c) (buffer.find(c) != std::string::npos)
 void MathInterpreter::sniffTextForMath (const std::string &buffer)
 {
   std::vector<std::string> suspicious_items;
 
-  if (CONTAINS('@') && CONTAINS('~') && CONTAINS('#'))
+  // One pass over the buffer finds all of the characters of interest
+  const CharClass found = SUSPECT_MATH_CHARS.presentIn (buffer);
+  if (found.empty())
+    return;
+
+  if (found.contains('@') && found.contains('~') && found.contains('#'))
     suspicious_items.push_back ("Fractions");
 
-  if (CONTAINS('<') || CONTAINS('>') || CONTAINS('='))
+  if (found.contains('<') || found.contains('>') || found.contains('='))
     suspicious_items.push_back ("Signs of Comparison");
 
-  if (CONTAINS("_/"))
-    suspicious_items.push_back ("Roots");
-  else if (CONTAINS("/_"))
-    suspicious_items.push_back ("Angles");
-  else if (CONTAINS('_'))
-    suspicious_items.push_back ("Subsbcripts");
+  if (found.contains('_')) {
+    if (buffer.find("_/") != std::string::npos)
+      suspicious_items.push_back ("Roots");
+    else if (buffer.find("/_") != std::string::npos)
+      suspicious_items.push_back ("Angles");
+    else
+      suspicious_items.push_back ("Subsbcripts");
+  }
 
-  if (CONTAINS('^'))
+  if (found.contains('^'))
     suspicious_items.push_back ("Exponents");
 
-  if (CONTAINS('|'))
+  if (found.contains('|'))
     suspicious_items.push_back ("Absolute Values");
 
   if (!suspicious_items.empty()) {
-    MSG_WARNING(SUSPECT_MATH_IN_TEXT, boost::str(boost::format("found %s in '%s'") % ba::join(suspicious_items, ", ") % buffer));
+    // The message says which line the text is on, so only the findings
+    // are kept, not a copy of the text
+    MSG_WARNING(SUSPECT_MATH_IN_TEXT, MSG_DETAIL("found %s") % ba::join(suspicious_items, ", "));
   }
 }
-#undef CONTAINS
 
 /**
  * Extracts the next "item" from the input buffer, which could be:
@@ -370,43 +1252,34 @@ void MathInterpreter::sniffTextForMath (const std::string &buffer)
  *
  * Returns TRUE on success, or FALSE on error.
  */
- bool MathInterpreter::extractItem (std::string &target,
+bool MathInterpreter::extractItem (std::string &target,
 				 const std::string &src,
-				 size_t &i,
-				 const std::string &terminators)
+				 size_t &i)
 {
-  std::string current_terminators = terminators;
   size_t pos = i;
 
   // Skip over any white space that might come before this group
   while (pos < src.length() && isspace(src[pos]))
     pos++;
 
-  // Copy characters until we encounter any of the above-mentioned
-  // terminators.
-  //
-  // The semi-colon is specifically designated as a terminator,
-  // and should be skipped if it arises.
+  // Copy characters until we encounter any of the ITEM_TERMINATORS.  On
+  // terminators other than the semi-colon, do not "lose them" -- they
+  // should wind up in the final output.
   //
   // Special cases:
   // - negative numbers (items can begin with a minus sign '-' but
-  //   only in the first character)
-  for (; pos < src.length(); pos++) {
-    if (src [pos] == ';') {
-      pos++;
-      break;
-    }
-
-    // On other terminators, do not "lose them" -- they should wind
-    // up in the final output.
-    if (isOneOf (src [pos], current_terminators))
-      break;
-
-    if (pos == i)
-      current_terminators += '-';
-
-    target += src [pos];
+  //   only in the first character, and only when no white space was
+  //   skipped)
+  const size_t start = pos;
+  if (pos < src.length() && !ITEM_TERMINATORS.contains (src [pos])) {
+    pos = (pos == i ? ITEM_TERMINATORS_AFTER_FIRST : ITEM_TERMINATORS).find (src, pos + 1);
+    if (pos == std::string::npos)
+      pos = src.length();
   }
+  target.append (src, start, pos - start);
+
+  if (pos < src.length() && src [pos] == ';')
+    pos++;
 
   i = pos;
 
@@ -532,18 +1405,85 @@ bool MathInterpreter::extractToDelimiter (std::string &target,
  */
 void MathInterpreter::addMessage (const MathInterpreterMsg::Category category,
 				  const MathInterpreterMsg::Code msgCode,
-				  const std::string &msg)
+				  const MathInterpreterMsg::Detail &detail)
 {
   assert (m_pCurLine != NULL);
 
-  MathInterpreterMsg message(category,
-			     msgCode,
-			     m_pCurLine->getFilename(),
-			     m_pCurLine->getStartLineNumber(),
-			     m_pCurLine->getEndLineNumber(),
-			     msg);
+  m_messages.push_back (MathInterpreterMsg(category,
+					   msgCode,
+					   getFilenameRef(*m_pCurLine),
+					   m_pCurLine->getStartLineNumber(),
+					   m_pCurLine->getEndLineNumber(),
+					   detail));
+}
+
+/**
+ * Returns the name of the file that 'mdl' came from, shared with the
+ * messages for earlier lines from the same file so that each message does
+ * not need its own copy.
+ */
+const boost::shared_ptr<const std::string> &MathInterpreter::getFilenameRef (const MathDocumentLine &mdl)
+{
+  if (!m_filenameRef || *m_filenameRef != mdl.getFilename())
+    m_filenameRef = boost::make_shared<const std::string>(mdl.getFilename());
+
+  return m_filenameRef;
+}
 
-  m_messages.push_back(message);
-  LOG_INFO << "MSG: " << message;
+/**
+ * Adds the messages for a line to m_messages, leaving out those over their
+ * code's limit and folding repeated ones together if asked to.
+ */
+void MathInterpreter::publishMessages (const std::vector<MathInterpreterMsg> &messages)
+{
+  BOOST_FOREACH (const MathInterpreterMsg &message, messages) {
+    const size_t hash = (m_foldMessages ? message.hashContent() : 0);
+    if (m_foldMessages && foldMessage (message, hash))
+      continue;
+
+    const MathInterpreterMsg::Code code = message.getCode();
+    std::map<MathInterpreterMsg::Code, size_t>::const_iterator limit = m_codeMessageLimits.find (code);
+    if (m_messageCounts [code] >= (limit != m_codeMessageLimits.end() ? limit->second : m_messageLimit)) {
+      m_suppressedCounts [code]++;
+      continue;
+    }
+
+    m_messageCounts [code]++;
+    if (m_foldMessages)
+      m_messageIndex.insert (std::make_pair (hash, m_messages.size()));
+    m_messages.push_back (message);
+  }
+}
+
+/**
+ * Looks for a published message identical to 'message', counting it as a
+ * repeat if there is one.
+ *
+ * @param hash message.hashContent()
+ * @return true if 'message' was folded into an earlier one
+ */
+bool MathInterpreter::foldMessage (const MathInterpreterMsg &message, const size_t hash)
+{
+  typedef boost::unordered_multimap<size_t, size_t>::const_iterator IndexIterator;
+  std::pair<IndexIterator, IndexIterator> range = m_messageIndex.equal_range (hash);
+  for (IndexIterator it = range.first; it != range.second; ++it) {
+    if (m_messages [it->second].hasSameContent (message)) {
+      m_messages [it->second].addRepeat();
+      return true;
+    }
+  }
+
+  return false;
+}
+
+/**
+ * Forgets the counts behind the message limits and folding, for when the
+ * messages from m_msgOffset on are about to be published again.
+ */
+void MathInterpreter::restartMessageCounts (void)
+{
+  m_messageCounts.clear();
+  m_suppressedCounts.clear();
+  m_messageIndex.clear();
 }
 
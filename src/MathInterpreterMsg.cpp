@@ -11,6 +11,8 @@
 #include <map>
 
 #include <boost/assign.hpp>
+#include <boost/format.hpp>
+#include <boost/functional/hash.hpp>
 
 #include "MathInterpreterMsg.h"
 
@@ -22,14 +24,14 @@
  * @param source_filename Filename of document line loaded from
  * @param source_linenumber1 Number of line in file
  * @param source_linenumber2 Number of line (if continuation line) in file
- * @param text Contents of the line
+ * @param detail Details to add to the message for 'msgCode', if any
  */
 MathInterpreterMsg::MathInterpreterMsg (const MathInterpreterMsg::Category category,
 					const MathInterpreterMsg::Code msgCode,
-					const std::string &source_filename,
+					const boost::shared_ptr<const std::string> &source_filename,
 					const unsigned long source_linenumber1,
 					const unsigned long source_linenumber2,
-					const std::string &msg) : m_category(category), m_code(msgCode), m_filename(source_filename), m_line1(source_linenumber1), m_line2(source_linenumber2), m_message(msg)
+					const Detail &detail) : m_category(category), m_code(msgCode), m_filename(source_filename), m_line1(source_linenumber1), m_line2(source_linenumber2), m_detail(detail), m_repeats(0)
 {
 }
 
@@ -58,7 +60,7 @@ MathInterpreterMsg::Code MathInterpreterMsg::getCode (void) const
  */
 std::string MathInterpreterMsg::getFilename (void) const
 {
-  return m_filename;
+  return (m_filename ? *m_filename : std::string());
 }
 
 /**
@@ -82,39 +84,106 @@ unsigned long MathInterpreterMsg::getEndLineNumber (void) const
 }
 
 
+namespace {
+  // Built before main() runs and only ever read afterwards
+  const std::map<MathInterpreterMsg::Code,std::string> error_map = boost::assign::map_list_of
+    (MathInterpreterMsg::UNKNOWN_COMMAND, "Invalid or unknown interpreter command found")
+    (MathInterpreterMsg::NESTED_TEXT_MODE, "Text mode indicator (&&) found while already in text mode")
+    (MathInterpreterMsg::NESTED_MATH_MODE, "Math mode indicator ($$) found while already in math mode")
+    (MathInterpreterMsg::SUSPECT_MATH_IN_TEXT, "Suspected math symbols in a text passage")
+    (MathInterpreterMsg::SUSPECT_TEXT_IN_MATH, "Suspected text material in a math passage")
+    (MathInterpreterMsg::SUSPECT_FRACTION, "Suspect missing open fraction symbol (@)")
+    (MathInterpreterMsg::UNKNOWN_GREEK, "Unknown Greek character symbol")
+    (MathInterpreterMsg::UNKNOWN_BACKQUOTE_SYMBOL, "Unrecognized symbol")
+    (MathInterpreterMsg::FRACTION_NOT_TERMINATED, "Fraction terminator symbol (#) appears to be missing")
+    (MathInterpreterMsg::EXPONENT_NOT_TERMINATED, "Exponent begins with opening paren '(' but is never terminated with a closing paren ')'")
+    (MathInterpreterMsg::SUBSCRIPT_NOT_TERMINATED, "Subscript begins with opening paren '(' but is never terminated with a closing paren ')'")
+    (MathInterpreterMsg::ROOT_INDEX_NOT_TERMINATED, "Root includes a complex index with opening bracket '[' but is never terminated with a closing bracket ']'")
+    (MathInterpreterMsg::ROOT_NOT_TERMINATED, "Root begins with opening paren '(' but is never terminated with a closing paren ')'")
+    (MathInterpreterMsg::SUMMATION_LOWER_BOUND_NOT_TERMINATED, "Lower bound of a summation is never followed by a comma ','")
+    (MathInterpreterMsg::SUMMATION_UPPER_BOUND_NOT_TERMINATED, "Upper bound of a summation is never followed by a closing paren ')'")
+    (MathInterpreterMsg::MODIFIER_NOT_TERMINATED, "Text attached to a symbol begins with opening paren '(' but is never terminated with a closing paren ')'")
+    (MathInterpreterMsg::MODIFIER_MISSING_ARGUMENT, "Symbol is missing attached text")
+    (MathInterpreterMsg::MODIFIER_ROOT_REQUIRES_PARENS, "To include a root symbol within a modifier, enclose it in parantheses")
+    (MathInterpreterMsg::GROUP_NOT_TERMINATED, "A group was begun but not correctly termianted")
+    (MathInterpreterMsg::NESTING_TOO_DEEP, "Groups, fractions, roots, etc. are nested too deeply")
+    (MathInterpreterMsg::TOO_MANY_ELEMENTS, "Line is too long or complicated to interpret")
+    (MathInterpreterMsg::TIME_LIMIT_EXCEEDED, "Interpretation took longer than the time allowed")
+    ;
+}
+
 /**
- * Retrieve the contents of the line.
+ * Retrieve the text of the message, with its details filled in.
  *
- * @return Contents of the line.
+ * @return Text of the message.
  */
 std::string MathInterpreterMsg::getMessage (void) const
 {
-  static std::map<MathInterpreterMsg::Code,std::string> error_map = boost::assign::map_list_of
-    (UNKNOWN_COMMAND, "Invalid or unknown interpreter command found")
-    (NESTED_TEXT_MODE, "Text mode indicator (&&) found while already in text mode")
-    (NESTED_MATH_MODE, "Math mode indicator ($$) found while already in math mode")
-    (SUSPECT_MATH_IN_TEXT, "Suspected math symbols in a text passage")
-    (SUSPECT_TEXT_IN_MATH, "Suspected text material in a math passage")
-    (SUSPECT_FRACTION, "Suspect missing open fraction symbol (@)")
-    (UNKNOWN_GREEK, "Unknown Greek character symbol")
-    (UNKNOWN_BACKQUOTE_SYMBOL, "Unrecognized symbol")
-    (FRACTION_NOT_TERMINATED, "Fraction terminator symbol (#) appears to be missing")
-    (EXPONENT_NOT_TERMINATED, "Exponent begins with opening paren '(' but is never terminated with a closing paren ')'")
-    (SUBSCRIPT_NOT_TERMINATED, "Subscript begins with opening paren '(' but is never terminated with a closing paren ')'")
-    (ROOT_INDEX_NOT_TERMINATED, "Root includes a complex index with opening bracket '[' but is never terminated with a closing bracket ']'")
-    (ROOT_NOT_TERMINATED, "Root begins with opening paren '(' but is never terminated with a closing paren ')'")
-    (MODIFIER_NOT_TERMINATED, "Text attached to a symbol begins with opening paren '(' but is never terminated with a closing paren ')'")
-    (MODIFIER_MISSING_ARGUMENT, "Symbol is missing attached text")
-    (MODIFIER_ROOT_REQUIRES_PARENS, "To include a root symbol within a modifier, enclose it in parantheses")
-    (GROUP_NOT_TERMINATED, "A group was begun but not correctly termianted")
-    ;
+  std::map<MathInterpreterMsg::Code,std::string>::const_iterator it = error_map.find(m_code);
+  assert (it != error_map.end());
+
+  return std::string(it->second + " - " + m_detail.str());
+}
+
+/**
+ * Retrieve the number of identical messages (for other source lines) that
+ * were folded into this one; see MathInterpreter::setMessageFolding().
+ */
+unsigned long MathInterpreterMsg::getRepeatCount (void) const
+{
+  return m_repeats;
+}
+
+/**
+ * Retrieve roughly how much memory the message takes up.
+ */
+size_t MathInterpreterMsg::getByteSize (void) const
+{
+  return sizeof(MathInterpreterMsg) + m_detail.getByteSize();
+}
 
+/**
+ * Returns a hash of everything but the message's location, for finding
+ * identical messages.
+ */
+size_t MathInterpreterMsg::hashContent (void) const
+{
+  size_t hash = m_detail.hash();
+  boost::hash_combine (hash, int(m_category));
+  boost::hash_combine (hash, int(m_code));
+  return hash;
+}
 
-  assert (error_map.count(m_code) == 1);
+/**
+ * Returns true if 'other' says the same thing as this message, wherever
+ * in the document it is.
+ */
+bool MathInterpreterMsg::hasSameContent (const MathInterpreterMsg &other) const
+{
+  return (m_category == other.m_category && m_code == other.m_code &&
+	  m_detail == other.m_detail);
+}
 
-  return std::string(error_map[m_code] + " - " + m_message);
+/**
+ * Counts another occurrence of this message, elsewhere in the document.
+ */
+void MathInterpreterMsg::addRepeat (void)
+{
+  m_repeats++;
 }
 
+/**
+ * Moves the message to another source line; used when a message produced
+ * for one line is reused for an identical line elsewhere.
+ */
+void MathInterpreterMsg::setLocation (const boost::shared_ptr<const std::string> &source_filename,
+				      const unsigned long source_linenumber1,
+				      const unsigned long source_linenumber2)
+{
+  m_filename = source_filename;
+  m_line1 = source_linenumber1;
+  m_line2 = source_linenumber2;
+}
 
 /**
 * Retrieves a fully formatted message for display purposes.
@@ -155,6 +224,8 @@ std::string MathInterpreterMsg::getFormattedMessage(void) const
   os << categoryStr << ": " << getMessage()
     << " (at line " << lineNum.str()
     << " in " << getFilename() << ")";
+  if (m_repeats)
+    os << " (and " << m_repeats << " more time" << (m_repeats == 1 ? "" : "s") << ")";
 
   return os.str();
 }
@@ -167,3 +238,47 @@ std::ostream &operator<<(std::ostream &os, const MathInterpreterMsg &mdm)
   return (os << mdm.getFormattedMessage());
 }
 
+
+/* ========================= MathInterpreterMsg::Detail ==================== */
+
+/**
+ * Formats the details.
+ */
+std::string MathInterpreterMsg::Detail::str (void) const
+{
+  if (!m_format)
+    return std::string();
+
+  boost::format fmt (m_format);
+  for (Args::const_iterator it = m_args.begin(); it != m_args.end(); ++it)
+    fmt % *it;
+
+  return fmt.str();
+}
+
+size_t MathInterpreterMsg::Detail::hash (void) const
+{
+  size_t hash = boost::hash_value (static_cast<const void *>(m_format));
+  boost::hash_range (hash, m_args.begin(), m_args.end());
+  return hash;
+}
+
+size_t MathInterpreterMsg::Detail::getByteSize (void) const
+{
+  size_t bytes = 0;
+  for (Args::const_iterator it = m_args.begin(); it != m_args.end(); ++it) {
+    if (const std::string *arg = boost::get<std::string>(&*it))
+      bytes += arg->length();
+  }
+
+  return bytes;
+}
+
+/**
+ * Details are the same if they use the same format string (by address:
+ * each message is made in one place in the code) with the same arguments.
+ */
+bool MathInterpreterMsg::Detail::operator== (const Detail &other) const
+{
+  return (m_format == other.m_format && m_args == other.m_args);
+}
@@ -18,12 +18,44 @@
 
 namespace ba = boost::algorithm;
 
+// Line length meaning "no limit"; see setMaxLineLength()
+#define NO_LINE_LENGTH_LIMIT ((size_t)-1)
+
+MathSourceFile::MathSourceFile ()
+  : m_maxLineLength(NO_LINE_LENGTH_LIMIT)
+{
+}
 
 const std::vector<MathDocumentLine> &MathSourceFile::getDocument (void) const
 {
   return m_document;
 }
 
+void MathSourceFile::replaceLine (const size_t index, const std::string &content)
+{
+  assert (index < m_document.size());
+
+  const MathDocumentLine &old = m_document [index];
+  checkLineLength (old.getFilename(), old.getStartLineNumber(), content.length());
+  m_document [index] = MathDocumentLine (old.getFilename(),
+					 old.getStartLineNumber(),
+					 old.getEndLineNumber(),
+					 content);
+}
+
+/**
+ * Sets the longest logical line allowed, counting the text of all of its
+ * continuation lines.  Untrusted input could otherwise hand the
+ * interpreter a single line of many megabytes.
+ *
+ * @param maxLength Most characters allowed in a line; by default there is
+ *        no limit
+ */
+void MathSourceFile::setMaxLineLength (const size_t maxLength)
+{
+  m_maxLineLength = maxLength;
+}
+
 /**
  * Loads a source document from the specified file.
  *
@@ -137,7 +169,8 @@ void MathSourceFile::ingest (const std::string &filename,
       // Remove the continuation character from the line
       temp.erase(temp.end() - 1, temp.end());
 
-      curLine = curLine + temp;
+      checkLineLength (filename, continuedLineStartedNumber, curLine.length() + temp.length());
+      curLine += temp;
       continue;
     }
 
@@ -187,11 +220,12 @@ void MathSourceFile::ingest (const std::string &filename,
       continue;
     }
 
-    curLine = curLine + temp;
-
     if (!continuedLineStartedNumber)
       continuedLineStartedNumber = lineNumber;
 
+    checkLineLength (filename, continuedLineStartedNumber, curLine.length() + temp.length());
+    curLine += temp;
+
     m_document.push_back (MathDocumentLine (filename,
 					    continuedLineStartedNumber,
 					    lineNumber,
@@ -202,3 +236,25 @@ void MathSourceFile::ingest (const std::string &filename,
 }
 
 /* ========================= PRIVATE FUNCTIONS =========================== */
+
+/**
+ * Refuses a line longer than the limit set with setMaxLineLength().
+ *
+ * @param filename File the line comes from
+ * @param lineNumber Line on which it begins
+ * @param length Length of the line (so far, for a continued line)
+ * @throw MathDocumentFileException if the line is too long
+ */
+void MathSourceFile::checkLineLength (const std::string &filename,
+				      const unsigned long lineNumber,
+				      const size_t length) const
+{
+  if (length <= m_maxLineLength)
+    return;
+
+  BOOST_THROW_EXCEPTION (MathDocumentFileException() <<
+			 mdx_filename_info(filename) <<
+			 mdx_lineno_info(lineNumber) <<
+			 mdx_error_info(boost::str(boost::format("Line %u is longer than %u characters")
+						   % lineNumber % m_maxLineLength)));
+}
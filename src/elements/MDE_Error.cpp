@@ -0,0 +1,30 @@
+/**
+ * @file MDE_Error.cpp
+ * Source text that was skipped over after an interpretation error
+ *
+ * @copyright Copyright 2015 Anthony Tibbs
+ * This project is released under the GNU General Public License.
+*/
+
+#include "MathDocumentElements.h"
+
+/* ========================= PUBLIC FUNCTION =============================== */
+MDE_Error::MDE_Error(const std::string &contents) :
+  MDE_GenericText(contents)
+{
+}
+
+/**
+ * Generate a string representation of this element (primarily for
+ * debugging purposes)
+ *
+ * @return string representation of this element
+ */
+std::string MDE_Error::getString (void) const
+{
+  std::string output;
+
+  output = "<ERROR>" + payload + "</ERROR>";
+
+  return output;
+}
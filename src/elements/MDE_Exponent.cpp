@@ -13,7 +13,7 @@ MDE_Exponent::MDE_Exponent(const MDEVector exponent) : contents(exponent)
 {
 }
 
-MDEVector MDE_Exponent::getValue (void) const
+const MDEVector &MDE_Exponent::getValue (void) const
 {
   return contents;
 }
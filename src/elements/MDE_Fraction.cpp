@@ -14,12 +14,12 @@ MDE_Fraction::MDE_Fraction(const MDEVector num, const MDEVector den) :
 {
 }
 
-MDEVector MDE_Fraction::getNumerator (void) const
+const MDEVector &MDE_Fraction::getNumerator (void) const
 {
   return numerator;
 }
 
-MDEVector MDE_Fraction::getDenominator (void) const
+const MDEVector &MDE_Fraction::getDenominator (void) const
 {
   return denominator;
 }
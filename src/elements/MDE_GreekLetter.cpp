@@ -25,12 +25,14 @@ void MDE_GreekLetter::setValue (const MDE_GreekLetter::Character c)
   letter = c;
 }
 
-std::string MDE_GreekLetter::getName (void) const
-{
-#define CHARMAP(a,b,c,d) (a, #a) (b, #b) (c, #c) (d, #d)
-#define CHARMAP2(a,b) (a, #a) (b, #b)
+namespace {
+#define NAME(a) (MDE_GreekLetter::a, #a)
+#define CHARMAP(a,b,c,d) NAME(a) NAME(b) NAME(c) NAME(d)
+#define CHARMAP2(a,b) NAME(a) NAME(b)
 
-  static std::map<MDE_GreekLetter::Character,std::string> charmap = boost::assign::map_list_of
+  // Filled in during static initialization, so that looking up a name is
+  // a read-only operation that any number of threads can do at once.
+  const std::map<MDE_GreekLetter::Character,std::string> charmap = boost::assign::map_list_of
     CHARMAP(alpha, Alpha, beta, Beta)
     CHARMAP(gamma, Gamma, delta, Delta)
     CHARMAP(epsilon, Epsilon, zeta, Zeta)
@@ -46,7 +48,16 @@ std::string MDE_GreekLetter::getName (void) const
     CHARMAP2(omega, Omega)
     ;
 
-  return charmap [letter];
+#undef CHARMAP2
+#undef CHARMAP
+#undef NAME
+}
+
+std::string MDE_GreekLetter::getName (void) const
+{
+  std::map<MDE_GreekLetter::Character,std::string>::const_iterator it = charmap.find(letter);
+  assert (it != charmap.end());
+  return it->second;
 }
 
 /**
@@ -16,7 +16,7 @@ MDE_Group::MDE_Group(const MDE_Group::EnclosureType encl,
 {
 }
 
-MDEVector MDE_Group::getContents (void) const
+const MDEVector &MDE_Group::getContents (void) const
 {
   return contents;
 }
@@ -23,24 +23,26 @@ MDE_Modifier::Modifier MDE_Modifier::getModifier (void) const
   return modifier;
 }
 
-MDEVector MDE_Modifier::getArgument (void) const
+const MDEVector &MDE_Modifier::getArgument (void) const
 {
   return argument;
 }
 
-const std::string &MDE_Modifier::getModifierName (const Modifier m)
-{
-#define MAP(m) (m, #m)
-  static std::map<MDE_Modifier::Modifier,std::string> map = boost::assign::map_list_of
+namespace {
+#define MAP(m) (MDE_Modifier::m, #m)
+  const std::map<MDE_Modifier::Modifier,std::string> modifierNames = boost::assign::map_list_of
     MAP(OVER_ARROW_RIGHT)
     MAP(OVER_BAR)
     MAP(OVER_HAT)
     ;
 #undef MAP
+}
 
-  assert (map.count(m) == 1);
-  return map[m];
-
+const std::string &MDE_Modifier::getModifierName (const Modifier m)
+{
+  std::map<MDE_Modifier::Modifier,std::string>::const_iterator it = modifierNames.find(m);
+  assert (it != modifierNames.end());
+  return it->second;
 }
 
 /**
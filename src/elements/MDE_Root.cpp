@@ -14,12 +14,12 @@ MDE_Root::MDE_Root(const MDEVector idx, const MDEVector contents) :
 {
 }
 
-MDEVector MDE_Root::getIndex (void) const
+const MDEVector &MDE_Root::getIndex (void) const
 {
   return index;
 }
 
-MDEVector MDE_Root::getArgument (void) const
+const MDEVector &MDE_Root::getArgument (void) const
 {
   return argument;
 }
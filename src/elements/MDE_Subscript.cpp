@@ -13,7 +13,7 @@ MDE_Subscript::MDE_Subscript(const MDEVector subscript) : contents(subscript)
 {
 }
 
-MDEVector MDE_Subscript::getValue (void) const
+const MDEVector &MDE_Subscript::getValue (void) const
 {
   return contents;
 }
@@ -16,12 +16,12 @@ MDE_Summation::MDE_Summation(const MDEVector lower, const MDEVector upper) :
 {
 }
 
-MDEVector MDE_Summation::getLowerBound (void) const
+const MDEVector &MDE_Summation::getLowerBound (void) const
 {
   return lowerBound;
 }
 
-MDEVector MDE_Summation::getUpperBound (void) const
+const MDEVector &MDE_Summation::getUpperBound (void) const
 {
   return upperBound;
 }
@@ -26,16 +26,9 @@ void MDE_Symbol::setSymbol (const MDE_Symbol::Symbol s)
   symbol = s;
 }
 
-/**
- * Generate a string representation of this element (primarily for
- * debugging purposes)
- *
- * @return string representation of this element
- */
-std::string MDE_Symbol::getString (void) const
-{
-#define MAP(m) (m, #m)
-  static std::map<MDE_Symbol::Symbol,std::string> map = boost::assign::map_list_of
+namespace {
+#define MAP(m) (MDE_Symbol::m, #m)
+  const std::map<MDE_Symbol::Symbol,std::string> symbolNames = boost::assign::map_list_of
     MAP(COMMA)
     MAP(CURRENCY_CENTS)
     MAP(CURRENCY_EURO)
@@ -55,9 +48,19 @@ std::string MDE_Symbol::getString (void) const
     MAP(THEREFORE)
     ;
 #undef MAP
+}
 
-  assert (map.count(symbol) == 1);
-  return std::string("<" + map[symbol] + ">");
+/**
+ * Generate a string representation of this element (primarily for
+ * debugging purposes)
+ *
+ * @return string representation of this element
+ */
+std::string MDE_Symbol::getString (void) const
+{
+  std::map<MDE_Symbol::Symbol,std::string>::const_iterator it = symbolNames.find(symbol);
+  assert (it != symbolNames.end());
+  return std::string("<" + it->second + ">");
 }
 
 
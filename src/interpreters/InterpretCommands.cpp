@@ -7,7 +7,6 @@
 
 #include <assert.h>
 #include <boost/algorithm/string.hpp>
-#include <boost/format.hpp>
 
 #include "logging.h"
 
@@ -64,8 +63,8 @@ bool MathInterpreter::interpretCommand (MDEVector &target,
 
   if (!isCommand(commandName)) {
     LOG_TRACE << "* found unrecognized command: " << commandName << " // " << commandParameters;
-    MSG_ERROR(UNKNOWN_COMMAND, boost::str(boost::format("'%s'") % commandName));
-    BOOST_THROW_EXCEPTION (MathInterpreterException());
+    MSG_ERROR(UNKNOWN_COMMAND, MSG_DETAIL("'%s'") % commandName);
+    INTERPRET_FAIL();
 
   }
   LOG_TRACE << "* found command: " << commandName << " // " << commandParameters;
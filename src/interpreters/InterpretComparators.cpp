@@ -5,10 +5,6 @@
  * This project is released under the GNU General Public License.
 */
 
-
-#include <vector>
-#include <boost/assign.hpp>
-
 #include "logging.h"
 
 #include "MathInterpreter.h"
@@ -20,48 +16,64 @@
  * Returns true on success, false on error, and puts resulting elements
  * into the 'target' buffer.
  */
-namespace {
-  struct ComparatorSymbolMap {
-    ComparatorSymbolMap (const std::string &s, const MDE_Comparator::Comparator c) : search(s), symbol(c) {}
-    std::string search;
-    MDE_Comparator::Comparator symbol;
-  };
-}
-
 bool MathInterpreter::interpretComparator (MDEVector &target,
 					const std::string &src,
 					size_t &i)
 {
-  static const std::vector<ComparatorSymbolMap> map = boost::assign::list_of
-    ( ComparatorSymbolMap("<=", MDE_Comparator::LESS_THAN_EQUALS) )
-    ( ComparatorSymbolMap(">=", MDE_Comparator::GREATER_THAN_EQUALS) )
-    ( ComparatorSymbolMap("!=", MDE_Comparator::NOT_EQUALS) )
-    ( ComparatorSymbolMap("~=", MDE_Comparator::APPROX_EQUALS) )
-    ( ComparatorSymbolMap("<", MDE_Comparator::LESS_THAN) )
-    ( ComparatorSymbolMap(">", MDE_Comparator::GREATER_THAN) )
-    ( ComparatorSymbolMap("=", MDE_Comparator::EQUALS) );
+  // Dispatch directly on the first character; the two-character forms
+  // (<= >= != ~=) are then decided by looking at the second one.
+  const char next = (i+1 < src.length()) ? src [i+1] : '\0';
+  MDE_Comparator::Comparator symbol;
+  size_t len = 1;
 
-  const std::string temp = src.substr(i, 2);
+  switch (src [i]) {
+  case '<':
+    if (next == '=') {
+      symbol = MDE_Comparator::LESS_THAN_EQUALS;
+      len = 2;
+    } else {
+      symbol = MDE_Comparator::LESS_THAN;
+    }
+    break;
 
-  for (std::vector<ComparatorSymbolMap>::const_iterator it = map.begin();
-       it != map.end(); ++it) {
-    const ComparatorSymbolMap &mi = *it;
-    // Look for the first character
-    if (temp[0] == mi.search[0]) {
-      // It matches. If the second one also has to match, consider it too.
-      if (mi.search.length() == 1 || temp[1] == mi.search[1]) {
-	LOG_TRACE << "* added comparator sign (" << mi.search << ")";
-	target.push_back (boost::make_shared<MDE_Comparator>(mi.symbol));
-	i += mi.search.length();
+  case '>':
+    if (next == '=') {
+      symbol = MDE_Comparator::GREATER_THAN_EQUALS;
+      len = 2;
+    } else {
+      symbol = MDE_Comparator::GREATER_THAN;
+    }
+    break;
 
-	// Skip whitespace after a sign of comparison
-	while (i < src.length() && isspace(src[i]))
-	  i++;
+  case '!':
+    if (next != '=')
+      return false;
+    symbol = MDE_Comparator::NOT_EQUALS;
+    len = 2;
+    break;
 
-	return true;
-      }
-    }
+  case '~':
+    if (next != '=')
+      return false;
+    symbol = MDE_Comparator::APPROX_EQUALS;
+    len = 2;
+    break;
+
+  case '=':
+    symbol = MDE_Comparator::EQUALS;
+    break;
+
+  default:
+    return false;
   }
 
-  return false;
+  LOG_TRACE << "* added comparator sign (" << src.substr(i, len) << ")";
+  target.push_back (boost::make_shared<MDE_Comparator>(symbol));
+  i += len;
+
+  // Skip whitespace after a sign of comparison
+  while (i < src.length() && isspace(src[i]))
+    i++;
+
+  return true;
 }
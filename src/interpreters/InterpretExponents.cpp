@@ -6,13 +6,21 @@
 */
 
 
-#include <boost/format.hpp>
-
 #include "logging.h"
 
 #include "MathInterpreter.h"
 #include "MathExceptions.h"
 
+namespace {
+  /**
+   * Builds an exponent once its contents have been interpreted.
+   */
+  MathDocumentElementPtr makeExponent (const std::vector<MDEVector> &nested)
+  {
+    return boost::make_shared<MDE_Exponent>(nested [0]);
+  }
+}
+
 /**
  * Attempts to interpret an exponent: ^item or ^(item)
  *
@@ -22,12 +30,12 @@
  * If ^ is followed by parenthesees then the entire paranthesees is
  * taken as the exponent.
  *
- * Returns true on success, false on error, and puts resulting elements
- * into the 'target' buffer.
+ * Returns true on success, false on error.  The element is built once its
+ * contents have been interpreted (see interpretNested()).
  *
  * ##TODO: warn about empty exponents: x^() for example
  */
-bool MathInterpreter::interpretExponent (MDEVector &target,
+bool MathInterpreter::interpretExponent (MDEVector & /*target*/,
 				      const std::string &src,
 				      size_t &i)
 {
@@ -41,13 +49,13 @@ bool MathInterpreter::interpretExponent (MDEVector &target,
   i++;
   if (src [i] == '(') {
     if (!extractGroup(exponent_contents, src, i)) {
-      MSG_ERROR(EXPONENT_NOT_TERMINATED, boost::str(boost::format("text in exponent: '%s'") % exponent_contents));
-      BOOST_THROW_EXCEPTION (MathInterpreterException());
+      MSG_ERROR(EXPONENT_NOT_TERMINATED, MSG_DETAIL("text in exponent: '%s'") % exponent_contents);
+      INTERPRET_FAIL();
     }
   } else if (src [i] == '@') {
     if (!extractGroup(exponent_contents, src, i, "@", "#", true)) {
-      MSG_ERROR(EXPONENT_NOT_TERMINATED, boost::str(boost::format("text in exponent: '%s'") % exponent_contents));
-      BOOST_THROW_EXCEPTION (MathInterpreterException());
+      MSG_ERROR(EXPONENT_NOT_TERMINATED, MSG_DETAIL("text in exponent: '%s'") % exponent_contents);
+      INTERPRET_FAIL();
     }
   } else {
     extractItem(exponent_contents, src, i);
@@ -55,8 +63,5 @@ bool MathInterpreter::interpretExponent (MDEVector &target,
 
   LOG_TRACE << "* found exponent: " << exponent_contents;
 
-  MDEVector v;
-  v = interpretBuffer (exponent_contents);
-  target.push_back (boost::make_shared<MDE_Exponent>(v));
-  return true;
+  return interpretNested (makeExponent, exponent_contents);
 }
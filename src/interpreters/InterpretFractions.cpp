@@ -6,27 +6,36 @@
 */
 
 
-#include <boost/format.hpp>
-
 #include "logging.h"
 
 #include "MathInterpreter.h"
 #include "MathExceptions.h"
 
+namespace {
+  /**
+   * Builds a fraction once its numerator and denominator have been
+   * interpreted.
+   */
+  MathDocumentElementPtr makeFraction (const std::vector<MDEVector> &nested)
+  {
+    return boost::make_shared<MDE_Fraction>(nested [0], nested [1]);
+  }
+}
+
 /**
  * Attempts to interpret a fraction: @num~den#
 
- * Returns true on success, false on error, and puts resulting elements
- * into the 'target' buffer.
+ * Returns true on success, false on error.  The element is built once its
+ * contents have been interpreted (see interpretNested()).
  *
  * ##TODO: warn about empty numerator/denominator
  */
-bool MathInterpreter::interpretFraction (MDEVector &target,
+bool MathInterpreter::interpretFraction (MDEVector & /*target*/,
 				      const std::string &src,
 				      size_t &i)
 {
   if (src [i] == '#' || src [i] == '~') {
-    MSG_WARNING(SUSPECT_FRACTION, boost::str(boost::format("found '%c' modifier outside of a fraction") % src [i]));
+    MSG_WARNING(SUSPECT_FRACTION, MSG_DETAIL("found '%c' modifier outside of a fraction") % src [i]);
     return false;
   }
 
@@ -45,8 +54,8 @@ bool MathInterpreter::interpretFraction (MDEVector &target,
   for (pos = i+1; pos < src.length(); pos++) {
     // Skip escaped characters or "approximately equal to" modifiers
     // that appear within a fraction.
-    if (src.substr (pos, 2) == "\\#" || src.substr(pos, 2) == "\\@"
-	|| src.substr (pos, 2) == "\\~" || src.substr(pos, 2) == "~=")
+    if (!src.compare (pos, 2, "\\#") || !src.compare (pos, 2, "\\@")
+	|| !src.compare (pos, 2, "\\~") || !src.compare (pos, 2, "~="))
       pos += 2;
 
     // Look for nested fractions
@@ -75,9 +84,9 @@ bool MathInterpreter::interpretFraction (MDEVector &target,
   }
 
   if (!foundTerminator) {
-    MSG_ERROR(FRACTION_NOT_TERMINATED, boost::str(boost::format("end of line encountered while still inside %d fraction%s") % (num_nested_fractions+1) % (num_nested_fractions >= 2 ? "s" : "")));
+    MSG_ERROR(FRACTION_NOT_TERMINATED, MSG_DETAIL("end of line encountered while still inside %d fraction%s") % (num_nested_fractions+1) % (num_nested_fractions >= 2 ? "s" : ""));
 
-    BOOST_THROW_EXCEPTION (MathInterpreterException());
+    INTERPRET_FAIL();
   }
 
   // advance cursor
@@ -85,12 +94,5 @@ bool MathInterpreter::interpretFraction (MDEVector &target,
 
   LOG_TRACE << "* found fraction: " << numerator << " // " << denominator;
 
-  MDEVector numvec;
-  MDEVector denvec;
-
-  numvec = interpretBuffer (numerator);
-  denvec = interpretBuffer (denominator);
-
-  target.push_back (boost::make_shared<MDE_Fraction>(numvec, denvec));
-  return true;
+  return interpretNested (makeFraction, numerator, denominator);
 }
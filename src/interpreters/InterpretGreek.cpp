@@ -5,34 +5,25 @@
  * This project is released under the GNU General Public License.
 */
 
-#include <boost/assign.hpp>
-#include <boost/format.hpp>
-
 #include "logging.h"
 
 #include "MathInterpreter.h"
 
-/**
- * Attempts to interpret a greek letter: %a, %b, etc.
- *
- * Returns true on success, false on error, and puts resulting elements
- * into the 'target' buffer.
- */
 namespace {
-  struct GreekLetterMap {
-    GreekLetterMap (const char s, const MDE_GreekLetter::Character c) : symbol(s), character(c) {}
-    char symbol;
-    MDE_GreekLetter::Character character;
-  };
-}
+  /**
+   * Maps the character following '%' to the greek letter it represents.
+   * The compiler turns the switch into a direct-index jump table, so the
+   * cost of a lookup does not depend on the number of letters defined.
+   *
+   * Returns false if the character does not represent a greek letter.
+   */
+  bool lookupGreekLetter (const char c, MDE_GreekLetter::Character &character)
+  {
+#define CHARMAP(symbol1,char1,symbol2,char2) \
+    case symbol1: character = MDE_GreekLetter::char1; return true; \
+    case symbol2: character = MDE_GreekLetter::char2; return true;
 
-bool MathInterpreter::interpretGreekLetter (MDEVector &target,
-					 const std::string &src,
-					 size_t &i)
-{
-
-#define CHARMAP(symbol1,char1,symbol2,char2) ( GreekLetterMap(symbol1, MDE_GreekLetter::char1) ) ( GreekLetterMap(symbol2, MDE_GreekLetter::char2) )
-  static const std::vector<GreekLetterMap> map = boost::assign::list_of
+    switch (c) {
     CHARMAP('a', alpha, 'A', Alpha)
     CHARMAP('b', beta, 'B', Beta)
     CHARMAP('g', gamma, 'G', Gamma)
@@ -57,8 +48,23 @@ bool MathInterpreter::interpretGreekLetter (MDEVector &target,
     CHARMAP('c', chi, 'C', Chi)
     CHARMAP('f', psi, 'F', Psi)
     CHARMAP('w', omega, 'W', Omega)
-    ;
+    default:
+      return false;
+    }
+#undef CHARMAP
+  }
+}
 
+/**
+ * Attempts to interpret a greek letter: %a, %b, etc.
+ *
+ * Returns true on success, false on error, and puts resulting elements
+ * into the 'target' buffer.
+ */
+bool MathInterpreter::interpretGreekLetter (MDEVector &target,
+					 const std::string &src,
+					 size_t &i)
+{
   if (src [i] != '%' || (i+1) >= src.length())
     return false;
 
@@ -66,19 +72,15 @@ bool MathInterpreter::interpretGreekLetter (MDEVector &target,
   if (c == '%') /* %% is the symbol for 'percent sign' */
     return false;
 
-  for (std::vector<GreekLetterMap>::const_iterator it = map.begin();
-       it != map.end(); ++it) {
-    const GreekLetterMap &mi = *it;
-    // Look for the first character
-    if (c == mi.symbol) {
-      LOG_TRACE << "* added greek letter for (" << mi.symbol << ")";
-      target.push_back (boost::make_shared<MDE_GreekLetter>(mi.character));
-      i += 2;
+  MDE_GreekLetter::Character character;
+  if (lookupGreekLetter(c, character)) {
+    LOG_TRACE << "* added greek letter for (" << c << ")";
+    target.push_back (boost::make_shared<MDE_GreekLetter>(character));
+    i += 2;
 
-      return true;
-    }
+    return true;
   }
 
-  MSG_WARNING(UNKNOWN_GREEK, boost::str(boost::format("'%%%c' does not represent a greek letter") % c));
+  MSG_WARNING(UNKNOWN_GREEK, MSG_DETAIL("'%%%c' does not represent a greek letter") % c);
   return false;
 }
@@ -6,18 +6,31 @@
 */
 
 
+#include <boost/bind.hpp>
+
 #include "logging.h"
 
 #include "MathInterpreter.h"
 #include "MathExceptions.h"
 
+namespace {
+  /**
+   * Builds a group once its contents have been interpreted.
+   */
+  MathDocumentElementPtr makeGroup (const MDE_Group::EnclosureType groupType,
+				    const std::vector<MDEVector> &nested)
+  {
+    return boost::make_shared<MDE_Group>(groupType, nested [0]);
+  }
+}
+
 /**
  * Attempts to interpret a 'group' -- something enclosed in ([{ }])
  *
- * Returns true on success, false on error, and puts resulting elements
- * into the 'target' buffer.
+ * Returns true on success, false on error.  The element is built once its
+ * contents have been interpreted (see interpretNested()).
  */
-bool MathInterpreter::interpretGroup (MDEVector &target,
+bool MathInterpreter::interpretGroup (MDEVector & /*target*/,
 				      const std::string &src,
 				      size_t &i)
 {
@@ -26,9 +39,9 @@ bool MathInterpreter::interpretGroup (MDEVector &target,
 
   if (src[i] == '(') {
     if (!extractGroup(contents, src, i, "(", ")")) {
-      MSG_ERROR(GROUP_NOT_TERMINATED, std::string("end of line was reached while looking for closing paranthesis - saw " + contents));
+      MSG_ERROR(GROUP_NOT_TERMINATED, MSG_DETAIL("end of line was reached while looking for closing paranthesis - saw %s") % contents);
 
-      BOOST_THROW_EXCEPTION (MathInterpreterException());
+      INTERPRET_FAIL();
     }
 
     groupType = MDE_Group::PARENTHESES;
@@ -36,9 +49,9 @@ bool MathInterpreter::interpretGroup (MDEVector &target,
   }
   else if (src [i] == '[') {
     if (!extractGroup(contents, src, i, "[", "]")) {
-      MSG_ERROR(GROUP_NOT_TERMINATED, std::string("end of line was reached while looking for closing bracket - saw " + contents));
+      MSG_ERROR(GROUP_NOT_TERMINATED, MSG_DETAIL("end of line was reached while looking for closing bracket - saw %s") % contents);
 
-      BOOST_THROW_EXCEPTION (MathInterpreterException());
+      INTERPRET_FAIL();
     }
 
     groupType = MDE_Group::BRACKETS;
@@ -46,9 +59,9 @@ bool MathInterpreter::interpretGroup (MDEVector &target,
   }
   else if (src [i] == '{') {
     if (!extractGroup(contents, src, i, "{", "}")) {
-      MSG_ERROR(GROUP_NOT_TERMINATED, std::string("end of line was reached while looking for closing paranthesis - saw " + contents));
+      MSG_ERROR(GROUP_NOT_TERMINATED, MSG_DETAIL("end of line was reached while looking for closing paranthesis - saw %s") % contents);
 
-      BOOST_THROW_EXCEPTION (MathInterpreterException());
+      INTERPRET_FAIL();
     }
 
 
@@ -58,9 +71,5 @@ bool MathInterpreter::interpretGroup (MDEVector &target,
   else
     return false;
 
-  MDEVector contents_vec;
-  contents_vec = interpretBuffer (contents);
-
-  target.push_back (boost::make_shared<MDE_Group>(groupType, contents_vec));
-  return true;
+  return interpretNested (boost::bind(makeGroup, groupType, _1), contents);
 }
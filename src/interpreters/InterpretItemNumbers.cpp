@@ -5,14 +5,58 @@
  * This project is released under the GNU General Public License.
 */
 
-#include <boost/assign.hpp>
-#include <boost/regex.hpp>
+#include <algorithm>
 #include <boost/algorithm/string.hpp>
 
 #include "logging.h"
 
 #include "MathInterpreter.h"
 
+// Item numbers are assumed not to be longer than 10 characters, including
+// the whitespace that follows them: "(1234)    "
+#define MAX_ITEM_NUMBER_LEN 10
+
+namespace {
+  /**
+   * Returns the length of the item number (and the whitespace following
+   * it) found at position 'i' of 'src', or 0 if there is none there.
+   */
+  size_t matchItemNumber (const std::string &src, const size_t i)
+  {
+    const size_t end = std::min (src.length(), i + MAX_ITEM_NUMBER_LEN);
+    size_t pos = i;
+
+    bool inParens = (pos < end && src [pos] == '(');
+    if (inParens)
+      pos++;
+
+    // Either 1 to 4 digits, or a single letter
+    const size_t labelStart = pos;
+    if (pos < end && isdigit((unsigned char)src [pos])) {
+      while (pos < end && pos - labelStart < 4 && isdigit((unsigned char)src [pos]))
+	pos++;
+    } else if (pos < end && ((src [pos] >= 'A' && src [pos] <= 'Z') ||
+			     (src [pos] >= 'a' && src [pos] <= 'z'))) {
+      pos++;
+    } else {
+      return 0;
+    }
+
+    // "(1)" must be closed by a paren; "1." and "1)" are both acceptable
+    if (pos < end && (src [pos] == ')' || (!inParens && src [pos] == '.')))
+      pos++;
+    else
+      return 0;
+
+    // ... and at least one whitespace character has to follow
+    const size_t labelEnd = pos;
+    while (pos < end && isspace((unsigned char)src [pos]))
+      pos++;
+
+    return (pos > labelEnd) ? pos - i : 0;
+  }
+}
+
 /**
  * Attempts to interpret the specified characters as item numbers. THese
  * may appear at the start of the line.  We treat them as a special text
@@ -28,35 +72,15 @@ bool MathInterpreter::interpretItemNumber (MDEVector &target,
 					const std::string &src,
 					size_t &i)
 {
-  const std::vector<std::string> patterns = boost::assign::list_of
-    ( std::string("^(\\d{1,4}\\.\\s+)") ) // 1.
-    ( std::string("^([A-Za-z]{1}\\.\\s+)") ) // a.
-    ( std::string("^(\\d{1,4}\\)\\s+)") ) // 1)
-    ( std::string("^([A-Za-z]{1}\\)\\s+)") ) // a)
-    ( std::string("^(\\(\\d{1,4}\\)\\s+)") ) // (1)
-    ( std::string("^(\\([A-Za-z]{1}\\)\\s+)") ) // (a)
-    ;
-
-  for (std::vector<std::string>::const_iterator it = patterns.begin();
-       it != patterns.end(); ++it) {
-    const std::string pattern = *it;
-
-    boost::regex exp(pattern);
-    boost::smatch mr;
-
-    // search for item numbers - assume they will not be longer than 10 chars
-    // (123456) 
-    std::string searchStr = src.substr(i, 10);
-    if (boost::regex_search(searchStr, mr, exp)) {
-      std::string item_number (mr[1].first, mr[1].second);
-      boost::trim(item_number);
-
-      LOG_TRACE << "* added item number '" << item_number << "' with pattern '" << pattern << "'";
-      i = i + mr.length();
-      target.push_back (boost::make_shared<MDE_ItemNumber>(item_number));
-      return true;
-    }
-  }
+  const size_t len = matchItemNumber (src, i);
+  if (!len)
+    return false;
+
+  std::string item_number = src.substr (i, len);
+  boost::trim(item_number);
 
-  return false;
+  LOG_TRACE << "* added item number '" << item_number << "'";
+  i += len;
+  target.push_back (boost::make_shared<MDE_ItemNumber>(item_number));
+  return true;
 }
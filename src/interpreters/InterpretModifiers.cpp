@@ -5,9 +5,7 @@
  * This project is released under the GNU General Public License.
 */
 
-#include <boost/algorithm/string.hpp>
-#include <boost/assign.hpp>
-#include <boost/format.hpp>
+#include <boost/bind.hpp>
 
 #include "logging.h"
 
@@ -18,58 +16,90 @@
  * Attempts to interpret a variety of "modifiers" or symbols which have
  * arguments attached (such as vectors, etc.)
  *
- * Returns true on success, false on error, and puts resulting elements
- * into the 'target' buffer.
+ * Returns true on success, false on error.  The element is built once its
+ * contents have been interpreted (see interpretNested()).
  */
 namespace {
   struct ModifierMap {
-    ModifierMap (const std::string &s, const std::string &name, const MDE_Modifier::Modifier mod) : search(s), modifierName(name), modifier(mod) {}
-    std::string search;
-    std::string modifierName;
+    const char *search;
+    size_t searchLen;
+    const char *modifierName;
     MDE_Modifier::Modifier modifier;
   };
+
+#define MODIFIER(search, name, mod) { search, sizeof(search) - 1, name, MDE_Modifier::mod }
+  const ModifierMap MOD_VECTOR = MODIFIER("`V", "vector", OVER_ARROW_RIGHT);
+  const ModifierMap MOD_BAR = MODIFIER("`BAR", "bar", OVER_BAR);
+  const ModifierMap MOD_CONJUGATE = MODIFIER("`CJ", "conjugate", OVER_BAR);
+  const ModifierMap MOD_HAT_LONG = MODIFIER("`HAT", "hat", OVER_HAT);
+  const ModifierMap MOD_HAT = MODIFIER("`H", "hat", OVER_HAT);
+#undef MODIFIER
+
+  /**
+   * Case-insensitively checks whether 'mi' appears at position 'i' of
+   * 'src', without copying either string.
+   */
+  bool matchesAt (const std::string &src, const size_t i, const ModifierMap &mi)
+  {
+    if (src.length() - i < mi.searchLen)
+      return false;
+
+    for (size_t n = 0; n < mi.searchLen; n++) {
+      if (toupper(src [i+n]) != mi.search [n])
+	return false;
+    }
+
+    return true;
+  }
+
+  /**
+   * Builds a modifier once its argument has been interpreted.
+   */
+  MathDocumentElementPtr makeModifier (const MDE_Modifier::Modifier modifier,
+				       const std::vector<MDEVector> &nested)
+  {
+    return boost::make_shared<MDE_Modifier>(modifier, nested [0]);
+  }
 }
 
-bool MathInterpreter::interpretModifier (MDEVector &target,
+bool MathInterpreter::interpretModifier (MDEVector & /*target*/,
 				      const std::string &src,
 				      size_t &i)
 {
 
   // Quick check: don't bother with all this if the first character doesn't
   // make this at least a possibility.
-  if (src[i] != '`')
+  if (src[i] != '`' || (i+1) >= src.length())
     return false;
 
-#define MAX_MODIFIER_LEN 4
-  // Be sure to update MAX_MODIFIER_LEN if longer symbols get added to
-  // this table.  Place longer symbols at the top.
-  static const std::vector<ModifierMap> map = boost::assign::list_of
-    ( ModifierMap("`V", "vector", MDE_Modifier::OVER_ARROW_RIGHT) )
-    ( ModifierMap("`BAR", "bar", MDE_Modifier::OVER_BAR) )
-    ( ModifierMap("`CJ", "conjugate", MDE_Modifier::OVER_BAR) )
-    ( ModifierMap("`HAT", "hat", MDE_Modifier::OVER_HAT) )
-    ( ModifierMap("`H", "hat", MDE_Modifier::OVER_HAT) )
-    ;
-
-  const std::string temp = src.substr(i, MAX_MODIFIER_LEN);
+  // Dispatch on the letter following the backquote.  Where two modifiers
+  // share a letter, the longer one has to be tried first.
+  const ModifierMap *candidates[2] = { NULL, NULL };
+  switch (toupper(src [i+1])) {
+  case 'V': candidates[0] = &MOD_VECTOR; break;
+  case 'B': candidates[0] = &MOD_BAR; break;
+  case 'C': candidates[0] = &MOD_CONJUGATE; break;
+  case 'H': candidates[0] = &MOD_HAT_LONG; candidates[1] = &MOD_HAT; break;
+  default:
+    return false;
+  }
 
-  for(std::vector<ModifierMap>::const_iterator it = map.begin();
-      it != map.end(); ++it) {
-    const ModifierMap &mi = *it;
+  for (int n = 0; n < 2 && candidates[n]; n++) {
+    const ModifierMap &mi = *candidates[n];
 
-    if (!strBeginsWith(temp, mi.search))
+    if (!matchesAt(src, i, mi))
       continue;
 
     // Skip over symbol indicator
-    i += mi.search.length();
+    i += mi.searchLen;
 
     // skip any whitespace
     while (i < src.length() && isspace(src[i]))
       i++;
 
     if (i == src.length()) {
-      MSG_ERROR(MODIFIER_MISSING_ARGUMENT, boost::str(boost::format("%s symbol") % mi.modifierName));
-      BOOST_THROW_EXCEPTION (MathInterpreterException());
+      MSG_ERROR(MODIFIER_MISSING_ARGUMENT, MSG_DETAIL("%s symbol") % mi.modifierName);
+      INTERPRET_FAIL();
     }
 
     // If this is followed by an open paren '(', read until the closing
@@ -77,26 +107,23 @@ bool MathInterpreter::interpretModifier (MDEVector &target,
     std::string argument;
     if (src [i] == '(') {
       if (!extractGroup(argument, src, i)) {
-	MSG_ERROR(MODIFIER_NOT_TERMINATED, boost::str(boost::format("text found inside %s symbol so far: '%s'") % mi.modifierName % argument));
-	BOOST_THROW_EXCEPTION (MathInterpreterException());
+	MSG_ERROR(MODIFIER_NOT_TERMINATED, MSG_DETAIL("text found inside %s symbol so far: '%s'") % mi.modifierName % argument);
+	INTERPRET_FAIL();
       }
     } else if (src [i] == '@') {
       if (!extractGroup(argument, src, i, "@", "#", true)) {
-	MSG_ERROR(MODIFIER_NOT_TERMINATED, boost::str(boost::format("partial fraction inside %s symbol so far: '%s'") % mi.modifierName % argument));
-	BOOST_THROW_EXCEPTION (MathInterpreterException());
+	MSG_ERROR(MODIFIER_NOT_TERMINATED, MSG_DETAIL("partial fraction inside %s symbol so far: '%s'") % mi.modifierName % argument);
+	INTERPRET_FAIL();
       }
     } else if (src.substr(i, 2) == "_/") {
-      MSG_ERROR(MODIFIER_ROOT_REQUIRES_PARENS, boost::str(boost::format("symbol type: %s") % mi.modifierName));
-      BOOST_THROW_EXCEPTION (MathInterpreterException());
+      MSG_ERROR(MODIFIER_ROOT_REQUIRES_PARENS, MSG_DETAIL("symbol type: %s") % mi.modifierName);
+      INTERPRET_FAIL();
     } else {
       extractItem(argument, src, i);
     }
 
     LOG_TRACE << "* found item in " << mi.modifierName << " symbol: " << argument;
-    MDEVector v;
-    v = interpretBuffer (argument);
-    target.push_back (boost::make_shared<MDE_Modifier>(mi.modifier, v));
-    return true;
+    return interpretNested (boost::bind(makeModifier, mi.modifier, _1), argument);
   }
 
   return false;
@@ -5,12 +5,57 @@
  * This project is released under the GNU General Public License.
 */
 
-#include <boost/regex.hpp>
+#include <boost/cstdint.hpp>
 
 #include "logging.h"
 
 #include "MathInterpreter.h"
 
+namespace {
+  /**
+   * Returns true if the three bytes at 'p' are all ASCII digits.
+   *
+   * The bytes are packed into one word and tested together: every digit
+   * has a high nibble of 3, and adding 6 to a digit leaves that nibble
+   * alone, while any other 0x3X byte (':' through '?') carries out of it.
+   */
+  inline bool isThreeDigits (const char *p)
+  {
+    const boost::uint32_t w = (boost::uint32_t)(unsigned char)p[0]
+      | ((boost::uint32_t)(unsigned char)p[1] << 8)
+      | ((boost::uint32_t)(unsigned char)p[2] << 16);
+
+    return ((w & 0xF0F0F0) == 0x303030 &&
+	    ((w + 0x060606) & 0xF0F0F0) == 0x303030);
+  }
+
+  /**
+   * Determines whether a thousands separator begins at 'pos': the
+   * separator itself, exactly three digits, and then something other
+   * than a digit (or the end of the buffer).
+   *
+   * Example when this holds: 1,024,576
+   * Example when it does not: 1,24837,23872 (treat as separate)
+   *
+   * @param allowComma FALSE if only a space may act as the separator
+   */
+  inline bool isDigitGroup (const std::string &src, const size_t pos,
+			    const bool allowComma)
+  {
+    if ((src.length() - pos) < 4)
+      return false;
+
+    const char sep = src [pos];
+    if (sep != ' ' && !(allowComma && sep == ','))
+      return false;
+
+    if (!isThreeDigits (src.data() + pos + 1))
+      return false;
+
+    return ((src.length() - pos) == 4 || !isdigit(src [pos+4]));
+  }
+}
+
 /**
  * Attempts to interpret a number or set of digits.
  *
@@ -78,30 +123,15 @@ bool MathInterpreter::interpretNumber (MDEVector &target,
 	pos++;
 	continue;
       }
-      else if (isOneOf (src[pos], ", ")) {
-	if (curDigitGroupCount <= 3 && (src.length() - pos) >= 3) {
-	  // If we see "," or " " followed by 3 digits and then a non-digit,
-	  // assume this is a thousands separator within a number
-	  boost::regex re("^[, ]\\d{3}");
-	  boost::smatch matches;
-	  std::string searchStr = src.substr(pos, 4);
-	  if (boost::regex_search(searchStr, matches, re)) {
-	    // If the next character is NOT a number, we assume this
-	    // was a set of thousands and add it in.  If we see yet
-	    // another number, then this was not a thousands separator
-	    // and we abort.
-	    // Example when we continue: 1,024,576
-	    // Example when we do not: 1,24837,23872 (treat as separate)
-	    if ((src.length() - pos == 3) || !isdigit(src [pos+4])) {
-	      lhs += searchStr;
-	      pos += 4;
-	      curDigitGroupCount = 0;
-	    }
-	    else
-	      break;
-	  }
-	  else
-	    break;
+      else if (src[pos] == ',' || src[pos] == ' ') {
+	// If we see "," or " " followed by 3 digits and then a non-digit,
+	// assume this is a thousands separator within a number.  If we
+	// see yet another digit, then this was not a thousands separator
+	// and we stop here.
+	if (curDigitGroupCount <= 3 && isDigitGroup (src, pos, true)) {
+	  lhs.append (src, pos, 4);
+	  pos += 4;
+	  curDigitGroupCount = 0;
 	}
 	else
 	  break;
@@ -125,29 +155,12 @@ bool MathInterpreter::interpretNumber (MDEVector &target,
 	  rhs += src.substr(pos, 1);
 	  pos++;
 	} else if (src[pos] == ' ') {
-	  if (curDigitGroupCount <= 3 && (src.length() - pos) >= 3) {
-	    // If we see " " followed by 3 digits and then a non-digit,
-	    // assume this is a thousands separator within a number
-	    boost::regex re("^ \\d{3}");
-	    boost::smatch matches;
-	    std::string searchStr = src.substr(pos, 4);
-	    if (boost::regex_search(searchStr, matches, re)) {
-	      // If the next character is NOT a number, we assume this
-	      // was a set of thousands and add it in.  If we see yet
-	      // another number, then this was not a thousands separator
-	      // and we abort.
-	      // Example when we continue: 1,024,576
-	      // Example when we do not: 1,24837,23872 (treat as separate)
-	      if ((src.length() - pos == 3) || !isdigit(src [pos+4])) {
-		rhs += searchStr;
-		pos += 4;
-		curDigitGroupCount = 0;
-	      }
-	      else
-		break;
-	    }
-	    else
-	      break;
+	  // If we see " " followed by 3 digits and then a non-digit,
+	  // assume this is a thousands separator within a number
+	  if (curDigitGroupCount <= 3 && isDigitGroup (src, pos, false)) {
+	    rhs.append (src, pos, 4);
+	    pos += 4;
+	    curDigitGroupCount = 0;
 	  }
 	  else
 	    break;
@@ -6,13 +6,22 @@
 */
 
 
-#include <boost/regex.hpp>
-
 #include "logging.h"
 
 #include "MathInterpreter.h"
 #include "MathExceptions.h"
 
+namespace {
+  /**
+   * Builds a root once its index (possibly empty) and argument have been
+   * interpreted.
+   */
+  MathDocumentElementPtr makeRoot (const std::vector<MDEVector> &nested)
+  {
+    return boost::make_shared<MDE_Root>(nested [0], nested [1]);
+  }
+}
+
 /**
  * Attempts to interpret a root: _/100 (square root of 100)
  *                            or _/(n+1) (square root of 'n+1')
@@ -33,10 +42,10 @@
  * taken as the root index, and the entire paranthesees following that is
  * taken as the root argument.
  *
- * Returns true on success, false on error, and puts resulting elements
- * into the 'target' buffer.
+ * Returns true on success, false on error.  The element is built once its
+ * contents have been interpreted (see interpretNested()).
  */
-bool MathInterpreter::interpretRoot (MDEVector &target,
+bool MathInterpreter::interpretRoot (MDEVector & /*target*/,
 				  const std::string &src,
 				  size_t &i)
 {
@@ -45,30 +54,29 @@ bool MathInterpreter::interpretRoot (MDEVector &target,
 
   std::string root_index;
   std::string root_argument;
-  MDEVector root_index_vector;
 
   i += 2;
 
   // Look for root indexes, which may be a simple letter or number, or a
-  // more complex expression bounded by square brackets.
-  boost::regex root_index_regex("(\\w)+\\(");
-  boost::smatch mr;
+  // more complex expression bounded by square brackets.  A simple index
+  // must sit directly against the opening paren of the argument -- _/3(8)
+  // -- so only the run of word characters at the cursor is examined.
+  size_t pos = i;
+  while (pos < src.length() && (isalnum((unsigned char)src[pos]) || src[pos] == '_'))
+    pos++;
 
-  std::string searchStr = src.substr(i);
-  if (boost::regex_search(searchStr, mr, root_index_regex)) {
-    root_index = mr[1];
-    i += root_index.length();
+  if (pos > i && pos < src.length() && src [pos] == '(') {
+    root_index = src.substr(i, pos - i);
+    i = pos;
   } else if (src [i] == '[') {
     if (!extractGroup(root_index, src, i, "[", "]")) {
-      MSG_ERROR(ROOT_INDEX_NOT_TERMINATED, std::string("text in root index: '" + root_index + "'"));
-      BOOST_THROW_EXCEPTION (MathInterpreterException());
+      MSG_ERROR(ROOT_INDEX_NOT_TERMINATED, MSG_DETAIL("text in root index: '%s'") % root_index);
+      INTERPRET_FAIL();
     }
   }
 
-  if (!root_index.empty()) {
-    LOG_TRACE << "- found a root with an index: generating index vector for '" << root_index << "'";
-    root_index_vector = interpretBuffer(root_index);
-  }
+  if (!root_index.empty())
+    LOG_TRACE << "- found a root with an index: '" << root_index << "'";
   else
     LOG_TRACE << "- found a root with no index";
 
@@ -77,13 +85,13 @@ bool MathInterpreter::interpretRoot (MDEVector &target,
 
   if (src [i] == '@') {
     if (!extractGroup(root_argument, src, i, "@", "#", true)) {
-      MSG_ERROR(ROOT_NOT_TERMINATED, std::string("text in fractional root: '" + root_argument + "'"));
-      BOOST_THROW_EXCEPTION (MathInterpreterException());
+      MSG_ERROR(ROOT_NOT_TERMINATED, MSG_DETAIL("text in fractional root: '%s'") % root_argument);
+      INTERPRET_FAIL();
     }
   } else if (src [i] == '(') {
     if (!extractGroup(root_argument, src, i)) {
-      MSG_ERROR(ROOT_NOT_TERMINATED, std::string("text in root: '" + root_argument + "'"));
-      BOOST_THROW_EXCEPTION (MathInterpreterException());
+      MSG_ERROR(ROOT_NOT_TERMINATED, MSG_DETAIL("text in root: '%s'") % root_argument);
+      INTERPRET_FAIL();
     }
   } else {
     extractItem(root_argument, src, i);
@@ -91,7 +99,5 @@ bool MathInterpreter::interpretRoot (MDEVector &target,
 
   LOG_TRACE << "* found root: index='" << root_index << "', argument: '" << root_argument << "'";
 
-  MDEVector root_argument_vector = interpretBuffer (root_argument);
-  target.push_back (boost::make_shared<MDE_Root>(root_index_vector, root_argument_vector));
-  return true;
+  return interpretNested (makeRoot, root_index, root_argument);
 }
@@ -11,6 +11,16 @@
 #include "MathInterpreter.h"
 #include "MathExceptions.h"
 
+namespace {
+  /**
+   * Builds a subscript once its contents have been interpreted.
+   */
+  MathDocumentElementPtr makeSubscript (const std::vector<MDEVector> &nested)
+  {
+    return boost::make_shared<MDE_Subscript>(nested [0]);
+  }
+}
+
 /**
  * Attempts to interpret a subscript: _item or _(item)
  *
@@ -20,12 +30,12 @@
  * If _ is followed by parenthesees then the entire paranthesees is
  * taken as the subscript.
  *
- * Returns true on success, false on error, and puts resulting elements
- * into the 'target' buffer.
+ * Returns true on success, false on error.  The element is built once its
+ * contents have been interpreted (see interpretNested()).
  *
  * ##TODO: warn about empty subscriptions: x_() for example
  */
-bool MathInterpreter::interpretSubscript (MDEVector &target,
+bool MathInterpreter::interpretSubscript (MDEVector & /*target*/,
 				      const std::string &src,
 				      size_t &i)
 {
@@ -40,13 +50,13 @@ bool MathInterpreter::interpretSubscript (MDEVector &target,
   i++;
   if (src [i] == '(') {
     if (!extractGroup(subscript_contents, src, i)) {
-      MSG_ERROR(SUBSCRIPT_NOT_TERMINATED, std::string("text in subscript: '" + subscript_contents + "'"));
-      BOOST_THROW_EXCEPTION (MathInterpreterException());
+      MSG_ERROR(SUBSCRIPT_NOT_TERMINATED, MSG_DETAIL("text in subscript: '%s'") % subscript_contents);
+      INTERPRET_FAIL();
     }
   } else if (src [i] == '@') {
     if (!extractGroup(subscript_contents, src, i, "@", "#", true)) {
-      MSG_ERROR(EXPONENT_NOT_TERMINATED, std::string("text in fractional subscript: '" + subscript_contents + "'"));
-      BOOST_THROW_EXCEPTION (MathInterpreterException());
+      MSG_ERROR(EXPONENT_NOT_TERMINATED, MSG_DETAIL("text in fractional subscript: '%s'") % subscript_contents);
+      INTERPRET_FAIL();
     }
   } else {
     extractItem(subscript_contents, src, i);
@@ -54,8 +64,5 @@ bool MathInterpreter::interpretSubscript (MDEVector &target,
 
   LOG_TRACE << "* found subscript: " << subscript_contents;
 
-  MDEVector v;
-  v = interpretBuffer (subscript_contents);
-  target.push_back (boost::make_shared<MDE_Subscript>(v));
-  return true;
+  return interpretNested (makeSubscript, subscript_contents);
 }
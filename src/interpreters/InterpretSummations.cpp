@@ -11,14 +11,24 @@
 #include "MathInterpreter.h"
 #include "MathExceptions.h"
 
+namespace {
+  /**
+   * Builds a summation once its bounds have been interpreted.
+   */
+  MathDocumentElementPtr makeSummation (const std::vector<MDEVector> &nested)
+  {
+    return boost::make_shared<MDE_Summation>(nested [0], nested [1]);
+  }
+}
+
 /**
  * Attempts to interpret a fraction: `S(lower, upper) ...
 
- * Returns true on success, false on error, and puts resulting elements
- * into the 'target' buffer.
+ * Returns true on success, false on error.  The element is built once its
+ * contents have been interpreted (see interpretNested()).
  *
  */
-bool MathInterpreter::interpretSummation (MDEVector &target,
+bool MathInterpreter::interpretSummation (MDEVector & /*target*/,
 					  const std::string &src,
 					  size_t &i)
 {
@@ -42,8 +52,8 @@ bool MathInterpreter::interpretSummation (MDEVector &target,
   std::string upperBoundStr;
   LOG_TRACE << "before ETD: pos " << pos << ", buffer: " << src.substr(pos, 20);
   if (!extractToDelimiter(lowerBoundStr, src, pos, ",")) {
-    //## TODO: ADD ERROR MESSAGE - unable to extrtact lower bound
-    BOOST_THROW_EXCEPTION (MathInterpreterException());
+    MSG_ERROR(SUMMATION_LOWER_BOUND_NOT_TERMINATED, MSG_DETAIL("text in summation bounds: '%s'") % src.substr(pos));
+    INTERPRET_FAIL();
   }
   LOG_TRACE << "after ETD: pos " << pos << ", buffer: " << src.substr(pos, 20);
 
@@ -55,8 +65,8 @@ bool MathInterpreter::interpretSummation (MDEVector &target,
   LOG_TRACE << "extractToDelimeter calling on pos " << pos << ": buffer '" << src.substr(pos, 20) << "...";
 
   if (!extractToDelimiter(upperBoundStr, src, pos, ")")) {
-    //## TODO: ADD ERROR MESSAGE - unable to extrtact upper bound
-    BOOST_THROW_EXCEPTION (MathInterpreterException());
+    MSG_ERROR(SUMMATION_UPPER_BOUND_NOT_TERMINATED, MSG_DETAIL("text in summation upper bound: '%s'") % src.substr(pos));
+    INTERPRET_FAIL();
   }
 
   // advance cursor
@@ -64,12 +74,5 @@ bool MathInterpreter::interpretSummation (MDEVector &target,
 
   LOG_TRACE << "* found summation: lower=" << lowerBoundStr << ", upper=" << upperBoundStr;
 
-  MDEVector lowerBoundVec;
-  MDEVector upperBoundVec;
-
-  lowerBoundVec = interpretBuffer (lowerBoundStr);
-  upperBoundVec = interpretBuffer (upperBoundStr);
-
-  target.push_back (boost::make_shared<MDE_Summation>(lowerBoundVec, upperBoundVec));
-  return true;
+  return interpretNested (makeSummation, lowerBoundStr, upperBoundStr);
 }
@@ -5,8 +5,6 @@
  * This project is released under the GNU General Public License.
 */
 
-#include <boost/assign.hpp>
-
 #include "logging.h"
 
 #include "MathInterpreter.h"
@@ -18,54 +16,62 @@
  * Returns true on success, false on error, and puts resulting elements
  * into the 'target' buffer.
  */
-namespace {
-  struct SymbolMap {
-    SymbolMap (const std::string &s, const MDE_Symbol::Symbol sym) : search(s), symbol(sym) {}
-    std::string search;
-    MDE_Symbol::Symbol symbol;
-  };
-}
-
 bool MathInterpreter::interpretSymbol (MDEVector &target,
 				    const std::string &src,
 				    size_t &i)
 {
-  #define MAX_SYMBOL_LEN 2
-  // Be sure to update MAX_SYMBOL_LEN if longer symbols get added to
-  // this table.  Place longer symbols at the top.
-  static const std::vector<SymbolMap> map = boost::assign::list_of
-    ( SymbolMap("%%", MDE_Symbol::PERCENT) )
-    ( SymbolMap("/\\", MDE_Symbol::THEREFORE) )
-    ( SymbolMap(",", MDE_Symbol::COMMA) )
-    ( SymbolMap("`C", MDE_Symbol::CURRENCY_CENTS) )
-    ( SymbolMap("`E", MDE_Symbol::CURRENCY_EURO) )
-    ( SymbolMap("`F", MDE_Symbol::CURRENCY_FRANC) )
-    ( SymbolMap("`P", MDE_Symbol::CURRENCY_POUND) )
-    ( SymbolMap("`$", MDE_Symbol::CURRENCY_DOLLAR) )
-    ( SymbolMap("`Y", MDE_Symbol::CURRENCY_YEN) )
-    ( SymbolMap("{", MDE_Symbol::LEFT_BRACE) )
-    ( SymbolMap("[", MDE_Symbol::LEFT_BRACKET) )
-    ( SymbolMap("(", MDE_Symbol::LEFT_PAREN) )
-    ( SymbolMap("!", MDE_Symbol::FACTORIAL) )
-    ( SymbolMap(".", MDE_Symbol::PERIOD) )
-    ( SymbolMap("}", MDE_Symbol::RIGHT_BRACE) )
-    ( SymbolMap("]", MDE_Symbol::RIGHT_BRACKET) )
-    ( SymbolMap(")", MDE_Symbol::RIGHT_PAREN) )
-    ;
+  // Dispatch directly on the first character.  Multi-character symbols
+  // then only need to look at the character that follows; as before,
+  // the letters of currency symbols are matched case-insensitively.
+  const char next = (i+1 < src.length()) ? src [i+1] : '\0';
+  MDE_Symbol::Symbol symbol;
+  size_t len = 1;
 
-  const std::string temp = src.substr(i, MAX_SYMBOL_LEN);
+  switch (src [i]) {
+  case '%':
+    if (next != '%')
+      return false;
+    symbol = MDE_Symbol::PERCENT;
+    len = 2;
+    break;
 
-  for (std::vector<SymbolMap>::const_iterator it = map.begin();
-       it != map.end(); ++it) {
-    const SymbolMap &mi = *it;
+  case '/':
+    if (next != '\\')
+      return false;
+    symbol = MDE_Symbol::THEREFORE;
+    len = 2;
+    break;
 
-    if (strBeginsWith(temp, mi.search)) {
-      LOG_TRACE << "* added symbol (" << mi.search << ")";
-      target.push_back (boost::make_shared<MDE_Symbol>(mi.symbol));
-      i += mi.search.length();
-      return true;
+  case '`':
+    switch (toupper(next)) {
+    case 'C': symbol = MDE_Symbol::CURRENCY_CENTS; break;
+    case 'E': symbol = MDE_Symbol::CURRENCY_EURO; break;
+    case 'F': symbol = MDE_Symbol::CURRENCY_FRANC; break;
+    case 'P': symbol = MDE_Symbol::CURRENCY_POUND; break;
+    case '$': symbol = MDE_Symbol::CURRENCY_DOLLAR; break;
+    case 'Y': symbol = MDE_Symbol::CURRENCY_YEN; break;
+    default:
+      return false;
     }
+    len = 2;
+    break;
+
+  case ',': symbol = MDE_Symbol::COMMA; break;
+  case '{': symbol = MDE_Symbol::LEFT_BRACE; break;
+  case '[': symbol = MDE_Symbol::LEFT_BRACKET; break;
+  case '(': symbol = MDE_Symbol::LEFT_PAREN; break;
+  case '!': symbol = MDE_Symbol::FACTORIAL; break;
+  case '.': symbol = MDE_Symbol::PERIOD; break;
+  case '}': symbol = MDE_Symbol::RIGHT_BRACE; break;
+  case ']': symbol = MDE_Symbol::RIGHT_BRACKET; break;
+  case ')': symbol = MDE_Symbol::RIGHT_PAREN; break;
+
+  default:
+    return false;
   }
 
-  return false;
+  LOG_TRACE << "* added symbol (" << src.substr(i, len) << ")";
+  target.push_back (boost::make_shared<MDE_Symbol>(symbol));
+  i += len;
+  return true;
 }
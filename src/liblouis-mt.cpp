@@ -2,6 +2,11 @@
  * @file liblouis-mt.cpp
  * Support functions for interfacing with the liblouis library
  *
+ * liblouis works in UTF-16, and the rest of MathText in UTF-8; text is
+ * converted between the two on its way in and out.  Nearly all of it is
+ * ASCII, so runs of ASCII are converted 16 characters at a time where SSE2
+ * is available.
+ *
  * @copyright Copyright 2015 Anthony Tibbs
  * This project is released under the GNU General Public License.
 */
@@ -9,20 +14,211 @@
 #include <string>
 #include "liblouis-mt.h"
 
-void strToWideCharString(const std::string &str, ll_widechar *outString, unsigned &outLength)
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define LIBLOUIS_USE_SSE2
+#include <emmintrin.h>
+#endif
+
+// Stands in for anything that cannot be converted
+#define REPLACEMENT_CHARACTER 0xFFFD
+
+namespace {
+  /**
+   * Works out the code point of the UTF-8 sequence starting at 'in', which
+   * is not ASCII.  Malformed sequences (truncated, overlong, surrogates or
+   * out of range) are taken one byte at a time, each as U+FFFD.
+   *
+   * @param length Number of bytes available at 'in'
+   * @param used Receives the number of bytes the sequence takes up
+   */
+  unsigned long decodeUTF8 (const unsigned char *in, const size_t length, size_t &used)
+  {
+    const unsigned char lead = in [0];
+    unsigned long codePoint;
+    size_t numBytes;
+    unsigned long minimum;
+
+    used = 1;
+    if (lead >= 0xC2 && lead <= 0xDF) {
+      numBytes = 2; codePoint = lead & 0x1F; minimum = 0x80;
+    } else if (lead >= 0xE0 && lead <= 0xEF) {
+      numBytes = 3; codePoint = lead & 0x0F; minimum = 0x800;
+    } else if (lead >= 0xF0 && lead <= 0xF4) {
+      numBytes = 4; codePoint = lead & 0x07; minimum = 0x10000;
+    } else {
+      return REPLACEMENT_CHARACTER;
+    }
+
+    if (numBytes > length)
+      return REPLACEMENT_CHARACTER;
+
+    for (size_t n = 1; n < numBytes; n++) {
+      if ((in [n] & 0xC0) != 0x80)
+	return REPLACEMENT_CHARACTER;
+      codePoint = (codePoint << 6) | (in [n] & 0x3F);
+    }
+
+    if (codePoint < minimum || codePoint > 0x10FFFF ||
+	(codePoint >= 0xD800 && codePoint <= 0xDFFF))
+      return REPLACEMENT_CHARACTER;
+
+    used = numBytes;
+    return codePoint;
+  }
+
+  /**
+   * Writes a code point as UTF-8.
+   *
+   * @return Number of bytes written (at most 4)
+   */
+  size_t encodeUTF8 (const unsigned long codePoint, char *out)
+  {
+    if (codePoint < 0x80) {
+      out [0] = (char)codePoint;
+      return 1;
+    } else if (codePoint < 0x800) {
+      out [0] = (char)(0xC0 | (codePoint >> 6));
+      out [1] = (char)(0x80 | (codePoint & 0x3F));
+      return 2;
+    } else if (codePoint < 0x10000) {
+      out [0] = (char)(0xE0 | (codePoint >> 12));
+      out [1] = (char)(0x80 | ((codePoint >> 6) & 0x3F));
+      out [2] = (char)(0x80 | (codePoint & 0x3F));
+      return 3;
+    }
+
+    out [0] = (char)(0xF0 | (codePoint >> 18));
+    out [1] = (char)(0x80 | ((codePoint >> 12) & 0x3F));
+    out [2] = (char)(0x80 | ((codePoint >> 6) & 0x3F));
+    out [3] = (char)(0x80 | (codePoint & 0x3F));
+    return 4;
+  }
+}
+
+/**
+ * Converts UTF-8 text to the UTF-16 used by liblouis.
+ *
+ * @param str Text to convert
+ * @param outString Buffer for the converted text, which is terminated
+ *        with a 0
+ * @param maxLength Size of the buffer, including room for the 0
+ * @param outLength Receives the length of the converted text (without the
+ *        0)
+ * @return false if the converted text does not fit in the buffer
+ */
+bool strToWideCharString(const std::string &str, ll_widechar *outString,
+			 const unsigned maxLength, unsigned &outLength)
 {
+  const unsigned char *in = reinterpret_cast<const unsigned char *>(str.data());
+  const size_t length = str.length();
+  size_t inPos = 0;
   unsigned outPos = 0;
 
-  for (size_t inPos = 0; inPos < str.length(); inPos++)
-    outString[outPos++] = (ll_widechar)str[inPos];
+  // Every byte gives at most one UTF-16 unit, so if the whole string fits
+  // there is no need to check for room as we go
+  const bool fits = (length < maxLength);
+
+  while (inPos < length) {
+#ifdef LIBLOUIS_USE_SSE2
+    if (fits) {
+      const __m128i zero = _mm_setzero_si128();
+      while (inPos + 16 <= length) {
+	const __m128i block = _mm_loadu_si128 (reinterpret_cast<const __m128i *>(in + inPos));
+	if (_mm_movemask_epi8 (block))
+	  break; // not all ASCII
+
+	_mm_storeu_si128 (reinterpret_cast<__m128i *>(outString + outPos), _mm_unpacklo_epi8 (block, zero));
+	_mm_storeu_si128 (reinterpret_cast<__m128i *>(outString + outPos + 8), _mm_unpackhi_epi8 (block, zero));
+	inPos += 16;
+	outPos += 16;
+      }
+      if (inPos >= length)
+	break;
+    }
+#endif
+
+    if (in [inPos] < 0x80) {
+      if (!fits && outPos + 1 >= maxLength)
+	return false;
+      outString [outPos++] = in [inPos++];
+      continue;
+    }
+
+    size_t used;
+    const unsigned long codePoint = decodeUTF8 (in + inPos, length - inPos, used);
+    inPos += used;
+
+    if (codePoint < 0x10000) {
+      if (!fits && outPos + 1 >= maxLength)
+	return false;
+      outString [outPos++] = (ll_widechar)codePoint;
+    } else {
+      if (!fits && outPos + 2 >= maxLength)
+	return false;
+      outString [outPos++] = (ll_widechar)(0xD800 + ((codePoint - 0x10000) >> 10));
+      outString [outPos++] = (ll_widechar)(0xDC00 + ((codePoint - 0x10000) & 0x3FF));
+    }
+  }
 
   outString[outPos] = 0;
   outLength = outPos;
+  return true;
 }
 
+/**
+ * Converts UTF-16 text from liblouis to UTF-8, appending it to a string.
+ * Unpaired surrogates are converted to U+FFFD.
+ *
+ * @param str Text to convert
+ * @param inLength Length of the text
+ * @param outString String to append the converted text to
+ */
 void wideCharStringToStr(const ll_widechar *str, const unsigned inLength, std::string &outString)
 {
-  for (unsigned inPos = 0; inPos < inLength; inPos++)
-    outString += std::string(1, (char)str[inPos]);
-}
+  const size_t start = outString.length();
 
+  // Every UTF-16 unit gives at most three bytes (a surrogate pair gives
+  // four, for two units)
+  outString.resize (start + 3 * (size_t)inLength);
+  char *out = &outString [0] + start;
+  unsigned inPos = 0;
+
+  while (inPos < inLength) {
+#ifdef LIBLOUIS_USE_SSE2
+    const __m128i nonASCII = _mm_set1_epi16 ((short)0xFF80);
+    const __m128i zero = _mm_setzero_si128();
+    while (inPos + 16 <= inLength) {
+      const __m128i low = _mm_loadu_si128 (reinterpret_cast<const __m128i *>(str + inPos));
+      const __m128i high = _mm_loadu_si128 (reinterpret_cast<const __m128i *>(str + inPos + 8));
+      const __m128i bits = _mm_and_si128 (_mm_or_si128 (low, high), nonASCII);
+      if (_mm_movemask_epi8 (_mm_cmpeq_epi16 (bits, zero)) != 0xFFFF)
+	break; // not all ASCII
+
+      _mm_storeu_si128 (reinterpret_cast<__m128i *>(out), _mm_packus_epi16 (low, high));
+      inPos += 16;
+      out += 16;
+    }
+    if (inPos >= inLength)
+      break;
+#endif
+
+    const unsigned long unit = str [inPos++];
+    if (unit < 0x80) {
+      *out++ = (char)unit;
+      continue;
+    }
+
+    unsigned long codePoint = unit;
+    if (unit >= 0xD800 && unit <= 0xDBFF && inPos < inLength &&
+	str [inPos] >= 0xDC00 && str [inPos] <= 0xDFFF) {
+      codePoint = 0x10000 + ((unit - 0xD800) << 10) + (str [inPos] - 0xDC00);
+      inPos++;
+    } else if (unit >= 0xD800 && unit <= 0xDFFF) {
+      codePoint = REPLACEMENT_CHARACTER;
+    }
+
+    out += encodeUTF8 (codePoint, out);
+  }
+
+  outString.resize (out - outString.data());
+}
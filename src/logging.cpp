@@ -10,23 +10,40 @@
 
 #include <iostream>
 #include <fstream>
+#include <boost/thread/tss.hpp>
 #include "logging.h"
 
-int logIndentLevel = 0;
+namespace {
+  boost::thread_specific_ptr<int> logIndentLevel;
+
+  int &indentLevel (void)
+  {
+    if (!logIndentLevel.get())
+      logIndentLevel.reset (new int(0));
+
+    return *logIndentLevel;
+  }
+}
+
 void logIncreaseIndent (void)
 {
-  logIndentLevel++;
+  indentLevel()++;
 }
 
 void logDecreaseIndent (void)
 {
-  assert (logIndentLevel != 0);
-  logIndentLevel--;
+  assert (indentLevel() != 0);
+  indentLevel()--;
 }
 
 void logResetIndent (void)
 {
-  logIndentLevel = 0;
+  indentLevel() = 0;
+}
+
+int logGetIndent (void)
+{
+  return indentLevel();
 }
 
 namespace logging = boost::log;
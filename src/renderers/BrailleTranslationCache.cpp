@@ -0,0 +1,174 @@
+/**
+ * @file BrailleTranslationCache.cpp
+ * Implementation of the cache of text translated to braille
+ *
+ * @copyright Copyright 2015 Anthony Tibbs
+ * This project is released under the GNU General Public License.
+*/
+
+#include <boost/functional/hash.hpp>
+#include <boost/thread/lock_guard.hpp>
+
+#include "BrailleTranslationCache.h"
+
+BrailleTranslationCache::Statistics::Statistics ()
+  : hits(0), misses(0), evictions(0), entries(0), bytesUsed(0),
+    microsecondsSaved(0)
+{
+}
+
+/**
+ * Returns the fraction (0 to 1) of lookups that found an entry.
+ */
+double BrailleTranslationCache::Statistics::getHitRate (void) const
+{
+  if (hits + misses == 0)
+    return 0;
+
+  return (double)hits / (hits + misses);
+}
+
+bool BrailleTranslationCache::Key::operator== (const Key &other) const
+{
+  return (withHints == other.withHints &&
+	  text == other.text &&
+	  table == other.table);
+}
+
+size_t BrailleTranslationCache::KeyHash::operator() (const Key &key) const
+{
+  size_t seed = boost::hash_value(key.text);
+  boost::hash_combine (seed, key.table);
+  boost::hash_combine (seed, key.withHints);
+  return seed;
+}
+
+/**
+ * Sets up an empty cache.
+ *
+ * @param maxBytes Approximate upper limit on the memory used by entries
+ */
+BrailleTranslationCache::BrailleTranslationCache (const size_t maxBytes)
+  : m_maxBytes(maxBytes)
+{
+}
+
+/**
+ * Looks for a previous translation of some text.
+ *
+ * @param table liblouis translation table the text is translated with
+ * @param text Text to be translated
+ * @param withHints Whether wrapping hints are wanted
+ * @param braille Buffer the braille is appended to, if found
+ * @param hints Receives the wrapping hints for the braille, if found, as
+ *        offsets into the braille buffer
+ * @return true if a translation was found
+ */
+bool BrailleTranslationCache::lookup (const std::string &table,
+				      const std::string &text,
+				      const bool withHints,
+				      std::string &braille,
+				      std::vector<UEBRenderer::WrapHint> &hints)
+{
+  Key key;
+  key.table = table;
+  key.text = text;
+  key.withHints = withHints;
+
+  boost::lock_guard<boost::mutex> lock (m_mutex);
+
+  EntryIndex::iterator it = m_index.find(key);
+  if (it == m_index.end()) {
+    m_stats.misses++;
+    return false;
+  }
+
+  // Move to the front of the LRU list
+  m_entries.splice (m_entries.begin(), m_entries, it->second);
+
+  const Entry &entry = *it->second;
+  const size_t start = braille.length();
+  braille += entry.braille;
+  for (std::vector<UEBRenderer::WrapHint>::const_iterator hint = entry.hints.begin();
+       hint != entry.hints.end(); ++hint) {
+    const UEBRenderer::WrapHint moved = { start + hint->offset, hint->type };
+    hints.push_back (moved);
+  }
+
+  m_stats.hits++;
+  m_stats.microsecondsSaved += entry.microseconds;
+  return true;
+}
+
+/**
+ * Adds a translation to the cache, dropping the least recently used
+ * entries if that takes it over its memory limit.
+ *
+ * @param hints Wrapping hints for the braille, as offsets into it
+ * @param microseconds How long the text took to translate; hits on the
+ *        entry count this much towards the time saved
+ */
+void BrailleTranslationCache::store (const std::string &table,
+				     const std::string &text,
+				     const bool withHints,
+				     const std::string &braille,
+				     const std::vector<UEBRenderer::WrapHint> &hints,
+				     const unsigned long microseconds)
+{
+  Entry entry;
+  entry.key.table = table;
+  entry.key.text = text;
+  entry.key.withHints = withHints;
+  entry.braille = braille;
+  entry.hints = hints;
+  entry.microseconds = microseconds;
+
+  // The key is held twice: in the entry, and in the index
+  entry.bytes = sizeof(Entry) + 2 * (table.length() + text.length()) +
+    braille.length() + hints.size() * sizeof(UEBRenderer::WrapHint);
+
+  if (entry.bytes > m_maxBytes)
+    return;
+
+  boost::lock_guard<boost::mutex> lock (m_mutex);
+
+  // Another renderer may have stored the same text in the meantime
+  if (m_index.count(entry.key))
+    return;
+
+  m_entries.push_front (entry);
+  m_index [entry.key] = m_entries.begin();
+  m_stats.bytesUsed += entry.bytes;
+
+  while (m_stats.bytesUsed > m_maxBytes) {
+    const Entry &oldest = m_entries.back();
+    m_stats.bytesUsed -= oldest.bytes;
+    m_stats.evictions++;
+    m_index.erase (oldest.key);
+    m_entries.pop_back();
+  }
+
+  m_stats.entries = m_entries.size();
+}
+
+/**
+ * Removes all entries (the statistics are kept).
+ */
+void BrailleTranslationCache::clear (void)
+{
+  boost::lock_guard<boost::mutex> lock (m_mutex);
+
+  m_index.clear();
+  m_entries.clear();
+  m_stats.entries = 0;
+  m_stats.bytesUsed = 0;
+}
+
+/**
+ * Returns a snapshot of the cache's usage figures.
+ */
+BrailleTranslationCache::Statistics BrailleTranslationCache::getStatistics (void) const
+{
+  boost::lock_guard<boost::mutex> lock (m_mutex);
+  return m_stats;
+}
@@ -11,8 +11,10 @@
 
 #include <boost/algorithm/string.hpp>
 #include <boost/assign.hpp>
+#include <boost/bind.hpp>
 #include <boost/format.hpp>
 
+#include "CharClass.h"
 #include "logging.h"
 
 #include "MathExceptions.h"
@@ -20,6 +22,11 @@
 
 namespace ba = boost::assign;
 
+namespace {
+  // Characters escaped by makeLaTeXSafe()
+  const CharClass LATEX_SPECIAL_CHARS ("#\\_^{}");
+}
+
 LaTeXRenderer::LaTeXRenderer() : MathRenderer()
 {
   writerLineMode = UNKNOWN;
@@ -32,11 +39,11 @@ LaTeXRenderer::LaTeXRenderer() : MathRenderer()
 }
 
 /**
- * @copydoc MathRenderer::renderDocument
+ * @copydoc MathRenderer::beginDocument
  *
- * The rendered document includes the LaTeX preamble, \\begin, \\end, etc.
+ * Produces the LaTeX preamble and \\begin{document}.
  */
-std::string LaTeXRenderer::renderDocument (const MathDocument &document)
+std::string LaTeXRenderer::beginDocument (void)
 {
   std::string output;
 
@@ -57,13 +64,19 @@ std::string LaTeXRenderer::renderDocument (const MathDocument &document)
   output += "\\parskip 0in \\parindent 0in\n";
 	output += "\\setlength{\\mathindent}{0pt}\n";
   output += "\\begin{document}\n\n";
-
-  output += MathRenderer::renderDocument (document);
-
-  output += "\n\\end{document}\n";
   return output;
 }
 
+/**
+ * @copydoc MathRenderer::endDocument
+ *
+ * Produces the closing \\end{document}.
+ */
+std::string LaTeXRenderer::endDocument (void)
+{
+  return "\n\\end{document}\n";
+}
+
 /**
  * Provides the interpreter with a list of LaTeX-specific commands.
  *
@@ -92,38 +105,40 @@ void LaTeXRenderer::getInterpreterCommandList (std::vector<std::string> &cmdlist
 std::string LaTeXRenderer::makeLaTeXSafe (const std::string &input)
 {
   std::string output;
-  bool bSawLatexEscape = false;
-
-  for (size_t pos = 0; pos < input.length(); pos++) {
-    char ch = input [pos];
-
-    if (!bSawLatexEscape) {
-      if (ch == '#') {
-      	output += "\\#";
-      } else if (ch == '\\') {
-      	output += "\\backslash ";
-      } else if (ch == '_') {
-	      output += "\\underline ";
-      } else if (ch == '^') {
-	      output += "\\^{}";
-      } else if (ch == '{') {
-	      output += "\\lbrace ";
-      } else if (ch == '}') {
-	      output += "\\rbrace ";
-      }
-      else if (ch == '\\') {
-	      bSawLatexEscape = true;
-	      output += "\\";
-      } else {
-	      output += ch;
-      }
-    } else {
-      output += ch;
-      bSawLatexEscape = false;
+  makeLaTeXSafe (input, output);
+  return output;
+}
+
+/**
+ * Sanitizes a text string, appending it to the LaTeX output.
+ *
+ * @param [in] input Text string to be sanitized
+ * @param [out] output Buffer to append the sanitized string to
+ * @see makeLaTeXSafe(const std::string &)
+ */
+void LaTeXRenderer::makeLaTeXSafe (const std::string &input, std::string &output)
+{
+  size_t pos = 0;
+
+  // Copy the runs of ordinary characters between special ones in bulk
+  for (;;) {
+    const size_t next = LATEX_SPECIAL_CHARS.find (input, pos);
+    if (next == std::string::npos) {
+      output.append (input, pos, std::string::npos);
+      break;
     }
-  }
 
-  return output;
+    output.append (input, pos, next - pos);
+    switch (input [next]) {
+    case '#': output += "\\#"; break;
+    case '\\': output += "\\backslash "; break;
+    case '_': output += "\\underline "; break;
+    case '^': output += "\\^{}"; break;
+    case '{': output += "\\lbrace "; break;
+    case '}': output += "\\rbrace "; break;
+    }
+    pos = next + 1;
+  }
 }
 
 /**
@@ -189,21 +204,82 @@ void LaTeXRenderer::endInternalRender (void)
 }
 
 /**
- * Renders mathematical material into the LaTeX file.
+ * Renders an optional argument of a root or summation (an index or bound),
+ * enclosed by 'open' and 'close'.  Nothing at all is output if the
+ * argument renders to nothing.
  *
- * Inserts the provided text (assumed to be already-rendere LaTeX) into 
- * the output, changing to math mode (and beginning a math environment) 
- * if required.
+ * @param [in] v Elements making up the argument
+ * @param [in] open Text to put before the argument
+ * @param [in] close Text to put after the argument
+ * @param [out] output Buffer to append to
+ */
+void LaTeXRenderer::renderArgument (const MDEVector &v, const std::string &open,
+				    const std::string &close, std::string &output)
+{
+  const size_t start = output.length();
+
+  output += open;
+  renderNested (v);
+  scheduleStep (boost::bind(&LaTeXRenderer::finishArgument, this, start,
+			    output.length(), close, _1));
+}
+
+/**
+ * Closes an argument begun by renderArgument(), once it has been rendered.
  *
- * @param [in] s Rendered LaTeX to be inserted into the output
- * @return Input string, with any mode change indicators prepended as required
- * @see writerCurrentMode, writerLineMode, isStartOfLine
+ * @param [in] start Where the argument's opening text began in the output
+ * @param [in] argumentStart ... and where the argument itself began
+ * @param [in] close Text to put after the argument
+ * @param [out] output Buffer to append to
  */
-std::string LaTeXRenderer::renderMathContent (const std::string &s)
+void LaTeXRenderer::finishArgument (const size_t start, const size_t argumentStart,
+				    const std::string &close, std::string &output)
 {
-  std::string output;
+  if (output.length() == argumentStart)
+    output.resize (start);
+  else
+    output += close;
+}
+
+/**
+ * Renders elements nested in a construct, after the text 'open'.
+ *
+ * @param [in] v Elements to render
+ * @param [in] open Text to put before them
+ * @param [out] output Buffer to append to
+ */
+void LaTeXRenderer::renderContents (const MDEVector &v, const std::string &open,
+				    std::string &output)
+{
+  output += open;
+  renderNested (v);
+}
+
+/**
+ * Finishes off a construct once the elements nested in it have been
+ * rendered: the counterpart of beginInternalRender().
+ *
+ * @param [in] close Text to put after the construct
+ * @param [out] output Buffer to append to
+ */
+void LaTeXRenderer::endNested (const std::string &close, std::string &output)
+{
+  endInternalRender();
+  output += close;
+}
 
-  LOG_TRACE << "enter LaTeXRenderer::renderMathContent (" << s << ")";
+/**
+ * Prepares to render mathematical material into the LaTeX file.
+ *
+ * Changes to math mode (beginning a math environment) if required, so
+ * that rendered LaTeX for the material can then be appended to the output.
+ *
+ * @param [out] output Buffer to append any mode change indicators to
+ * @see writerCurrentMode, writerLineMode, isStartOfLine
+ */
+void LaTeXRenderer::beginMathContent (std::string &output)
+{
+  LOG_TRACE << "enter LaTeXRenderer::beginMathContent";
   LOG_TRACE << "   >> " << status();
   logIncreaseIndent();
 
@@ -245,32 +321,43 @@ std::string LaTeXRenderer::renderMathContent (const std::string &s)
     }
   }
 
-  output += s;
   if (!doingInternalRender())
     isStartOfLine = false;
 
   logDecreaseIndent();
-  LOG_TRACE << "exit LaTeXRenderer::renderMathContent: " << output;
+  LOG_TRACE << "exit LaTeXRenderer::beginMathContent";
   LOG_TRACE << "  >> " << status();
+}
 
-  return output;
+/**
+ * Renders mathematical material into the LaTeX file.
+ *
+ * Appends the provided text (assumed to be already-rendered LaTeX) to
+ * the output, changing to math mode first if required.
+ *
+ * @param [in] s Rendered LaTeX to be inserted into the output
+ * @param [out] output Buffer to append to
+ * @see beginMathContent
+ */
+void LaTeXRenderer::renderMathContent (const std::string &s, std::string &output)
+{
+  beginMathContent (output);
+  output += s;
 }
 
 /**
 * Renders textual material into the LaTeX file.
 *
-* Inserts the provided text (assumed to be already-rendere LaTeX) into
-* the output, changing to text mode (and ending a math environment)
+* Appends the provided text to the output, escaping any LaTeX special
+* characters, and changing to text mode (and ending a math environment)
 * if required.
 *
-* @param [in] s Rendered LaTeX to be inserted into the output
-* @return Input string, with any mode change indicators prepended as required
+* @param [in] s Text to be inserted into the output
+* @param [out] output Buffer to append to
 * @see writerCurrentMode, writerLineMode, isStartOfLine
 */
-std::string LaTeXRenderer::renderTextContent(const std::string &s)
+void LaTeXRenderer::renderTextContent(const std::string &s, std::string &output)
 {
-  std::string output;
-
   LOG_TRACE << "enter LaTeXRenderer::renderTextContent (" << s << ")";
   LOG_TRACE << "   >> " << status();
   logIncreaseIndent();
@@ -311,14 +398,12 @@ std::string LaTeXRenderer::renderTextContent(const std::string &s)
     }
   }
 
-  output += makeLaTeXSafe(s);
+  makeLaTeXSafe(s, output);
   isStartOfLine = false;
 
   logDecreaseIndent();
-  LOG_TRACE << "exit LaTeXRenderer::renderTextContent: " << output;
+  LOG_TRACE << "exit LaTeXRenderer::renderTextContent";
   LOG_TRACE << "  >> " << status();
-
-  return output;
 }
 
 /**
@@ -327,22 +412,20 @@ std::string LaTeXRenderer::renderTextContent(const std::string &s)
  * In the LaTeX file, the original source code lines are inserted with 
  * the source filename and line number, to aid in troubleshooting.
  */
-std::string LaTeXRenderer::renderSourceLine (const MDE_SourceLine *e)
+void LaTeXRenderer::renderSourceLine (const MDE_SourceLine *e, std::string &output)
 {
-  std::string output;
-
-  output = "%% " + e->getString() + "\n";
+  output += "%% ";
+  output += e->getString();
+  output += "\n";
   LOG_TRACE << "%% " << e->getString();
-
-  return output;
 }
 
-std::string LaTeXRenderer::renderCommand (const MDE_Command *e)
+void LaTeXRenderer::renderCommand (const MDE_Command *e, std::string &output)
 {
-  std::string output;
-
-  output = "%% COMMAND: " + e->getString() + "\n";
-  LOG_TRACE << output;
+  output += "%% COMMAND: ";
+  output += e->getString();
+  output += "\n";
+  LOG_TRACE << "%% COMMAND: " << e->getString();
 
   // automatic sizing of group enclosures (brackets) works well at producing
   // nicely formatted output, but fails if a single line of math breaks
@@ -361,14 +444,10 @@ std::string LaTeXRenderer::renderCommand (const MDE_Command *e)
 
     }
   }
-
-  return output;
 }
 
-std::string LaTeXRenderer::renderMathModeMarker (const MDE_MathModeMarker *e)
+void LaTeXRenderer::renderMathModeMarker (const MDE_MathModeMarker *e, std::string & /*output*/)
 {
-  std::string output;
-
   LOG_TRACE << "enter LaTeXRenderer::renderMathModeMarker (" << *e << ")";
   LOG_TRACE << "  >> " << status();
   logIncreaseIndent();
@@ -378,14 +457,10 @@ std::string LaTeXRenderer::renderMathModeMarker (const MDE_MathModeMarker *e)
   logDecreaseIndent();
   LOG_TRACE << "exit LaTeXRenderer::renderMathModeMarker: no output";
   LOG_TRACE << "  >> " << status();
-
-  return output;
 }
 
-std::string LaTeXRenderer::renderTextModeMarker (const MDE_TextModeMarker *e)
+void LaTeXRenderer::renderTextModeMarker (const MDE_TextModeMarker *e, std::string & /*output*/)
 {
-  std::string output;
-
   LOG_TRACE << "enter LaTeXRenderer::renderTextModeMarker: (" << *e << ")";
   LOG_TRACE << "  >> " << status();
   logIncreaseIndent();
@@ -395,8 +470,6 @@ std::string LaTeXRenderer::renderTextModeMarker (const MDE_TextModeMarker *e)
   logDecreaseIndent();
   LOG_TRACE << "exit LaTeXRenderer::renderTextModeMarker: no output";
   LOG_TRACE << "  >> " << status();
-
-  return output;
 }
 
 /**
@@ -408,9 +481,9 @@ std::string LaTeXRenderer::renderTextModeMarker (const MDE_TextModeMarker *e)
  *
  * In the case of blank lines, a 10pt vertical space is inserted.
  */
-std::string LaTeXRenderer::renderLineBreak (const MDE_LineBreak *e)
+void LaTeXRenderer::renderLineBreak (const MDE_LineBreak *e, std::string &output)
 {
-  std::string output;
+  const size_t start = output.length();
 
   LOG_TRACE << "enter LaTeXRenderer::renderLineBreak: (" << *e << ")";
   LOG_TRACE << "  >> " << status();
@@ -450,34 +523,37 @@ std::string LaTeXRenderer::renderLineBreak (const MDE_LineBreak *e)
   isStartOfLine = true;
 
   logDecreaseIndent();
-  LOG_TRACE << "exit LaTeXRenderer::renderLineBreak: " << output;
+  LOG_TRACE << "exit LaTeXRenderer::renderLineBreak: " << output.substr(start);
   LOG_TRACE << "  >> " << status();
+}
 
-  return output;
+void LaTeXRenderer::renderTextBlock (const MDE_TextBlock *e, std::string &output)
+{
+  renderTextContent(e->getText(), output);
 }
 
-std::string LaTeXRenderer::renderTextBlock (const MDE_TextBlock *e)
+void LaTeXRenderer::renderMathBlock (const MDE_MathBlock *e, std::string &output)
 {
-  return renderTextContent(e->getText());
+  renderMathContent(e->getText(), output);
 }
 
-std::string LaTeXRenderer::renderMathBlock (const MDE_MathBlock *e)
+/**
+ * @copydoc MathRenderer::renderError
+ *
+ * The skipped source text is reproduced as-is, as text.
+ */
+void LaTeXRenderer::renderError (const MDE_Error *e, std::string &output)
 {
-  return renderMathContent(e->getText());
+  renderTextContent(e->getText(), output);
 }
 
 /**
  * @copydoc MathRenderer::renderGroup
  * @see LaTeXRenderer::isBracketSizingEnabled
  */
-std::string LaTeXRenderer::renderGroup (const MDE_Group *e)
+void LaTeXRenderer::renderGroup (const MDE_Group *e, std::string &output)
 {
-  std::string renderedContents;
-  std::string openChar, closeChar;
-
-  beginInternalRender();
-  renderedContents = renderVector (e->getContents());
-  endInternalRender();
+  const char *openChar = "", *closeChar = "";
 
   switch (e->getType()) {
   case MDE_Group::PARENTHESES:
@@ -499,78 +575,93 @@ std::string LaTeXRenderer::renderGroup (const MDE_Group *e)
     assert(0);
   }
 
+  beginMathContent(output);
   if (isBracketSizingEnabled)
-    return renderMathContent("\\left" + openChar + renderedContents + "\\right" + closeChar);
-  else
-    return renderMathContent(openChar + renderedContents + closeChar);
+    output += "\\left";
+  output += openChar;
 
+  beginInternalRender();
+  renderNested (e->getContents());
+  scheduleStep (boost::bind(&LaTeXRenderer::endNested, this,
+			    std::string(isBracketSizingEnabled ? "\\right" : "") + closeChar, _1));
 }
 
-std::string LaTeXRenderer::renderItemNumber (const MDE_ItemNumber *e)
+void LaTeXRenderer::renderItemNumber (const MDE_ItemNumber *e, std::string &output)
 {
-  std::string qnumber, output;
-  qnumber = e->getText();
-  output = boost::str(boost::format("\\text{%s}\\thickspace ") % qnumber);
-  return renderMathContent(output);
+  beginMathContent(output);
+  output += "\\text{";
+  output += e->getText();
+  output += "}\\thickspace ";
 }
 
-std::string LaTeXRenderer::renderNumber (const MDE_Number *e)
+void LaTeXRenderer::renderNumber (const MDE_Number *e, std::string &output)
 {
-  return renderMathContent(e->getStandardNotation());
+  renderMathContent(e->getStandardNotation(), output);
 }
 
-std::string LaTeXRenderer::renderOperator (const MDE_Operator *e)
+void LaTeXRenderer::renderOperator (const MDE_Operator *e, std::string &output)
 {
   switch (e->getOperator()) {
   case MDE_Operator::ADDITION:
-    return renderMathContent(" + ");
+    renderMathContent(" + ", output);
+    break;
 
   case MDE_Operator::SUBTRACTION:
-    return renderMathContent(" - ");
+    renderMathContent(" - ", output);
+    break;
 
   case MDE_Operator::DIVISION:
-    return renderMathContent(" \\div ");
+    renderMathContent(" \\div ", output);
+    break;
 
   case MDE_Operator::MULTIPLICATION:
-    return renderMathContent(" \\times ");
+    renderMathContent(" \\times ", output);
+    break;
 
   default:
     assert(false);
-    return renderTextContent (" **OPERATOR ERROR** ");
+    renderTextContent (" **OPERATOR ERROR** ", output);
   }
 }
 
-std::string LaTeXRenderer::renderComparator (const MDE_Comparator *e)
+void LaTeXRenderer::renderComparator (const MDE_Comparator *e, std::string &output)
 {
   switch (e->getComparator()) {
   case MDE_Comparator::LESS_THAN:
-    return renderMathContent (" < ");
+    renderMathContent (" < ", output);
+    break;
 
   case MDE_Comparator::GREATER_THAN:
-    return renderMathContent (" > ");
+    renderMathContent (" > ", output);
+    break;
 
   case MDE_Comparator::EQUALS:
-    return renderMathContent (" = ");
+    renderMathContent (" = ", output);
+    break;
 
   case MDE_Comparator::APPROX_EQUALS:
-    return renderMathContent (" \\approx ");
+    renderMathContent (" \\approx ", output);
+    break;
 
   case MDE_Comparator::NOT_EQUALS:
-    return renderMathContent (" \\neq ");
+    renderMathContent (" \\neq ", output);
+    break;
 
   case MDE_Comparator::GREATER_THAN_EQUALS:
-    return renderMathContent (" \\geq ");
+    renderMathContent (" \\geq ", output);
+    break;
 
   case MDE_Comparator::LESS_THAN_EQUALS:
-    return renderMathContent (" \\leq ");
+    renderMathContent (" \\leq ", output);
+    break;
 
   default:
     assert(false);
-    return renderTextContent (" **COMPARATOR ERROR** ");
+    renderTextContent (" **COMPARATOR ERROR** ", output);
   }
 }
 
-std::string LaTeXRenderer::renderGreekLetter (const MDE_GreekLetter *e)
+void LaTeXRenderer::renderGreekLetter (const MDE_GreekLetter *e, std::string &output)
 {
 #define MAP(a) (MDE_GreekLetter::a, "\\" #a)
 #define MAPTO(a, b) (MDE_GreekLetter::a, b)
@@ -605,10 +696,10 @@ std::string LaTeXRenderer::renderGreekLetter (const MDE_GreekLetter *e)
 #undef MAP
 #undef MAPTO
   assert(charmap.count(e->getValue()) == 1);
-  return renderMathContent(charmap [e->getValue()]);
+  renderMathContent(charmap [e->getValue()], output);
 }
 
-std::string LaTeXRenderer::renderSymbol (const MDE_Symbol *e)
+void LaTeXRenderer::renderSymbol (const MDE_Symbol *e, std::string &output)
 {
   static std::map<MDE_Symbol::Symbol,std::string> map = ba::map_list_of
     ( MDE_Symbol::COMMA, "," )
@@ -632,105 +723,89 @@ std::string LaTeXRenderer::renderSymbol (const MDE_Symbol *e)
 
   assert (map.count(e->getSymbol()) == 1);
 
-  return renderMathContent(map[e->getSymbol()]);
+  renderMathContent(map[e->getSymbol()], output);
 }
 
-std::string LaTeXRenderer::renderModifier (const MDE_Modifier *e)
+void LaTeXRenderer::renderModifier (const MDE_Modifier *e, std::string &output)
 {
-  std::string renderedArgument;
-  std::string output;
-
-  beginInternalRender();
-  renderedArgument = renderVector (e->getArgument());
-  endInternalRender();
+  const char *command = "";
 
   switch (e->getModifier()) {
   case MDE_Modifier::OVER_ARROW_RIGHT:
-    output = boost::str(boost::format("\\overrightarrow{%s}") % renderedArgument);
+    command = "\\overrightarrow{";
     break;
 
   case MDE_Modifier::OVER_BAR:
-    output = boost::str(boost::format("\\overline{%s}") % renderedArgument);
+    command = "\\overline{";
     break;
 
   case MDE_Modifier::OVER_HAT:
-    output = boost::str(boost::format("\\hat{%s}") % renderedArgument);
+    command = "\\hat{";
     break;
 
   default:
     assert(0);
   }
 
-  return renderMathContent(output);
+  beginMathContent(output);
+  output += command;
+  beginInternalRender();
+  renderNested (e->getArgument());
+  scheduleStep (boost::bind(&LaTeXRenderer::endNested, this, "}", _1));
 }
 
-std::string LaTeXRenderer::renderRoot (const MDE_Root *e)
+void LaTeXRenderer::renderRoot (const MDE_Root *e, std::string &output)
 {
-  std::string renderedIndex, renderedArgument;
+  beginMathContent(output);
+  output += "\\sqrt";
 
   beginInternalRender();
-  renderedIndex = renderVector (e->getIndex());
-  renderedArgument = renderVector (e->getArgument());
-  endInternalRender();
-
-  if (!renderedIndex.empty()) {
-    return renderMathContent(boost::str(boost::format("\\sqrt[%s]{%s}") % renderedIndex % renderedArgument));
-  } else {
-    return renderMathContent(boost::str(boost::format("\\sqrt{%s}") % renderedArgument));
-  }
+  renderArgument (e->getIndex(), "[", "]", output);
+  scheduleStep (boost::bind(&LaTeXRenderer::renderContents, this,
+			    boost::cref(e->getArgument()), "{", _1));
+  scheduleStep (boost::bind(&LaTeXRenderer::endNested, this, "}", _1));
 }
 
-std::string LaTeXRenderer::renderSummation (const MDE_Summation *e)
+void LaTeXRenderer::renderSummation (const MDE_Summation *e, std::string &output)
 {
-  std::string renderedLowerBound, renderedUpperBound;
-  std::string output;
+  beginMathContent(output);
+  output += "\\sum";
 
   beginInternalRender();
-  renderedLowerBound = renderVector (e->getLowerBound());
-  renderedUpperBound = renderVector (e->getUpperBound());
-  endInternalRender();
-
-  output = "\\sum";
-  if (!renderedLowerBound.empty())
-    output += boost::str(boost::format("_{%s}") % renderedLowerBound);
-
-  if (!renderedUpperBound.empty())
-    output += boost::str(boost::format("^{%s}") % renderedUpperBound);
-
-  output += " ";
-  return renderMathContent(output);
+  renderArgument (e->getLowerBound(), "_{", "}", output);
+  scheduleStep (boost::bind(&LaTeXRenderer::renderArgument, this,
+			    boost::cref(e->getUpperBound()), "^{", "}", _1));
+  scheduleStep (boost::bind(&LaTeXRenderer::endNested, this, " ", _1));
 }
 
-std::string LaTeXRenderer::renderFraction (const MDE_Fraction *e)
+void LaTeXRenderer::renderFraction (const MDE_Fraction *e, std::string &output)
 {
-  std::string renderedNumerator, renderedDenominator;
+  beginMathContent(output);
+  output += "\\frac{";
 
   beginInternalRender();
-  renderedNumerator = renderVector (e->getNumerator());
-  renderedDenominator = renderVector (e->getDenominator());
-  endInternalRender();
-
-  return renderMathContent(boost::str(boost::format("\\frac{%s}{%s}") % renderedNumerator % renderedDenominator));
+  renderNested (e->getNumerator());
+  scheduleStep (boost::bind(&LaTeXRenderer::renderContents, this,
+			    boost::cref(e->getDenominator()), "}{", _1));
+  scheduleStep (boost::bind(&LaTeXRenderer::endNested, this, "}", _1));
 }
 
-std::string LaTeXRenderer::renderExponent (const MDE_Exponent *e)
+void LaTeXRenderer::renderExponent (const MDE_Exponent *e, std::string &output)
 {
-  std::string renderedExponent;
+  beginMathContent(output);
+  output += "^{";
 
   beginInternalRender();
-  renderedExponent = renderVector (e->getValue());
-  endInternalRender();
-
-  return renderMathContent(boost::str(boost::format("^{%s}") % renderedExponent));
+  renderNested (e->getValue());
+  scheduleStep (boost::bind(&LaTeXRenderer::endNested, this, "}", _1));
 }
 
-std::string LaTeXRenderer::renderSubscript (const MDE_Subscript *e)
+void LaTeXRenderer::renderSubscript (const MDE_Subscript *e, std::string &output)
 {
-  std::string renderedSubscript;
+  beginMathContent(output);
+  output += "_{";
 
   beginInternalRender();
-  renderedSubscript = renderVector (e->getValue());
-  endInternalRender();
-
-  return renderMathContent(boost::str(boost::format("_{%s}") % renderedSubscript));
+  renderNested (e->getValue());
+  scheduleStep (boost::bind(&LaTeXRenderer::endNested, this, "}", _1));
 }
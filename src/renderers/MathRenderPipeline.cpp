@@ -0,0 +1,222 @@
+/**
+ * @file MathRenderPipeline.cpp
+ * Renders a document on separate threads while it is being interpreted
+ *
+ * @copyright Copyright 2015 Anthony Tibbs
+ * This project is released under the GNU General Public License.
+*/
+
+#include <cassert>
+#include <boost/atomic.hpp>
+#include <boost/bind.hpp>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+#include <boost/exception_ptr.hpp>
+#include <boost/foreach.hpp>
+#include <boost/lockfree/spsc_queue.hpp>
+#include <boost/make_shared.hpp>
+#include <boost/thread.hpp>
+
+#include "logging.h"
+#include "MathRenderPipeline.h"
+
+// A thread with nothing to do polls this many times before it starts to
+// sleep between polls
+#define IDLE_SPINS 64
+
+// ... and then sleeps this long (in microseconds) between polls
+#define IDLE_SLEEP_US 50
+
+namespace {
+  /**
+   * Waits a little before polling a queue again: yielding at first, since
+   * the other side is usually about to catch up, then sleeping so that a
+   * thread waiting on a slow interpreter or renderer does not hog a core.
+   */
+  void waitBriefly (unsigned &idlePolls)
+  {
+    if (++idlePolls < IDLE_SPINS)
+      boost::this_thread::yield();
+    else
+      boost::this_thread::sleep (boost::posix_time::microseconds(IDLE_SLEEP_US));
+  }
+}
+
+/**
+ * One renderer, the stream it writes to, and the queue of lines waiting
+ * for it.  The queue has a single producer (addLine()) and a single
+ * consumer (the stage's thread).
+ */
+struct MathRenderPipeline::Stage {
+  Stage (MathRenderer &r, std::ostream &o, const size_t queueLength)
+    : renderer(r), os(o), queue(queueLength), inputDone(false), abandoned(false),
+      failed(false) {}
+
+  MathRenderer &renderer;
+  std::ostream &os;
+  boost::lockfree::spsc_queue<MDEVector> queue;
+  boost::atomic<bool> inputDone; // no more lines will be queued
+  boost::atomic<bool> abandoned; // the output is unwanted; stop rendering
+  boost::atomic<bool> failed; // the renderer threw; stop feeding it
+  boost::exception_ptr error;
+  boost::thread thread;
+};
+
+/* ========================= PUBLIC FUNCTION =============================== */
+
+/**
+ * Sets up an empty pipeline.
+ *
+ * @param queueLength Number of lines that may be waiting for each renderer
+ *        before addLine() waits for it to catch up
+ */
+MathRenderPipeline::MathRenderPipeline (const size_t queueLength)
+  : m_queueLength(queueLength), m_started(false), m_finished(false)
+{
+  assert (queueLength > 0);
+}
+
+/**
+ * If finish() was not called (e.g. because interpretation failed), the
+ * output is incomplete: the renderers drop any lines still queued and stop
+ * without finishing their output.  Any rendering errors are ignored.
+ */
+MathRenderPipeline::~MathRenderPipeline ()
+{
+  if (m_started && !m_finished) {
+    BOOST_FOREACH (const boost::shared_ptr<Stage> &stage, m_stages) {
+      stage->abandoned = true;
+    }
+    BOOST_FOREACH (const boost::shared_ptr<Stage> &stage, m_stages) {
+      stage->thread.join();
+    }
+  }
+}
+
+/**
+ * Adds a renderer to the pipeline.  All renderers must be added before the
+ * first line is.
+ *
+ * @param renderer Renderer to use; it must not be used for anything else
+ *        until finish() has returned
+ * @param os Stream to receive the rendered output
+ */
+void MathRenderPipeline::addRenderer (MathRenderer &renderer, std::ostream &os)
+{
+  assert (!m_started);
+  m_stages.push_back (boost::make_shared<Stage>(boost::ref(renderer), boost::ref(os),
+						m_queueLength));
+}
+
+/**
+ * @copydoc MathDocumentSink::addLine
+ *
+ * The line is queued for every renderer, waiting for room in any queue that
+ * is full.
+ *
+ * @throw The exception thrown by the first renderer, once every renderer
+ *        has failed (e.g. on reaching an output limit), since there is
+ *        then no point in interpreting the rest of the document
+ */
+void MathRenderPipeline::addLine (const MDEVector &elements)
+{
+  if (!m_started)
+    start();
+
+  size_t numFailed = 0;
+  BOOST_FOREACH (const boost::shared_ptr<Stage> &stage, m_stages) {
+    unsigned idlePolls = 0;
+    while (!stage->failed && !stage->queue.push (elements))
+      waitBriefly (idlePolls);
+
+    if (stage->failed)
+      numFailed++;
+  }
+
+  // A stage's error is set before it is marked as failed
+  if (numFailed > 0 && numFailed == m_stages.size())
+    boost::rethrow_exception (m_stages.front()->error);
+}
+
+/**
+ * Waits for every renderer to render the lines still queued for it and
+ * to finish its output.
+ *
+ * @throw The first exception thrown by a renderer, if any
+ */
+void MathRenderPipeline::finish (void)
+{
+  if (!m_started)
+    start();
+
+  BOOST_FOREACH (const boost::shared_ptr<Stage> &stage, m_stages) {
+    stage->inputDone = true;
+  }
+  BOOST_FOREACH (const boost::shared_ptr<Stage> &stage, m_stages) {
+    stage->thread.join();
+  }
+  m_finished = true;
+
+  BOOST_FOREACH (const boost::shared_ptr<Stage> &stage, m_stages) {
+    if (stage->error)
+      boost::rethrow_exception (stage->error);
+  }
+}
+
+/* ========================= PRIVATE FUNCTIONS =========================== */
+
+/**
+ * Starts a thread for each renderer.
+ */
+void MathRenderPipeline::start (void)
+{
+  LOG_TRACE << "* starting render pipeline with " << m_stages.size() << " renderer(s)";
+
+  m_started = true;
+  BOOST_FOREACH (const boost::shared_ptr<Stage> &stage, m_stages) {
+    stage->thread = boost::thread (boost::bind(&MathRenderPipeline::runStage,
+					       boost::ref(*stage)));
+  }
+}
+
+/**
+ * Thread function for a single renderer: renders lines as they are queued
+ * until told that there are no more, or that the output is unwanted.
+ */
+void MathRenderPipeline::runStage (Stage &stage)
+{
+  try {
+    stage.os << stage.renderer.beginDocument();
+
+    MDEVector elements;
+    std::string output;
+    unsigned idlePolls = 0;
+    for (;;) {
+      // Whatever is still queued is released along with the queue
+      if (stage.abandoned)
+	return;
+
+      if (stage.queue.pop (elements)) {
+	output.clear();
+	stage.renderer.renderLines (elements, output);
+	stage.os << output;
+	idlePolls = 0;
+	continue;
+      }
+
+      // Lines queued before inputDone was set are visible once it is, so
+      // an empty queue at that point means everything has been rendered
+      if (stage.inputDone) {
+	if (!stage.queue.read_available())
+	  break;
+	continue;
+      }
+
+      waitBriefly (idlePolls);
+    }
+
+    stage.os << stage.renderer.endDocument();
+  } catch (...) {
+    stage.error = boost::current_exception();
+    stage.failed = true;
+  }
+}
@@ -6,19 +6,117 @@
 * See COPYING or http://www.gnu.org/licenses/ for more information. 
 */
 
-#include <boost/foreach.hpp>
-
 #include "logging.h"
 
 #include "MathDocument.h"
 #include "MathRenderer.h"
 #include "MathExceptions.h"
 
+// Default for setMaxNestingDepth()
+#define DEFAULT_MAX_NESTING_DEPTH 1000
+
+// Output size meaning "no limit"; see setMaxOutputBytes()
+#define NO_OUTPUT_LIMIT ((size_t)-1)
+
+// The deadline (see setDeadline()) is checked once every this many
+// elements rendered
+#define DEADLINE_CHECK_INTERVAL 256
+
+// Room set aside for the render task stack; it grows as needed for more
+// deeply nested documents
+#define INITIAL_RENDER_TASKS 64
+
+// renderDocument() writes to its stream whenever this much output has
+// built up
+#define STREAM_WRITE_BYTES 65536
+
+namespace {
+  /**
+   * Restores a renderer's task stack for as long as it is in scope: work
+   * left over if rendering throws is dropped, and work scheduled by the
+   * caller (if rendering was started from inside a render* method) is put
+   * back for it.
+   */
+  template <typename Task>
+  class RenderTaskGuard
+  {
+    std::vector<Task> &tasks;
+    std::vector<Task> &scheduled;
+    std::vector<Task> callerScheduled;
+    unsigned long &depth;
+    const size_t base;
+    const unsigned long callerDepth;
+
+  public:
+    RenderTaskGuard(std::vector<Task> &t, std::vector<Task> &s, unsigned long &d)
+      : tasks(t), scheduled(s), depth(d), base(t.size()), callerDepth(d)
+    {
+      callerScheduled.swap (scheduled);
+    }
+
+    ~RenderTaskGuard()
+    {
+      tasks.resize (base, Task());
+      scheduled.swap (callerScheduled);
+      depth = callerDepth;
+    }
+
+    size_t getBase(void) const { return base; }
+  };
+}
+
 /**
  * Basic constructor.
  */
 MathRenderer::MathRenderer()
+  : renderDepth(0), maxNestingDepth(DEFAULT_MAX_NESTING_DEPTH),
+    maxOutputBytes(NO_OUTPUT_LIMIT), outputBytes(0), elementsToDeadlineCheck(0)
+{
+  renderTasks.reserve (INITIAL_RENDER_TASKS);
+}
+
+/**
+ * Sets how deeply groups, fractions, roots, etc. may be nested inside one
+ * another for rendering.  Nested elements are rendered from a task stack
+ * of their own, which grows with the nesting depth, so this bounds the
+ * memory a pathologically nested (untrusted) document can take: a
+ * document nested more deeply is refused with a MathRenderException.
+ * It should be no lower than the interpreter's limit (see
+ * MathInterpreter::setMaxNestingDepth()).
+ *
+ * @param [in] maxDepth Deepest nesting allowed (1000 by default)
+ */
+void MathRenderer::setMaxNestingDepth(const unsigned long maxDepth)
+{
+  maxNestingDepth = maxDepth;
+}
+
+/**
+ * Limits the size of the rendered output, so that a small but hostile
+ * document cannot make the renderer produce an enormous one.  Output is
+ * counted from when the limit is set; once it would pass the limit,
+ * rendering stops with a MathRenderException.
+ *
+ * @param [in] maxBytes Most bytes of output allowed (by default there is
+ *             no limit)
+ */
+void MathRenderer::setMaxOutputBytes(const size_t maxBytes)
 {
+  maxOutputBytes = maxBytes;
+  outputBytes = 0;
+}
+
+/**
+ * Sets a time by which rendering must be finished.  The clock is checked
+ * every so often as elements are rendered, and once the deadline has
+ * passed rendering stops with a MathRenderException.
+ *
+ * @param [in] deadline Time (in UTC) by which to finish; not_a_date_time
+ *             (the default) for no deadline
+ */
+void MathRenderer::setDeadline(const boost::posix_time::ptime &deadline)
+{
+  this->deadline = deadline;
 }
 
 /**
@@ -29,43 +127,238 @@ MathRenderer::MathRenderer()
  */
 std::string MathRenderer::renderDocument (const MathDocument &document)
 {
-  return renderVector (document.getDocument());
+  std::string output;
+
+  output = beginDocument();
+  renderLines (document.getDocument(), output);
+  output += endDocument();
+  return output;
 }
 
 /**
- * Render a particular vector/set of elements to an output text string.
+ * Render the provided document, writing the output to a stream as it goes.
  *
- * Loops through each MathDocumentElement in the provided vector and 
- * renders each, concatenating them together into the output string 
- * that is returned. 
+ * The document is rendered a line at a time, and the output written out
+ * every so often, so the whole of it is never held in memory at once.
+ *
+ * @param [in] document Interpreted math document to render
+ * @param [in] os Stream to receive the rendered output
+ */
+void MathRenderer::renderDocument (const MathDocument &document, std::ostream &os)
+{
+  const MDEVector &elements = document.getDocument();
+  std::string output = beginDocument();
+  MDEVector line;
+
+  for (MDEVector::const_iterator it = elements.begin(); it != elements.end(); ++it) {
+    line.push_back (*it);
+    if (!dynamic_cast<const MDE_LineBreak *>(it->get()) && it + 1 != elements.end())
+      continue;
+
+    renderLines (line, output);
+    line.clear();
+
+    if (output.length() >= STREAM_WRITE_BYTES) {
+      os << output;
+      output.clear();
+    }
+  }
+
+  output += endDocument();
+  os << output;
+}
+
+/**
+ * Begin rendering a document a piece at a time.
+ *
+ * A document may be rendered in pieces, as it is interpreted, by calling
+ * beginDocument(), then renderLines() for each successive group of lines,
+ * then endDocument(), and concatenating the output.  The output is the
+ * same as renderDocument() would give for the whole document.
+ *
+ * @return std::string containing any output that comes before the
+ *         document itself (e.g. a preamble)
+ */
+std::string MathRenderer::beginDocument (void)
+{
+  return std::string();
+}
+
+/**
+ * Render the next lines of a document being rendered a piece at a time.
+ *
+ * @param [in] elements Elements for one or more complete source lines,
+ *             as passed to MathDocumentSink::addLine()
+ * @param [out] output Buffer to append the rendered output to; a renderer
+ *              may hold some output back until later lines (or
+ *              endDocument())
+ * @see MathRenderer::beginDocument
+ */
+void MathRenderer::renderLines (const MDEVector &elements, std::string &output)
+{
+  const size_t start = output.length();
+  renderVector (elements, output);
+  outputBytes += output.length() - start;
+}
+
+/**
+ * Finish rendering a document that was rendered a piece at a time.
+ *
+ * @return std::string containing any remaining output
+ * @see MathRenderer::beginDocument
+ */
+std::string MathRenderer::endDocument (void)
+{
+  return std::string();
+}
+
+/**
+ * Render a particular vector/set of elements to an output text string.
  *
  * @param [in] v A vector (array) of MathDocumentElement elements to render
  * @return std::string containing the rendered output of the vector
+ * @see renderVector(const MDEVector &, std::string &)
  */
 std::string MathRenderer::renderVector (const MDEVector &v)
 {
-  std::string temp;
+  std::string output;
+  renderVector (v, output);
+  return output;
+}
 
-  std::string logtemp;
-  BOOST_FOREACH (const MathDocumentElementPtr &ePtr, v) {
-    const MathDocumentElement *ptr = ePtr.get();
-    logtemp += ptr->getString();
-  }
-  LOG_TRACE << ">> renderVector(" << logtemp << ")";
-  logIncreaseIndent();
+/**
+ * Render a particular vector/set of elements into an output buffer.
+ *
+ * Loops through each MathDocumentElement in the provided vector and 
+ * renders each, appending them one after another to the output buffer.
+ *
+ * @param [in] v A vector (array) of MathDocumentElement elements to render
+ * @param [out] output Buffer to append the rendered output of the vector to
+ * @throw MathRenderException is thrown if the elements are nested too
+ *        deeply (see setMaxNestingDepth()), or if the output or time limit
+ *        is exceeded (see setMaxOutputBytes() and setDeadline())
+ */
+void MathRenderer::renderVector (const MDEVector &v, std::string &output)
+{
+  checkNestingDepth(renderDepth + 1);
 
-  for (MDEVector::const_iterator it = v.begin();
-       it != v.end(); ++it) {
+  RenderTask task;
+  task.elements = &v;
+  task.depth = renderDepth + 1;
+  runRenderTasks (task, output);
+}
 
-    const MathDocumentElementPtr ePtr = *it;
-    const MathDocumentElement *ptr = ePtr.get();
-    temp += renderElement(ptr);
-  }
+/**
+ * Asks for a vector of elements nested in the element being rendered to be
+ * rendered, one level deeper, once the current render* method (or step)
+ * returns.
+ *
+ * @param [in] v Elements to render; they must outlast the rendering
+ * @throw MathRenderException if they would be nested too deeply (see
+ *        setMaxNestingDepth())
+ */
+void MathRenderer::renderNested (const MDEVector &v)
+{
+  checkNestingDepth(renderDepth + 1);
+
+  RenderTask task;
+  task.elements = &v;
+  task.depth = renderDepth + 1;
+  scheduledTasks.push_back (task);
+}
+
+/**
+ * Asks for an element to be rendered, at the same level as the element
+ * being rendered, once the current render* method (or step) returns.
+ *
+ * @param [in] e Element to render, which is kept until it has been
+ */
+void MathRenderer::renderNested (const MathDocumentElementPtr &e)
+{
+  RenderTask task;
+  task.element = e.get();
+  task.elementRef = e;
+  task.depth = renderDepth;
+  scheduledTasks.push_back (task);
+}
+
+/**
+ * Asks for a step to be run once the current render* method (or step)
+ * returns, and once everything asked for before it has been rendered.
+ * A step may itself ask for nested elements and further steps, which come
+ * straight after it.
+ *
+ * @param [in] step Step to run, which is given the output buffer
+ */
+void MathRenderer::scheduleStep (const RenderStep &step)
+{
+  RenderTask task;
+  task.step = step;
+  task.depth = renderDepth;
+  scheduledTasks.push_back (task);
+}
+
+/**
+ * Works through the render task stack, starting from 'first', until
+ * everything that it led to has been rendered.
+ *
+ * @param [in] first Task to start with
+ * @param [out] output Buffer to append the rendered output to
+ */
+void MathRenderer::runRenderTasks (const RenderTask &first, std::string &output)
+{
+  RenderTaskGuard<RenderTask> guard (renderTasks, scheduledTasks, renderDepth);
+  const size_t start = output.length();
 
-  logDecreaseIndent();
-  LOG_TRACE << "<< renderVector: " << temp;
+  renderTasks.push_back (first);
+  while (renderTasks.size() > guard.getBase()) {
+    RenderTask &task = renderTasks.back();
+    renderDepth = task.depth;
 
-  return temp;
+    if (task.elements) {
+      if (task.next == 0) {
+	LOG_TRACE << ">> renderVector(" << task.elements->size() << " element(s))";
+	logIncreaseIndent();
+      }
+
+      if (task.next == task.elements->size()) {
+	logDecreaseIndent();
+	LOG_TRACE << "<< renderVector";
+	renderTasks.pop_back();
+	continue;
+      }
+
+      const MathDocumentElement *e = (*task.elements) [task.next++].get();
+      checkDeadline();
+      dispatchElement(e, output);
+    } else if (task.element) {
+      const MathDocumentElementPtr elementRef = task.elementRef;
+      const MathDocumentElement *e = task.element;
+      renderTasks.pop_back();
+      checkDeadline();
+      dispatchElement(e, output);
+
+      // What the element scheduled may refer to its contents
+      if (elementRef) {
+	for (std::vector<RenderTask>::iterator it = scheduledTasks.begin();
+	     it != scheduledTasks.end(); ++it)
+	  it->elementRef = elementRef;
+      }
+    } else {
+      RenderStep step;
+      step.swap (task.step);
+      renderTasks.pop_back();
+      step (output);
+    }
+
+    // Checked as the output grows, however deeply nested, so a single
+    // large element cannot build up far more than the limit in memory
+    checkOutputSize(output.length() - start);
+
+    // Whatever that scheduled comes next, in the order it was scheduled
+    renderTasks.insert (renderTasks.end(), scheduledTasks.rbegin(), scheduledTasks.rend());
+    scheduledTasks.clear();
+  }
 }
 
 
@@ -76,23 +369,54 @@ std::string MathRenderer::renderVector (const MDEVector &v)
  * @param class The element type that we are attempting to reflect to.
  * @internal
  */
-#define RX(class) { if (const MDE_##class *ptr = dynamic_cast< const MDE_##class *>(e)) { return render##class (ptr); } }
+#define RX(class) { if (const MDE_##class *ptr = dynamic_cast< const MDE_##class *>(e)) { render##class (ptr, output); return; } }
 
 /**
- * Renders the specified MathDocumentElement to a text string.
- * 
- * Accepts a pointer to a MathDocumentElement item, determines what type of element 
- * has been provided, and calls the appropriate rendering function for that 
- * type of element.
+ * Renders the specified MathDocumentElement to a text string of its own.
  *
  * @param [in] e Pointer to a MathDocumentElement item to be rendered.
  * @return std::string containing the rendered element.
+ * @see renderElement(const MathDocumentElement *, std::string &)
+ */
+std::string MathRenderer::renderElement (const MathDocumentElement *e)
+{
+  std::string output;
+  renderElement (e, output);
+  return output;
+}
+
+/**
+ * Renders the specified MathDocumentElement into an output buffer.
+ * 
+ * Accepts a pointer to a MathDocumentElement item and renders it, along
+ * with any elements nested in it (see dispatchElement()).
+ *
+ * @param [in] e Pointer to a MathDocumentElement item to be rendered.
+ * @param [out] output Buffer to append the rendered element to
  * @throw MathRenderException is thrown if renderElement() is called with a 
  *        MathDocumentElement type that is not recognized.
+  */
+void MathRenderer::renderElement (const MathDocumentElement *e, std::string &output)
+{
+  RenderTask task;
+  task.element = e;
+  task.depth = renderDepth;
+  runRenderTasks (task, output);
+}
+
+/**
+ * Calls the render* method for the type of the specified
+ * MathDocumentElement.  Any elements nested in it are only rendered once
+ * runRenderTasks() gets to them.
+ *
+ * @param [in] e Pointer to a MathDocumentElement item to be rendered.
+ * @param [out] output Buffer to append the rendered element to
+ * @throw MathRenderException is thrown if the element type is not
+ *        recognized.
  * @note Whenever a new MathDocumentElement type is created, a new reflector must
  *       be added here (and render* functions added, etc.)!
-  */
-std::string MathRenderer::renderElement (const MathDocumentElement *e)
+ */
+void MathRenderer::dispatchElement (const MathDocumentElement *e, std::string &output)
 {
   RX(SourceLine);
   RX(Command);
@@ -104,6 +428,7 @@ std::string MathRenderer::renderElement (const MathDocumentElement *e)
   RX(ItemNumber); // have to do this before TextBlock as it is a subclass
   RX(TextBlock);
   RX(MathBlock);
+  RX(Error);
   RX(Number);
   RX(Group);
 
@@ -121,8 +446,126 @@ std::string MathRenderer::renderElement (const MathDocumentElement *e)
   RX(Subscript);
 
   std::ostringstream os;
-  os << "Unsupported element type in MathRenderer::renderElement(): " << typeid(*e).name();
+  os << "Unsupported element type in MathRenderer::dispatchElement(): " << typeid(*e).name();
   BOOST_THROW_EXCEPTION (MathRenderException() <<
 			 mdx_error_info(os.str()));
 
 }
+
+/**
+ * Refuses to go on if the output would pass the limit set with
+ * setMaxOutputBytes().
+ *
+ * @param [in] pendingBytes Output rendered but not yet counted
+ * @throw MathRenderException if the limit is exceeded
+ */
+void MathRenderer::checkOutputSize(const size_t pendingBytes) const
+{
+  if (outputBytes + pendingBytes <= maxOutputBytes)
+    return;
+
+  std::ostringstream os;
+  os << "Output is larger than " << maxOutputBytes << " bytes";
+  BOOST_THROW_EXCEPTION (MathRenderException() <<
+			 mdx_error_info(os.str()));
+}
+
+/**
+ * Refuses to go on if elements would be nested more deeply than allowed by
+ * setMaxNestingDepth().
+ *
+ * @param [in] depth Nesting depth of the elements (the outermost vector,
+ *             the document itself, being 1)
+ * @throw MathRenderException if the limit is exceeded
+ */
+void MathRenderer::checkNestingDepth(const unsigned long depth) const
+{
+  if (depth <= maxNestingDepth + 1)
+    return;
+
+  std::ostringstream os;
+  os << "Elements are nested more than " << maxNestingDepth << " levels deep";
+  BOOST_THROW_EXCEPTION (MathRenderException() <<
+			 mdx_error_info(os.str()));
+}
+
+/**
+ * Refuses to go on if the deadline set with setDeadline() has passed.  The
+ * clock is only read every DEADLINE_CHECK_INTERVAL calls.
+ *
+ * @throw MathRenderException if the deadline has passed
+ */
+void MathRenderer::checkDeadline(void)
+{
+  if (deadline.is_special() || elementsToDeadlineCheck-- > 0)
+    return;
+
+  elementsToDeadlineCheck = DEADLINE_CHECK_INTERVAL;
+  if (boost::posix_time::microsec_clock::universal_time() > deadline) {
+    BOOST_THROW_EXCEPTION (MathRenderException() <<
+			   mdx_error_info("Time limit exceeded"));
+  }
+}
+
+/* ========================= MathRendererSink ============================== */
+
+/**
+ * Sets up a sink with no renderers; add them with addRenderer().
+ */
+MathRendererSink::MathRendererSink ()
+{
+}
+
+/**
+ * Sets up a sink that renders with 'renderer' and writes to 'os'.
+ *
+ * @param [in] renderer Renderer to use; it should not be used for anything
+ *             else until finish() has been called
+ * @param [in] os Stream to receive the rendered output
+ */
+MathRendererSink::MathRendererSink (MathRenderer &renderer, std::ostream &os)
+{
+  addRenderer (renderer, os);
+}
+
+/**
+ * Adds another renderer, writing to a stream of its own.  All renderers
+ * must be added before the first line is.
+ *
+ * @param [in] renderer Renderer to use; it should not be used for anything
+ *             else until finish() has been called
+ * @param [in] os Stream to receive the rendered output
+ */
+void MathRendererSink::addRenderer (MathRenderer &renderer, std::ostream &os)
+{
+  const Target target = { &renderer, &os };
+  m_targets.push_back (target);
+  os << renderer.beginDocument();
+}
+
+/**
+ * @copydoc MathDocumentSink::addLine
+ *
+ * The line is rendered by each renderer in turn, while it is still fresh
+ * in the cache.
+ */
+void MathRendererSink::addLine (const MDEVector &elements)
+{
+  for (std::vector<Target>::const_iterator it = m_targets.begin();
+       it != m_targets.end(); ++it) {
+    m_buffer.clear();
+    it->renderer->renderLines (elements, m_buffer);
+    *it->os << m_buffer;
+  }
+}
+
+/**
+ * Writes the rest of each renderer's output after the last line.
+ */
+void MathRendererSink::finish (void)
+{
+  for (std::vector<Target>::const_iterator it = m_targets.begin();
+       it != m_targets.end(); ++it) {
+    *it->os << it->renderer->endDocument();
+  }
+}
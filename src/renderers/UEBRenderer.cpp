@@ -6,14 +6,20 @@
  * This project is released under the GNU General Public License.
 */
 
+#include <algorithm>
+#include <cstring>
 #include <string>
 #include <map>
+#include <set>
 
 #include <boost/algorithm/string.hpp>
 #include <boost/assign.hpp>
+#include <boost/bind.hpp>
 #include <boost/format.hpp>
-#include <boost/scoped_array.hpp>
 
+#include "BrailleTranslationCache.h"
+#include "CharClass.h"
+#include "LibLouisContext.h"
 #include "liblouis-mt.h"
 #include "logging.h"
 #include "UEBRenderer.h"
@@ -24,9 +30,116 @@ namespace ba = boost::assign;
 #define __func__ __FUNCTION__
 #endif
 
+// Room set aside for saved render status; it grows as needed for more
+// deeply nested documents
+#define UEB_INITIAL_STATUS_STACK 64
+
+// Elements held back, while translating text in batches, before their
+// text is translated and they are rendered
+#define UEB_BATCH_WINDOW 1024
+
+namespace {
+  // Characters that continue numeric mode once a number sign has started it
+  const CharClass NUMERIC_MODE_SYMBOLS (UEB_NUMERIC_MODE_SYMBOLS);
+
+  // Braille characters that end a sentence or clause in text (period,
+  // exclamation mark and question mark), which make good places to break
+  const CharClass SENTENCE_END_SYMBOLS ("468");
+
+  /**
+   * What post-processing braille needs to know about each character, so
+   * that math and text can each be finished in a single pass.
+   */
+  struct BrailleCharTable {
+    enum {
+      CAPITAL = 1,         ///< Takes a capital sign in math
+      NUMERIC = 2,         ///< Continues numeric mode (once brailled)
+      LETTER = 4,          ///< A letter, in either case
+      SENTENCE_END = 8,    ///< Ends a sentence in text
+      BRACKET_BEGIN = 16,  ///< First cell of an opening bracket
+      BRACKET_END = 32     ///< Last cell of an opening bracket
+    };
+
+    unsigned char flags [256];
+    char math [256]; ///< How the character is brailled in math
+
+    BrailleCharTable ()
+    {
+      for (unsigned c = 0; c < 256; c++) {
+	math [c] = (char)c;
+	flags [c] = 0;
+      }
+      math [(unsigned char)','] = UEB_COMMA [0];
+      math [(unsigned char)'.'] = UEB_PERIOD [0];
+
+      for (unsigned c = 0; c < 256; c++) {
+	if (c >= 'A' && c <= 'Z')
+	  flags [c] |= CAPITAL | LETTER;
+	if (c >= 'a' && c <= 'z')
+	  flags [c] |= LETTER;
+	if (NUMERIC_MODE_SYMBOLS.contains(math [c]))
+	  flags [c] |= NUMERIC;
+	if (SENTENCE_END_SYMBOLS.contains((char)c))
+	  flags [c] |= SENTENCE_END;
+      }
+
+      // The opening brackets all end with the same cell
+      const char *brackets[] = { UEB_LEFT_PAREN, UEB_LEFT_BRACKET, UEB_LEFT_BRACE };
+      for (unsigned n = 0; n < 3; n++) {
+	flags [(unsigned char)brackets [n][0]] |= BRACKET_BEGIN;
+	flags [(unsigned char)brackets [n][1]] |= BRACKET_END;
+      }
+    }
+  };
+
+  const BrailleCharTable BRAILLE_CHARS;
+
+  // Put between pieces of text translated together: a control character
+  // (which text from a source file never contains) as a word of its own
+  const char BATCH_SEPARATOR_CHAR = '\x1e';
+  const std::string BATCH_SEPARATOR = std::string(" ") + BATCH_SEPARATOR_CHAR + " ";
+
+  /**
+   * Finds where the next piece of text to be sent to liblouis should end:
+   * at the last space within reach that follows the end of a sentence, or
+   * failing that the last space of all, or failing that (for a "word"
+   * longer than a whole piece) wherever it must.
+   *
+   * @param [in] s Text being translated
+   * @param [in] start Where the piece starts
+   * @param [in] maxLength Maximum length of the piece
+   * @return Offset in 's' just past the end of the piece
+   */
+  size_t findChunkEnd (const std::string &s, const size_t start, const size_t maxLength)
+  {
+    if (s.length() - start <= maxLength)
+      return s.length();
+
+    size_t lastSpace = std::string::npos;
+    for (size_t pos = start + maxLength; pos > start; pos--) {
+      if (s [pos] != ' ')
+	continue;
+      if (lastSpace == std::string::npos)
+	lastSpace = pos;
+      if (isOneOf(s [pos - 1], ".?!"))
+	return pos;
+    }
+
+    if (lastSpace != std::string::npos)
+      return lastSpace;
+
+    // Do not split up the bytes of a UTF-8 character
+    size_t end = start + maxLength;
+    while (end > start + 1 && (s [end] & 0xC0) == 0x80)
+      end--;
+    return end;
+  }
+}
+
 UEBRenderer::UEBRenderer() : MathRenderer()
 {
   internalRenderCount = 0;
+  statusStack.reserve (UEB_INITIAL_STATUS_STACK);
 
   status.isInTextBlock = false;
   status.isNumericMode = false;
@@ -35,13 +148,15 @@ UEBRenderer::UEBRenderer() : MathRenderer()
 
   maxLineLength = UEB_DEFAULT_LINE_LEN;
   isUsingSpacedOperators = false;
-
-  lou_setDataPath(".");
-}
-
-UEBRenderer::~UEBRenderer()
-{
-  lou_free();
+  wrapLineLength = 0;
+  wrapBreaks [0] = wrapBreaks [1] = wrapBreaks [2] = std::string::npos;
+  wrapContinuation = NULL;
+  isWrapLineStarted = false;
+  isWrappingTextBlock = false;
+  isBatchTranslating = false;
+
+  louisInput.resize (LIBLOUIS_MAXSTRING);
+  louisOutput.resize (LIBLOUIS_MAXSTRING);
 }
 
 /**
@@ -60,203 +175,278 @@ void UEBRenderer::getInterpreterCommandList (std::vector<std::string> &cmdlist)
   cmdlist.push_back("SpaceUEBOperators");
 }
 
-std::string UEBRenderer::renderDocument (const MathDocument &document)
+/**
+ * @copydoc MathRenderer::beginDocument
+ *
+ * Resets the line wrapping state.
+ */
+std::string UEBRenderer::beginDocument (void)
 {
-  std::string output;
-  bool isInTextBlock = false;
-
-  // We hard code the lengths here for efficiency, but make sure
-  // the word wrapping indicators haven't been changed.
-  assert (std::string(UEB_WORDWRAP_PRI1).length() == UEB_WORDWRAP_INDLEN);
-  assert (std::string(UEB_WORDWRAP_PRI2).length() == UEB_WORDWRAP_INDLEN);
-  assert (std::string(UEB_WORDWRAP_PRI3).length() == UEB_WORDWRAP_INDLEN);
-
-  LOG_TRACE << ">> UEBRenderer::renderDocument begin";
-  logIncreaseIndent();
-
-  std::string renderedBraille = MathRenderer::renderDocument (document);
-
-  if (isWrappingEnabled()) {
-    size_t pos = 0;
-    while (pos < renderedBraille.length()) {
-      std::string curLine;
-      std::string curOutputLine;
+  LOG_TRACE << ">> UEBRenderer::beginDocument";
+
+  unwrappedBraille.clear();
+  wrapHints.clear();
+  wrapLine.clear();
+  wrapLineLength = 0;
+  wrapBreaks [0] = wrapBreaks [1] = wrapBreaks [2] = std::string::npos;
+  wrapContinuation = NULL;
+  isWrapLineStarted = false;
+  isWrappingTextBlock = false;
+  heldLines.clear();
+  return std::string();
+}
 
-      size_t eolPos = renderedBraille.find("\n", pos);
-      if (eolPos == std::string::npos) { // no final end of line found?
-	      curLine = renderedBraille.substr(pos);
-	      // Advance to the end of the buffer
-	      pos = renderedBraille.length();
-      }
-      else {
-	      curLine = renderedBraille.substr(pos, eolPos - pos);
-	      // Advance to the end of the current line
-	      pos = eolPos+1;
-      }
+/**
+ * @copydoc MathRenderer::renderLines
+ *
+ * When line wrapping is enabled, the braille is wrapped as soon as it has
+ * been rendered; only the part of the last line that has not filled a
+ * braille line yet is held back until the next call (or endDocument()).
+ *
+ * When text is translated in batches, lines are held back until there
+ * are enough of them to make good-sized batches, so documents rendered a
+ * line at a time batch their text as well as whole ones.
+ */
+void UEBRenderer::renderLines (const MDEVector &elements, std::string &output)
+{
+  if (!isBatchTranslating) {
+    renderBrailleLines (elements, output);
+    return;
+  }
 
-#ifdef UEB_WRAPPING_DEBUG
-      LOG_TRACE << "pos " << pos << "/" << renderedBraille.length() << ", wordwrapping " << curLine.length() << ":'" << stripWrappingIndicators(curLine) << "'";
-      logIncreaseIndent();
-      LOG_TRACE << curLine;
-#endif
+  heldLines.insert (heldLines.end(), elements.begin(), elements.end());
+  if (heldLines.size() >= UEB_BATCH_WINDOW)
+    renderHeldLines (output);
+}
 
-      size_t last_break_position [3] = {0, 0, 0};
-      size_t curOutputLinePos = 0;
-      size_t curOutputLineLength = 0;
-      size_t i = 0;
+/**
+ * Renders lines to braille, translating their text first if it is
+ * translated in batches, and wraps it if need be.
+ *
+ * @param [in] elements Elements for one or more complete source lines
+ * @param [out] output Buffer to append the braille to
+ */
+void UEBRenderer::renderBrailleLines (const MDEVector &elements, std::string &output)
+{
+  if (isBatchTranslating)
+    translateTextBatches (elements);
 
-      if (strBeginsWith (curLine, UEB_MATH_BLOCK_BEGIN)) {
-#ifdef UEB_WRAPPING_DEBUG
-	      LOG_TRACE << "beginning math block and indentation...";
-#endif
+  if (!isWrappingEnabled()) {
+    MathRenderer::renderLines (elements, output);
+  } else {
+    MathRenderer::renderLines (elements, unwrappedBraille);
+    wrapBraille (output);
+  }
 
-	      isInTextBlock = false;
-	      i = std::string(UEB_MATH_BLOCK_BEGIN).length();
-      } else if (strBeginsWith (curLine, UEB_TEXT_BLOCK_BEGIN)) {
-#ifdef UEB_WRAPPING_DEBUG
-	      LOG_TRACE << "beginning text block and disabling indentation...";
-#endif
+  batchedTranslations.clear();
+}
 
-	      isInTextBlock = true;
-	      i = std::string(UEB_TEXT_BLOCK_BEGIN).length();
-      }
+/**
+ * Renders the lines held back while translating text in batches.
+ *
+ * @param [out] output Buffer to append the braille to
+ * @see UEBRenderer::renderLines
+ */
+void UEBRenderer::renderHeldLines (std::string &output)
+{
+  MDEVector lines;
+  lines.swap (heldLines);
+  if (!lines.empty())
+    renderBrailleLines (lines, output);
+}
 
-      while (i < curLine.length()) {
-#ifdef UEB_WRAPPING_DEBUG
-	      LOG_TRACE << "  wrap lookahead @ " << i << ": " << curLine.substr(i, 10);
-#endif
+/**
+ * @copydoc MathRenderer::endDocument
+ *
+ * Outputs whatever is left of the final line.
+ */
+std::string UEBRenderer::endDocument (void)
+{
+  std::string output;
 
-	      if (curLine.substr(i, UEB_WORDWRAP_INDLEN) == UEB_WORDWRAP_PRI1) {
-	        last_break_position [0] = curOutputLinePos;
-	        i += UEB_WORDWRAP_INDLEN;
-	        continue;
-	      }
-	      if (curLine.substr(i, UEB_WORDWRAP_INDLEN) == UEB_WORDWRAP_PRI2) {
-	        last_break_position [1] = curOutputLinePos;
-	        i += UEB_WORDWRAP_INDLEN;
-	        continue;
-	      }
-	      if (curLine.substr(i, UEB_WORDWRAP_INDLEN) == UEB_WORDWRAP_PRI3) {
-	        last_break_position [2] = curOutputLinePos;
-	        i += UEB_WORDWRAP_INDLEN;
-	        continue;
-	      }
-
-	      curOutputLine += curLine[i];
-	      curOutputLinePos++;
-	      curOutputLineLength++;
-	      i++;
-
-	      /**
-	       * We first try to find a "priority 1" break point within the last 20%
-	       * of the line. If there is none, then look for priority 2, then
-	       * priority 3. If none of those are available, we increase the lookback
-	       * up until 50% of the line, at which point we just say to heck with it
-	       * and break right where we are.
-	       */
-        if (curOutputLineLength == maxLineLength) {
-#ifdef UEB_WRAPPING_DEBUG
-          LOG_TRACE << "reached maxLength " << curOutputLineLength << "@" << curOutputLinePos;
-          LOG_TRACE << "recorded breakpoints: ";
-          for (int xxxx = 0; xxxx <= 2; xxxx++)
-            LOG_TRACE << " - priority " << (xxxx+1) << ": " << last_break_position[xxxx];
-#endif
+  renderHeldLines (output);
+  if (isWrappingEnabled() && isWrapLineStarted)
+    endWrapLine (output);
 
-          unsigned breakpoint = 0;
-          for (size_t lookback_window_size = (size_t)(maxLineLength / 5);
-            !breakpoint && lookback_window_size < (size_t)(maxLineLength / 2);
-            lookback_window_size++) {
-            size_t lookback_start_offset = curOutputLine.length() - lookback_window_size;
+  LOG_TRACE << "<< UEBRenderer::endDocument";
+  return output;
+}
 
-#ifdef UEB_WRAPPING_DEBUG
-            LOG_TRACE << "lookback window size: " << lookback_window_size << ", starting offset: " << lookback_start_offset;
-#endif
+/**
+ * Word wraps rendered braille to the maximum line length.
+ *
+ * Takes all of UEBRenderer::unwrappedBraille and its hints, a run of
+ * characters at a time, and outputs each braille line as soon as it is
+ * full (or ends).  Only the current line is kept, so the time taken is
+ * linear in the length of the braille.
+ *
+ * @param [out] output Buffer to append the wrapped lines to
+ * @see UEBRenderer::maxLineLength, UEBRenderer::isWrappingTextBlock
+ */
+void UEBRenderer::wrapBraille (std::string &output)
+{
+  const size_t start = output.length();
+  const char *braille = unwrappedBraille.data();
+  const size_t length = unwrappedBraille.length();
+  size_t hint = 0;
+  size_t i = 0;
 
-            for (int curPriority = 1; curPriority <= 3 && !breakpoint; curPriority++) {
-              if (last_break_position[curPriority - 1] != 0 &&
-                last_break_position[curPriority - 1] >= lookback_start_offset) {
-#ifdef UEB_WRAPPING_DEBUG
-                LOG_TRACE << " - breaking at priority " << curPriority << " position " << last_break_position [curPriority-1];
-#endif
+  LOG_TRACE << ">> UEBRenderer::wrapBraille begin";
+  logIncreaseIndent();
 
-                breakpoint = last_break_position[curPriority - 1];
-              } else {
-#ifdef UEB_WRAPPING_DEBUG
-                LOG_TRACE << " - no priotity " << curPriority << " break available";
-#endif
-              }
-            }
-          }
-	      
-	        if (!breakpoint) {
-#ifdef UEB_WRAPPING_DEBUG
-	          LOG_TRACE << "no suitable breakpoint found: breaking at EOL";
-#endif
-	          breakpoint = curOutputLinePos;
-	        }
+  while (true) {
+    // Take note of the hints that come before this character
+    for (; hint < wrapHints.size() && wrapHints[hint].offset <= i; hint++) {
+      switch (wrapHints[hint].type) {
+      case MATH_BLOCK_BEGIN:
+	isWrappingTextBlock = false;
+	break;
+
+      case TEXT_BLOCK_BEGIN:
+	isWrappingTextBlock = true;
+	break;
+
+      default:
+	// The very start of a line is no place to break it
+	if (!wrapLine.empty() || wrapContinuation)
+	  wrapBreaks [wrapHints[hint].type - BREAK_PRI1] = wrapLine.length();
+      }
+    }
 
-	        size_t post_break_length;
-	        post_break_length = curOutputLine.length() - breakpoint;
-#ifdef UEB_WRAPPING_DEBUG
-	        LOG_TRACE << "inserting break at " << breakpoint << ", post-break length: " << post_break_length;
-	        LOG_TRACE << "  before: " << curOutputLineLength << ":[" << curOutputLine << "]";
-#endif
+    if (i == length)
+      break;
 
-	        // Delete any whitespace which appears before this point
-	        while (breakpoint > 0 && isspace(curOutputLine[breakpoint-1])) {
-#ifdef UEB_WRAPPING_DEBUG
-	          LOG_TRACE << "  * deleting trailing space before break";
-#endif
-	          breakpoint--;
-	          curOutputLinePos--;
-	          curOutputLine.erase(breakpoint, 1);
-	        }
-
-	        // Delete spaces following the break
-	        while (breakpoint < curOutputLine.length() &&
-		             isspace(curOutputLine[breakpoint])) {
-#ifdef UEB_WRAPPING_DEBUG
-	          LOG_TRACE << "  * deleting space after break";
-#endif
-	          curOutputLinePos--;
-	          curOutputLine.erase(breakpoint, 1);
-	        }
+    if (braille [i] == '\n') {
+      endWrapLine (output);
+      i++;
+      continue;
+    }
 
-	        std::string continuationString;
+    // Take the characters up to the next hint, the end of the line or
+    // the point at which the braille line is full, whichever comes first
+    size_t end = length;
+    if (hint < wrapHints.size())
+      end = std::min (end, wrapHints[hint].offset);
+    if (wrapLineLength < maxLineLength)
+      end = std::min (end, i + (maxLineLength - wrapLineLength));
+    const char *eol = (const char *)memchr (braille + i, '\n', end - i);
+    if (eol)
+      end = eol - braille;
+
+    wrapLine.append (braille + i, end - i);
+    wrapLineLength += end - i;
+    isWrapLineStarted = true;
+    i = end;
+
+    if (wrapLineLength == maxLineLength)
+      breakWrapLine (output);
+  }
 
-	        if (isInTextBlock)
-	          continuationString = "\n"; // no indentation
-	        else
-	          continuationString = "\n  "; // 2 cell runover indentation
+  unwrappedBraille.clear();
+  wrapHints.clear();
 
-	        curOutputLine.insert(breakpoint, continuationString);
-	        curOutputLinePos = curOutputLine.length();
-	        curOutputLineLength = post_break_length + (continuationString.length() - 1);
-#ifdef UEB_WRAPPING_DEBUG
-	        LOG_TRACE << "  after: " << curOutputLineLength << ":[" << curOutputLine << "]";
-#endif
+  logDecreaseIndent();
+  LOG_TRACE << "<< UEBRenderer::wrapBraille end: " << output.substr(start);
+}
 
-	        // reset breakpoints for new line
-	        for (int curPriority = 1; curPriority <= 3; curPriority++)
-	          last_break_position[curPriority-1] = 0;
-        }
+/**
+ * Breaks the current braille line once it has reached the maximum length.
+ *
+ * We first try to find a "priority 1" break point within the last 20% of
+ * the line. If there is none, then look for priority 2, then priority 3.
+ * If none of those are available, we increase the lookback up until 50% of
+ * the line, at which point we just say to heck with it and break right
+ * where we are.
+ *
+ * The lookback that first takes in a break point is simply the distance
+ * back to the nearest one, so it is worked out directly rather than by
+ * trying each lookback in turn.
+ *
+ * @param [out] output Buffer to append the finished part of the line to
+ */
+void UEBRenderer::breakWrapLine (std::string &output)
+{
+  const size_t length = wrapLine.length();
+  const size_t minLookback = (size_t)(maxLineLength / 5);
+  const size_t maxLookback = (size_t)(maxLineLength / 2);
+
+  size_t lookback = std::string::npos;
+  for (int curPriority = 1; curPriority <= 3; curPriority++) {
+    if (wrapBreaks[curPriority - 1] != std::string::npos)
+      lookback = std::min (lookback, length - wrapBreaks[curPriority - 1]);
+  }
+  if (lookback != std::string::npos)
+    lookback = std::max (lookback, minLookback);
+
+  size_t breakpoint = length;
+  if (lookback < maxLookback) {
+    for (int curPriority = 1; curPriority <= 3; curPriority++) {
+      if (wrapBreaks[curPriority - 1] != std::string::npos &&
+	  length - wrapBreaks[curPriority - 1] <= lookback) {
+	breakpoint = wrapBreaks[curPriority - 1];
+	break;
       }
+    }
+  }
 
 #ifdef UEB_WRAPPING_DEBUG
-      LOG_TRACE << "wordwrapped to: " << curOutputLine.length() << ":[" << curOutputLine << "]";
-      logDecreaseIndent();
+  LOG_TRACE << "breaking " << length << ":[" << wrapLine << "] at " << breakpoint;
 #endif
 
-      output += curOutputLine + "\n";
-    }
+  // The length of the next line counts everything after the break point,
+  // including any spaces dropped from the start of it
+  const size_t post_break_length = length - breakpoint;
+
+  // Delete any whitespace which appears before this point, and spaces
+  // following the break
+  size_t lineEnd = breakpoint;
+  while (lineEnd > 0 && isspace((unsigned char)wrapLine[lineEnd - 1]))
+    lineEnd--;
+  size_t nextLineStart = breakpoint;
+  while (nextLineStart < length && isspace((unsigned char)wrapLine[nextLineStart]))
+    nextLineStart++;
+
+  // If there is nothing but whitespace before the break, the previous
+  // break is dropped along with it
+  if (lineEnd > 0) {
+    if (wrapContinuation)
+      output += wrapContinuation;
+    output.append (wrapLine, 0, lineEnd);
   }
+
+  if (isWrappingTextBlock)
+    wrapContinuation = "\n"; // no indentation
   else
-    output = renderedBraille;
+    wrapContinuation = "\n  "; // 2 cell runover indentation
 
-  LOG_TRACE << "<< UEBRenderer::renderDocument end: " << output;
-  logDecreaseIndent();
+  // What is left is less than half a line
+  wrapLine.erase (0, nextLineStart);
+  wrapLineLength = post_break_length + (strlen(wrapContinuation) - 1);
 
-  return output;
+  // reset breakpoints for new line
+  for (int curPriority = 1; curPriority <= 3; curPriority++)
+    wrapBreaks[curPriority - 1] = std::string::npos;
+}
+
+/**
+ * Outputs the rest of the current braille line, at the end of a line of
+ * the document.
+ *
+ * @param [out] output Buffer to append the line to
+ */
+void UEBRenderer::endWrapLine (std::string &output)
+{
+  if (wrapContinuation)
+    output += wrapContinuation;
+  output += wrapLine;
+  output += "\n";
+
+  wrapLine.clear();
+  wrapLineLength = 0;
+  for (int curPriority = 1; curPriority <= 3; curPriority++)
+    wrapBreaks[curPriority - 1] = std::string::npos;
+  wrapContinuation = NULL;
+  isWrapLineStarted = false;
 }
 
 /**
@@ -264,8 +454,7 @@ std::string UEBRenderer::renderDocument (const MathDocument &document)
  *
  * @see UEBRenderer::enableLineWrapping, UEBRenderer::maxLineLength
  * @todo This should probably be a construction-time parameter, because it 
- *       cannot actually be changed mid-render (unless we rework wrapping 
- *       to have wrapping happen on-the-fly rather than at the end).
+ *       cannot actually be changed mid-render.
  */
 void UEBRenderer::disableLineWrapping (void)
 {
@@ -296,22 +485,136 @@ bool UEBRenderer::isWrappingEnabled(void) const
 }
 
 /**
- * Remove line wrap indicators from a rendered braille string
+ * Sets a cache of text translated to braille, which may be shared with
+ * other renderers.  Text found in the cache is not sent to liblouis again,
+ * and text that is translated is added to it.
+ *
+ * @param [in] cache The cache to use, or an empty pointer for none
+ */
+void UEBRenderer::setTranslationCache (const boost::shared_ptr<BrailleTranslationCache> &cache)
+{
+  translationCache = cache;
+}
+
+/**
+ * Sets whether text is translated in batches.
+ *
+ * When this is on, lines are held back until some hundreds of elements
+ * (or the whole document) have been collected.  Their text is then
+ * translated in as few calls to liblouis as possible before they are
+ * rendered.  This pays off for documents with many short pieces of text,
+ * each of which would otherwise be a call of its own.
  *
- * Special indicators are inserted into the rendered math output to indicate 
- * plausible and realistic places for the line to be broken when the time 
- * comes to word wrap. This strips those indicators from the provided string.
+ * Pieces of text translated together are kept apart by a separator, but
+ * liblouis still sees them as neighbouring words.  Tables that use
+ * indicators spanning several words (such as capitalised passages) could
+ * then braille them differently, so this is off by default.
  *
- * @param [in] input Rendered braille string to be cleansed
- * @return std::string containing rendered braille (without wrapping symbols)
+ * @param [in] batch TRUE to translate text in batches
  */
-std::string UEBRenderer::stripWrappingIndicators (const std::string &input) const
+void UEBRenderer::setBatchTranslation (const bool batch)
 {
-  std::string temp = input;
-  boost::algorithm::replace_all (temp, UEB_WORDWRAP_PRI1, "");
-  boost::algorithm::replace_all (temp, UEB_WORDWRAP_PRI2, "");
-  boost::algorithm::replace_all (temp, UEB_WORDWRAP_PRI3, "");
-  return temp;
+  isBatchTranslating = batch;
+}
+
+/**
+ * Determine whether wrapping hints are being kept for a buffer.
+ *
+ * Hints are only kept for the braille being held back for word wrapping;
+ * elements rendered on their own, or without wrapping, have none.
+ *
+ * @param [in] output Buffer being rendered into
+ * @retval TRUE if UEBRenderer::wrapHints refers to offsets in 'output'
+ * @retval FALSE if no hints are kept for 'output'
+ */
+bool UEBRenderer::hintsApplyTo (const std::string &output) const
+{
+  return (&output == &unwrappedBraille);
+}
+
+/**
+ * Record a wrapping hint at the end of the braille output.
+ *
+ * @param [in] output Buffer being rendered into
+ * @param [in] type Kind of hint to record
+ * @see UEBRenderer::wrapHints
+ */
+void UEBRenderer::addWrapHint (const std::string &output, const WrapHintType type)
+{
+  if (hintsApplyTo(output)) {
+    const WrapHint hint = { output.length(), type };
+    wrapHints.push_back (hint);
+  }
+}
+
+/**
+ * Insert braille into the output, moving any later wrapping hints along.
+ *
+ * Hints at 'pos' itself stay before the inserted braille.
+ *
+ * @param [in,out] output Buffer being rendered into
+ * @param [in] pos Offset in 'output' at which to insert
+ * @param [in] s Braille to insert
+ */
+void UEBRenderer::insertBraille (std::string &output, const size_t pos, const char *s)
+{
+  const size_t length = strlen(s);
+
+  output.insert (pos, s, length);
+  if (hintsApplyTo(output)) {
+    for (std::vector<WrapHint>::reverse_iterator it = wrapHints.rbegin();
+	 it != wrapHints.rend() && it->offset > pos; ++it)
+      it->offset += length;
+  }
+}
+
+/**
+ * Erase braille from the output, moving any later wrapping hints back.
+ *
+ * Hints within the erased braille end up at 'pos'.
+ *
+ * @param [in,out] output Buffer being rendered into
+ * @param [in] pos Offset in 'output' of the first character to erase
+ * @param [in] n Number of characters to erase
+ */
+void UEBRenderer::eraseBraille (std::string &output, const size_t pos, const size_t n)
+{
+  output.erase (pos, n);
+  if (hintsApplyTo(output)) {
+    for (std::vector<WrapHint>::reverse_iterator it = wrapHints.rbegin();
+	 it != wrapHints.rend() && it->offset > pos; ++it)
+      it->offset = (it->offset > pos + n) ? it->offset - n : pos;
+  }
+}
+
+/**
+ * Remove whitespace from the start of the braille output, from 'start' on.
+ *
+ * @param [in,out] output Buffer being rendered into
+ * @param [in] start Offset in 'output' from which to trim
+ */
+void UEBRenderer::trimLeftFrom (std::string &output, const size_t start)
+{
+  size_t end = start;
+  while (end < output.length() && isspace((unsigned char)output [end]))
+    end++;
+  if (end > start)
+    eraseBraille (output, start, end - start);
+}
+
+/**
+ * Remove whitespace from both ends of the braille output, from 'start' on.
+ *
+ * @param [in,out] output Buffer being rendered into
+ * @param [in] start Offset in 'output' from which to trim
+ */
+void UEBRenderer::trimFrom (std::string &output, const size_t start)
+{
+  size_t end = output.length();
+  while (end > start && isspace((unsigned char)output [end - 1]))
+    end--;
+  eraseBraille (output, end, output.length() - end);
+  trimLeftFrom (output, start);
 }
 
 /**
@@ -320,7 +623,7 @@ std::string UEBRenderer::stripWrappingIndicators (const std::string &input) cons
 void UEBRenderer::beginInternalRender(void)
 {
   internalRenderCount++;
-  statusStack.push (status);
+  statusStack.push_back (status);
 
   LOG_TRACE << "** push render stack #" << internalRenderCount << ", status: #=" << status.isNumericMode << ", S=" << status.isStartOfLine << ", spaceOp=" << isUsingSpacedOperators;
 
@@ -345,8 +648,8 @@ void UEBRenderer::endInternalRender(void)
 {
   assert (internalRenderCount != 0);
   internalRenderCount--;
-  status = statusStack.top();
-  statusStack.pop();
+  status = statusStack.back();
+  statusStack.pop_back();
 
   logDecreaseIndent();
   LOG_TRACE << "** pop render stack #" << internalRenderCount << ", status: #=" << status.isNumericMode << ", S=" << status.isStartOfLine << ", spaceOp=" << isUsingSpacedOperators;
@@ -357,108 +660,38 @@ void UEBRenderer::endInternalRender(void)
  *
  * Translates the provided input string into braille, taking into account
  * punctuation symbols and the need for capitalization indicators on uppercase
- * letters.  
+ * letters, in a single pass.
  *
  * This is used only for mathematical material, and not text material!
  *
  * @param [in] s Input string containing rendered content
- * @return std::string containing sanitized/indicated content
+ * @param [out] output Buffer to append the sanitized/indicated content to
  */
-std::string UEBRenderer::translateToBraille (const std::string &s)
+void UEBRenderer::translateToBraille (const std::string &s, std::string &output)
 {
-  std::string output;
-
-  LOG_TRACE << ">> " << __func__ << ": (" << s << ")";
-  logIncreaseIndent();
-
-  output = translateBraillePunctuation (s);
-  output = translateBrailleLetterIndicators (output);
-
-  logDecreaseIndent();
-  LOG_TRACE << "<< " << __func__ << ": (" << stripWrappingIndicators(output) << ")";
-
-  return output;
-}
-
-/**
- * Add capitalization indicators in braille (math) material where required.
- *
- * @param [in] s Input string containing rendered content
- * @return std::string containing sanitized/indicated content
- */
-std::string UEBRenderer::translateBrailleLetterIndicators (const std::string &s)
-{
-  std::string output;
+  const size_t start = output.length();
+  bool inNumericMode = false;
 
   LOG_TRACE << ">> " << __func__ << ": (" << s << ")";
   logIncreaseIndent();
 
-  bool inNumericMode = false;
-
   for (size_t pos = 0; pos < s.length(); pos++) {
-    char c = s [pos];
+    const unsigned char c = s [pos];
 
-    if (c == '#') {
+    // Capital signs are needed except in numeric mode, which continues
+    // through "A-J", "4" (period), "1" (comma) and numeric spaces
+    if (c == '#')
       inNumericMode = true;
-      output += c;
-      continue;
-    }
-
-    // End numeric mode if we find anything other than "A-F", "4" (period),
-    // "2" (comma)
-    if (inNumericMode) {
-      if (!isOneOf(c, UEB_NUMERIC_MODE_SYMBOLS)) {
-	      inNumericMode = false;
-      }
-    } else if (c >= 'A' && c <= 'Z') {
+    else if (inNumericMode)
+      inNumericMode = ((BRAILLE_CHARS.flags [c] & BrailleCharTable::NUMERIC) != 0);
+    else if (BRAILLE_CHARS.flags [c] & BrailleCharTable::CAPITAL)
       output += UEB_CAPITAL_SIGN;
-    }
 
-    output += c;
+    output += BRAILLE_CHARS.math [c];
   }
 
   logDecreaseIndent();
-  LOG_TRACE << "<< " << __func__ << ": (" << stripWrappingIndicators(output) << ")";
-
-  return output;
-}
-
-/**
-* Add punctuation indicators in braille (math) material where required.
-*
-* @todo Confirm that this is in fact necessary. It may be entire usurped by 
-*       UEBRenderer::renderSymbols now (UEB_COMMA, UEB_PERIOD)?  
-* @param [in] s Input string containing rendered content
-* @return std::string containing sanitized/indicated content
-*/
-std::string UEBRenderer::translateBraillePunctuation(const std::string &s)
-{
-  std::string output;
-
-  LOG_TRACE << ">> " << __func__ << ": (" << s << ")";
-  logIncreaseIndent();
-
-  for (size_t pos = 0; pos < s.length(); pos++) {
-    char c = s [pos];
-
-    if (c == ',') {
-      output += UEB_COMMA;
-      continue;
-    }
-
-    if (c == '.') {
-      output += UEB_PERIOD;
-      continue;
-    }
-
-    output += c;
-  }
-
-
-  logDecreaseIndent();
-  LOG_TRACE << "<< " << __func__ << ": (" << stripWrappingIndicators(output) << ")";
-
-  return output;
+  LOG_TRACE << "<< " << __func__ << ": (" << output.substr(start) << ")";
 }
 
 /**
@@ -552,184 +785,388 @@ bool UEBRenderer::isSimpleFraction (const MDE_Fraction &frac)
 /**
 * Renders mathematical material into the braille output.
 *
-* Inserts the provided text (assumed to be already-rendere braille) into
-* the output, changing to math mode if required, and inserting a letter 
-* indicator if needed (i.e. if we are following a number).
+* Finishes off material (assumed to be already-rendered braille) that has
+* just been appended to the output, inserting a letter indicator before it
+* if needed (i.e. if we are following a number).
 *
 * This will also skip over any leading whitespace if we have been asked
 * to do so by some other function (e.g. UEBRenderer::renderOperator may
 * do this to prevent multiple spaces appearing after an operator).
 *
-* @param [in] s Rendered braille to be inserted into the output
-* @return Input string, with any indicators prepended as required
+* @param [in,out] output Output buffer, ending with the rendered material
+* @param [in] start Offset in 'output' at which the material begins
 * @see UEBRenderer::UEBRenderStatus::isNumericMode
 */
-std::string UEBRenderer::renderMathContent (const std::string &s)
+void UEBRenderer::finishMathContent (std::string &output, const size_t start)
 {
-  std::string output;
+  bool needLetterIndicator = false;
 
-  LOG_TRACE << ">> " << __func__ << ": (" << s << ")";
+  LOG_TRACE << ">> " << __func__ << ": (" << output.substr(start) << ")";
   logIncreaseIndent();
 
   // If we're in numeric mode, we might need a letter indicator here.
   if (status.isNumericMode) {
-    if (isOneOf(s[0], "abcdefghij")) {
+    if (isOneOf(output[start], "abcdefghij")) {
       LOG_TRACE << "- inserting letter indicator before string b/c in math mode";
-      output = UEB_G1;
+      needLetterIndicator = true;
       status.isNumericMode = false;
     }
   }
 
   if (status.skipFollowingWhitespace) {
-    output += boost::trim_left_copy(s);
+    trimLeftFrom(output, start);
     status.skipFollowingWhitespace = false;
   }
-  else
-    output += s;
 
-  status.isStartOfLine = false;
+  if (needLetterIndicator)
+    insertBraille(output, start, UEB_G1);
+
+  status.isStartOfLine = false;
+
+  logDecreaseIndent();
+  LOG_TRACE << "<< " << __func__ << ": (" << output.substr(start) << ")";
+}
+
+/**
+* Renders mathematical material into the braille output.
+*
+* Appends the provided text (assumed to be already-rendered braille) to
+* the output, with any indicators it needs.
+*
+* @param [in] s Rendered braille to be inserted into the output
+* @param [out] output Buffer to append to
+* @see UEBRenderer::finishMathContent
+*/
+void UEBRenderer::renderMathContent (const std::string &s, std::string &output)
+{
+  const size_t start = output.length();
+
+  output += s;
+  finishMathContent(output, start);
+}
+
+/**
+* Translates text to braille using the liblouis library.
+*
+* liblouis can only translate so much at once, so longer text is split
+* between sentences or words, and the pieces translated separately.
+*
+* @param [in] s Text content (ASCII) to be translated
+* @param [out] braille Buffer to append the braille to
+* @throw MathRenderException if liblouis fails to translate the text
+*/
+void UEBRenderer::translateText (const std::string &s, std::string &braille)
+{
+  size_t maxLength = LIBLOUIS_MAXCHUNK;
+
+  for (size_t start = 0; start < s.length(); ) {
+    const size_t end = findChunkEnd(s, start, maxLength);
+
+    // Braille is usually a little longer than the text it comes from, but
+    // can be much longer; if this piece did not fit, try a smaller one.
+    if (!translateTextChunk(s.substr(start, end - start), braille)) {
+      maxLength /= 2;
+      continue;
+    }
+
+    // The pieces are split at spaces, which are put back between them
+    start = end;
+    if (start < s.length() && s [start] == ' ') {
+      braille += ' ';
+      start++;
+    }
+    maxLength = LIBLOUIS_MAXCHUNK;
+  }
+}
+
+/**
+* Translates a piece of text small enough for liblouis to manage at once.
+*
+* @param [in] s Text to be translated
+* @param [out] braille Buffer to append the braille to
+* @return false, leaving 'braille' alone, if the braille would not fit in
+*         liblouis' buffer (so that a smaller piece should be tried)
+* @throw MathRenderException if liblouis fails to translate the text
+*/
+bool UEBRenderer::translateTextChunk (const std::string &s, std::string &braille)
+{
+  unsigned inlen;
+  if (!strToWideCharString(s, &louisInput [0], LIBLOUIS_MAXSTRING, inlen))
+    return false;
+  const unsigned wideLength = inlen;
+  unsigned outlen = LIBLOUIS_MAXSTRING;
+
+  LOG_TRACE << "Sending " << inlen << " chars to louis using table '" << LIBLOUIS_UEB_G1_TABLE << "': {" << s << "}, max output size=" << outlen;
+  if (!LibLouisContext::get().translate(LIBLOUIS_UEB_G1_TABLE,
+					&louisInput [0], inlen,
+					&louisOutput [0], outlen)) {
+    LOG_ERROR << "! Braille translation error on '" << s << "'!";
+    std::ostringstream os;
+    lou_logEnd();
+    os << "Error occurred while trying to render braille for text: '" << s << "'";
+    BOOST_THROW_EXCEPTION (MathRenderException() <<
+			   mdx_error_info(os.str()));
+  }
+
+  // liblouis stops when its output buffer is full, and says how much of
+  // the input it got through
+  if (inlen < wideLength) {
+    LOG_TRACE << "Louis only translated " << inlen << " of " << wideLength << " chars";
+    if (wideLength <= 1) {
+      std::ostringstream os;
+      os << "Braille for text does not fit in the translation buffer: '" << s << "'";
+      BOOST_THROW_EXCEPTION (MathRenderException() <<
+			     mdx_error_info(os.str()));
+    }
+    return false;
+  }
+
+  const size_t start = braille.length();
+  wideCharStringToStr(&louisOutput [0], outlen, braille);
+  LOG_TRACE << "Louis returned " << outlen << " chars: {" << braille.substr(start) << "}";
+  return true;
+}
+
+/**
+* Translates the text in a set of lines ahead of rendering them, in as
+* few batches as possible.  Text that is not translated here (because it
+* is too long, say) is translated as it is rendered.
+*
+* @param [in] elements Lines about to be rendered
+* @see UEBRenderer::setBatchTranslation
+*/
+void UEBRenderer::translateTextBatches (const MDEVector &elements)
+{
+  std::set<std::string> seen;
+  std::vector<std::string> batch;
+  size_t batchLength = 0;
+
+  batchedTranslations.clear();
+
+  for (MDEVector::const_iterator it = elements.begin(); it != elements.end(); ++it) {
+    const MathDocumentElement *ptr = it->get();
+    std::string text;
+
+    if (const MDE_ItemNumber *item = dynamic_cast<const MDE_ItemNumber *>(ptr))
+      text = item->getText() + " ";
+    else if (const MDE_TextBlock *block = dynamic_cast<const MDE_TextBlock *>(ptr))
+      text = block->getText();
+    else if (const MDE_Error *error = dynamic_cast<const MDE_Error *>(ptr))
+      text = error->getText();
+    else
+      continue;
+
+    if (text.empty() || text [0] == ' ' || text.length() > LIBLOUIS_MAXCHUNK ||
+	text.find (BATCH_SEPARATOR_CHAR) != std::string::npos ||
+	!seen.insert(text).second)
+      continue;
+
+    if (batchLength + text.length() > LIBLOUIS_MAXCHUNK) {
+      translateTextBatch (batch);
+      batch.clear();
+      batchLength = 0;
+    }
+
+    batch.push_back (text);
+    batchLength += text.length() + BATCH_SEPARATOR.length();
+  }
+
+  translateTextBatch (batch);
+}
+
+/**
+* Translates several pieces of text in one call to liblouis, adding the
+* results to UEBRenderer::batchedTranslations.
+*
+* The pieces are translated with separators between them, which the
+* braille is then split at.  If it cannot be split up again as expected,
+* the pieces are left to be translated one by one.
+*
+* @param [in] texts Pieces of text to translate, which do not start with
+*             a space or contain the separator
+*/
+void UEBRenderer::translateTextBatch (const std::vector<std::string> &texts)
+{
+  if (texts.size() < 2)
+    return;
+
+  if (batchSeparatorBraille.empty() &&
+      !translateTextChunk(std::string(1, BATCH_SEPARATOR_CHAR), batchSeparatorBraille))
+    return;
+
+  // Trailing spaces would run into the separator, so they are left off
+  // and put back afterwards
+  std::string batch;
+  std::vector<size_t> trailingSpaces;
+  for (std::vector<std::string>::const_iterator it = texts.begin(); it != texts.end(); ++it) {
+    const size_t end = it->find_last_not_of (' ') + 1;
+    trailingSpaces.push_back (it->length() - end);
+    if (!batch.empty())
+      batch += BATCH_SEPARATOR;
+    batch.append (*it, 0, end);
+  }
+
+  std::string braille;
+  if (!translateTextChunk(batch, braille))
+    return;
+
+  const std::string separator = " " + batchSeparatorBraille + " ";
+  std::vector<std::string> pieces;
+  size_t start = 0;
+  for (;;) {
+    const size_t end = braille.find (separator, start);
+    pieces.push_back (braille.substr (start, end - start));
+    if (end == std::string::npos)
+      break;
+    start = end + separator.length();
+  }
 
-  logDecreaseIndent();
-  LOG_TRACE << "<< " << __func__ << ": (" << stripWrappingIndicators(output) << ")";
+  if (pieces.size() != texts.size()) {
+    LOG_TRACE << "* batch of " << texts.size() << " pieces of text came back as " << pieces.size();
+    return;
+  }
 
-  return output;
+  for (size_t n = 0; n < texts.size(); n++)
+    batchedTranslations [texts [n]] = pieces [n] + std::string(trailingSpaces [n], ' ');
 }
 
 /**
 * Renders textual material into the braille output.
 *
-* Inserts the provided text into the output, converting it to braille
-* using the liblouis library.
+* Appends the provided text to the output, converting it to braille
+* using the liblouis library (or taking the braille from the translation
+* cache, if the text has been translated before).
 *
 * @param [in] s Text content (ASCII) to be added to output file.
-* @return Rendered braille, including wordwrap indicators.
+* @param [out] output Buffer to append the rendered braille to; places to
+*              break lines are recorded as wrapping hints
 */
-std::string UEBRenderer::renderTextContent (const std::string &s)
+void UEBRenderer::renderTextContent (const std::string &s, std::string &output)
 {
-  std::string output;
-  std::string braille_string;
-
   LOG_TRACE << ">> " << __func__ << ": (" << s << ")";
   logIncreaseIndent();
 
-  // Assume that the braille could grow to be a bit larger than our max
-  // LibLouis buffer size.  If this will likely be a problem, abort.
+  const size_t textStart = output.length();
+  const bool withHints = hintsApplyTo(output);
+  std::vector<WrapHint> unusedHints;
 
-  /*! @todo Split long strings into ~500-byte chunks (using a "period space"
-      or just a space as a likely split point) and feed to LibLouis in smaller
-      sections to get around this limitation. */
-  if (s.length() >= (0.90 * LIBLOUIS_MAXSTRING)) {
-    LOG_ERROR << "! Braille translation max buffer size error on '" << s << "'!";
-    std::ostringstream os;
-    os << "This text is too long to translate to braille, and a workaround has not yet been implemented: '" << s << "'";
-    BOOST_THROW_EXCEPTION (MathRenderException() <<
-			   mdx_error_info(os.str()));
-  }
-
-  boost::scoped_array<ll_widechar> input_buffer (new ll_widechar [LIBLOUIS_MAXSTRING]);
-  boost::scoped_array<ll_widechar> braille_buffer (new ll_widechar [LIBLOUIS_MAXSTRING]);
-
-  unsigned inlen;
-  strToWideCharString(s, input_buffer.get(), inlen);
-  unsigned outlen = LIBLOUIS_MAXSTRING;
+  if (translationCache &&
+      translationCache->lookup(LIBLOUIS_UEB_G1_TABLE, s, withHints, output,
+			       withHints ? wrapHints : unusedHints)) {
+    LOG_TRACE << "* translation of (" << s << ") found in cache";
+  } else {
+    const size_t firstHint = wrapHints.size();
+    boost::posix_time::ptime started = boost::posix_time::microsec_clock::universal_time();
+    std::string braille_string;
 
-  LOG_TRACE << "Sending " << inlen << " chars to louis using table '" << LIBLOUIS_UEB_G1_TABLE << "': {" << s << "}, max output size=" << outlen;
-  if (!lou_translateString(LIBLOUIS_UEB_G1_TABLE,
-			   input_buffer.get(),
-			   (int *)&inlen,
-			   braille_buffer.get(),
-			   (int *)&outlen,
-			   NULL /* no typeform checking */,
-			   NULL /* don't care about spacing info */,
-			   0 /* no modes set */)) {
-    LOG_ERROR << "! Braille translation error on '" << s << "'!";
-    std::ostringstream os;
-    lou_logEnd();
-    os << "Error occurred while trying to render braille for text: '" << s << "'";
-    BOOST_THROW_EXCEPTION (MathRenderException() <<
-			   mdx_error_info(os.str()));
-  }
+    std::map<std::string, std::string>::const_iterator batched = batchedTranslations.find(s);
+    if (batched != batchedTranslations.end())
+      braille_string = batched->second;
+    else
+      translateText(s, braille_string);
 
-  wideCharStringToStr(braille_buffer.get(), outlen, braille_string);
-  LOG_TRACE << "Louis returned " << outlen << " chars: {" << braille_string << "}";
-  
-  // Insert wrapping indicators.
-  if (isWrappingEnabled()) {
-    boost::replace_all(braille_string, "4 ", "4 " UEB_WORDWRAP_PRI1);
-    boost::replace_all(braille_string, "6 ", "6 " UEB_WORDWRAP_PRI1);
-    boost::replace_all(braille_string, "8 ", "8 " UEB_WORDWRAP_PRI1);
-    boost::replace_all(braille_string, " ", " " UEB_WORDWRAP_PRI2);
-    boost::replace_all(braille_string, UEB_LEFT_PAREN, UEB_WORDWRAP_PRI1 UEB_LEFT_PAREN);
-    boost::replace_all(braille_string, UEB_LEFT_BRACKET, UEB_WORDWRAP_PRI1 UEB_LEFT_BRACKET);
-    boost::replace_all(braille_string, UEB_LEFT_BRACE, UEB_WORDWRAP_PRI1 UEB_LEFT_BRACE);
-  }
+    finishTextContent(braille_string, output, withHints);
 
-  /*! @bug There is a bug in liblouis that results in single letters
-      getting letter indicators before them unnecessarily.  Fix this. */
-  std::string fixed_braille_string;
-  fixed_braille_string = braille_string;
-  for (char ch = 'a'; ch <= 'z'; ch++) {
-    const std::string searchStr = boost::str(boost::format(";%c ") % ch);
-    const std::string replaceStr = boost::str(boost::format("%c ") % ch);
+    if (translationCache) {
+      boost::posix_time::time_duration elapsed = boost::posix_time::microsec_clock::universal_time() - started;
+      std::vector<WrapHint> hints (wrapHints.begin() + firstHint, wrapHints.end());
+      for (std::vector<WrapHint>::iterator it = hints.begin(); it != hints.end(); ++it)
+	it->offset -= textStart;
 
-    boost::ireplace_all(fixed_braille_string, searchStr, replaceStr);
+      translationCache->store (LIBLOUIS_UEB_G1_TABLE, s, withHints,
+			       output.substr(textStart), hints,
+			       elapsed.total_microseconds());
+    }
   }
 
-  output += fixed_braille_string;
-
   status.isNumericMode = false;
   status.isStartOfLine = false;
 
   logDecreaseIndent();
-  LOG_TRACE << "<< " << __func__ << ": (" << stripWrappingIndicators(output) << ")";
-
-  return output;
+  LOG_TRACE << "<< " << __func__ << ": (" << output.substr(textStart) << ")";
 }
 
-std::string UEBRenderer::renderSourceLine (const MDE_SourceLine *e)
+/**
+ * Appends braille from liblouis to the output, in a single pass that
+ * corrects it and (if asked to) records the places that the text may be
+ * broken: after any space, preferably at the end of a sentence, or before
+ * an opening bracket.
+ *
+ * @param [in] braille Braille for the text, as liblouis returned it
+ * @param [out] output Buffer to append the braille to
+ * @param [in] withHints TRUE to record wrapping hints for the braille
+ */
+void UEBRenderer::finishTextContent (const std::string &braille, std::string &output,
+				     const bool withHints)
 {
-  std::string output;
+  const size_t textStart = output.length();
+  output.reserve (textStart + braille.length());
 
-  //! @todo Function does nothing on braille render: remove?
+  for (size_t pos = 0; pos < braille.length(); pos++) {
+    unsigned char c = braille [pos];
 
-  LOG_TRACE << "%% " << e->getString();
+    /*! @bug There is a bug in liblouis that results in single letters
+        getting letter indicators before them unnecessarily.  Fix this
+        (leaving the letter in lower case). */
+    if (c == ';' && pos + 2 < braille.length() &&
+	(BRAILLE_CHARS.flags [(unsigned char)braille [pos + 1]] & BrailleCharTable::LETTER) &&
+	braille [pos + 2] == ' ')
+      c = tolower ((unsigned char)braille [++pos]);
 
-  return output;
+    const size_t outPos = output.length();
+    output += (char)c;
+
+    if (!withHints)
+      continue;
+
+    if (c == ' ') {
+      const bool isSentenceEnd = (outPos > textStart &&
+				  (BRAILLE_CHARS.flags [(unsigned char)output [outPos - 1]] &
+				   BrailleCharTable::SENTENCE_END));
+      const WrapHint hint = { outPos + 1, isSentenceEnd ? BREAK_PRI1 : BREAK_PRI2 };
+      wrapHints.push_back (hint);
+    } else if ((BRAILLE_CHARS.flags [c] & BrailleCharTable::BRACKET_END) &&
+	       outPos > textStart &&
+	       (BRAILLE_CHARS.flags [(unsigned char)output [outPos - 1]] &
+		BrailleCharTable::BRACKET_BEGIN)) {
+      const WrapHint hint = { outPos - 1, BREAK_PRI1 };
+      wrapHints.push_back (hint);
+    }
+  }
 }
 
-std::string UEBRenderer::renderCommand (const MDE_Command *e)
+void UEBRenderer::renderSourceLine (const MDE_SourceLine *e, std::string & /*output*/)
 {
-  std::string output;
+  //! @todo Function does nothing on braille render: remove?
+
+  LOG_TRACE << "%% " << e->getString();
+}
 
+void UEBRenderer::renderCommand (const MDE_Command *e, std::string & /*output*/)
+{
   LOG_TRACE << "%% COMMAND: " << e->getString();
   if (boost::iequals(e->getName(), "SpaceUEBOperators")) {
     isUsingSpacedOperators = (e->getParameters() == "true");
     LOG_TRACE << "- extra operator spacing: " << isUsingSpacedOperators;
   }
-
-  return output;
 }
 
-std::string UEBRenderer::renderMathModeMarker (const MDE_MathModeMarker *e)
+void UEBRenderer::renderMathModeMarker (const MDE_MathModeMarker *e, std::string &output)
 {
-  std::string output;
-
   if (e->getType() == MDE_MathModeMarker::BLOCK_MARKER) {
     // We should only see the start of a math "block" if we are also at the
     // start of a line.  We can't commence a math block mid-line, as the
     // indenting and word wrapping requirements will be different.
     assert (status.isStartOfLine == true);
     status.isInTextBlock = false;
-    output += UEB_MATH_BLOCK_BEGIN;
+    addWrapHint(output, MATH_BLOCK_BEGIN);
     LOG_TRACE << "* commencing math block mode";
   }
-
-  return output;
 }
 
-std::string UEBRenderer::renderTextModeMarker (const MDE_TextModeMarker *e)
+void UEBRenderer::renderTextModeMarker (const MDE_TextModeMarker *e, std::string &output)
 {
-  std::string output;
+  const size_t start = output.length();
 
   LOG_TRACE << ">> " << __func__ << ": (" << *e << ")";
   logIncreaseIndent();
@@ -740,19 +1177,17 @@ std::string UEBRenderer::renderTextModeMarker (const MDE_TextModeMarker *e)
     // indenting and word wrapping requirements will be different.
     assert (status.isStartOfLine == true);
     status.isInTextBlock = true;
-    output += UEB_TEXT_BLOCK_BEGIN;
+    addWrapHint(output, TEXT_BLOCK_BEGIN);
     LOG_TRACE << "* commencing text block mode";
   }
 
   logDecreaseIndent();
-  LOG_TRACE << "<< " << __func__ << ": (" << stripWrappingIndicators(output) << ")";
-
-  return output;
+  LOG_TRACE << "<< " << __func__ << ": (" << output.substr(start) << ")";
 }
 
-std::string UEBRenderer::renderLineBreak (const MDE_LineBreak *e)
+void UEBRenderer::renderLineBreak (const MDE_LineBreak *e, std::string &output)
 {
-  std::string output;
+  const size_t start = output.length();
 
   LOG_TRACE << ">> " << __func__ << ": (" << *e << ")";
   logIncreaseIndent();
@@ -762,72 +1197,86 @@ std::string UEBRenderer::renderLineBreak (const MDE_LineBreak *e)
   status.isStartOfLine = true;
 
   logDecreaseIndent();
-  LOG_TRACE << "<< " << __func__ << ": (" << stripWrappingIndicators(output) << ")";
-
-  return output;
+  LOG_TRACE << "<< " << __func__ << ": (" << output.substr(start) << ")";
 }
 
-std::string UEBRenderer::renderTextBlock (const MDE_TextBlock *e)
+void UEBRenderer::renderTextBlock (const MDE_TextBlock *e, std::string &output)
 {
-  std::string output;
+  const size_t start = output.length();
 
   LOG_TRACE << ">> " << __func__ << ": (" << *e << ")";
   logIncreaseIndent();
 
   if (!status.isStartOfLine)
-    output = " ";
+    output += " ";
 
-  output += renderTextContent(e->getText());
+  renderTextContent(e->getText(), output);
   status.isStartOfLine = false;
 
   logDecreaseIndent();
-  LOG_TRACE << "<< " << __func__ << ": (" << stripWrappingIndicators(output) << ")";
-  return output;
+  LOG_TRACE << "<< " << __func__ << ": (" << output.substr(start) << ")";
 }
 
-std::string UEBRenderer::renderMathBlock (const MDE_MathBlock *e)
+void UEBRenderer::renderMathBlock (const MDE_MathBlock *e, std::string &output)
 {
-  std::string output;
-  std::string brl;
+  const size_t start = output.length();
 
   LOG_TRACE << ">> " << __func__ << ": (" << *e << ")";
   logIncreaseIndent();
 
-  brl = translateToBraille(e->getText());
-  output = renderMathContent(brl);
+  translateToBraille(e->getText(), output);
+  finishMathContent(output, start);
 
   logDecreaseIndent();
-  LOG_TRACE << "<< " << __func__ << ": (" << stripWrappingIndicators(output) << ")";
-  return output;
+  LOG_TRACE << "<< " << __func__ << ": (" << output.substr(start) << ")";
 }
 
-std::string UEBRenderer::renderItemNumber (const MDE_ItemNumber *e)
+/**
+ * @copydoc MathRenderer::renderError
+ *
+ * The skipped source text is brailled as ordinary text.
+ */
+void UEBRenderer::renderError (const MDE_Error *e, std::string &output)
 {
-  std::string output;
+  const size_t start = output.length();
 
   LOG_TRACE << ">> " << __func__ << ": (" << *e << ")";
   logIncreaseIndent();
 
-  output = renderTextContent(e->getText() + " ");
+  if (!status.isStartOfLine)
+    output += " ";
 
-  // Drop letter indicator if one has appeared
-  if (output.substr(0, 1) == UEB_G1)
-    output.erase(output.begin(), output.begin()+1);
+  renderTextContent(e->getText(), output);
+  status.isStartOfLine = false;
 
   logDecreaseIndent();
-  LOG_TRACE << "<< " << __func__ << ": (" << stripWrappingIndicators(output) << ")";
-  return output;
+  LOG_TRACE << "<< " << __func__ << ": (" << output.substr(start) << ")";
 }
 
-std::string UEBRenderer::renderGroup (const MDE_Group *e)
+void UEBRenderer::renderItemNumber (const MDE_ItemNumber *e, std::string &output)
 {
-  std::string renderedContents;
-  std::string openChar, closeChar;
-  std::string output;
+  const size_t start = output.length();
 
   LOG_TRACE << ">> " << __func__ << ": (" << *e << ")";
   logIncreaseIndent();
 
+  renderTextContent(e->getText() + " ", output);
+
+  // Drop letter indicator if one has appeared
+  if (output.compare(start, 1, UEB_G1) == 0)
+    eraseBraille(output, start, 1);
+
+  logDecreaseIndent();
+  LOG_TRACE << "<< " << __func__ << ": (" << output.substr(start) << ")";
+}
+
+void UEBRenderer::renderGroup (const MDE_Group *e, std::string &output)
+{
+  const char *openChar = "", *closeChar = "";
+
+  LOG_TRACE << ">> " << __func__;
+  logIncreaseIndent();
+
   switch (e->getType()) {
   case MDE_Group::PARENTHESES:
     openChar = UEB_LEFT_PAREN;
@@ -849,34 +1298,44 @@ std::string UEBRenderer::renderGroup (const MDE_Group *e)
   }
 
 
+  addWrapHint(output, BREAK_PRI2);
+  output += openChar;
+
   beginInternalRender();
   status.isNumericMode = false;
-  renderedContents = renderVector (e->getContents());
-  endInternalRender();
+  renderNested (e->getContents());
+  scheduleStep (boost::bind(&UEBRenderer::finishGroup, this, output.length(), closeChar, _1));
+}
 
-  if (isWrappingEnabled())
-    output = UEB_WORDWRAP_PRI2;
+/**
+ * Closes a group once its contents have been rendered.
+ *
+ * @param [in] contentsStart Where the contents began in the output
+ * @param [in] closeChar Closing grouping symbol
+ * @param [out] output Buffer to append to
+ */
+void UEBRenderer::finishGroup (const size_t contentsStart, const char *closeChar,
+			       std::string &output)
+{
+  endInternalRender();
 
-  output += openChar;
-  output += boost::trim_copy(renderedContents);
+  trimFrom(output, contentsStart);
   output += closeChar;
 
   logDecreaseIndent();
-  LOG_TRACE << "<< " << __func__ << ": (" << stripWrappingIndicators(output) << ")";
-  return output;
+  LOG_TRACE << "<< renderGroup";
 }
 
-std::string UEBRenderer::renderNumber (const MDE_Number *e)
+void UEBRenderer::renderNumber (const MDE_Number *e, std::string &output)
 {
-  std::string output;
+  const size_t start = output.length();
   std::string printNumber;
   std::string brailleNumber;
 
   LOG_TRACE << ">> " << __func__ << ": (" << *e << ")";
   logIncreaseIndent();
 
-  if (isWrappingEnabled())
-    brailleNumber = UEB_WORDWRAP_PRI3;
+  addWrapHint(output, BREAK_PRI3);
 
   size_t pos = 0;
   printNumber = e->getStandardNotation();
@@ -916,17 +1375,16 @@ std::string UEBRenderer::renderNumber (const MDE_Number *e)
     pos++;
   }
 
-  output = renderMathContent(brailleNumber);
+  renderMathContent(brailleNumber, output);
   status.isNumericMode = true;
 
   logDecreaseIndent();
-  LOG_TRACE << "<< " << __func__ << ": (" << stripWrappingIndicators(output) << ")";
-  return output;
+  LOG_TRACE << "<< " << __func__ << ": (" << output.substr(start) << ")";
 }
 
-std::string UEBRenderer::renderOperator (const MDE_Operator *e)
+void UEBRenderer::renderOperator (const MDE_Operator *e, std::string &output)
 {
-  std::string output;
+  const size_t start = output.length();
 
   static std::map<MDE_Operator::Operator,std::string> opmap = ba::map_list_of
     ( MDE_Operator::ADDITION, UEB_PLUS_SIGN )
@@ -941,11 +1399,9 @@ std::string UEBRenderer::renderOperator (const MDE_Operator *e)
   assert(opmap.count(e->getOperator()) == 1);
 
   if (isUsingSpacedOperators)
-    output = " ";
-
-  if (isWrappingEnabled())
-    output += UEB_WORDWRAP_PRI2;
+    output += " ";
 
+  addWrapHint(output, BREAK_PRI2);
   output += opmap[e->getOperator()];
 
   if (isUsingSpacedOperators)
@@ -955,13 +1411,12 @@ std::string UEBRenderer::renderOperator (const MDE_Operator *e)
   status.skipFollowingWhitespace = true;
 
   logDecreaseIndent();
-  LOG_TRACE << "<< " << __func__ << ": (" << stripWrappingIndicators(output) << ")";
-  return output;
+  LOG_TRACE << "<< " << __func__ << ": (" << output.substr(start) << ")";
 }
 
-std::string UEBRenderer::renderComparator (const MDE_Comparator *e)
+void UEBRenderer::renderComparator (const MDE_Comparator *e, std::string &output)
 {
-  std::string output;
+  const size_t start = output.length();
 
   static std::map<MDE_Comparator::Comparator,std::string> compmap = ba::map_list_of
     ( MDE_Comparator::LESS_THAN, UEB_LESS_THAN )
@@ -978,22 +1433,21 @@ std::string UEBRenderer::renderComparator (const MDE_Comparator *e)
 
   assert(compmap.count(e->getComparator()) == 1);
 
-  if (isWrappingEnabled())
-    output = " " UEB_WORDWRAP_PRI1 + compmap [e->getComparator()] + " ";
-  else
-    output = " " + compmap [e->getComparator()] + " ";
+  output += " ";
+  addWrapHint(output, BREAK_PRI1);
+  output += compmap [e->getComparator()];
+  output += " ";
 
   // make sure no additional spaces wind up following this comparator
   status.skipFollowingWhitespace = true;
 
   logDecreaseIndent();
-  LOG_TRACE << "<< " << __func__ << ": (" << stripWrappingIndicators(output) << ")";
-  return output;
+  LOG_TRACE << "<< " << __func__ << ": (" << output.substr(start) << ")";
 }
 
-std::string UEBRenderer::renderGreekLetter (const MDE_GreekLetter *e)
+void UEBRenderer::renderGreekLetter (const MDE_GreekLetter *e, std::string &output)
 {
-  std::string output;
+  const size_t start = output.length();
 
 #define MAPLC(ltr, brl) (MDE_GreekLetter::ltr, UEB_GREEK_SIGN brl)
 #define MAPUC(ltr, brl) (MDE_GreekLetter::ltr, UEB_CAPITAL_SIGN UEB_GREEK_SIGN brl)
@@ -1035,19 +1489,16 @@ std::string UEBRenderer::renderGreekLetter (const MDE_GreekLetter *e)
 
   assert(charmap.count(e->getValue()) == 1);
 
-  if (isWrappingEnabled())
-    output = UEB_WORDWRAP_PRI3;
+  addWrapHint(output, BREAK_PRI3);
 
-  output += renderMathContent(charmap[e->getValue()]);
+  renderMathContent(charmap[e->getValue()], output);
   logDecreaseIndent();
-  LOG_TRACE << "<< " << __func__ << ": (" << stripWrappingIndicators(output) << ")";
-
-  return output;
+  LOG_TRACE << "<< " << __func__ << ": (" << output.substr(start) << ")";
 }
 
-std::string UEBRenderer::renderSymbol (const MDE_Symbol *e)
+void UEBRenderer::renderSymbol (const MDE_Symbol *e, std::string &output)
 {
-  std::string output;
+  const size_t start = output.length();
 
   static std::map<MDE_Symbol::Symbol,std::string> symmap = ba::map_list_of
     ( MDE_Symbol::COMMA, UEB_COMMA)
@@ -1074,36 +1525,50 @@ std::string UEBRenderer::renderSymbol (const MDE_Symbol *e)
 
   assert(symmap.count(e->getSymbol()) == 1);
 
-  output = renderMathContent(symmap [e->getSymbol()]);
+  renderMathContent(symmap [e->getSymbol()], output);
 
   logDecreaseIndent();
-  LOG_TRACE << "<< " << __func__ << ": (" << stripWrappingIndicators(output) << ")";
-  return output;
-
+  LOG_TRACE << "<< " << __func__ << ": (" << output.substr(start) << ")";
 }
 
-std::string UEBRenderer::renderModifier (const MDE_Modifier *e)
+void UEBRenderer::renderModifier (const MDE_Modifier *e, std::string &output)
 {
-  std::string renderedArgument;
-  std::string output;
+  const size_t start = output.length();
 
-  LOG_TRACE << ">> " << __func__ << ": (" << *e << ")";
+  LOG_TRACE << ">> " << __func__;
   logIncreaseIndent();
 
+  // Include grouping indicators only if the symbol to be modified is
+  // something more than an 'item'.  See isBrailleItem() for details.
+  const bool isItem = isBrailleItem(e->getArgument());
+
+  addWrapHint(output, BREAK_PRI3);
+
+  if (!isItem)
+    output += UEB_GROUP_BEGIN;
+
   beginInternalRender();
   status.isNumericMode = false;
-  renderedArgument = renderVector(e->getArgument());
-  endInternalRender();
+  renderNested (e->getArgument());
+  scheduleStep (boost::bind(&UEBRenderer::finishModifier, this, e, isItem, start, _1));
+}
 
-  // Include grouping indicators only if the symbol to be modified is
-  // something more than an 'item'.  See isBrailleItem() for details.
-  if (isWrappingEnabled())
-    output = UEB_WORDWRAP_PRI3;
+/**
+ * Adds the modification symbol once the modified elements have been
+ * rendered.
+ *
+ * @param [in] e Modifier being rendered
+ * @param [in] isItem TRUE if the modified elements are an 'item'
+ * @param [in] start Where the modifier began in the output
+ * @param [out] output Buffer to append to
+ */
+void UEBRenderer::finishModifier (const MDE_Modifier *e, const bool isItem,
+				  const size_t start, std::string &output)
+{
+  endInternalRender();
 
-  if (!isBrailleItem(e->getArgument()))
-    output += UEB_GROUP_BEGIN + renderedArgument + UEB_GROUP_END;
-  else
-    output += renderedArgument;
+  if (!isItem)
+    output += UEB_GROUP_END;
 
   switch (e->getModifier()) {
   case MDE_Modifier::OVER_ARROW_RIGHT:
@@ -1122,244 +1587,292 @@ std::string UEBRenderer::renderModifier (const MDE_Modifier *e)
     assert(0);
   }
 
-  output = renderMathContent(output);
+  finishMathContent(output, start);
 
   logDecreaseIndent();
-  LOG_TRACE << "<< " << __func__ << ": (" << stripWrappingIndicators(output) << ")";
-  return output;
+  LOG_TRACE << "<< renderModifier";
 }
 
-std::string UEBRenderer::renderRoot (const MDE_Root *e)
+void UEBRenderer::renderRoot (const MDE_Root *e, std::string &output)
 {
-  std::string output;
-
-  LOG_TRACE << ">> " << __func__ << ": (" << *e << ")";
+  LOG_TRACE << ">> " << __func__;
   logIncreaseIndent();
 
-  if (isWrappingEnabled())
-    output = UEB_WORDWRAP_PRI3;
-
-  if (e->getIndex().empty()) { /* simple square root */
-    std::string renderedRootArgument;
-
-    beginInternalRender();
-    status.isNumericMode = false;
-    renderedRootArgument = renderVector(e->getArgument());
-    endInternalRender();
-
-    LOG_TRACE << "- rendered root: " << renderedRootArgument;
+  addWrapHint(output, BREAK_PRI3);
 
-    output += renderMathContent(UEB_ROOT_BEGIN + renderedRootArgument + UEB_ROOT_END);
-  } else {
+  const size_t rootStart = output.length();
+  output += UEB_ROOT_BEGIN;
 
+  beginInternalRender();
+  if (!e->getIndex().empty()) {
     // Insert the index as an exponent at the start of the root argment, e.g.
     // _/3(8) becomes [open root] [exponent] #c h [end root]
-    std::string renderedRootIndex, renderedRootArgument;
-
-    MathDocumentElementPtr index_exponent;
-    index_exponent = boost::make_shared<MDE_Exponent>(e->getIndex());
-
-    beginInternalRender();
     status.isNumericMode = false;
-    renderedRootIndex = renderElement(index_exponent.get());
+    renderNested (boost::make_shared<MDE_Exponent>(e->getIndex()));
+  }
 
-    status.isNumericMode = false;
-    renderedRootArgument = renderVector(e->getArgument());
-    endInternalRender();
+  scheduleStep (boost::bind(&UEBRenderer::renderRootArgument, this, e, rootStart, _1));
+}
 
-    LOG_TRACE << "- rendered index: " << renderedRootIndex;
-    LOG_TRACE << "- rendered root: " << renderedRootArgument;
+/**
+ * Renders the argument of a root, after its index (if any).
+ *
+ * @param [in] e Root being rendered
+ * @param [in] rootStart Where the root began in the output
+ */
+void UEBRenderer::renderRootArgument (const MDE_Root *e, const size_t rootStart,
+				      std::string & /*output*/)
+{
+  status.isNumericMode = false;
+  renderNested (e->getArgument());
+  scheduleStep (boost::bind(&UEBRenderer::finishRoot, this, rootStart, _1));
+}
 
-    output += renderMathContent(UEB_ROOT_BEGIN + renderedRootIndex + renderedRootArgument + UEB_ROOT_END);
-  }
+/**
+ * Closes a root once its argument has been rendered.
+ *
+ * @param [in] rootStart Where the root began in the output
+ * @param [out] output Buffer to append to
+ */
+void UEBRenderer::finishRoot (const size_t rootStart, std::string &output)
+{
+  endInternalRender();
+
+  output += UEB_ROOT_END;
+  finishMathContent(output, rootStart);
 
   logDecreaseIndent();
-  LOG_TRACE << "<< " << __func__ << ": (" << stripWrappingIndicators(output) << ")";
-  return output;
+  LOG_TRACE << "<< renderRoot";
 }
 
-std::string UEBRenderer::renderSummation (const MDE_Summation *e)
+void UEBRenderer::renderSummation (const MDE_Summation *e, std::string &output)
 {
-  std::string output;
-
-  LOG_TRACE << ">> " << __func__ << ": (" << *e << ")";
+  LOG_TRACE << ">> " << __func__;
   logIncreaseIndent();
 
-  if (isWrappingEnabled())
-    output = UEB_WORDWRAP_PRI3;
+  addWrapHint(output, BREAK_PRI3);
 
   output += UEB_CAPITAL_SIGN UEB_GREEK_SIGN UEB_GREEK_SIGMA;
 
-  if (!e->getLowerBound().empty()) {
-    std::string renderedBound;
-    bool savedNumericMode;
+  if (!e->getLowerBound().empty())
+    renderBound (e->getLowerBound(), UEB_DIRECTLY_BELOW, output);
 
-    beginInternalRender();
-    status.isNumericMode = false;
-    renderedBound = renderVector(e->getLowerBound());
-    savedNumericMode = status.isNumericMode;
-    endInternalRender();
+  if (!e->getUpperBound().empty())
+    scheduleStep (boost::bind(&UEBRenderer::renderBound, this,
+			      boost::cref(e->getUpperBound()), UEB_DIRECTLY_ABOVE, _1));
 
-    LOG_TRACE << "- rendered lower bound: " << renderedBound << " (numeric mode: " << savedNumericMode << ")";
+  scheduleStep (boost::bind(&UEBRenderer::finishSummation, this, _1));
+}
 
-    if (isBrailleItem(e->getLowerBound())) {
-      output += renderMathContent(boost::str(boost::format(UEB_DIRECTLY_BELOW "%s") % renderedBound));
+/**
+ * Renders the lower or upper bound of a summation.
+ *
+ * @param [in] v Elements making up the bound
+ * @param [in] position Indicator for where the bound goes (below/above)
+ * @param [out] output Buffer to append to
+ */
+void UEBRenderer::renderBound (const MDEVector &v, const char *position,
+			       std::string &output)
+{
+  const bool isItem = isBrailleItem(v);
+  const size_t boundStart = output.length();
 
-      // Restore numeric mode status for "item" bounds, in case we need to
-      // follow this with a letter indicator (e.g. a sigma with only a lower
-      // bound that is a number, and is then followed by an 'a')
-      status.isNumericMode = savedNumericMode;
-    } else {
-      output += renderMathContent(boost::str(boost::format(UEB_DIRECTLY_BELOW UEB_GROUP_BEGIN "%s" UEB_GROUP_END) % renderedBound));
-    }
-  }
+  output += position;
+  if (!isItem)
+    output += UEB_GROUP_BEGIN;
 
-  if (!e->getUpperBound().empty()) {
-    std::string renderedBound;
-    bool savedNumericMode;
+  beginInternalRender();
+  status.isNumericMode = false;
+  renderNested (v);
+  scheduleStep (boost::bind(&UEBRenderer::finishBound, this, isItem, boundStart, _1));
+}
 
-    beginInternalRender();
-    status.isNumericMode = false;
-    renderedBound = renderVector(e->getUpperBound());
-    savedNumericMode = status.isNumericMode;
-    endInternalRender();
+/**
+ * Closes a summation bound once it has been rendered.
+ *
+ * @param [in] isItem TRUE if the bound is an 'item'
+ * @param [in] boundStart Where the bound began in the output
+ * @param [out] output Buffer to append to
+ */
+void UEBRenderer::finishBound (const bool isItem, const size_t boundStart,
+			       std::string &output)
+{
+  const bool savedNumericMode = status.isNumericMode;
+  endInternalRender();
 
-    LOG_TRACE << "- rendered upper bound: " << renderedBound << " (numeric mode: " << savedNumericMode << ")";
+  if (!isItem)
+    output += UEB_GROUP_END;
 
-    if (isBrailleItem(e->getUpperBound())) {
-      output += renderMathContent(boost::str(boost::format(UEB_DIRECTLY_ABOVE "%s") % renderedBound));
+  LOG_TRACE << "- rendered bound (numeric mode: " << savedNumericMode << ")";
 
-      // Restore numeric mode status for "item" bounds, in case we need to
-      // follow this with a letter indicator (e.g. a sigma with an upper
-      // bound that is a number, and is then followed by an 'a')
-      status.isNumericMode = savedNumericMode;
-    } else {
-      output += renderMathContent(boost::str(boost::format(UEB_DIRECTLY_ABOVE UEB_GROUP_BEGIN "%s" UEB_GROUP_END) % renderedBound));
-    }
+  finishMathContent(output, boundStart);
+  if (isItem) {
+
+    // Restore numeric mode status for "item" bounds, in case we need to
+    // follow this with a letter indicator (e.g. a sigma with only a lower
+    // bound that is a number, and is then followed by an 'a')
+    status.isNumericMode = savedNumericMode;
   }
+}
 
+/**
+ * Finishes a summation once its bounds have been rendered.
+ */
+void UEBRenderer::finishSummation (std::string & /*output*/)
+{
   logDecreaseIndent();
-  LOG_TRACE << "<< " << __func__ << ": (" << stripWrappingIndicators(output) << ")";
-  return output;
+  LOG_TRACE << "<< renderSummation";
 }
 
-std::string UEBRenderer::renderFraction (const MDE_Fraction *e)
+void UEBRenderer::renderFraction (const MDE_Fraction *e, std::string &output)
 {
-  std::string renderedNumerator, renderedDenominator;
-  std::string output;
-
-  LOG_TRACE << ">> " << __func__ << ": (" << *e << ")";
+  LOG_TRACE << ">> " << __func__;
   logIncreaseIndent();
 
-  beginInternalRender();
-  status.isNumericMode = false;
-  renderedNumerator = renderVector (e->getNumerator());
+  bool simpleFraction = isSimpleFraction(*e);
+  LOG_TRACE << "- is simple fraction? " << simpleFraction;
+
+  addWrapHint(output, BREAK_PRI2);
 
+  const size_t fractionStart = output.length();
+  const size_t fractionHints = wrapHints.size();
+  if (!simpleFraction)
+    output += UEB_FRAC_BEGIN;
+
+  beginInternalRender();
   status.isNumericMode = false;
-  renderedDenominator = renderVector (e->getDenominator());
-  endInternalRender();
+  renderNested (e->getNumerator());
+  scheduleStep (boost::bind(&UEBRenderer::renderDenominator, this, e, simpleFraction,
+			    fractionStart, fractionHints, _1));
+}
 
-  bool simpleFraction = isSimpleFraction(*e);
+/**
+ * Renders the denominator of a fraction, once its numerator has been.
+ *
+ * @param [in] e Fraction being rendered
+ * @param [in] simpleFraction TRUE if it is a simple fraction
+ * @param [in] fractionStart Where the fraction began in the output
+ * @param [in] fractionHints Number of wrap hints before the fraction
+ * @param [out] output Buffer to append to
+ */
+void UEBRenderer::renderDenominator (const MDE_Fraction *e, const bool simpleFraction,
+				     const size_t fractionStart, const size_t fractionHints,
+				     std::string &output)
+{
+  if (simpleFraction)
+    output += UEB_SIMPLE_FRAC_DIVIDER;
+  else {
+    output += UEB_FRAC_DIVIDER;
+    addWrapHint(output, BREAK_PRI3);
+  }
 
-  LOG_TRACE << "- rendered numerator:   " << renderedNumerator;
-  LOG_TRACE << "- rendered denominator: " << renderedDenominator;
-  LOG_TRACE << "- is simple fraction? " << simpleFraction;
+  status.isNumericMode = false;
+  renderNested (e->getDenominator());
+  scheduleStep (boost::bind(&UEBRenderer::finishFraction, this, simpleFraction,
+			    fractionStart, fractionHints, output.length(), _1));
+}
 
-  if (isWrappingEnabled())
-    output = UEB_WORDWRAP_PRI2;
+/**
+ * Closes a fraction once its denominator has been rendered.
+ *
+ * @param [in] simpleFraction TRUE if it is a simple fraction
+ * @param [in] fractionStart Where the fraction began in the output
+ * @param [in] fractionHints Number of wrap hints before the fraction
+ * @param [in] denominatorStart Where the denominator began in the output
+ * @param [out] output Buffer to append to
+ */
+void UEBRenderer::finishFraction (const bool simpleFraction, const size_t fractionStart,
+				  const size_t fractionHints, const size_t denominatorStart,
+				  std::string &output)
+{
+  endInternalRender();
 
   if (simpleFraction) {
     // Do not permit word wrapping within simple fractions
-    if (isWrappingEnabled()) {
-      renderedNumerator = stripWrappingIndicators(renderedNumerator);
-      renderedDenominator = stripWrappingIndicators(renderedDenominator);
-    }
+    wrapHints.resize (fractionHints);
 
     // The dividing slash does not cancel numeric mode, so remove the
     // extra number sign that will appear in the denominator
-    renderedDenominator.erase (0, 1);
-
-    output += renderMathContent(boost::str(boost::format("%s" UEB_SIMPLE_FRAC_DIVIDER "%s") % renderedNumerator % renderedDenominator));
+    eraseBraille (output, denominatorStart, 1);
   } else {
-    if (isWrappingEnabled())
-      output += renderMathContent(boost::str(boost::format(UEB_FRAC_BEGIN "%s" UEB_FRAC_DIVIDER UEB_WORDWRAP_PRI3 "%s" UEB_FRAC_END) % renderedNumerator % renderedDenominator));
-    else
-      output += renderMathContent(boost::str(boost::format(UEB_FRAC_BEGIN "%s" UEB_FRAC_DIVIDER "%s" UEB_FRAC_END) % renderedNumerator % renderedDenominator));
+    output += UEB_FRAC_END;
   }
 
+  finishMathContent(output, fractionStart);
+
   logDecreaseIndent();
-  LOG_TRACE << "<< " << __func__ << ": (" << stripWrappingIndicators(output) << ")";
-  return output;
+  LOG_TRACE << "<< renderFraction";
 }
 
-std::string UEBRenderer::renderExponent (const MDE_Exponent *e)
+void UEBRenderer::renderExponent (const MDE_Exponent *e, std::string &output)
 {
-  std::string renderedExponent;
-  std::string output;
+  const size_t start = output.length();
 
-  LOG_TRACE << ">> " << __func__ << ": (" << *e << ")";
+  LOG_TRACE << ">> " << __func__;
   logIncreaseIndent();
 
+  // Insert grouping symbols only if the exponent contents is not an 'item'
+  // (See isBrailleItem() for details)
+  const bool isItem = isBrailleItem(e->getValue());
+
+  output += UEB_LEVEL_UP;
+  if (!isItem) {
+    addWrapHint(output, BREAK_PRI3);
+    output += UEB_GROUP_BEGIN;
+  }
+
   beginInternalRender();
   status.isNumericMode = false;
-  renderedExponent = renderVector (e->getValue());
+  renderNested (e->getValue());
+  scheduleStep (boost::bind(&UEBRenderer::finishScript, this, isItem, start, __func__, _1));
+}
 
+/**
+ * Closes an exponent or subscript once its contents have been rendered.
+ *
+ * @param [in] isItem TRUE if the contents are an 'item'
+ * @param [in] start Where the exponent or subscript began in the output
+ * @param [in] func Name of the render function, for the log
+ * @param [out] output Buffer to append to
+ */
+void UEBRenderer::finishScript (const bool isItem, const size_t start,
+				const char *func, std::string &output)
+{
   // Store and save numeric mode status in case we might need a letter
   // indicator later.
   bool endedInNumericMode = status.isNumericMode;
   endInternalRender();
 
-  // Insert grouping symbols only if the exponent contents is not an 'item'
-  // (See isBrailleItem() for details)
-  if (isBrailleItem(e->getValue())) {
-    output = renderMathContent(boost::str(boost::format(UEB_LEVEL_UP "%s") % renderedExponent));
-    status.isNumericMode = endedInNumericMode;
-  } else {
-    if (isWrappingEnabled())
-      output = renderMathContent(boost::str(boost::format(UEB_LEVEL_UP UEB_WORDWRAP_PRI3 UEB_GROUP_BEGIN "%s" UEB_GROUP_END) % renderedExponent));
-    else
-      output = renderMathContent(boost::str(boost::format(UEB_LEVEL_UP UEB_GROUP_BEGIN "%s" UEB_GROUP_END) % renderedExponent));
-    status.isNumericMode = false;
-  }
+  if (!isItem)
+    output += UEB_GROUP_END;
+
+  finishMathContent(output, start);
+  status.isNumericMode = isItem && endedInNumericMode;
 
   logDecreaseIndent();
-  LOG_TRACE << "<< " << __func__ << ": (" << stripWrappingIndicators(output) << ")";
-  return output;
+  LOG_TRACE << "<< " << func;
 }
 
-std::string UEBRenderer::renderSubscript (const MDE_Subscript *e)
+void UEBRenderer::renderSubscript (const MDE_Subscript *e, std::string &output)
 {
-  std::string renderedSubscript;
-  std::string output;
+  const size_t start = output.length();
 
-  LOG_TRACE << ">> " << __func__ << ": (" << *e << ")";
+  LOG_TRACE << ">> " << __func__;
   logIncreaseIndent();
 
-  beginInternalRender();
-  status.isNumericMode = false;
-  renderedSubscript = renderVector (e->getValue());
-
-  // Store and save numeric mode status in case we might need a letter
-  // indicator later.
-  bool endedInNumericMode = status.isNumericMode;
-  endInternalRender();
-
   // Insert grouping symbols only if the subscript contents is not an 'item'
   // (See isBrailleItem() for details)
-  if (isBrailleItem(e->getValue())) {
-    output = renderMathContent(boost::str(boost::format(UEB_LEVEL_DOWN "%s") % renderedSubscript));
-    status.isNumericMode = endedInNumericMode;
-  } else {
-    if (isWrappingEnabled())
-      output = renderMathContent(boost::str(boost::format(UEB_LEVEL_DOWN UEB_WORDWRAP_PRI3 UEB_GROUP_BEGIN "%s" UEB_GROUP_END) % renderedSubscript));
-    else
-      output = renderMathContent(boost::str(boost::format(UEB_LEVEL_DOWN UEB_GROUP_BEGIN "%s" UEB_GROUP_END) % renderedSubscript));
+  const bool isItem = isBrailleItem(e->getValue());
 
-    status.isNumericMode = false;
+  output += UEB_LEVEL_DOWN;
+  if (!isItem) {
+    addWrapHint(output, BREAK_PRI3);
+    output += UEB_GROUP_BEGIN;
   }
 
-  logDecreaseIndent();
-  LOG_TRACE << "<< " << __func__ << ": (" << stripWrappingIndicators(output) << ")";
-  return output;
+  beginInternalRender();
+  status.isNumericMode = false;
+  renderNested (e->getValue());
+  scheduleStep (boost::bind(&UEBRenderer::finishScript, this, isItem, start, __func__, _1));
 }
 
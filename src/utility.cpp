@@ -70,9 +70,14 @@ bool isOneOf (const char subject, const std::string &candidates)
  */
 bool containsOnly (const std::string &subject, const std::string &candidates)
 {
-  for(size_t pos = 0; pos < subject.length(); pos++) {
-    if (!isOneOf(subject[pos], candidates))
-      return false;
-  }
-  return true;
+  return CharClass(candidates).matchesAll(subject);
+}
+
+/**
+ * Returns true if 'subject' contains only the characters in 'candidates'.
+ * Prefer this form when the same candidates are checked repeatedly.
+ */
+bool containsOnly (const std::string &subject, const CharClass &candidates)
+{
+  return candidates.matchesAll(subject);
 }
@@ -0,0 +1,47 @@
+/**
+ * @file Bench_BatchTranslation.cpp
+ *
+ * @copyright Copyright 2015 Anthony Tibbs
+ * This project is released under the GNU General Public License.
+*/
+
+#include "mttest.h"
+#include "MathInterpreter.h"
+#include "MathSourceFile.h"
+#include "UEBRenderer.h"
+
+// =========================================================================
+// Thousands of short pieces of text interleaved with math: item numbers,
+// and a word or two of text between equations.
+namespace {
+  unsigned renderFragments (const MathDocument &doc, const bool batch,
+			    std::string &output)
+  {
+    BenchmarkTimer timer;
+
+    UEBRenderer r;
+    r.setBatchTranslation (batch);
+    output = r.renderDocument (doc);
+
+    return timer.getElapsedMicroseconds();
+  }
+}
+
+TEST_CASE("benchmark/render/BatchTranslation", "[.][benchmark][render][BatchTranslation]") {
+  const unsigned numItems = 5000;
+  MathSourceFile src;
+  src.loadFromBuffer (makeWorksheet (numItems, WORKSHEET_PROSE));
+
+  MathDocument doc;
+  MathInterpreter interpreter (src, doc);
+  interpreter.interpret();
+
+  std::string oneByOneOutput, batchedOutput;
+  unsigned oneByOne = renderFragments (doc, false, oneByOneOutput);
+  unsigned batched = renderFragments (doc, true, batchedOutput);
+
+  CHECK (batchedOutput == oneByOneOutput);
+  WARN(numItems << " items (" << 3 * numItems << " pieces of text): "
+       << oneByOne << " us translating them one by one, "
+       << batched << " us in batches");
+}
@@ -0,0 +1,50 @@
+/**
+ * @file Bench_Cache.cpp
+ *
+ * @copyright Copyright 2015 Anthony Tibbs
+ * This project is released under the GNU General Public License.
+*/
+
+#include <boost/make_shared.hpp>
+
+#include "mttest.h"
+#include "MathInterpretationCache.h"
+#include "MathInterpreter.h"
+#include "MathSourceFile.h"
+
+// =========================================================================
+// A batch of worksheets generated from one template: each shares the same
+// instructions and most of its questions with the others, with a few
+// questions that differ per student.
+namespace {
+  unsigned interpretBatch (const unsigned numWorksheets,
+			   const boost::shared_ptr<MathInterpretationCache> &cache)
+  {
+    BenchmarkTimer timer;
+
+    for (unsigned student = 1; student <= numWorksheets; student++) {
+      MathSourceFile src;
+      MathDocument doc;
+      src.loadFromBuffer (makeWorksheet (40, WORKSHEET_INSTRUCTIONS, student));
+
+      MathInterpreter interpreter (src, doc);
+      interpreter.setCache (cache);
+      interpreter.interpret();
+    }
+
+    return timer.getElapsedMicroseconds();
+  }
+}
+
+TEST_CASE("benchmark/interpret/Cache", "[.][benchmark][interpret][Cache]") {
+  const unsigned numWorksheets = 200;
+  boost::shared_ptr<MathInterpretationCache> cache = boost::make_shared<MathInterpretationCache>();
+  unsigned uncached = interpretBatch (numWorksheets, boost::shared_ptr<MathInterpretationCache>());
+  unsigned cached = interpretBatch (numWorksheets, cache);
+
+  MathInterpretationCache::Statistics stats = cache->getStatistics();
+  WARN(numWorksheets << " worksheets: " << uncached << " us uncached, "
+       << cached << " us cached; hit rate " << (stats.getHitRate() * 100)
+       << "%, " << stats.microsecondsSaved << " us of interpretation saved, "
+       << stats.entries << " entries using " << stats.bytesUsed << " bytes");
+}
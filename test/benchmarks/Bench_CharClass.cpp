@@ -0,0 +1,136 @@
+/**
+ * @file Bench_CharClass.cpp
+ *
+ * @copyright Copyright 2015 Anthony Tibbs
+ * This project is released under the GNU General Public License.
+*/
+
+#include <boost/format.hpp>
+
+#include "mttest.h"
+#include "CharClass.h"
+#include "LaTeXRenderer.h"
+#include "utility.h"
+
+// =========================================================================
+// The places that scan strings for characters from a small set: sniffing
+// text blocks for math, extracting exponent/subscript/root arguments,
+// containsOnly() and LaTeXRenderer::makeLaTeXSafe().
+namespace {
+  const unsigned ITERATIONS = 5;
+
+  /**
+   * A text block of long prose lines, one in ten of which mentions math.
+   */
+  std::string makeProse (const unsigned numLines)
+  {
+    std::string doc = "&&\n";
+    for (unsigned n = 1; n <= numLines; n++) {
+      doc += boost::str(boost::format("%u. The quick brown fox jumps over the lazy dog, "
+				      "then rests for a while in the shade of the old oak tree "
+				      "before heading home across the fields and over the hill") % n);
+      doc += (n % 10 ? ".\n" : " when x = 2.\n");
+    }
+
+    return doc + "$$\n";
+  }
+
+  /**
+   * Math lines dominated by exponents, subscripts and roots whose arguments
+   * are not grouped, so that each argument is an "item".
+   */
+  std::string makeItems (const unsigned numLines)
+  {
+    std::string doc;
+    for (unsigned n = 1; n <= numLines; n++)
+      doc += boost::str(boost::format("x^%u + y_%u - z^abc * _/%u = w_n1 / v^-2, q_%u\n")
+			% (n % 100) % (n % 50) % (n % 1000) % n);
+
+    return doc;
+  }
+
+  /** Text with a LaTeX special character every 40 or so characters */
+  std::string makeLaTeXText (const unsigned length)
+  {
+    static const char *const special = "#\\_^{}";
+    std::string text;
+    for (unsigned n = 0; text.length() < length; n++) {
+      text += "Some ordinary text, then a special one: ";
+      text += special [n % 6];
+    }
+
+    return text;
+  }
+
+  /** containsOnly() as it was, looking up each character with find() */
+  bool containsOnlyFind (const std::string &subject, const std::string &candidates)
+  {
+    for (size_t pos = 0; pos < subject.length(); pos++) {
+      if (candidates.find(subject [pos]) == std::string::npos)
+	return false;
+    }
+    return true;
+  }
+}
+
+TEST_CASE("benchmark/scan/SniffText", "[.][benchmark][scan]") {
+  const std::string corpus = makeProse (5000);
+  unsigned elapsed = benchmarkInterpretation (corpus, ITERATIONS);
+
+  WARN("prose text block (5000 lines, " << corpus.length() << " bytes): "
+       << elapsed << " us");
+}
+
+TEST_CASE("benchmark/scan/Items", "[.][benchmark][scan]") {
+  const std::string corpus = makeItems (5000);
+  unsigned elapsed = benchmarkInterpretation (corpus, ITERATIONS);
+
+  WARN("unbracketed arguments (5000 lines, " << corpus.length() << " bytes): "
+       << elapsed << " us");
+}
+
+TEST_CASE("benchmark/scan/ContainsOnly", "[.][benchmark][scan]") {
+  const std::string digits = "0123456789,. ";
+  const CharClass digitClass (digits);
+  const std::string subject = "1,234,567.890 123 456 789 012,345,678.901";
+  const unsigned repeats = 200000;
+  unsigned matches [3] = { 0, 0, 0 };
+
+  BenchmarkTimer timer;
+  for (unsigned n = 0; n < repeats; n++)
+    matches [0] += containsOnlyFind (subject, digits);
+  unsigned find = timer.getElapsedMicroseconds();
+
+  timer.start();
+  for (unsigned n = 0; n < repeats; n++)
+    matches [1] += containsOnly (subject, digits);
+  unsigned fromString = timer.getElapsedMicroseconds();
+
+  timer.start();
+  for (unsigned n = 0; n < repeats; n++)
+    matches [2] += containsOnly (subject, digitClass);
+  unsigned fromClass = timer.getElapsedMicroseconds();
+
+  CHECK (matches [0] == repeats);
+  CHECK (matches [1] == repeats);
+  CHECK (matches [2] == repeats);
+  WARN("containsOnly (" << repeats << " x " << subject.length() << " bytes): "
+       << find << " us with find() per character, "
+       << fromString << " us building a CharClass each call, "
+       << fromClass << " us with a prebuilt CharClass");
+}
+
+TEST_CASE("benchmark/scan/LaTeXSafe", "[.][benchmark][scan]") {
+  const std::string text = makeLaTeXText (200);
+  const unsigned repeats = 100000;
+  size_t length = 0;
+
+  BenchmarkTimer timer;
+  for (unsigned n = 0; n < repeats; n++)
+    length += LaTeXRenderer::makeLaTeXSafe (text).length();
+  unsigned elapsed = timer.getElapsedMicroseconds();
+
+  CHECK (length > (size_t)repeats * text.length());
+  WARN("makeLaTeXSafe (" << repeats << " x " << text.length() << " bytes): "
+       << elapsed << " us");
+}
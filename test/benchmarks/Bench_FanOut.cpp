@@ -0,0 +1,75 @@
+/**
+ * @file Bench_FanOut.cpp
+ *
+ * @copyright Copyright 2015 Anthony Tibbs
+ * This project is released under the GNU General Public License.
+*/
+
+#include <sstream>
+
+#include "mttest.h"
+#include "LaTeXRenderer.h"
+#include "MathInterpreter.h"
+#include "MathRenderPipeline.h"
+#include "MathSourceFile.h"
+#include "UEBRenderer.h"
+
+// =========================================================================
+// Making both LaTeX and braille from one document: interpreting it and
+// then walking it once for each format, against handing each line to both
+// renderers as it is interpreted (on this thread, and on pipeline
+// threads).
+TEST_CASE("benchmark/render/FanOut", "[.][benchmark][render][FanOut]") {
+  const unsigned numExercises = 10000;
+  MathSourceFile src;
+  src.loadFromBuffer (makeWorksheet (numExercises, WORKSHEET_PROSE));
+
+  BenchmarkTimer timer;
+  MathDocument doc;
+  MathInterpreter interpreter (src, doc);
+  interpreter.setThreadCount (1);
+  interpreter.interpret();
+  LaTeXRenderer latex;
+  UEBRenderer ueb;
+  std::ostringstream latexOutput, uebOutput;
+  latex.renderDocument (doc, latexOutput);
+  ueb.renderDocument (doc, uebOutput);
+  unsigned separate = timer.getElapsedMicroseconds();
+
+  timer.start();
+  LaTeXRenderer sinkLaTeX;
+  UEBRenderer sinkUEB;
+  std::ostringstream sinkLaTeXOutput, sinkUEBOutput;
+  MathRendererSink sink;
+  sink.addRenderer (sinkLaTeX, sinkLaTeXOutput);
+  sink.addRenderer (sinkUEB, sinkUEBOutput);
+  MathDocument unused;
+  MathInterpreter streamer (src, unused);
+  streamer.setThreadCount (1);
+  streamer.interpret (sink);
+  sink.finish();
+  unsigned fannedOut = timer.getElapsedMicroseconds();
+
+  timer.start();
+  LaTeXRenderer pipelineLaTeX;
+  UEBRenderer pipelineUEB;
+  std::ostringstream pipelineLaTeXOutput, pipelineUEBOutput;
+  MathRenderPipeline pipeline;
+  pipeline.addRenderer (pipelineLaTeX, pipelineLaTeXOutput);
+  pipeline.addRenderer (pipelineUEB, pipelineUEBOutput);
+  MathDocument alsoUnused;
+  MathInterpreter pipelined (src, alsoUnused);
+  pipelined.setThreadCount (1);
+  pipelined.interpret (pipeline);
+  pipeline.finish();
+  unsigned threaded = timer.getElapsedMicroseconds();
+
+  CHECK (sinkLaTeXOutput.str() == latexOutput.str());
+  CHECK (sinkUEBOutput.str() == uebOutput.str());
+  CHECK (pipelineLaTeXOutput.str() == latexOutput.str());
+  CHECK (pipelineUEBOutput.str() == uebOutput.str());
+  WARN(numExercises << " exercises to LaTeX and UEB: "
+       << separate << " us interpreting and then rendering each, "
+       << fannedOut << " us rendering both line by line, "
+       << threaded << " us on pipeline threads");
+}
@@ -0,0 +1,42 @@
+/**
+ * @file Bench_Incremental.cpp
+ *
+ * @copyright Copyright 2015 Anthony Tibbs
+ * This project is released under the GNU General Public License.
+*/
+
+#include "mttest.h"
+#include "MathInterpreter.h"
+#include "MathSourceFile.h"
+
+// =========================================================================
+// Simulates an editor: a 5000-line document is interpreted once, then one
+// line at a time is edited and brought up to date with reinterpretLines().
+TEST_CASE("benchmark/interpret/Incremental", "[.][benchmark][interpret][Incremental]") {
+  MathSourceFile src;
+  MathDocument doc;
+  src.loadFromBuffer (makeWorksheet (1000, WORKSHEET_PROSE));
+
+  MathInterpreter interpreter (src, doc);
+  BenchmarkTimer timer;
+  interpreter.interpret();
+  unsigned full = timer.getElapsedMicroseconds();
+
+  // Edit a math line in the middle of the document
+  const size_t line = src.getDocument().size() / 2;
+  std::vector<size_t> changed (1, line);
+  src.replaceLine (line, "2500. x^3 + 1 = 0");
+  timer.start();
+  interpreter.reinterpretLines (changed);
+  unsigned oneLine = timer.getElapsedMicroseconds();
+
+  // Turn it into the start of a text block, forcing the block mode to be
+  // carried forward to the next '&&'
+  src.replaceLine (line, "&&");
+  timer.start();
+  interpreter.reinterpretLines (changed);
+  unsigned toggle = timer.getElapsedMicroseconds();
+
+  WARN(src.getDocument().size() << " lines: full interpretation " << full
+       << " us, one line " << oneLine << " us, block toggle " << toggle << " us");
+}
@@ -0,0 +1,56 @@
+/**
+ * @file Bench_LibLouis.cpp
+ *
+ * @copyright Copyright 2015 Anthony Tibbs
+ * This project is released under the GNU General Public License.
+*/
+
+#include "mttest.h"
+#include "LibLouisContext.h"
+#include "MathInterpreter.h"
+#include "MathSourceFile.h"
+#include "UEBRenderer.h"
+
+// =========================================================================
+// A batch of small documents, each brailled by a renderer of its own, with
+// the braille tables freed after every document (as each renderer used to
+// do when it was destroyed) or kept for the next.
+namespace {
+  unsigned renderBatch (const MathDocument &doc, const unsigned numDocuments,
+			const bool freeTables)
+  {
+    BenchmarkTimer timer;
+
+    for (unsigned n = 0; n < numDocuments; n++) {
+      UEBRenderer r;
+      r.renderDocument (doc);
+      if (freeTables)
+	LibLouisContext::get().release();
+    }
+
+    return timer.getElapsedMicroseconds();
+  }
+}
+
+TEST_CASE("benchmark/render/LibLouis", "[.][benchmark][render][LibLouis]") {
+  const unsigned numDocuments = 200;
+  MathSourceFile src;
+  src.loadFromBuffer ("1. x^2 + 1 = y\n&&\nShow your work, and simplify where possible.\n$$\n");
+
+  MathDocument doc;
+  MathInterpreter interpreter (src, doc);
+  interpreter.interpret();
+
+  LibLouisContext &louis = LibLouisContext::get();
+  const unsigned long loads = louis.getTableLoadCount();
+  unsigned freeing = renderBatch (doc, numDocuments, true);
+  const unsigned long freeingLoads = louis.getTableLoadCount() - loads;
+  unsigned keeping = renderBatch (doc, numDocuments, false);
+  const unsigned long keepingLoads = louis.getTableLoadCount() - loads - freeingLoads;
+
+  CHECK (keepingLoads <= 1);
+  WARN(numDocuments << " documents: " << freeing << " us (" << freeingLoads
+       << " table loads) freeing the tables after each one, "
+       << keeping << " us (" << keepingLoads << " table loads) keeping them; "
+       << (freeing - (double)keeping) / numDocuments << " us saved per document");
+}
@@ -0,0 +1,72 @@
+/**
+ * @file Bench_Messages.cpp
+ *
+ * @copyright Copyright 2015 Anthony Tibbs
+ * This project is released under the GNU General Public License.
+*/
+
+#include <sstream>
+#include <boost/format.hpp>
+
+#include "mttest.h"
+#include "MathInterpreter.h"
+#include "MathSourceFile.h"
+
+// =========================================================================
+// A noisy document: a long text block in which every line looks like math,
+// so each line gets a warning, and the warnings are all identical.
+namespace {
+  std::string makeNoisyDocument (const unsigned numLines)
+  {
+    std::string doc = "&&\n";
+    for (unsigned n = 1; n <= numLines; n++)
+      doc += boost::str(boost::format("The answer is x = %u.\n") % (n % 20));
+
+    return doc + "$$\n";
+  }
+
+  /**
+   * Interprets 'input' and lists its messages, as the command line tool
+   * does, returning the elapsed time.
+   */
+  unsigned timeMessages (const std::string &input, const bool limitAndFold,
+			 size_t &numListed)
+  {
+    MathSourceFile src;
+    MathDocument doc;
+    src.loadFromBuffer (input);
+
+    BenchmarkTimer timer;
+
+    MathInterpreter interpreter (src, doc);
+    interpreter.setThreadCount (1);
+    if (limitAndFold) {
+      interpreter.setMessageFolding (true);
+      interpreter.setMessageLimit (100);
+    }
+    interpreter.interpret();
+
+    std::ostringstream os;
+    for (std::vector<MathInterpreterMsg>::const_iterator it = interpreter.getMessages().begin();
+	 it != interpreter.getMessages().end(); ++it)
+      os << *it << std::endl;
+
+    numListed = interpreter.getMessages().size();
+    return timer.getElapsedMicroseconds();
+  }
+}
+
+TEST_CASE("benchmark/interpret/Messages", "[.][benchmark][interpret][Messages]") {
+  const std::string input = makeNoisyDocument (50000);
+  size_t allListed, foldedListed;
+
+  unsigned all = timeMessages (input, false, allListed);
+  unsigned folded = timeMessages (input, true, foldedListed);
+
+  CHECK (allListed == 50000);
+  CHECK (foldedListed == 1);
+  WARN("noisy document (50000 warnings): "
+       << all << " us listing every message, "
+       << folded << " us folded and limited to 100 per code ("
+       << foldedListed << " listed)");
+}
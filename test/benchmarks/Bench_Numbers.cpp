@@ -0,0 +1,47 @@
+/**
+ * @file Bench_Numbers.cpp
+ *
+ * @copyright Copyright 2015 Anthony Tibbs
+ * This project is released under the GNU General Public License.
+*/
+
+#include <boost/format.hpp>
+
+#include "mttest.h"
+
+// =========================================================================
+// A numeric-heavy corpus modelled on statistics tables: each row holds
+// grouped whole numbers (commas and spaces), grouped decimals and a few
+// ungrouped values, so number recognition dominates the interpretation.
+namespace {
+  std::string makeStatisticsTable (const unsigned numRows)
+  {
+    std::string doc;
+
+    for (unsigned row = 1; row <= numRows; row++) {
+      unsigned a = (row * 7919) % 1000;
+      unsigned b = (row * 104729) % 1000;
+      unsigned c = (row * 1299709) % 1000;
+
+      doc += boost::str(boost::format(
+        "%u. %u,%03u,%03u  %u %03u %03u  %u,%03u.%03u %03u  0.%03u %03u  %u  %u.%u\n")
+        % row
+        % (row % 97 + 1) % a % b
+        % (row % 13 + 1) % c % a
+        % (row % 41 + 1) % b % c % a
+        % b % c
+        % row
+        % c % (a % 10));
+    }
+
+    return doc;
+  }
+}
+
+TEST_CASE("benchmark/interpret/Numbers", "[.][benchmark][interpret][Numbers]") {
+  const std::string corpus = makeStatisticsTable (2000);
+  unsigned elapsed = benchmarkInterpretation (corpus, 5);
+
+  WARN("statistics table (2000 rows, " << corpus.length() << " bytes): "
+       << elapsed << " us");
+}
@@ -0,0 +1,25 @@
+/**
+ * @file Bench_Parallel.cpp
+ *
+ * @copyright Copyright 2015 Anthony Tibbs
+ * This project is released under the GNU General Public License.
+*/
+
+#include <boost/thread.hpp>
+
+#include "mttest.h"
+
+// =========================================================================
+// A long worksheet mixing math lines with text blocks, used to compare
+// sequential interpretation against interpretation on every core.
+TEST_CASE("benchmark/interpret/Parallel", "[.][benchmark][interpret][Parallel]") {
+  const std::string corpus = makeWorksheet (5000, WORKSHEET_PROSE);
+  const unsigned numCores = boost::thread::hardware_concurrency();
+
+  unsigned sequential = benchmarkInterpretation (corpus, 3, 1);
+  unsigned parallel = benchmarkInterpretation (corpus, 3, 0);
+
+  WARN("worksheet (" << corpus.length() << " bytes): " << sequential
+       << " us on 1 thread, " << parallel << " us on " << numCores
+       << " threads");
+}
@@ -0,0 +1,58 @@
+/**
+ * @file Bench_Pipeline.cpp
+ *
+ * @copyright Copyright 2015 Anthony Tibbs
+ * This project is released under the GNU General Public License.
+*/
+
+#include <sstream>
+#include <boost/thread.hpp>
+
+#include "mttest.h"
+#include "LaTeXRenderer.h"
+#include "MathInterpreter.h"
+#include "MathRenderPipeline.h"
+#include "MathSourceFile.h"
+#include "UEBRenderer.h"
+
+// =========================================================================
+// Interpreting a long document and rendering it to both LaTeX and braille,
+// one step after another, or with the renderers on pipeline threads.  The
+// pipeline can only overlap the steps when there are spare cores.
+TEST_CASE("benchmark/render/Pipeline", "[.][benchmark][render][Pipeline]") {
+  const unsigned numExercises = 10000;
+  MathSourceFile src;
+  src.loadFromBuffer (makeWorksheet (numExercises));
+
+  BenchmarkTimer timer;
+  MathDocument doc;
+  MathInterpreter interpreter (src, doc);
+  interpreter.setThreadCount (1);
+  interpreter.interpret();
+  LaTeXRenderer latex;
+  UEBRenderer ueb;
+  const std::string latexOutput = latex.renderDocument (doc);
+  const std::string uebOutput = ueb.renderDocument (doc);
+  unsigned sequential = timer.getElapsedMicroseconds();
+
+  timer.start();
+  LaTeXRenderer pipelineLaTeX;
+  UEBRenderer pipelineUEB;
+  std::ostringstream pipelineLaTeXOutput, pipelineUEBOutput;
+  MathRenderPipeline pipeline;
+  pipeline.addRenderer (pipelineLaTeX, pipelineLaTeXOutput);
+  pipeline.addRenderer (pipelineUEB, pipelineUEBOutput);
+  MathDocument unused;
+  MathInterpreter streamer (src, unused);
+  streamer.setThreadCount (1);
+  streamer.interpret (pipeline);
+  pipeline.finish();
+  unsigned pipelined = timer.getElapsedMicroseconds();
+
+  CHECK (pipelineLaTeXOutput.str() == latexOutput);
+  CHECK (pipelineUEBOutput.str() == uebOutput);
+  WARN(numExercises << " exercises to LaTeX and UEB on "
+       << boost::thread::hardware_concurrency() << " core(s): "
+       << sequential << " us one step after another, "
+       << pipelined << " us pipelined");
+}
@@ -0,0 +1,178 @@
+/**
+ * @file Bench_PostProcessing.cpp
+ *
+ * @copyright Copyright 2015 Anthony Tibbs
+ * This project is released under the GNU General Public License.
+*/
+
+#include <cstdlib>
+#include <boost/algorithm/string.hpp>
+#include <boost/format.hpp>
+
+#include "mttest.h"
+#include "CharClass.h"
+#include "UEBRenderer.h"
+
+// =========================================================================
+// Finishing off braille for math and text blocks, in a single pass,
+// against the separate passes that were used before (which must give the
+// same results).
+namespace {
+  const unsigned NUM_BLOCKS = 20000;
+
+  /**
+   * Exposes the single-pass post-processing.
+   */
+  class PostProcessor : public UEBRenderer
+  {
+  public:
+    std::vector<WrapHint> hints;
+
+    void math (const std::string &s, std::string &output)
+    {
+      translateToBraille (s, output);
+    }
+
+    void text (const std::string &braille, std::string &output)
+    {
+      wrapHints.clear();
+      finishTextContent (braille, output, true);
+      hints = wrapHints;
+    }
+  };
+
+  // ---- The passes used before ----
+
+  std::string oldPunctuation (const std::string &s)
+  {
+    std::string output;
+    for (size_t pos = 0; pos < s.length(); pos++) {
+      if (s [pos] == ',')
+	output += UEB_COMMA;
+      else if (s [pos] == '.')
+	output += UEB_PERIOD;
+      else
+	output += s [pos];
+    }
+    return output;
+  }
+
+  std::string oldLetterIndicators (const std::string &s)
+  {
+    const CharClass numericModeSymbols (UEB_NUMERIC_MODE_SYMBOLS);
+    std::string output;
+    bool inNumericMode = false;
+
+    for (size_t pos = 0; pos < s.length(); pos++) {
+      char c = s [pos];
+      if (c == '#') {
+	inNumericMode = true;
+	output += c;
+	continue;
+      }
+      if (inNumericMode) {
+	if (!numericModeSymbols.contains(c))
+	  inNumericMode = false;
+      } else if (c >= 'A' && c <= 'Z') {
+	output += UEB_CAPITAL_SIGN;
+      }
+      output += c;
+    }
+    return output;
+  }
+
+  std::string oldText (const std::string &braille, std::vector<UEBRenderer::WrapHint> &hints)
+  {
+    const CharClass sentenceEndSymbols ("468");
+    std::string output = braille;
+
+    for (char ch = 'a'; ch <= 'z'; ch++) {
+      const std::string searchStr = boost::str(boost::format(";%c ") % ch);
+      const std::string replaceStr = boost::str(boost::format("%c ") % ch);
+      boost::ireplace_all(output, searchStr, replaceStr);
+    }
+
+    hints.clear();
+    for (size_t pos = 0; pos < output.length(); pos++) {
+      if (output.compare (pos, 2, UEB_LEFT_PAREN) == 0 ||
+	  output.compare (pos, 2, UEB_LEFT_BRACKET) == 0 ||
+	  output.compare (pos, 2, UEB_LEFT_BRACE) == 0) {
+	const UEBRenderer::WrapHint hint = { pos, UEBRenderer::BREAK_PRI1 };
+	hints.push_back (hint);
+      } else if (output [pos] == ' ') {
+	const bool isSentenceEnd = (pos > 0 && sentenceEndSymbols.contains (output [pos - 1]));
+	const UEBRenderer::WrapHint hint = { pos + 1, isSentenceEnd ? UEBRenderer::BREAK_PRI1 : UEBRenderer::BREAK_PRI2 };
+	hints.push_back (hint);
+      }
+    }
+    return output;
+  }
+
+  /**
+   * Braille-like strings, heavy in the characters post-processing looks
+   * at.
+   */
+  std::string makeBlock (const unsigned length)
+  {
+    static const char cells[] = "abcxyzABCXYZ;;;   #,.46812\"<._<>";
+    std::string s;
+    for (unsigned n = 0; n < length; n++)
+      s += cells [std::rand() % (sizeof(cells) - 1)];
+    return s;
+  }
+
+  bool sameHints (const std::vector<UEBRenderer::WrapHint> &a,
+		  const std::vector<UEBRenderer::WrapHint> &b)
+  {
+    if (a.size() != b.size())
+      return false;
+    for (size_t n = 0; n < a.size(); n++)
+      if (a [n].offset != b [n].offset || a [n].type != b [n].type)
+	return false;
+    return true;
+  }
+}
+
+TEST_CASE("benchmark/render/PostProcessing", "[.][benchmark][render][PostProcessing]") {
+  std::srand (42);
+  std::vector<std::string> blocks;
+  for (unsigned n = 0; n < NUM_BLOCKS; n++)
+    blocks.push_back (makeBlock (10 + n % 60));
+
+  LoggingDisabled loggingDisabled;
+  PostProcessor fused;
+  std::vector<UEBRenderer::WrapHint> oldHints;
+  unsigned mismatches = 0;
+
+  for (unsigned n = 0; n < NUM_BLOCKS; n++) {
+    std::string math, text;
+    fused.math (blocks [n], math);
+    fused.text (blocks [n], text);
+    if (math != oldLetterIndicators (oldPunctuation (blocks [n])) ||
+	text != oldText (blocks [n], oldHints) || !sameHints (fused.hints, oldHints))
+      mismatches++;
+  }
+
+  size_t total = 0;
+  BenchmarkTimer timer;
+  for (unsigned n = 0; n < NUM_BLOCKS; n++) {
+    total += oldLetterIndicators (oldPunctuation (blocks [n])).length();
+    total += oldText (blocks [n], oldHints).length();
+  }
+  unsigned separate = timer.getElapsedMicroseconds();
+
+  timer.start();
+  for (unsigned n = 0; n < NUM_BLOCKS; n++) {
+    std::string math, text;
+    fused.math (blocks [n], math);
+    fused.text (blocks [n], text);
+    total -= math.length() + text.length();
+  }
+  unsigned single = timer.getElapsedMicroseconds();
+
+  CHECK (mismatches == 0);
+  CHECK (total == 0);
+  WARN(NUM_BLOCKS << " math and text blocks: " << separate << " us in separate passes ("
+       << (double)separate / NUM_BLOCKS << " us/block), " << single << " us in one ("
+       << (double)single / NUM_BLOCKS << " us/block)");
+}
@@ -0,0 +1,80 @@
+/**
+ * @file Bench_Recovery.cpp
+ *
+ * @copyright Copyright 2015 Anthony Tibbs
+ * This project is released under the GNU General Public License.
+*/
+
+#include "mttest.h"
+#include "MathExceptions.h"
+#include "MathInterpreter.h"
+#include "MathSourceFile.h"
+
+// =========================================================================
+// Error-dense submissions: every other line has an unterminated fraction,
+// group, exponent or root.  Without error recovery, finding all of them
+// means interpreting each line on its own and catching the exception.
+namespace {
+  unsigned timeLineByLine (const std::string &input, unsigned &numFailures)
+  {
+    MathSourceFile src;
+    src.loadFromBuffer (input);
+
+    BenchmarkTimer timer;
+
+    numFailures = 0;
+    for (std::vector<MathDocumentLine>::const_iterator it = src.getDocument().begin();
+	 it != src.getDocument().end(); ++it) {
+      MathSourceFile line;
+      MathDocument doc;
+      line.loadFromBuffer (it->getContent());
+
+      MathInterpreter interpreter (line, doc);
+      interpreter.setThreadCount (1);
+      try {
+	interpreter.interpret();
+      } catch (MathInterpreterException &e) {
+	numFailures++;
+      }
+    }
+
+    return timer.getElapsedMicroseconds();
+  }
+
+  unsigned timeRecovery (const std::string &input, unsigned &numFailures)
+  {
+    MathSourceFile src;
+    MathDocument doc;
+    src.loadFromBuffer (input);
+
+    BenchmarkTimer timer;
+
+    MathInterpreter interpreter (src, doc);
+    interpreter.setThreadCount (1);
+    interpreter.setErrorRecovery (true);
+    interpreter.interpret();
+    unsigned elapsed = timer.getElapsedMicroseconds();
+
+    numFailures = 0;
+    for (MDEVector::const_iterator it = doc.getDocument().begin();
+	 it != doc.getDocument().end(); ++it) {
+      if (dynamic_cast<const MDE_Error *>(it->get()))
+	numFailures++;
+    }
+
+    return elapsed;
+  }
+}
+
+TEST_CASE("benchmark/interpret/Recovery", "[.][benchmark][interpret][Recovery]") {
+  const std::string submission = makeWorksheet (4000, WORKSHEET_ERRORS);
+  unsigned thrown, recovered;
+
+  unsigned lineByLine = timeLineByLine (submission, thrown);
+  unsigned recovery = timeRecovery (submission, recovered);
+
+  CHECK (thrown == recovered);
+  WARN("error-dense submission (4000 lines, " << recovered << " errors): "
+       << lineByLine << " us one line at a time with exceptions, "
+       << recovery << " us in one pass with error recovery");
+}
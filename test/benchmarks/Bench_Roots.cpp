@@ -0,0 +1,36 @@
+/**
+ * @file Bench_Roots.cpp
+ *
+ * @copyright Copyright 2015 Anthony Tibbs
+ * This project is released under the GNU General Public License.
+*/
+
+#include "mttest.h"
+
+// =========================================================================
+// Interpreting a line made up of many roots.  8x the roots should cost
+// about 8x the time; scanning the rest of the line for each root's index
+// (as was once done) would be closer to 64x.
+namespace {
+  unsigned timeRootLine (const unsigned numRoots)
+  {
+    std::string line;
+    for (unsigned n = 0; n < numRoots; n++)
+      line += "_/3(8) + ";
+    line += "1\n";
+
+    return benchmarkInterpretation (line, 3);
+  }
+}
+
+TEST_CASE("benchmark/interpret/Roots", "[.][benchmark][interpret][Roots]") {
+  const unsigned smallCount = 200;
+  const unsigned largeCount = 1600;
+
+  unsigned smallTime = timeRootLine (smallCount);
+  unsigned largeTime = timeRootLine (largeCount);
+
+  WARN(smallCount << " roots on a line: " << smallTime << " us, "
+       << largeCount << " roots: " << largeTime << " us ("
+       << (double)largeTime / (smallTime ? smallTime : 1) << "x)");
+}
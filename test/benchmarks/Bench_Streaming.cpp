@@ -0,0 +1,71 @@
+/**
+ * @file Bench_Streaming.cpp
+ *
+ * @copyright Copyright 2015 Anthony Tibbs
+ * This project is released under the GNU General Public License.
+*/
+
+#include <sstream>
+
+#include "mttest.h"
+#include "LaTeXRenderer.h"
+#include "MathInterpreter.h"
+#include "MathSourceFile.h"
+
+// =========================================================================
+// A long problem set rendered to LaTeX, either by interpreting the whole
+// document and then rendering it, or by rendering each line as soon as it
+// has been interpreted.  Streaming should produce its first output almost
+// at once instead of after the whole document has been interpreted.
+namespace {
+  /**
+   * Renders lines as they arrive, noting when the first one did.
+   */
+  class TimedRendererSink : public MathRendererSink
+  {
+  public:
+    BenchmarkTimer &timer;
+    unsigned firstLine;
+
+    TimedRendererSink (MathRenderer &renderer, std::ostream &os, BenchmarkTimer &t)
+      : MathRendererSink (renderer, os), timer (t), firstLine (0) {}
+
+    virtual void addLine (const MDEVector &elements)
+    {
+      MathRendererSink::addLine (elements);
+      if (!firstLine)
+	firstLine = timer.getElapsedMicroseconds();
+    }
+  };
+}
+
+TEST_CASE("benchmark/interpret/Streaming", "[.][benchmark][interpret][Streaming]") {
+  const unsigned numProblems = 20000;
+  MathSourceFile src;
+  src.loadFromBuffer (makeWorksheet (numProblems));
+
+  BenchmarkTimer timer;
+  MathDocument doc;
+  MathInterpreter interpreter (src, doc);
+  interpreter.setThreadCount (1);
+  interpreter.interpret();
+  LaTeXRenderer latex;
+  const std::string output = latex.renderDocument (doc);
+  unsigned whole = timer.getElapsedMicroseconds();
+
+  timer.start();
+  MathDocument unused;
+  MathInterpreter streamer (src, unused);
+  streamer.setThreadCount (1);
+  LaTeXRenderer streamingLaTeX;
+  std::ostringstream os;
+  TimedRendererSink sink (streamingLaTeX, os, timer);
+  streamer.interpret (sink);
+  sink.finish();
+  unsigned streamed = timer.getElapsedMicroseconds();
+
+  CHECK (os.str() == output);
+  WARN(numProblems << " problems to LaTeX: whole document " << whole
+       << " us; streamed " << streamed << " us, first line after "
+       << sink.firstLine << " us");
+}
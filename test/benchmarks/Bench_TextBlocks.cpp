@@ -0,0 +1,43 @@
+/**
+ * @file Bench_TextBlocks.cpp
+ *
+ * @copyright Copyright 2015 Anthony Tibbs
+ * This project is released under the GNU General Public License.
+*/
+
+#include <boost/format.hpp>
+
+#include "mttest.h"
+
+// =========================================================================
+// Lab reports: long text blocks of prose, with a short piece of inline
+// math in some of the sentences.
+namespace {
+  const unsigned ITERATIONS = 5;
+
+  std::string makeLabReport (const unsigned numParagraphs)
+  {
+    std::string doc;
+    for (unsigned n = 1; n <= numParagraphs; n++) {
+      doc += boost::str(boost::format("&&\nTrial %u\n") % n);
+      doc += "The sample was weighed on the balance, transferred to the beaker and "
+	"dissolved in distilled water before the solution was titrated.\n";
+      doc += boost::str(boost::format("The volume of titrant used was $%u.%u& millilitres, "
+				      "so the concentration is $c = @n~V#& as expected.\n")
+			% (n % 50 + 10) % (n % 10));
+      doc += "Sources of error include the reading of the burette and the judgement of "
+	"the end point, both of which were repeated to check the result.\n";
+      doc += "$$\n";
+    }
+
+    return doc;
+  }
+}
+
+TEST_CASE("benchmark/interpret/TextBlocks", "[.][benchmark][interpret][TextBlocks]") {
+  const std::string corpus = makeLabReport (2000);
+  unsigned elapsed = benchmarkInterpretation (corpus, ITERATIONS);
+
+  WARN("lab report (2000 paragraphs, " << corpus.length() << " bytes): "
+       << elapsed << " us");
+}
@@ -0,0 +1,67 @@
+/**
+ * @file Bench_Transcoding.cpp
+ *
+ * @copyright Copyright 2015 Anthony Tibbs
+ * This project is released under the GNU General Public License.
+*/
+
+#include <string>
+#include <vector>
+
+#include "mttest.h"
+#include "liblouis-mt.h"
+
+// =========================================================================
+// Converting text to and from liblouis' UTF-16: a sentence-length piece of
+// text at a time, as UEBRenderer does, against converting a character at a
+// time (as was done before).
+namespace {
+  const unsigned ITERATIONS = 200000;
+
+  void oneAtATimeToWide (const std::string &str, ll_widechar *outString, unsigned &outLength)
+  {
+    unsigned outPos = 0;
+
+    for (size_t inPos = 0; inPos < str.length(); inPos++)
+      outString[outPos++] = (ll_widechar)str[inPos];
+
+    outString[outPos] = 0;
+    outLength = outPos;
+  }
+
+  void oneAtATimeFromWide (const ll_widechar *str, const unsigned inLength, std::string &outString)
+  {
+    for (unsigned inPos = 0; inPos < inLength; inPos++)
+      outString += std::string(1, (char)str[inPos]);
+  }
+}
+
+TEST_CASE("benchmark/render/Transcoding", "[.][benchmark][render][Transcoding]") {
+  const std::string text = ",show your work1 & simplify your answer where possible4 ,j os explains 8";
+  std::vector<ll_widechar> wide (LIBLOUIS_MAXSTRING);
+  unsigned length = 0;
+  size_t total = 0;
+
+  BenchmarkTimer timer;
+  for (unsigned n = 0; n < ITERATIONS; n++) {
+    std::string back;
+    oneAtATimeToWide (text, &wide [0], length);
+    oneAtATimeFromWide (&wide [0], length, back);
+    total += back.length();
+  }
+  unsigned oneAtATime = timer.getElapsedMicroseconds();
+
+  timer.start();
+  for (unsigned n = 0; n < ITERATIONS; n++) {
+    std::string back;
+    strToWideCharString (text, &wide [0], wide.size(), length);
+    wideCharStringToStr (&wide [0], length, back);
+    total += back.length();
+  }
+  unsigned transcoded = timer.getElapsedMicroseconds();
+
+  CHECK (total == 2 * ITERATIONS * text.length());
+  WARN(ITERATIONS << " round trips of " << text.length() << " characters: "
+       << oneAtATime << " us a character at a time, "
+       << transcoded << " us transcoding");
+}
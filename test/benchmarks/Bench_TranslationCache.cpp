@@ -0,0 +1,56 @@
+/**
+ * @file Bench_TranslationCache.cpp
+ *
+ * @copyright Copyright 2015 Anthony Tibbs
+ * This project is released under the GNU General Public License.
+*/
+
+#include <boost/make_shared.hpp>
+
+#include "mttest.h"
+#include "BrailleTranslationCache.h"
+#include "MathInterpreter.h"
+#include "MathSourceFile.h"
+#include "UEBRenderer.h"
+
+// =========================================================================
+// An exam paper: numbered questions, each followed by a couple of lines of
+// instructions, most of them drawn from the same handful of phrases.
+namespace {
+  unsigned renderPaper (const MathDocument &doc,
+			const boost::shared_ptr<BrailleTranslationCache> &cache,
+			std::string &output)
+  {
+    BenchmarkTimer timer;
+
+    UEBRenderer r;
+    r.enableLineWrapping (40);
+    r.setTranslationCache (cache);
+    output = r.renderDocument (doc);
+
+    return timer.getElapsedMicroseconds();
+  }
+}
+
+TEST_CASE("benchmark/render/TranslationCache", "[.][benchmark][render][TranslationCache]") {
+  const unsigned numQuestions = 2000;
+  MathSourceFile src;
+  src.loadFromBuffer (makeWorksheet (numQuestions, WORKSHEET_INSTRUCTIONS | WORKSHEET_PROSE));
+
+  MathDocument doc;
+  MathInterpreter interpreter (src, doc);
+  interpreter.interpret();
+
+  boost::shared_ptr<BrailleTranslationCache> cache = boost::make_shared<BrailleTranslationCache>();
+  std::string uncachedOutput, cachedOutput;
+  unsigned uncached = renderPaper (doc, boost::shared_ptr<BrailleTranslationCache>(), uncachedOutput);
+  unsigned cached = renderPaper (doc, cache, cachedOutput);
+
+  CHECK (cachedOutput == uncachedOutput);
+
+  BrailleTranslationCache::Statistics stats = cache->getStatistics();
+  WARN(numQuestions << " questions: " << uncached << " us uncached, "
+       << cached << " us cached; hit rate " << (stats.getHitRate() * 100)
+       << "%, " << stats.microsecondsSaved << " us of translation saved, "
+       << stats.entries << " entries using " << stats.bytesUsed << " bytes");
+}
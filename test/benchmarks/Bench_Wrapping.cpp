@@ -0,0 +1,61 @@
+/**
+ * @file Bench_Wrapping.cpp
+ *
+ * @copyright Copyright 2015 Anthony Tibbs
+ * This project is released under the GNU General Public License.
+*/
+
+#include <boost/format.hpp>
+
+#include "mttest.h"
+#include "MathInterpreter.h"
+#include "MathSourceFile.h"
+#include "UEBRenderer.h"
+
+// =========================================================================
+// Word wrapping braille: long lines of math, each of which has to be
+// broken over many braille lines.
+namespace {
+  std::string makeLongLines (const unsigned numLines, const unsigned numTerms)
+  {
+    std::string doc;
+
+    for (unsigned n = 1; n <= numLines; n++) {
+      doc += "y = x";
+      for (unsigned term = 1; term <= numTerms; term++)
+	doc += boost::str(boost::format(" + %ux^%u - @1~%u#") % term % (term % 9 + 1) % (term + n));
+      doc += "\n";
+    }
+
+    return doc;
+  }
+}
+
+TEST_CASE("benchmark/render/Wrapping", "[.][benchmark][render][Wrapping]") {
+  const unsigned numLines = 10;
+  const unsigned numTerms = 2000;
+  const unsigned lineLength = 40;
+  MathSourceFile src;
+  src.loadFromBuffer (makeLongLines (numLines, numTerms));
+
+  MathDocument doc;
+  MathInterpreter interpreter (src, doc);
+  interpreter.interpret();
+
+  BenchmarkTimer timer;
+  UEBRenderer unwrapped;
+  const std::string unwrappedOutput = unwrapped.renderDocument (doc);
+  unsigned unwrappedElapsed = timer.getElapsedMicroseconds();
+
+  timer.start();
+  UEBRenderer wrapped;
+  wrapped.enableLineWrapping (lineLength);
+  const std::string wrappedOutput = wrapped.renderDocument (doc);
+  unsigned wrappedElapsed = timer.getElapsedMicroseconds();
+
+  CHECK (wrappedOutput.length() > unwrappedOutput.length());
+  WARN(numLines << " lines of " << numTerms << " terms ("
+       << unwrappedOutput.length() << " bytes of braille): "
+       << unwrappedElapsed << " us unwrapped, "
+       << wrappedElapsed << " us wrapped to " << lineLength << " cells");
+}
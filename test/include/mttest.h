@@ -21,5 +21,53 @@ void documentToString (const MathDocument &document, std::string &outputString);
 void checkInterpretation (const std::string &inputStr,
                           const std::string &expectedOutputStr);
 
+/**
+ * What makeWorksheet() puts in a worksheet besides its numbered questions.
+ */
+enum WorksheetContent {
+  WORKSHEET_INSTRUCTIONS = 1, // a text block of instructions at the start
+  WORKSHEET_PROSE = 2,        // a short text block after each question
+  WORKSHEET_WARNINGS = 4,     // text after each question that gets 3 warnings
+  WORKSHEET_ERRORS = 8        // every other question left unfinished
+};
+
+std::string makeWorksheet (const unsigned numQuestions,
+                           const unsigned content = 0,
+                           const unsigned variant = 0);
+
+/**
+ * Switches logging off while in scope, then puts it back as it was.
+ */
+class LoggingDisabled
+{
+public:
+  LoggingDisabled ();
+  ~LoggingDisabled ();
+
+private:
+  bool wasEnabled;
+};
+
+/**
+ * Benchmarking support: tests tagged [.][benchmark] are hidden from normal
+ * runs and report their timings with WARN().  Run them with:
+ *   mttest "[benchmark]"
+ */
+class BenchmarkTimer
+{
+public:
+  BenchmarkTimer ();
+  void start (void);
+  unsigned getElapsedMicroseconds (void) const;
+
+private:
+  LoggingDisabled loggingDisabled;
+  Catch::Timer timer;
+};
+
+unsigned benchmarkInterpretation (const std::string &input,
+                                  const unsigned iterations,
+                                  const unsigned numThreads = 1);
+
 
 #endif
@@ -0,0 +1,110 @@
+/**
+ * @file Int_Cache.cpp
+ *
+ * @copyright Copyright 2015 Anthony Tibbs
+ * This project is released under the GNU General Public License.
+*/
+
+#include <sstream>
+#include <boost/lexical_cast.hpp>
+#include <boost/make_shared.hpp>
+
+#include "mttest.h"
+#include "MathExceptions.h"
+#include "MathInterpretationCache.h"
+#include "MathInterpreter.h"
+#include "MathSourceFile.h"
+
+// =========================================================================
+namespace {
+  struct CachedRun {
+    std::string output;
+    std::vector<std::string> messages;
+  };
+
+  CachedRun interpretWithCache (const std::string &input,
+				const boost::shared_ptr<MathInterpretationCache> &cache,
+				const std::string &command = std::string())
+  {
+    CachedRun run;
+    MathSourceFile src;
+    MathDocument doc;
+    src.loadFromBuffer (input, "worksheet.txt");
+
+    MathInterpreter interpreter (src, doc);
+    interpreter.setCache (cache);
+    if (!command.empty())
+      interpreter.registerCommand (command);
+    interpreter.interpret();
+
+    documentToString (doc, run.output);
+    for (std::vector<MathInterpreterMsg>::const_iterator it = interpreter.getMessages().begin();
+	 it != interpreter.getMessages().end(); ++it) {
+      std::ostringstream ss;
+      ss << *it;
+      run.messages.push_back (ss.str());
+    }
+
+    return run;
+  }
+}
+
+TEST_CASE("interpret/Cache", "[interpret][Cache]") {
+  const std::string first =
+    "1. x^2 + 1\n"
+    "&&\n"
+    "The answer is x = 5.\n"
+    "$$\n"
+    "2. @1/2# + @1/3#\n";
+  const std::string second =
+    "The answer is x = 5.\n"
+    "1. x^2 + 1\n"
+    "&&\n"
+    "The answer is x = 5.\n"
+    "$$\n";
+  boost::shared_ptr<MathInterpretationCache> noCache;
+
+  SECTION("cached lines give the same results as interpreting them") {
+    boost::shared_ptr<MathInterpretationCache> cache = boost::make_shared<MathInterpretationCache>();
+
+    interpretWithCache (first, cache);
+    CHECK (cache->getStatistics().hits == 0);
+
+    CachedRun cached = interpretWithCache (second, cache);
+    CachedRun uncached = interpretWithCache (second, noCache);
+    CHECK (cached.output == uncached.output);
+    CHECK (cached.messages == uncached.messages); // now at line 4, not 3
+
+    MathInterpretationCache::Statistics stats = cache->getStatistics();
+    CHECK (stats.hits == 2);
+    CHECK (stats.misses == 4);
+  }
+  SECTION("the block mode is part of the key") {
+    boost::shared_ptr<MathInterpretationCache> cache = boost::make_shared<MathInterpretationCache>();
+
+    interpretWithCache (first, cache);
+    CachedRun cached = interpretWithCache (second, cache);
+    CHECK (cached.output == interpretWithCache (second, noCache).output);
+    CHECK (cached.messages == interpretWithCache (second, noCache).messages);
+  }
+  SECTION("so is the set of registered commands") {
+    boost::shared_ptr<MathInterpretationCache> cache = boost::make_shared<MathInterpretationCache>();
+
+    interpretWithCache ("$$Dummy on\n", cache, "Dummy");
+    CHECK_THROWS_AS (interpretWithCache ("$$Dummy on\n", cache), const MathInterpreterException &);
+    CHECK (cache->getStatistics().hits == 0);
+  }
+  SECTION("memory use is bounded") {
+    boost::shared_ptr<MathInterpretationCache> cache = boost::make_shared<MathInterpretationCache>(4096);
+
+    std::string input;
+    for (int n = 1; n <= 200; n++)
+      input += boost::lexical_cast<std::string>(n) + ". x + " + boost::lexical_cast<std::string>(n) + "\n";
+    interpretWithCache (input, cache);
+
+    MathInterpretationCache::Statistics stats = cache->getStatistics();
+    CHECK (stats.bytesUsed <= 4096);
+    CHECK (stats.evictions > 0);
+    CHECK (stats.entries + stats.evictions == 200);
+  }
+}
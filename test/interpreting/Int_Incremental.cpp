@@ -0,0 +1,139 @@
+/**
+ * @file Int_Incremental.cpp
+ *
+ * @copyright Copyright 2015 Anthony Tibbs
+ * This project is released under the GNU General Public License.
+*/
+
+#include <sstream>
+
+#include "mttest.h"
+#include "MathExceptions.h"
+#include "MathInterpreter.h"
+#include "MathSourceFile.h"
+
+// =========================================================================
+// After reinterpretLines(), the document and messages must be exactly what
+// interpreting the edited source from scratch would give.
+namespace {
+  const char *incrementalSource =
+    "1. x + 1 = 2\n"
+    "2. y^2\n"
+    "Some words\n"
+    "3. %a + %b\n"
+    "&&\n"
+    "A text block.\n"
+    "More text.\n"
+    "$$\n"
+    "4. _/(x+1)\n"
+    "5. 3/4\n";
+
+  std::string fullDocumentString (const MathDocument &doc)
+  {
+    std::string output;
+    for (MDEVector::const_iterator it = doc.getDocument().begin();
+	 it != doc.getDocument().end(); ++it)
+      output += (*it)->getString();
+
+    return output;
+  }
+
+  std::vector<std::string> messageStrings (const MathInterpreter &interpreter)
+  {
+    std::vector<std::string> messages;
+    for (std::vector<MathInterpreterMsg>::const_iterator it = interpreter.getMessages().begin();
+	 it != interpreter.getMessages().end(); ++it) {
+      std::ostringstream ss;
+      ss << *it;
+      messages.push_back (ss.str());
+    }
+
+    return messages;
+  }
+
+  void checkAgainstFreshInterpretation (const MathSourceFile &src,
+					const MathDocument &doc,
+					const MathInterpreter &interpreter)
+  {
+    MathDocument freshDoc;
+    MathInterpreter fresh (src, freshDoc);
+    REQUIRE_NOTHROW (fresh.interpret());
+
+    CHECK (fullDocumentString(doc) == fullDocumentString(freshDoc));
+    CHECK (messageStrings(interpreter) == messageStrings(fresh));
+  }
+
+  void editLine (MathSourceFile &src, MathInterpreter &interpreter,
+		 const size_t line, const std::string &content)
+  {
+    src.replaceLine (line, content);
+    interpreter.reinterpretLines (std::vector<size_t>(1, line));
+  }
+}
+
+TEST_CASE("interpret/Incremental", "[interpret][Incremental]") {
+  MathSourceFile src;
+  MathDocument doc;
+  src.loadFromBuffer (incrementalSource);
+
+  MathInterpreter interpreter (src, doc);
+  REQUIRE_NOTHROW (interpreter.interpret());
+
+  SECTION("changing a math line") {
+    editLine (src, interpreter, 1, "2. y^3 + 7");
+    checkAgainstFreshInterpretation (src, doc, interpreter);
+  }
+  SECTION("changing several lines at once") {
+    src.replaceLine (0, "1. x");
+    src.replaceLine (9, "5. 3/4 + 1/8");
+    std::vector<size_t> changed;
+    changed.push_back (9);
+    changed.push_back (0);
+    interpreter.reinterpretLines (changed);
+    checkAgainstFreshInterpretation (src, doc, interpreter);
+  }
+  SECTION("adding and removing a block toggle") {
+    editLine (src, interpreter, 2, "&&");
+    checkAgainstFreshInterpretation (src, doc, interpreter);
+
+    editLine (src, interpreter, 2, "Some words");
+    checkAgainstFreshInterpretation (src, doc, interpreter);
+  }
+  SECTION("moving the start of a text block") {
+    // The repeated '&&' below warns about where its block began
+    editLine (src, interpreter, 6, "&&");
+    checkAgainstFreshInterpretation (src, doc, interpreter);
+
+    src.replaceLine (3, "&&");
+    src.replaceLine (4, "3. %a + %b");
+    std::vector<size_t> changed;
+    changed.push_back (3);
+    changed.push_back (4);
+    interpreter.reinterpretLines (changed);
+    checkAgainstFreshInterpretation (src, doc, interpreter);
+
+    // Lines that were not re-interpreted still know where their block began
+    editLine (src, interpreter, 5, "&&");
+    checkAgainstFreshInterpretation (src, doc, interpreter);
+  }
+  SECTION("removing the end of a text block") {
+    editLine (src, interpreter, 7, "Even more text.");
+    checkAgainstFreshInterpretation (src, doc, interpreter);
+  }
+  SECTION("adding and removing a warning") {
+    editLine (src, interpreter, 5, "The answer is x = 5.");
+    CHECK (interpreter.getMessages().size() == 1);
+    checkAgainstFreshInterpretation (src, doc, interpreter);
+
+    editLine (src, interpreter, 5, "A text block.");
+    CHECK (interpreter.haveMessages() == false);
+    checkAgainstFreshInterpretation (src, doc, interpreter);
+  }
+  SECTION("a line that cannot be interpreted") {
+    CHECK_THROWS_AS (editLine (src, interpreter, 3, "3. `V"), const MathInterpreterException &);
+    CHECK (interpreter.haveMessages() == true);
+
+    editLine (src, interpreter, 3, "3. `V x");
+    checkAgainstFreshInterpretation (src, doc, interpreter);
+  }
+}
@@ -0,0 +1,160 @@
+/**
+ * @file Int_Limits.cpp
+ *
+ * @copyright Copyright 2015 Anthony Tibbs
+ * This project is released under the GNU General Public License.
+*/
+
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+
+#include "mttest.h"
+#include "MathExceptions.h"
+#include "MathInterpreter.h"
+#include "MathSourceFile.h"
+
+// =========================================================================
+// Limits on the resources that untrusted input may use: each one ends in
+// a clean error rather than a hang.
+namespace {
+  /**
+   * Runs 'interpreter', returning false (with the codes of any error
+   * messages in 'errors') if the interpreter threw.
+   */
+  bool interpretLimited (MathInterpreter &interpreter,
+			 std::vector<MathInterpreterMsg::Code> &errors)
+  {
+    bool succeeded = true;
+    try {
+      interpreter.interpret();
+    } catch (MathInterpreterException &e) {
+      succeeded = false;
+    }
+
+    errors.clear();
+    for (std::vector<MathInterpreterMsg>::const_iterator it = interpreter.getMessages().begin();
+	 it != interpreter.getMessages().end(); ++it) {
+      if (it->getCategory() == MathInterpreterMsg::MI_ERROR)
+	errors.push_back (it->getCode());
+    }
+
+    return succeeded;
+  }
+
+  boost::posix_time::ptime pastDeadline (void)
+  {
+    return boost::posix_time::microsec_clock::universal_time() - boost::posix_time::seconds(1);
+  }
+}
+
+TEST_CASE("interpret/Limits/LineLength", "[interpret][Limits]") {
+  MathSourceFile src;
+  src.setMaxLineLength (20);
+
+  SECTION("lines up to the limit are loaded") {
+    REQUIRE_NOTHROW (src.loadFromBuffer ("x + 1 = 2\n" + std::string(20, 'y') + "\n"));
+    CHECK (src.getDocument().size() == 2);
+  }
+  SECTION("a longer line is refused") {
+    CHECK_THROWS_AS (src.loadFromBuffer ("x + 1 = 2\n" + std::string(21, 'y') + "\n"),
+		     const MathDocumentFileException &);
+  }
+  SECTION("continuation lines count towards the limit") {
+    const std::string part = "1234567\\\n";
+    REQUIRE_NOTHROW (src.loadFromBuffer (part + part + "123456\n"));
+    CHECK (src.getDocument() [0].getContent().length() == 20);
+
+    MathSourceFile src2;
+    src2.setMaxLineLength (20);
+    CHECK_THROWS_AS (src2.loadFromBuffer (part + part + part + "\n"), const MathDocumentFileException &);
+
+    // The line is refused while it is still being joined, however long it
+    // would have grown
+    std::string hostile;
+    for (unsigned n = 0; n < 100000; n++)
+      hostile += part;
+
+    MathSourceFile src3;
+    src3.setMaxLineLength (20);
+    CHECK_THROWS_AS (src3.loadFromBuffer (hostile + "\n"), const MathDocumentFileException &);
+  }
+  SECTION("replacement lines are held to the limit") {
+    src.loadFromBuffer ("x + 1 = 2\n");
+    CHECK_NOTHROW (src.replaceLine (0, std::string(20, 'y')));
+    CHECK_THROWS_AS (src.replaceLine (0, std::string(21, 'y')), const MathDocumentFileException &);
+  }
+}
+
+TEST_CASE("interpret/Limits/Elements", "[interpret][Limits]") {
+  MathSourceFile src;
+  MathDocument doc;
+  std::vector<MathInterpreterMsg::Code> errors;
+
+  SECTION("lines up to the limit are interpreted") {
+    src.loadFromBuffer ("1 + 2\n");
+    MathInterpreter interpreter (src, doc);
+    interpreter.setMaxElements (3);
+    CHECK (interpretLimited (interpreter, errors));
+    CHECK (errors.empty());
+  }
+  SECTION("a line with more elements is an error") {
+    src.loadFromBuffer ("1 + 2 + 3\n");
+    MathInterpreter interpreter (src, doc);
+    interpreter.setMaxElements (3);
+    CHECK_FALSE (interpretLimited (interpreter, errors));
+    REQUIRE (errors.size() == 1);
+    CHECK (errors [0] == MathInterpreterMsg::TOO_MANY_ELEMENTS);
+  }
+  SECTION("nested elements count towards the limit") {
+    src.loadFromBuffer ("((1 + 2))\n");
+    MathInterpreter interpreter (src, doc);
+    interpreter.setMaxElements (4);
+    CHECK_FALSE (interpretLimited (interpreter, errors));
+    REQUIRE (errors.size() == 1);
+    CHECK (errors [0] == MathInterpreterMsg::TOO_MANY_ELEMENTS);
+  }
+  SECTION("the rest of the line is skipped when recovering from errors") {
+    src.loadFromBuffer ("1 + 2 + 3\ny\n");
+    MathInterpreter interpreter (src, doc);
+    interpreter.setMaxElements (3);
+    interpreter.setErrorRecovery (true);
+    interpreter.setThreadCount (1);
+    CHECK (interpretLimited (interpreter, errors));
+    REQUIRE (errors.size() == 1);
+
+    std::string output;
+    documentToString (doc, output);
+    CHECK (output == "<#>1</#><plus><#>2</#><plus><ERROR>3</ERROR><eol><M>y</M><eol>");
+  }
+}
+
+TEST_CASE("interpret/Limits/Deadline", "[interpret][Limits]") {
+  MathSourceFile src;
+  MathDocument doc;
+  std::vector<MathInterpreterMsg::Code> errors;
+  std::string input;
+  for (unsigned n = 0; n < 500; n++)
+    input += "x^2 + @1~2# = y_1\n";
+  src.loadFromBuffer (input);
+
+  SECTION("a deadline in the future is no obstacle") {
+    MathInterpreter interpreter (src, doc);
+    interpreter.setDeadline (boost::posix_time::microsec_clock::universal_time() + boost::posix_time::hours(1));
+    CHECK (interpretLimited (interpreter, errors));
+  }
+  SECTION("interpretation stops once the deadline has passed") {
+    MathInterpreter interpreter (src, doc);
+    interpreter.setDeadline (pastDeadline());
+    interpreter.setThreadCount (4);
+    CHECK_FALSE (interpretLimited (interpreter, errors));
+    REQUIRE (errors.size() == 1);
+    CHECK (errors [0] == MathInterpreterMsg::TIME_LIMIT_EXCEEDED);
+  }
+  SECTION("... even when recovering from errors") {
+    MathInterpreter interpreter (src, doc);
+    interpreter.setDeadline (pastDeadline());
+    interpreter.setErrorRecovery (true);
+    CHECK_FALSE (interpretLimited (interpreter, errors));
+    REQUIRE_FALSE (errors.empty());
+    CHECK (errors [0] == MathInterpreterMsg::TIME_LIMIT_EXCEEDED);
+  }
+}
@@ -0,0 +1,137 @@
+/**
+ * @file Int_Messages.cpp
+ *
+ * @copyright Copyright 2015 Anthony Tibbs
+ * This project is released under the GNU General Public License.
+*/
+
+#include <sstream>
+#include <boost/format.hpp>
+
+#include "mttest.h"
+#include "MathExceptions.h"
+#include "MathInterpreter.h"
+#include "MathSourceFile.h"
+
+// =========================================================================
+namespace {
+  /**
+   * A text block in which every line looks like math, so each one gets a
+   * SUSPECT_MATH_IN_TEXT warning; 'numDistinct' (at most 5) different
+   * warnings are given.
+   */
+  std::string makeNoisyDocument (const unsigned numLines, const unsigned numDistinct)
+  {
+    static const char *lines[] = {
+      "The answer is x = %u.",
+      "Raise it to the power x^%u.",
+      "Start with _/%u first.",
+      "Note that |%u| is positive.",
+      "Check that x = %u^2 holds."
+    };
+
+    std::string doc = "&&\n";
+    for (unsigned n = 0; n < numLines; n++)
+      doc += boost::str(boost::format(lines [n % numDistinct]) % n) + "\n";
+
+    return doc + "$$\n";
+  }
+}
+
+TEST_CASE("interpret/Messages", "[interpret][Messages]") {
+  MathSourceFile src;
+  MathDocument doc;
+
+  SECTION("details are filled in when the message is displayed") {
+    src.loadFromBuffer ("&&\nThe answer is x = 5.\n$$\n", "answers.txt");
+    MathInterpreter interpreter (src, doc);
+    interpreter.interpret();
+
+    REQUIRE (interpreter.getMessages().size() == 1);
+    const MathInterpreterMsg &msg = interpreter.getMessages() [0];
+    CHECK (msg.getCode() == MathInterpreterMsg::SUSPECT_MATH_IN_TEXT);
+    CHECK (msg.getFilename() == "answers.txt");
+    CHECK (msg.getStartLineNumber() == 2);
+    CHECK (msg.getRepeatCount() == 0);
+
+    std::ostringstream os;
+    os << msg;
+    CHECK (os.str() == "WARNING: Suspected math symbols in a text passage - found Signs of Comparison (at line 2 in answers.txt)");
+  }
+  SECTION("warnings about text do not keep a copy of it") {
+    src.loadFromBuffer ("&&\nx = 1\n" + std::string(10000, 'a') + " x = 1\n$$\n");
+    MathInterpreter interpreter (src, doc);
+    interpreter.interpret();
+
+    REQUIRE (interpreter.getMessages().size() == 2);
+    CHECK (interpreter.getMessages() [1].getMessage() == interpreter.getMessages() [0].getMessage());
+    CHECK (interpreter.getMessages() [1].getByteSize() == interpreter.getMessages() [0].getByteSize());
+  }
+  SECTION("every message is kept by default") {
+    src.loadFromBuffer (makeNoisyDocument (50, 5));
+    MathInterpreter interpreter (src, doc);
+    interpreter.interpret();
+
+    CHECK (interpreter.getMessages().size() == 50);
+    CHECK (interpreter.getSuppressedMessageCount() == 0);
+  }
+  SECTION("messages past a code's limit are only counted") {
+    src.loadFromBuffer (makeNoisyDocument (50, 5) + "@x+1~y = 4\n");
+    MathInterpreter interpreter (src, doc);
+    interpreter.setMessageLimit (MathInterpreterMsg::SUSPECT_MATH_IN_TEXT, 3);
+    interpreter.setErrorRecovery (true);
+    interpreter.interpret();
+
+    REQUIRE (interpreter.getMessages().size() == 4);
+    CHECK (interpreter.getMessages() [2].getStartLineNumber() == 4);
+    CHECK (interpreter.getMessages() [3].getCode() != MathInterpreterMsg::SUSPECT_MATH_IN_TEXT);
+    CHECK (interpreter.getSuppressedMessageCount() == 47);
+    CHECK (interpreter.getSuppressedMessageCount (MathInterpreterMsg::SUSPECT_MATH_IN_TEXT) == 47);
+  }
+  SECTION("a code's own limit overrides the limit for all codes") {
+    src.loadFromBuffer (makeNoisyDocument (50, 5));
+    MathInterpreter interpreter (src, doc);
+    interpreter.setMessageLimit (1);
+    interpreter.setMessageLimit (MathInterpreterMsg::SUSPECT_MATH_IN_TEXT, 10);
+    interpreter.interpret();
+
+    CHECK (interpreter.getMessages().size() == 10);
+    CHECK (interpreter.getSuppressedMessageCount() == 40);
+  }
+  SECTION("identical messages are folded together") {
+    src.loadFromBuffer (makeNoisyDocument (50, 5));
+    MathInterpreter interpreter (src, doc);
+    interpreter.setMessageFolding (true);
+    interpreter.setThreadCount (4);
+    interpreter.interpret();
+
+    REQUIRE (interpreter.getMessages().size() == 5);
+    for (unsigned n = 0; n < 5; n++) {
+      CHECK (interpreter.getMessages() [n].getStartLineNumber() == n + 2);
+      CHECK (interpreter.getMessages() [n].getRepeatCount() == 9);
+    }
+
+    std::ostringstream os;
+    os << interpreter.getMessages() [0];
+    CHECK (os.str().find ("(and 9 more times)") != std::string::npos);
+  }
+  SECTION("limits and folding start afresh when lines are reinterpreted") {
+    src.loadFromBuffer (makeNoisyDocument (50, 5));
+    MathInterpreter interpreter (src, doc);
+    interpreter.setMessageFolding (true);
+    interpreter.setMessageLimit (3);
+    interpreter.interpret();
+    REQUIRE (interpreter.getMessages().size() == 3);
+    CHECK (interpreter.getSuppressedMessageCount() == 20);
+
+    std::vector<size_t> changed;
+    changed.push_back (1);
+    src.replaceLine (1, "Nothing to see here.");
+    interpreter.reinterpretLines (changed);
+
+    REQUIRE (interpreter.getMessages().size() == 3);
+    CHECK (interpreter.getMessages() [0].getStartLineNumber() == 3);
+    CHECK (interpreter.getMessages() [0].getRepeatCount() == 9);
+    CHECK (interpreter.getSuppressedMessageCount() == 19);
+  }
+}
@@ -0,0 +1,209 @@
+/**
+ * @file Int_Nesting.cpp
+ *
+ * @copyright Copyright 2015 Anthony Tibbs
+ * This project is released under the GNU General Public License.
+*/
+
+#include "mttest.h"
+#include "LaTeXRenderer.h"
+#include "MathExceptions.h"
+#include "MathInterpreter.h"
+#include "MathSourceFile.h"
+#include "UEBRenderer.h"
+
+// =========================================================================
+// Nested groups, fractions, etc. are interpreted and rendered on explicit
+// stacks, so pathologically deep nesting is reported as an error (or, with
+// a raised limit, interpreted and rendered) rather than overflowing the
+// call stack.
+namespace {
+  const unsigned DEEP_NESTING = 10000;
+
+  std::string makeNestedGroups (const unsigned depth)
+  {
+    return std::string(depth, '(') + "x" + std::string(depth, ')');
+  }
+
+  std::string makeNestedFractions (const unsigned depth)
+  {
+    std::string fraction = "1~2#";
+    for (unsigned n = 1; n < depth; n++)
+      fraction += "~2#";
+
+    return std::string(depth, '@') + fraction;
+  }
+
+  /**
+   * Interprets 'input', returning false (with the codes of any error
+   * messages in 'errors') if the interpreter threw.
+   */
+  bool interpretNested (const std::string &input, MathDocument &doc,
+			std::vector<MathInterpreterMsg::Code> &errors,
+			const unsigned long maxDepth, const bool recover = false)
+  {
+    MathSourceFile src;
+    src.loadFromBuffer (input);
+
+    MathInterpreter interpreter (src, doc);
+    interpreter.setThreadCount (1);
+    interpreter.setMaxNestingDepth (maxDepth);
+    interpreter.setErrorRecovery (recover);
+
+    bool succeeded = true;
+    try {
+      interpreter.interpret();
+    } catch (MathInterpreterException &e) {
+      succeeded = false;
+    }
+
+    errors.clear();
+    for (std::vector<MathInterpreterMsg>::const_iterator it = interpreter.getMessages().begin();
+	 it != interpreter.getMessages().end(); ++it) {
+      if (it->getCategory() == MathInterpreterMsg::MI_ERROR)
+	errors.push_back (it->getCode());
+    }
+
+    return succeeded;
+  }
+
+  /**
+   * Follows a chain of groups nested in one another, without recursion,
+   * returning how deep it goes and whether the innermost holds just 'x'.
+   */
+  unsigned countNestedGroups (const MathDocument &doc, bool &innermostIsX)
+  {
+    // The document starts with the source line
+    MDEVector elements = doc.getDocument();
+    elements.erase (elements.begin());
+
+    unsigned depth = 0;
+    for (;;) {
+      const MDE_Group *group = dynamic_cast<const MDE_Group *>(elements.front().get());
+      if (!group)
+	break;
+
+      depth++;
+      elements = group->getContents();
+    }
+
+    innermostIsX = (elements.size() == 1 && elements.front()->getString() == "<M>x</M>");
+    return depth;
+  }
+
+  size_t countOccurrences (const std::string &s, const std::string &what)
+  {
+    size_t count = 0;
+    for (size_t pos = s.find (what); pos != std::string::npos; pos = s.find (what, pos + what.length()))
+      count++;
+    return count;
+  }
+
+  unsigned countNestedFractions (const MathDocument &doc)
+  {
+    MDEVector elements = doc.getDocument();
+    elements.erase (elements.begin());
+
+    unsigned depth = 0;
+    for (;;) {
+      const MDE_Fraction *fraction = dynamic_cast<const MDE_Fraction *>(elements.front().get());
+      if (!fraction)
+	break;
+
+      depth++;
+      elements = fraction->getNumerator();
+    }
+
+    return depth;
+  }
+}
+
+TEST_CASE("interpret/Nesting", "[interpret][Nesting]") {
+  std::vector<MathInterpreterMsg::Code> errors;
+
+  SECTION("nesting up to the limit is allowed") {
+    MathDocument doc;
+    CHECK (interpretNested ("((x)) + @@1~2#~3#", doc, errors, 2));
+    CHECK (errors.empty());
+  }
+  SECTION("nesting beyond the limit is an error") {
+    MathDocument doc;
+    CHECK_FALSE (interpretNested ("(((x)))", doc, errors, 2));
+    REQUIRE (errors.size() == 1);
+    CHECK (errors [0] == MathInterpreterMsg::NESTING_TOO_DEEP);
+  }
+  SECTION("nested constructs keep their order and interpretation") {
+    checkInterpretation ("_/[n+1](@a~b#)^(2)",
+			 "<ROOT INDEX:<M>n</M><plus><#>1</#>><FRAC><M>a</M><OVER><M>b</M></FRAC></ROOT><EXP><#>2</#></EXP>");
+    checkInterpretation ("x_(i) + (y)", "<M>x</M><SUB><M>i</M></SUB><plus><GROUP:(><M>y</M></GROUP:)>");
+  }
+}
+
+TEST_CASE("interpret/Nesting/deep", "[interpret][Nesting]") {
+  // Trace logging of deeply nested input grows with the square of the
+  // nesting depth
+  LoggingDisabled loggingDisabled;
+  std::vector<MathInterpreterMsg::Code> errors;
+
+  SECTION("deep nesting is reported under the default limit") {
+    MathDocument doc;
+    CHECK_FALSE (interpretNested (makeNestedGroups (DEEP_NESTING), doc, errors, 1000));
+    REQUIRE (errors.size() == 1);
+    CHECK (errors [0] == MathInterpreterMsg::NESTING_TOO_DEEP);
+  }
+  SECTION("deep nesting is skipped when recovering from errors") {
+    MathDocument doc;
+    CHECK (interpretNested (makeNestedGroups (DEEP_NESTING) + "\ny\n", doc, errors, 1000, true));
+    REQUIRE (errors.size() == 1);
+    CHECK (errors [0] == MathInterpreterMsg::NESTING_TOO_DEEP);
+
+    // The whole of the first line is skipped; the second is unaffected
+    std::string output;
+    documentToString (doc, output);
+    CHECK (output == "<ERROR>" + makeNestedGroups (DEEP_NESTING) + "</ERROR><eol><M>y</M><eol>");
+  }
+  SECTION("deep nesting is interpreted under a raised limit") {
+    MathDocument doc;
+    REQUIRE (interpretNested (makeNestedGroups (DEEP_NESTING), doc, errors, DEEP_NESTING));
+    CHECK (errors.empty());
+
+    bool innermostIsX = false;
+    CHECK (countNestedGroups (doc, innermostIsX) == DEEP_NESTING);
+    CHECK (innermostIsX);
+  }
+  SECTION("deeply nested fractions are interpreted under a raised limit") {
+    // Each fraction is scanned character by character to find its end,
+    // which makes them slower to nest than groups
+    const unsigned depth = DEEP_NESTING / 4;
+    MathDocument doc;
+    REQUIRE (interpretNested (makeNestedFractions (depth), doc, errors, depth));
+    CHECK (countNestedFractions (doc) == depth);
+  }
+  SECTION("renderers refuse nesting deeper than their limit") {
+    MathDocument doc;
+    REQUIRE (interpretNested (makeNestedGroups (DEEP_NESTING), doc, errors, DEEP_NESTING));
+
+    LaTeXRenderer latex;
+    CHECK_THROWS_AS(latex.renderDocument (doc), const MathRenderException &);
+
+    UEBRenderer ueb;
+    CHECK_THROWS_AS(ueb.renderDocument (doc), const MathRenderException &);
+  }
+  SECTION("deep nesting is rendered under a raised limit") {
+    MathDocument doc;
+    REQUIRE (interpretNested (makeNestedGroups (DEEP_NESTING), doc, errors, DEEP_NESTING));
+
+    LaTeXRenderer latex;
+    latex.setMaxNestingDepth (DEEP_NESTING);
+    const std::string tex = latex.renderDocument (doc);
+    CHECK (countOccurrences (tex, "\\left(") == DEEP_NESTING);
+    CHECK (countOccurrences (tex, "\\right)") == DEEP_NESTING);
+    CHECK (tex.find ("\\left(x\\right)") != std::string::npos);
+
+    UEBRenderer ueb;
+    ueb.setMaxNestingDepth (DEEP_NESTING);
+    const std::string brf = ueb.renderDocument (doc);
+    CHECK (countOccurrences (brf, UEB_LEFT_PAREN) == DEEP_NESTING);
+    CHECK (countOccurrences (brf, UEB_RIGHT_PAREN) == DEEP_NESTING);
+  }
+}
@@ -0,0 +1,117 @@
+/**
+ * @file Int_Parallel.cpp
+ *
+ * @copyright Copyright 2015 Anthony Tibbs
+ * This project is released under the GNU General Public License.
+*/
+
+#include <boost/bind.hpp>
+#include <boost/thread.hpp>
+
+#include "mttest.h"
+#include "MathExceptions.h"
+#include "MathInterpreter.h"
+#include "MathSourceFile.h"
+
+// =========================================================================
+// Interpreting lines on several threads must give exactly the same
+// document and messages, in the same order, as interpreting them in turn.
+namespace {
+  struct InterpretationResult {
+    std::string output;
+    std::vector<std::string> messages;
+    bool threw;
+  };
+
+  InterpretationResult interpretWithThreads (const std::string &input,
+					     const unsigned numThreads)
+  {
+    InterpretationResult result;
+    MathSourceFile src;
+    MathDocument doc;
+    src.loadFromBuffer (input);
+
+    MathInterpreter interpreter (src, doc);
+    interpreter.setThreadCount (numThreads);
+
+    result.threw = false;
+    try {
+      interpreter.interpret();
+    } catch (MathInterpreterException &) {
+      result.threw = true;
+    }
+
+    documentToString (doc, result.output);
+    for (std::vector<MathInterpreterMsg>::const_iterator it = interpreter.getMessages().begin();
+	 it != interpreter.getMessages().end(); ++it) {
+      std::ostringstream ss;
+      ss << *it;
+      result.messages.push_back (ss.str());
+    }
+
+    return result;
+  }
+}
+
+TEST_CASE("interpret/Parallel", "[interpret][Parallel]") {
+  SECTION("same document and messages as a sequential run") {
+    const unsigned numSections = 50;
+    const std::string input = makeWorksheet (numSections, WORKSHEET_WARNINGS);
+    InterpretationResult sequential = interpretWithThreads (input, 1);
+    InterpretationResult parallel = interpretWithThreads (input, 4);
+
+    REQUIRE (sequential.threw == false);
+    CHECK (sequential.messages.size() == numSections * 3);
+    CHECK (parallel.threw == false);
+    CHECK (parallel.output == sequential.output);
+    CHECK (parallel.messages == sequential.messages);
+  }
+  SECTION("errors stop the document at the same line") {
+    const std::string input = makeWorksheet (20, WORKSHEET_WARNINGS) + "`V\n" + makeWorksheet (20, WORKSHEET_WARNINGS);
+    InterpretationResult sequential = interpretWithThreads (input, 1);
+    InterpretationResult parallel = interpretWithThreads (input, 4);
+
+    REQUIRE (sequential.threw == true);
+    CHECK (parallel.threw == true);
+    CHECK (parallel.output == sequential.output);
+    CHECK (parallel.messages == sequential.messages);
+  }
+}
+
+// =========================================================================
+// Separate interpreters must be usable on different threads at once.  The
+// assertions are made afterwards, on this thread, since Catch itself is not
+// thread-safe.
+namespace {
+  void interpretOnThread (const std::string &input,
+			  InterpretationResult &result)
+  {
+    result = interpretWithThreads (input, 1);
+  }
+}
+
+TEST_CASE("interpret/Parallel/instances", "[interpret][Parallel]") {
+  const unsigned numDocuments = 16;
+  std::vector<std::string> inputs;
+  std::vector<InterpretationResult> expected (numDocuments);
+  std::vector<InterpretationResult> actual (numDocuments);
+
+  for (unsigned n = 0; n < numDocuments; n++) {
+    inputs.push_back (makeWorksheet (5 + n, WORKSHEET_WARNINGS));
+    expected [n] = interpretWithThreads (inputs [n], 1);
+  }
+
+  boost::thread_group threads;
+  for (unsigned n = 0; n < numDocuments; n++)
+    threads.create_thread (boost::bind(&interpretOnThread,
+				       boost::cref(inputs [n]),
+				       boost::ref(actual [n])));
+  threads.join_all();
+
+  for (unsigned n = 0; n < numDocuments; n++) {
+    CAPTURE(n);
+    CHECK (actual [n].threw == false);
+    CHECK (actual [n].output == expected [n].output);
+    CHECK (actual [n].messages == expected [n].messages);
+  }
+}
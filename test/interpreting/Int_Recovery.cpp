@@ -0,0 +1,101 @@
+/**
+ * @file Int_Recovery.cpp
+ *
+ * @copyright Copyright 2015 Anthony Tibbs
+ * This project is released under the GNU General Public License.
+*/
+
+#include "mttest.h"
+#include "MathExceptions.h"
+#include "MathInterpreter.h"
+#include "MathSourceFile.h"
+
+// =========================================================================
+namespace {
+  /**
+   * Interprets 'input' with error recovery enabled, returning the
+   * interpretation and the codes of any error messages.
+   */
+  std::string recoverInterpretation (const std::string &input,
+				     std::vector<MathInterpreterMsg::Code> &errors,
+				     const unsigned numThreads = 1)
+  {
+    MathSourceFile src;
+    MathDocument doc;
+    std::string output;
+
+    src.loadFromBuffer (input);
+    MathInterpreter interpreter (src, doc);
+    interpreter.setErrorRecovery (true);
+    interpreter.setThreadCount (numThreads);
+    REQUIRE_NOTHROW(interpreter.interpret());
+
+    errors.clear();
+    for (std::vector<MathInterpreterMsg>::const_iterator it = interpreter.getMessages().begin();
+	 it != interpreter.getMessages().end(); ++it) {
+      if (it->getCategory() == MathInterpreterMsg::MI_ERROR)
+	errors.push_back (it->getCode());
+    }
+
+    documentToString (doc, output);
+    return output;
+  }
+}
+
+TEST_CASE("interpret/Recovery", "[interpret][Recovery]") {
+  std::vector<MathInterpreterMsg::Code> errors;
+
+  SECTION("errors still throw by default") {
+    MathSourceFile src;
+    MathDocument doc;
+    src.loadFromBuffer ("@1~2\n");
+
+    MathInterpreter interpreter (src, doc);
+    CHECK_THROWS_AS(interpreter.interpret(), const MathInterpreterException &);
+  }
+  SECTION("the rest of a failed line is kept as an error element") {
+    CHECK (recoverInterpretation ("x + @1~2", errors) ==
+	   "<M>x</M><plus><ERROR>@1~2</ERROR><eol>");
+    REQUIRE (errors.size() == 1);
+    CHECK (errors [0] == MathInterpreterMsg::FRACTION_NOT_TERMINATED);
+  }
+  SECTION("errors inside nested constructs abandon the outermost one") {
+    CHECK (recoverInterpretation ("1 + @(x~2# = 3", errors) ==
+	   "<#>1</#><plus><ERROR>@(x~2# = 3</ERROR><eol>");
+    REQUIRE (errors.size() == 1);
+    CHECK (errors [0] == MathInterpreterMsg::GROUP_NOT_TERMINATED);
+  }
+  SECTION("unterminated summation bounds are reported") {
+    CHECK (recoverInterpretation ("`S(i=1\n"
+				  "`S(i=1, n\n", errors) ==
+	   "<ERROR>`S(i=1</ERROR><eol>"
+	   "<ERROR>`S(i=1, n</ERROR><eol>");
+    REQUIRE (errors.size() == 2);
+    CHECK (errors [0] == MathInterpreterMsg::SUMMATION_LOWER_BOUND_NOT_TERMINATED);
+    CHECK (errors [1] == MathInterpreterMsg::SUMMATION_UPPER_BOUND_NOT_TERMINATED);
+  }
+  SECTION("every error in the document is reported") {
+    CHECK (recoverInterpretation ("(x + 1\n"
+				  "y = 2\n"
+				  "$$Nonsense\n"
+				  "_/[2(x)\n", errors) ==
+	   "<ERROR>(x + 1</ERROR><eol>"
+	   "<M>y</M><equals><#>2</#><eol>"
+	   "<ERROR>$$Nonsense</ERROR><eol>"
+	   "<ERROR>_/[2(x)</ERROR><eol>");
+    REQUIRE (errors.size() == 3);
+    CHECK (errors [0] == MathInterpreterMsg::GROUP_NOT_TERMINATED);
+    CHECK (errors [1] == MathInterpreterMsg::UNKNOWN_COMMAND);
+  }
+  SECTION("results do not depend on the number of threads") {
+    std::string doc;
+    for (unsigned n = 0; n < 400; n++)
+      doc += (n % 3 ? "x^(2 + 1\n" : "@1~2# + 3\n");
+
+    std::vector<MathInterpreterMsg::Code> threadedErrors;
+    CHECK (recoverInterpretation (doc, errors) ==
+	   recoverInterpretation (doc, threadedErrors, 4));
+    CHECK (errors.size() == threadedErrors.size());
+    CHECK (errors.size() > 0);
+  }
+}
@@ -0,0 +1,46 @@
+/**
+ * @file Int_Roots.cpp
+ *
+ * @copyright Copyright 2015 Anthony Tibbs
+ * This project is released under the GNU General Public License.
+*/
+
+#include "mttest.h"
+
+// =========================================================================
+TEST_CASE("interpret/Roots", "[interpret][Roots]") {
+  SECTION("square roots") {
+    checkInterpretation ("_/16", "<ROOT><#>16</#></ROOT>");
+    checkInterpretation ("_/(n+1)", "<ROOT><M>n</M><plus><#>1</#></ROOT>");
+  }
+  SECTION("simple root indexes") {
+    checkInterpretation ("_/3(8)", "<ROOT INDEX:<#>3</#>><#>8</#></ROOT>");
+    checkInterpretation ("_/12(x)", "<ROOT INDEX:<#>12</#>><M>x</M></ROOT>");
+    checkInterpretation ("_/n(x)", "<ROOT INDEX:<M>n</M>><M>x</M></ROOT>");
+  }
+  SECTION("complex root indexes") {
+    checkInterpretation ("_/[mn](xy)", "<ROOT INDEX:<M>mn</M>><M>xy</M></ROOT>");
+  }
+  SECTION("index is only taken from directly after the root sign") {
+    checkInterpretation ("_/x + 3(y)", "<ROOT><M>x</M></ROOT><plus><#>3</#><GROUP:(><M>y</M></GROUP:)>");
+    checkInterpretation ("_/4 = 2(1)", "<ROOT><#>4</#></ROOT><equals><#>2</#><GROUP:(><#>1</#></GROUP:)>");
+  }
+}
+
+// =========================================================================
+// Root index detection used to search the entire remainder of the line for
+// every root; an index must now sit directly after the root sign, however
+// many roots follow on the line.  (How the time grows with the number of
+// roots is measured by benchmark/interpret/Roots.)
+TEST_CASE("interpret/Roots/long lines", "[interpret][Roots]") {
+  const unsigned numRoots = 1600;
+  std::string line, expected;
+  for (unsigned n = 0; n < numRoots; n++) {
+    line += "_/3(8) + ";
+    expected += "<ROOT INDEX:<#>3</#>><#>8</#></ROOT><plus>";
+  }
+  line += "_/x + 1";
+  expected += "<ROOT><M>x</M></ROOT><plus><#>1</#>";
+
+  checkInterpretation (line, expected);
+}
@@ -0,0 +1,160 @@
+/**
+ * @file Int_Streaming.cpp
+ *
+ * @copyright Copyright 2015 Anthony Tibbs
+ * This project is released under the GNU General Public License.
+*/
+
+#include <sstream>
+#include <boost/format.hpp>
+
+#include "mttest.h"
+#include "LaTeXRenderer.h"
+#include "MathExceptions.h"
+#include "MathInterpreter.h"
+#include "MathSourceFile.h"
+#include "UEBRenderer.h"
+
+// =========================================================================
+// Lines handed to a MathDocumentSink must add up to exactly the document
+// that interpret() builds, and renderers fed one line at a time must give
+// exactly the output of rendering the whole document.
+namespace {
+  std::string makeStreamingDocument (const unsigned numSections)
+  {
+    std::string doc;
+
+    for (unsigned n = 1; n <= numSections; n++) {
+      doc += boost::str(boost::format("%u. x^2 + %u = y_%u + @1~%u# + _/(x + %u)\n") % n % n % n % n % n);
+      doc += "&&\n";
+      doc += "Answer the following question, showing all of your work and giving the result in lowest terms.\n";
+      doc += "$$\n";
+      doc += boost::str(boost::format("`S(i=1, %u) i^2 = %u,000 &so there\n") % n % n);
+    }
+
+    return doc;
+  }
+
+  /**
+   * Remembers each line it is given, and checks that each one begins with
+   * its source line.
+   */
+  class LineCollector : public MathDocumentSink
+  {
+  public:
+    std::vector<MDEVector> lines;
+
+    virtual void addLine (const MDEVector &elements)
+    {
+      REQUIRE (!elements.empty());
+      CHECK (dynamic_cast<const MDE_SourceLine *>(elements.front().get()) != NULL);
+      lines.push_back (elements);
+    }
+  };
+}
+
+TEST_CASE("interpret/Streaming", "[interpret][Streaming]") {
+  const std::string input = makeStreamingDocument (100);
+  MathSourceFile src;
+  src.loadFromBuffer (input);
+
+  MathDocument expected;
+  MathInterpreter reference (src, expected);
+  reference.interpret();
+  std::string expectedString;
+  documentToString (expected, expectedString);
+
+  SECTION("streaming into a document matches interpreting into one") {
+    for (unsigned numThreads = 1; numThreads <= 4; numThreads += 3) {
+      MathDocument unused, streamed;
+      MathInterpreter interpreter (src, unused);
+      interpreter.setThreadCount (numThreads);
+      interpreter.interpret (streamed);
+
+      std::string streamedString;
+      documentToString (streamed, streamedString);
+      CHECK (streamedString == expectedString);
+      CHECK (unused.getDocument().empty());
+      CHECK (interpreter.getMessages().size() == reference.getMessages().size());
+    }
+  }
+  SECTION("each line is delivered once, in order") {
+    MathDocument unused;
+    LineCollector collector;
+    MathInterpreter interpreter (src, unused);
+    interpreter.interpret (collector);
+
+    REQUIRE (collector.lines.size() == src.getDocument().size());
+    for (size_t n = 0; n < collector.lines.size(); n++) {
+      const MDE_SourceLine *line = dynamic_cast<const MDE_SourceLine *>(collector.lines [n].front().get());
+      REQUIRE (line != NULL);
+      CHECK (line->getContents() == src.getDocument() [n].getContent());
+    }
+  }
+  SECTION("lines before an error are delivered") {
+    MathSourceFile broken;
+    broken.loadFromBuffer ("x + 1\ny + 2\n@1~2\nz + 3\n");
+
+    MathDocument unused;
+    LineCollector collector;
+    MathInterpreter interpreter (broken, unused);
+    CHECK_THROWS_AS(interpreter.interpret (collector), const MathInterpreterException &);
+    CHECK (collector.lines.size() == 3);
+  }
+  SECTION("rendering while interpreting matches rendering the document") {
+    LaTeXRenderer latex;
+    UEBRenderer ueb;
+    ueb.enableLineWrapping (40);
+    const std::string expectedLaTeX = latex.renderDocument (expected);
+    const std::string expectedUEB = ueb.renderDocument (expected);
+
+    LaTeXRenderer streamingLaTeX;
+    UEBRenderer streamingUEB;
+    streamingUEB.enableLineWrapping (40);
+
+    std::ostringstream latexOutput;
+    std::ostringstream uebOutput;
+    MathRendererSink latexSink (streamingLaTeX, latexOutput);
+    MathRendererSink uebSink (streamingUEB, uebOutput);
+
+    MathDocument unused;
+    LineCollector collector;
+    MathInterpreter interpreter (src, unused);
+    interpreter.interpret (collector);
+    for (std::vector<MDEVector>::const_iterator it = collector.lines.begin();
+	 it != collector.lines.end(); ++it) {
+      latexSink.addLine (*it);
+      uebSink.addLine (*it);
+    }
+    latexSink.finish();
+    uebSink.finish();
+
+    CHECK (latexOutput.str() == expectedLaTeX);
+    CHECK (uebOutput.str() == expectedUEB);
+  }
+  SECTION("one sink can render to several formats at once") {
+    LaTeXRenderer latex;
+    UEBRenderer ueb;
+    ueb.enableLineWrapping (40);
+    const std::string expectedLaTeX = latex.renderDocument (expected);
+    const std::string expectedUEB = ueb.renderDocument (expected);
+
+    LaTeXRenderer streamingLaTeX;
+    UEBRenderer streamingUEB;
+    streamingUEB.enableLineWrapping (40);
+
+    std::ostringstream latexOutput;
+    std::ostringstream uebOutput;
+    MathRendererSink sink;
+    sink.addRenderer (streamingLaTeX, latexOutput);
+    sink.addRenderer (streamingUEB, uebOutput);
+
+    MathDocument unused;
+    MathInterpreter interpreter (src, unused);
+    interpreter.interpret (sink);
+    sink.finish();
+
+    CHECK (latexOutput.str() == expectedLaTeX);
+    CHECK (uebOutput.str() == expectedUEB);
+  }
+}
@@ -0,0 +1,42 @@
+/**
+ * @file Int_Symbols.cpp
+ *
+ * @copyright Copyright 2015 Anthony Tibbs
+ * This project is released under the GNU General Public License.
+*/
+
+#include "mttest.h"
+
+// =========================================================================
+TEST_CASE("interpret/Symbols", "[interpret][Symbols]") {
+  SECTION("single character symbols") {
+    checkInterpretation ("5!", "<#>5</#><FACTORIAL>");
+    checkInterpretation ("5!, 6", "<#>5</#><FACTORIAL><COMMA><#>6</#>");
+  }
+  SECTION("two character symbols") {
+    checkInterpretation ("5%%", "<#>5</#><PERCENT>");
+    checkInterpretation ("/\\x", "<THEREFORE><M>x</M>");
+  }
+  SECTION("currency symbols are not case sensitive") {
+    checkInterpretation ("`$5", "<CURRENCY_DOLLAR><#>5</#>");
+    checkInterpretation ("`E5", "<CURRENCY_EURO><#>5</#>");
+    checkInterpretation ("`e5", "<CURRENCY_EURO><#>5</#>");
+  }
+}
+
+// =========================================================================
+TEST_CASE("interpret/Greek", "[interpret][Greek]") {
+  checkInterpretation ("%a", "<GREEK:alpha>");
+  checkInterpretation ("%W", "<GREEK:Omega>");
+  checkInterpretation ("%q", "<GREEK:tau>");
+}
+
+// =========================================================================
+TEST_CASE("interpret/Modifiers", "[interpret][Modifiers]") {
+  checkInterpretation ("`Vx", "<OVER_ARROW_RIGHT><M>x</M></OVER_ARROW_RIGHT>");
+  checkInterpretation ("`bar(x)", "<OVER_BAR><M>x</M></OVER_BAR>");
+  checkInterpretation ("`CJz", "<OVER_BAR><M>z</M></OVER_BAR>");
+  checkInterpretation ("`HAT x", "<OVER_HAT><M>x</M></OVER_HAT>");
+  checkInterpretation ("`hx", "<OVER_HAT><M>x</M></OVER_HAT>");
+  checkInterpretation ("`C", "<CURRENCY_CENTS>");
+}
@@ -0,0 +1,84 @@
+/**
+ * @file Int_TextMode.cpp
+ *
+ * @copyright Copyright 2015 Anthony Tibbs
+ * This project is released under the GNU General Public License.
+*/
+
+#include "mttest.h"
+#include "MathInterpreter.h"
+#include "MathSourceFile.h"
+
+// =========================================================================
+// Runs of text are taken in one go, up to the next mode change or command;
+// the results must be the same as taking them a character at a time.
+namespace {
+  /**
+   * Interprets 'input', returning the document as a string and the codes
+   * of any messages in 'codes'.
+   */
+  std::string interpretText (const std::string &input,
+			     std::vector<MathInterpreterMsg::Code> &codes)
+  {
+    MathSourceFile src;
+    MathDocument doc;
+    src.loadFromBuffer (input);
+
+    MathInterpreter interpreter (src, doc);
+    interpreter.registerCommand ("NoBracketSizing");
+    interpreter.interpret();
+
+    codes.clear();
+    for (std::vector<MathInterpreterMsg>::const_iterator it = interpreter.getMessages().begin();
+	 it != interpreter.getMessages().end(); ++it)
+      codes.push_back (it->getCode());
+
+    std::string output;
+    documentToString (doc, output);
+    return output;
+  }
+}
+
+TEST_CASE("interpret/TextMode", "[interpret][TextMode]") {
+  std::vector<MathInterpreterMsg::Code> codes;
+
+  SECTION("a text block line is a single text element") {
+    CHECK (interpretText ("&&\nThe quick brown fox jumps over the lazy dog.\n$$\n", codes) ==
+	   "<&&><T>The quick brown fox jumps over the lazy dog.</T><eol><$$>");
+    CHECK (codes.empty());
+  }
+  SECTION("math segments within text are still found") {
+    CHECK (interpretText ("&&\nThe cost, in dollars, is $5 + x& or so.\n$$\n", codes) ==
+	   "<&&><T>The cost, in dollars, is </T><$><#>5</#><plus><M>x</M><&><T> or so.</T><eol><$$>");
+    CHECK (interpretText ("&&\n$x& at the start, and at the end $y\n$$\n", codes) ==
+	   "<&&><$><M>x</M><&><T> at the start, and at the end </T><$><M>y</M><eol><$$>");
+    CHECK (codes.empty());
+  }
+  SECTION("text segments within math are still found") {
+    CHECK (interpretText ("x + 1 &is the answer to the question$ = 2\n", codes) ==
+	   "<M>x</M><plus><#>1</#><&><T>is the answer to the question</T><$><equals><#>2</#><eol>");
+    CHECK (codes.empty());
+  }
+  SECTION("mode changes at every position in a long line") {
+    const std::string text (40, 'a');
+    for (size_t at = 0; at <= text.length(); at++) {
+      CAPTURE(at);
+      std::string line = text;
+      line.insert (at, "$1&");
+      CHECK (interpretText ("&&\n" + line + "\n$$\n", codes) ==
+	     "<&&>" + (at ? "<T>" + text.substr(0, at) + "</T>" : std::string())
+	     + "<$><#>1</#><&>"
+	     + (at < text.length() ? "<T>" + text.substr(at) + "</T>" : std::string())
+	     + "<eol><$$>");
+    }
+  }
+  SECTION("a '&' in text and commands in text blocks are handled as before") {
+    CHECK (interpretText ("&&\nThis & that\n$$\n", codes) == "<&&><T>This  that</T><eol><$$>");
+    REQUIRE (codes.size() == 1);
+    CHECK (codes [0] == MathInterpreterMsg::NESTED_TEXT_MODE);
+
+    CHECK (interpretText ("&&\nA line with $$NoBracketSizing\n$$\n", codes) ==
+	   "<&&><T>A line with </T><cmd 'NoBracketSizing'><eol><$$>");
+    CHECK (codes.empty());
+  }
+}
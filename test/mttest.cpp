@@ -7,6 +7,8 @@
 */
 
 #include <boost/foreach.hpp>
+#include <boost/format.hpp>
+#include <boost/log/core/core.hpp>
 
 #define CATCH_CONFIG_MAIN
 #include "mttest.h"
@@ -48,3 +50,135 @@ void checkInterpretation (const std::string &inputStr,
   documentToString (doc, outputString);
   CHECK (outputString == (expectedOutputStr + "<eol>"));
 }
+
+/**
+ * Makes up a worksheet of numbered questions, with exponents, subscripts,
+ * roots and fractions, for tests and benchmarks that need a realistic
+ * document of some size.
+ *
+ * @param [in] numQuestions How many questions to ask
+ * @param [in] content What else to put in it (WorksheetContent flags)
+ * @param [in] variant Changes every fourth question, so that worksheets
+ *             with different variants are mostly, but not entirely, alike
+ */
+std::string makeWorksheet (const unsigned numQuestions,
+			   const unsigned content,
+			   const unsigned variant)
+{
+  static const char *const phrases[] = {
+    "Show your work.",
+    "Simplify your answer where possible.",
+    "Give your answer to two decimal places.",
+    "Explain your reasoning in a sentence or two.",
+    "where",
+    "and"
+  };
+  static const char *const unfinished[] = {
+    "%u. @x+%u~y-1 = 4",
+    "%u. (x + %u)(x - 1 = 0",
+    "%u. y = x^(2 + %u",
+    "%u. _/[%u(x + y)"
+  };
+  const unsigned numPhrases = sizeof(phrases) / sizeof(phrases[0]);
+  std::string doc;
+
+  if (content & WORKSHEET_INSTRUCTIONS)
+    doc += "&&\n"
+      "Answer every question.  Show all of your work, and simplify your\n"
+      "answers where possible.  Calculators are not permitted.\n"
+      "$$\n";
+
+  for (unsigned q = 1; q <= numQuestions; q++) {
+    if ((content & WORKSHEET_ERRORS) && q % 2 == 0) {
+      doc += boost::str(boost::format(unfinished [(q / 2) % 4]) % q % q) + "\n";
+    } else {
+      const unsigned v = (q % 4 == 0) ? variant : 0;
+      doc += boost::str(boost::format("%u. %ux^2 + %u,%03ux - _/%u(y_1) = @%u~x + %u#\n")
+			% q % (q % 9 + 1) % (q % 5 + 1) % ((q + v) % 1000) % (q % 7 + 2) % (q % 7 + 1) % q);
+    }
+
+    if (content & WORKSHEET_PROSE) {
+      doc += "&&\n";
+      doc += boost::str(boost::format("Question %u\n") % (q % 50));
+      doc += phrases [q % numPhrases];
+      doc += "\n$$\n";
+    }
+
+    if (content & WORKSHEET_WARNINGS) {
+      doc += "&&\n";
+      doc += "Some prose, with a $%a + 1$ in the middle.\n"; // second '$'
+      doc += "&&\n"; // nested text block
+      doc += "The answer is x = 5.\n"; // looks like math
+      doc += "$$\n";
+      doc += boost::str(boost::format("_/%u(x) &and some text\n") % q);
+    }
+  }
+
+  return doc;
+}
+
+LoggingDisabled::LoggingDisabled ()
+  : wasEnabled (boost::log::core::get()->get_logging_enabled())
+{
+  boost::log::core::get()->set_logging_enabled(false);
+}
+
+LoggingDisabled::~LoggingDisabled ()
+{
+  boost::log::core::get()->set_logging_enabled(wasEnabled);
+}
+
+/**
+ * Starts timing, with logging switched off until the timer goes out of
+ * scope: trace logging would otherwise dominate the measurement.
+ */
+BenchmarkTimer::BenchmarkTimer ()
+{
+  timer.start();
+}
+
+/**
+ * Starts timing again, from now.
+ */
+void BenchmarkTimer::start (void)
+{
+  timer.start();
+}
+
+/**
+ * @return Microseconds since the timer was (last) started
+ */
+unsigned BenchmarkTimer::getElapsedMicroseconds (void) const
+{
+  return timer.getElapsedMicroseconds();
+}
+
+/**
+ * Interprets 'input' repeatedly and returns the best observed time, in
+ * microseconds.
+ */
+unsigned benchmarkInterpretation (const std::string &input,
+				  const unsigned iterations,
+				  const unsigned numThreads)
+{
+  MathSourceFile src;
+  REQUIRE_NOTHROW(src.loadFromBuffer (input));
+
+  LoggingDisabled loggingDisabled;
+
+  unsigned best = 0;
+  for (unsigned n = 0; n < iterations; n++) {
+    MathDocument document;
+    MathInterpreter interpreter(src, document);
+    interpreter.setThreadCount (numThreads);
+
+    BenchmarkTimer timer;
+    interpreter.interpret();
+    unsigned elapsed = timer.getElapsedMicroseconds();
+
+    if (!n || elapsed < best)
+      best = elapsed;
+  }
+
+  return best;
+}
@@ -0,0 +1,100 @@
+/**
+ * @file Render_Limits.cpp
+ *
+ * @copyright Copyright 2015 Anthony Tibbs
+ * This project is released under the GNU General Public License.
+*/
+
+#include <sstream>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+
+#include "mttest.h"
+#include "LaTeXRenderer.h"
+#include "MathExceptions.h"
+#include "UEBRenderer.h"
+
+// =========================================================================
+// Limits on the output size and rendering time stop the renderers with a
+// clean error.
+TEST_CASE("render/Limits", "[render][Limits]") {
+  std::string input;
+  for (unsigned n = 0; n < 100; n++)
+    input += "x^2 + @1~2# = y_1\n";
+
+  MathDocument doc;
+  interpretToDocument (input, doc);
+
+  LaTeXRenderer unlimited;
+  const size_t latexLength = unlimited.renderDocument (doc).length();
+
+  SECTION("output up to the limit is rendered") {
+    LaTeXRenderer latex;
+    latex.setMaxOutputBytes (latexLength);
+    CHECK (latex.renderDocument (doc).length() == latexLength);
+  }
+  SECTION("larger output is refused") {
+    LaTeXRenderer latex;
+    latex.setMaxOutputBytes (latexLength / 2);
+    CHECK_THROWS_AS (latex.renderDocument (doc), const MathRenderException &);
+
+    UEBRenderer ueb;
+    ueb.setMaxOutputBytes (100);
+    CHECK_THROWS_AS (ueb.renderDocument (doc), const MathRenderException &);
+  }
+  SECTION("output is capped within a single large element") {
+    std::string group = "((x";
+    for (unsigned n = 0; n < 5000; n++)
+      group += "+x";
+    group += "))";
+
+    MathDocument large;
+    interpretToDocument (group, large);
+
+    // The group follows the source line
+    const MathDocumentElement *e = large.getDocument() [1].get();
+    REQUIRE (dynamic_cast<const MDE_Group *>(e));
+
+    LaTeXRenderer latex;
+    latex.setMaxOutputBytes (1000);
+    std::string latexOutput;
+    CHECK_THROWS_AS (latex.renderElement (e, latexOutput), const MathRenderException &);
+    CHECK (latexOutput.length() < 1100);
+
+    UEBRenderer ueb;
+    ueb.setMaxOutputBytes (1000);
+    std::string uebOutput;
+    CHECK_THROWS_AS (ueb.renderElement (e, uebOutput), const MathRenderException &);
+    CHECK (uebOutput.length() < 1100);
+  }
+  SECTION("output is counted across lines rendered a piece at a time") {
+    LaTeXRenderer latex;
+    latex.setMaxOutputBytes (latexLength / 2);
+
+    std::ostringstream os;
+    MathRendererSink sink (latex, os);
+    bool threw = false;
+    try {
+      for (MDEVector::const_iterator it = doc.getDocument().begin();
+	   it != doc.getDocument().end(); ++it)
+	sink.addLine (MDEVector(1, *it));
+    } catch (MathRenderException &e) {
+      threw = true;
+    }
+
+    // The preamble from beginDocument() is not counted
+    CHECK (threw);
+    CHECK (os.str().length() <= latexLength / 2 + LaTeXRenderer().beginDocument().length());
+  }
+  SECTION("rendering stops once the deadline has passed") {
+    const boost::posix_time::ptime past =
+      boost::posix_time::microsec_clock::universal_time() - boost::posix_time::seconds(1);
+
+    LaTeXRenderer latex;
+    latex.setDeadline (past);
+    CHECK_THROWS_AS (latex.renderDocument (doc), const MathRenderException &);
+
+    UEBRenderer ueb;
+    ueb.setDeadline (past);
+    CHECK_THROWS_AS (ueb.renderDocument (doc), const MathRenderException &);
+  }
+}
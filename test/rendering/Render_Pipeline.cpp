@@ -0,0 +1,131 @@
+/**
+ * @file Render_Pipeline.cpp
+ *
+ * @copyright Copyright 2015 Anthony Tibbs
+ * This project is released under the GNU General Public License.
+*/
+
+#include <sstream>
+#include <stdexcept>
+
+#include "mttest.h"
+#include "LaTeXRenderer.h"
+#include "MathExceptions.h"
+#include "MathInterpreter.h"
+#include "MathRenderPipeline.h"
+#include "MathSourceFile.h"
+#include "UEBRenderer.h"
+
+// =========================================================================
+// Rendering on pipeline threads while interpreting must give the same
+// output as interpreting the whole document and then rendering it.
+namespace {
+  /**
+   * A renderer that gives up partway through the document.
+   */
+  class FailingRenderer : public LaTeXRenderer
+  {
+  public:
+    unsigned linesLeft;
+
+    FailingRenderer () : linesLeft(10) {}
+
+    void renderLines (const MDEVector &elements, std::string &output)
+    {
+      if (!linesLeft--)
+	throw std::runtime_error ("renderer failed");
+      LaTeXRenderer::renderLines (elements, output);
+    }
+  };
+}
+
+TEST_CASE("render/Pipeline", "[render][Pipeline]") {
+  MathSourceFile src;
+  src.loadFromBuffer (makeWorksheet (200, WORKSHEET_PROSE));
+
+  MathDocument doc;
+  MathInterpreter reference (src, doc);
+  reference.interpret();
+
+  LaTeXRenderer latex;
+  UEBRenderer ueb;
+  ueb.enableLineWrapping (32);
+  const std::string expectedLaTeX = latex.renderDocument (doc);
+  const std::string expectedUEB = ueb.renderDocument (doc);
+
+  SECTION("output matches rendering the whole document") {
+    for (size_t queueLength = 1; queueLength <= 1024; queueLength *= 32) {
+      CAPTURE(queueLength);
+
+      LaTeXRenderer pipelineLaTeX;
+      UEBRenderer pipelineUEB;
+      pipelineUEB.enableLineWrapping (32);
+      std::ostringstream latexOutput, uebOutput;
+
+      MathRenderPipeline pipeline (queueLength);
+      pipeline.addRenderer (pipelineLaTeX, latexOutput);
+      pipeline.addRenderer (pipelineUEB, uebOutput);
+
+      MathDocument unused;
+      MathInterpreter interpreter (src, unused);
+      interpreter.interpret (pipeline);
+      pipeline.finish();
+
+      CHECK (latexOutput.str() == expectedLaTeX);
+      CHECK (uebOutput.str() == expectedUEB);
+    }
+  }
+  SECTION("rendering straight to a stream gives the same output") {
+    LaTeXRenderer streamLaTeX;
+    UEBRenderer streamUEB;
+    streamUEB.enableLineWrapping (32);
+    std::ostringstream latexOutput, uebOutput;
+
+    streamLaTeX.renderDocument (doc, latexOutput);
+    streamUEB.renderDocument (doc, uebOutput);
+
+    CHECK (latexOutput.str() == expectedLaTeX);
+    CHECK (uebOutput.str() == expectedUEB);
+  }
+  SECTION("renderer errors are passed on by finish()") {
+    FailingRenderer failing;
+    LaTeXRenderer working;
+    std::ostringstream failingOutput, workingOutput;
+
+    MathRenderPipeline pipeline (4);
+    pipeline.addRenderer (failing, failingOutput);
+    pipeline.addRenderer (working, workingOutput);
+
+    MathDocument unused;
+    MathInterpreter interpreter (src, unused);
+    interpreter.interpret (pipeline);
+    CHECK_THROWS_AS(pipeline.finish(), const std::runtime_error &);
+    CHECK (workingOutput.str() == expectedLaTeX);
+  }
+  SECTION("interpretation stops once every renderer has failed") {
+    FailingRenderer failing;
+    std::ostringstream failingOutput;
+
+    MathRenderPipeline pipeline (4);
+    pipeline.addRenderer (failing, failingOutput);
+
+    MathDocument unused;
+    MathInterpreter interpreter (src, unused);
+    CHECK_THROWS_AS(interpreter.interpret (pipeline), const std::runtime_error &);
+  }
+  SECTION("the pipeline can be abandoned when interpretation fails") {
+    MathSourceFile broken;
+    broken.loadFromBuffer (makeWorksheet (50, WORKSHEET_PROSE) + "@1~2\n");
+
+    LaTeXRenderer pipelineLaTeX;
+    std::ostringstream latexOutput;
+    MathDocument unused;
+    MathInterpreter interpreter (broken, unused);
+    {
+      MathRenderPipeline pipeline (2);
+      pipeline.addRenderer (pipelineLaTeX, latexOutput);
+      CHECK_THROWS_AS(interpreter.interpret (pipeline), const MathInterpreterException &);
+    }
+    CHECK (latexOutput.str().find (pipelineLaTeX.endDocument()) == std::string::npos);
+  }
+}
@@ -0,0 +1,113 @@
+/**
+ * @file UEB_BatchTranslation.cpp
+ *
+ * @copyright Copyright 2015 Anthony Tibbs
+ * This project is released under the GNU General Public License.
+*/
+
+#include <sstream>
+
+#include "mttest.h"
+#include "MathInterpreter.h"
+#include "MathSourceFile.h"
+#include "UEBRenderer.h"
+
+// =========================================================================
+// Translating the text of a document in batches must give the same braille
+// as translating each piece of it on its own.
+namespace {
+  std::string renderBatched (const MathDocument &doc, const bool batch,
+			     const unsigned lineLength, const bool streamed = false)
+  {
+    UEBRenderer r;
+    r.setBatchTranslation (batch);
+    if (lineLength)
+      r.enableLineWrapping (lineLength);
+
+    if (!streamed)
+      return r.renderDocument (doc);
+
+    std::ostringstream os;
+    r.renderDocument (doc, os);
+    return os.str();
+  }
+
+  /**
+   * Shows what is translated ahead of rendering.
+   */
+  class BatchInspector : public UEBRenderer
+  {
+  public:
+    size_t countBatched (const MDEVector &elements)
+    {
+      translateTextBatches (elements);
+      return batchedTranslations.size();
+    }
+
+    size_t countHeld (void) const
+    {
+      return heldLines.size();
+    }
+  };
+}
+
+TEST_CASE("render/ueb/BatchTranslation", "[render][UEB][BatchTranslation]") {
+  std::string input;
+  for (int n = 1; n <= 30; n++) {
+    input += "1. x + 1 = 3\n";
+    input += "&&\n";
+    input += (n % 3 ? "Show your work.\n" : "Simplify (where possible) and check your answer.\n");
+    input += "Question a of Part B\n";
+    input += "$$\n";
+  }
+  input += "&&\n";
+  input += std::string(400, 'z') + "\n";
+  input += "$$\n";
+
+  MathSourceFile src;
+  src.loadFromBuffer (input);
+  MathDocument doc;
+  MathInterpreter interpreter (src, doc);
+  interpreter.interpret();
+
+  SECTION("each piece of text is translated once, unless it is too long") {
+    BatchInspector inspector;
+    CHECK (inspector.countBatched (doc.getDocument()) == 4);
+  }
+  SECTION("batched text gives the same braille") {
+    for (unsigned lineLength = 0; lineLength <= 20; lineLength += 10) {
+      CAPTURE(lineLength);
+      CHECK (renderBatched (doc, true, lineLength) == renderBatched (doc, false, lineLength));
+    }
+  }
+  SECTION("so does batching a line at a time") {
+    CHECK (renderBatched (doc, true, 0, true) == renderBatched (doc, false, 0));
+    CHECK (renderBatched (doc, true, 20, true) == renderBatched (doc, false, 20));
+  }
+  SECTION("lines streamed one at a time are held back to be batched together") {
+    BatchInspector inspector;
+    inspector.setBatchTranslation (true);
+    inspector.enableLineWrapping (20);
+
+    std::ostringstream os;
+    MathRendererSink sink (inspector, os);
+    MDEVector line;
+    for (MDEVector::const_iterator it = doc.getDocument().begin();
+	 it != doc.getDocument().end(); ++it) {
+      line.push_back (*it);
+      if (dynamic_cast<const MDE_LineBreak *>(it->get())) {
+	sink.addLine (line);
+	line.clear();
+      }
+    }
+    sink.addLine (line);
+
+    // The document is smaller than the window, so all of it is held
+    CHECK (inspector.countHeld() == doc.getDocument().size());
+    CHECK (os.str().empty());
+
+    sink.finish();
+    CHECK (inspector.countHeld() == 0);
+    CHECK (os.str() == renderBatched (doc, false, 20));
+  }
+}
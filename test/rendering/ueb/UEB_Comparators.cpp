@@ -9,7 +9,7 @@
 #include "MathDocumentElements.h"
 #include "UEBRenderer.h"
 
-#define RENDERCHECK(comp,brl) { MDE_Comparator c(comp); CHECK(r.renderComparator(&c) == brl); }
+#define RENDERCHECK(comp,brl) { MDE_Comparator c(comp); CHECK(r.renderElement(&c) == brl); }
 
 TEST_CASE("render/ueb/Comparators", "[render][UEB][Comparator]") {
   UEBRenderer r;
@@ -13,7 +13,7 @@
 
 #define MKNUM(pos, whole, dec) boost::make_shared<MDE_Number>(MDE_Number::pos, whole, dec)
 #define MKTEXT(txt) boost::make_shared<MDE_MathBlock>(txt)
-#define TF(num, den, brl) { MDEVector numerator, denominator; numerator.push_back(num); denominator.push_back(den); MDE_Fraction frac(numerator, denominator); CHECK(r.renderFraction(&frac) == brl); }
+#define TF(num, den, brl) { MDEVector numerator, denominator; numerator.push_back(num); denominator.push_back(den); MDE_Fraction frac(numerator, denominator); CHECK(r.renderElement(&frac) == brl); }
 
 TEST_CASE("render/ueb/Fractions", "[render][UEB][Fractions]") {
   UEBRenderer r;
@@ -71,7 +71,7 @@ TEST_CASE("render/ueb/Fractions", "[render][UEB][Fractions]") {
       denominator.push_back (MKNUM(POSITIVE, "6", ""));
 
       MDE_Fraction frac(numerator, denominator);
-      CHECK(r.renderFraction(&frac) == "(#C9#B./#F)");
+      CHECK(r.renderElement(&frac) == "(#C9#B./#F)");
     }
   }
 
@@ -9,7 +9,7 @@
 #include "MathDocumentElements.h"
 #include "UEBRenderer.h"
 
-#define R(ltr,brl) { MDE_GreekLetter l(MDE_GreekLetter::ltr); CHECK(r.renderGreekLetter(&l) == brl); }
+#define R(ltr,brl) { MDE_GreekLetter l(MDE_GreekLetter::ltr); CHECK(r.renderElement(&l) == brl); }
 
 TEST_CASE("render/ueb/GreekLetters", "[render][UEB][GreekLetter]") {
   UEBRenderer r;
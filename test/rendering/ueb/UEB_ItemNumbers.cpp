@@ -9,7 +9,7 @@
 #include "MathDocumentElements.h"
 #include "UEBRenderer.h"
 
-#define RENDERCHECK(str,brl) { MDE_ItemNumber t(str); CHECK(r.renderItemNumber(&t) == brl); }
+#define RENDERCHECK(str,brl) { MDE_ItemNumber t(str); CHECK(r.renderElement(&t) == brl); }
 
 TEST_CASE("render/ueb/ItemNumber", "[render][UEB][ItemNumber]") {
   UEBRenderer r;
@@ -0,0 +1,53 @@
+/**
+ * @file UEB_LibLouis.cpp
+ *
+ * @copyright Copyright 2015 Anthony Tibbs
+ * This project is released under the GNU General Public License.
+*/
+
+#include "mttest.h"
+#include "LibLouisContext.h"
+#include "MathInterpreter.h"
+#include "MathSourceFile.h"
+#include "UEBRenderer.h"
+
+// =========================================================================
+// Braille tables are loaded once for the whole process, not once for each
+// renderer.
+TEST_CASE("render/ueb/LibLouis", "[render][UEB][LibLouis]") {
+  MathSourceFile src;
+  src.loadFromBuffer ("1. x + 1\n&&\nShow your work.\n$$\n");
+  MathDocument doc;
+  MathInterpreter interpreter (src, doc);
+  interpreter.interpret();
+
+  LibLouisContext &louis = LibLouisContext::get();
+
+  SECTION("renderers come and go without the tables being loaded again") {
+    louis.warmUp();
+    const unsigned long loads = louis.getTableLoadCount();
+
+    UEBRenderer first;
+    const std::string braille = first.renderDocument (doc);
+    for (int n = 0; n < 5; n++) {
+      UEBRenderer other;
+      CHECK (other.renderDocument (doc) == braille);
+    }
+    CHECK (first.renderDocument (doc) == braille);
+    CHECK (louis.getTableLoadCount() == loads);
+  }
+  SECTION("the tables are loaded again from a new data path") {
+    const std::string dataPath = louis.getDataPath();
+    louis.warmUp();
+    const unsigned long loads = louis.getTableLoadCount();
+
+    louis.setDataPath (dataPath + "/.");
+    CHECK (louis.getDataPath() == dataPath + "/.");
+    louis.setDataPath (dataPath);
+    CHECK (louis.getTableLoadCount() == loads);
+
+    UEBRenderer r;
+    r.renderDocument (doc);
+    CHECK (louis.getTableLoadCount() == loads + 1);
+  }
+}
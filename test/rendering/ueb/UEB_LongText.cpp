@@ -0,0 +1,57 @@
+/**
+ * @file UEB_LongText.cpp
+ *
+ * @copyright Copyright 2015 Anthony Tibbs
+ * This project is released under the GNU General Public License.
+*/
+
+#include "mttest.h"
+#include "MathInterpreter.h"
+#include "MathSourceFile.h"
+#include "UEBRenderer.h"
+
+// =========================================================================
+// Text too long for liblouis to translate in one go is translated in
+// pieces, which must join up as if it had been translated all at once.
+namespace {
+  std::string renderText (const std::string &text)
+  {
+    MathSourceFile src;
+    src.loadFromBuffer ("&&\n" + text + "\n$$\n");
+
+    MathDocument document;
+    MathInterpreter interpreter (src, document);
+    interpreter.interpret();
+
+    UEBRenderer r;
+    return r.renderDocument (document);
+  }
+}
+
+TEST_CASE("render/ueb/LongText", "[render][UEB][LongText]") {
+  SECTION("long paragraphs are split between sentences") {
+    const std::string sentence = "The train leaves at noon, and arrives an hour later.";
+    const std::string single = renderText (sentence);
+    REQUIRE (single.length() > 1);
+    const std::string sentenceBraille = single.substr (0, single.length() - 1);
+
+    std::string paragraph, expected;
+    for (int n = 0; n < 40; n++) {
+      paragraph += (n ? " " : "") + sentence;
+      expected += (n ? " " : "") + sentenceBraille;
+    }
+    CHECK (renderText (paragraph) == expected + "\n");
+  }
+  SECTION("long runs of words are split between words") {
+    std::string words, expected;
+    for (int n = 0; n < 300; n++) {
+      words += (n ? " " : "") + std::string("and");
+      expected += (n ? " " : "") + std::string("and");
+    }
+    CHECK (renderText (words) == expected + "\n");
+  }
+  SECTION("even a single very long word can be translated") {
+    const std::string word (1000, 'z');
+    CHECK (renderText (word) == word + "\n");
+  }
+}
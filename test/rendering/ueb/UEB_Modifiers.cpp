@@ -54,11 +54,11 @@ TEST_CASE("render/ueb/Modifiers", "[render][UEB][Modifiers]") {
     std::string sectionName = std::string("modifier: " + MDE_Modifier::getModifierName(curTest.modifier));
     SECTION ( sectionName ) {
       MDE_Modifier ungrouped_modifier (curTest.modifier, positive_number_vector);
-      CHECK (r.renderModifier(&ungrouped_modifier) == curTest.ungrouped);
+      CHECK (r.renderElement(&ungrouped_modifier) == curTest.ungrouped);
 
 
       MDE_Modifier grouped_modifier (curTest.modifier, negative_number_vector);
-      CHECK (r.renderModifier(&grouped_modifier) == curTest.grouped);
+      CHECK (r.renderElement(&grouped_modifier) == curTest.grouped);
     }
   }
 }
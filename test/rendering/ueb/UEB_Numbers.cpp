@@ -18,7 +18,7 @@
 #define X(neg, whole, decimal, result)		\
   { \
     MDE_Number n(neg, S(whole), S(decimal));	\
-    CHECK(r.renderNumber(&n) == result); \
+    CHECK(r.renderElement(&n) == result); \
   }
 
 TEST_CASE("render/ueb/Number", "[render][UEB][Number]") {
@@ -9,14 +9,14 @@
 #include "MathDocumentElements.h"
 #include "UEBRenderer.h"
 
-#define RENDERCHECK(oper,brl) { MDE_Operator op(oper); CHECK(r.renderOperator(&op) == brl); }
+#define RENDERCHECK(oper,brl) { MDE_Operator op(oper); CHECK(r.renderElement(&op) == brl); }
 
 TEST_CASE("render/ueb/Operators/unspaced", "[render][UEB][Operator]") {
   UEBRenderer r;
 
   // Disable 'extra operator spacing'
   MDE_Command setupCmd("SpaceUEBOperators", "false");
-  r.renderCommand(&setupCmd);
+  r.renderElement(&setupCmd);
 
   // UEB Rulebook 11.2 ---------------------------------------------
   RENDERCHECK(MDE_Operator::ADDITION, "\"6");
@@ -30,7 +30,7 @@ TEST_CASE("render/ueb/Operators/spaced", "[render][UEB][Operator]") {
 
   // Enable 'extra operator spacing'
   MDE_Command setupCmd("SpaceUEBOperators", "true");
-  r.renderCommand(&setupCmd);
+  r.renderElement(&setupCmd);
 
   // UEB Rulebook 11.2.2 -------------------------------------------
   RENDERCHECK(MDE_Operator::ADDITION, " \"6 ");
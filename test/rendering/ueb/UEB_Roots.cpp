@@ -23,7 +23,7 @@ TEST_CASE("render/ueb/Roots", "[render][UEB][Roots]") {
     root_argument.push_back (boost::make_shared<MDE_Number>(MDE_Number::POSITIVE, "4", ""));
 
     const MDE_Root root (root_index, root_argument);
-    CHECK (r.renderRoot (&root) == "%#D+");
+    CHECK (r.renderElement (&root) == "%#D+");
   }
 
   // UEB Technical Guideline 8.2 ---------------------------------------------
@@ -39,7 +39,7 @@ TEST_CASE("render/ueb/Roots", "[render][UEB][Roots]") {
     root_argument.push_back (boost::make_shared<MDE_Number>(MDE_Number::POSITIVE, "27", ""));
 
     const MDE_Root root (root_index, root_argument);
-    CHECK (r.renderRoot (&root) == "%9#C#BG+");
+    CHECK (r.renderElement (&root) == "%9#C#BG+");
   }
 
   // More complex root indexes need grouping indicators.  See the example
@@ -51,7 +51,7 @@ TEST_CASE("render/ueb/Roots", "[render][UEB][Roots]") {
     root_argument.push_back (boost::make_shared<MDE_MathBlock>("xy"));
 
     const MDE_Root root (root_index, root_argument);
-    CHECK (r.renderRoot (&root) == "%9<mn>xy+");
+    CHECK (r.renderElement (&root) == "%9<mn>xy+");
   }
 }
 
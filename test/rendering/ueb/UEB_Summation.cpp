@@ -19,7 +19,7 @@ TEST_CASE("render/ueb/Summations/nolimits", "[render][UEB][Summations]") {
     MDEVector lower_bound, upper_bound;
 
     const MDE_Summation sum(lower_bound, upper_bound);
-    CHECK (r.renderSummation (&sum) == ",.S");
+    CHECK (r.renderElement (&sum) == ",.S");
   }
 }
 
@@ -32,7 +32,7 @@ TEST_CASE("render/ueb/Summations/lower_limits", "[render][UEB][Summations]") {
     lower_bound.push_back (boost::make_shared<MDE_Number>(MDE_Number::POSITIVE, "4", ""));
 
     const MDE_Summation sum(lower_bound, upper_bound);
-    CHECK (r.renderSummation (&sum) == ",.S.5#D");
+    CHECK (r.renderElement (&sum) == ",.S.5#D");
   }
 
   SECTION ("Summation with simple, numeric lower limit followed by letter-indicator requiring letter") {
@@ -53,7 +53,7 @@ TEST_CASE("render/ueb/Summations/lower_limits", "[render][UEB][Summations]") {
     lower_bound.push_back (boost::make_shared<MDE_MathBlock>("n"));
 
     const MDE_Summation sum(lower_bound, upper_bound);
-    CHECK (r.renderSummation (&sum) == ",.S.5n");
+    CHECK (r.renderElement (&sum) == ",.S.5n");
   }
 
   SECTION ("Summation with complex lower limit") {
@@ -63,7 +63,7 @@ TEST_CASE("render/ueb/Summations/lower_limits", "[render][UEB][Summations]") {
     lower_bound.push_back (boost::make_shared<MDE_MathBlock>("a"));
 
     const MDE_Summation sum(lower_bound, upper_bound);
-    CHECK (r.renderSummation (&sum) == ",.S.5<#D;a>");
+    CHECK (r.renderElement (&sum) == ",.S.5<#D;a>");
   }
 }
 
@@ -76,7 +76,7 @@ TEST_CASE("render/ueb/Summations/upper_limits", "[render][UEB][Summations]") {
     upper_bound.push_back (boost::make_shared<MDE_Number>(MDE_Number::POSITIVE, "4", ""));
 
     const MDE_Summation sum(lower_bound, upper_bound);
-    CHECK (r.renderSummation (&sum) == ",.S.9#D");
+    CHECK (r.renderElement (&sum) == ",.S.9#D");
   }
 
   SECTION ("Summation with simple, numeric upper limit followed by letter-indicator requiring letter") {
@@ -97,7 +97,7 @@ TEST_CASE("render/ueb/Summations/upper_limits", "[render][UEB][Summations]") {
     upper_bound.push_back (boost::make_shared<MDE_MathBlock>("n"));
 
     const MDE_Summation sum(lower_bound, upper_bound);
-    CHECK (r.renderSummation (&sum) == ",.S.9n");
+    CHECK (r.renderElement (&sum) == ",.S.9n");
   }
 
   SECTION ("Summation with complex upper limit") {
@@ -107,7 +107,7 @@ TEST_CASE("render/ueb/Summations/upper_limits", "[render][UEB][Summations]") {
     upper_bound.push_back (boost::make_shared<MDE_MathBlock>("a"));
 
     const MDE_Summation sum(lower_bound, upper_bound);
-    CHECK (r.renderSummation (&sum) == ",.S.9<#D;a>");
+    CHECK (r.renderElement (&sum) == ",.S.9<#D;a>");
   }
 }
 
@@ -123,7 +123,7 @@ TEST_CASE("render/ueb/Summations/complex", "[render][UEB][Summations]") {
     upper_bound.push_back (boost::make_shared<MDE_MathBlock>("a"));
 
     const MDE_Summation sum(lower_bound, upper_bound);
-    CHECK (r.renderSummation (&sum) == ",.S.5#D.9a");
+    CHECK (r.renderElement (&sum) == ",.S.5#D.9a");
   }
 
   SECTION ("Summation with complex lower and upper limits") {
@@ -136,7 +136,7 @@ TEST_CASE("render/ueb/Summations/complex", "[render][UEB][Summations]") {
     upper_bound.push_back (boost::make_shared<MDE_MathBlock>("x"));
 
     const MDE_Summation sum(lower_bound, upper_bound);
-    CHECK (r.renderSummation (&sum) == ",.S.5<#D;a>.9<-#Dx>");
+    CHECK (r.renderElement (&sum) == ",.S.5<#D;a>.9<-#Dx>");
   }
 }
 
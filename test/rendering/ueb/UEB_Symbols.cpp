@@ -9,7 +9,7 @@
 #include "MathDocumentElements.h"
 #include "UEBRenderer.h"
 
-#define R(sym,brl) { MDE_Symbol s(sym); CHECK(r.renderSymbol(&s) == brl); }
+#define R(sym,brl) { MDE_Symbol s(sym); CHECK(r.renderElement(&s) == brl); }
 
 TEST_CASE("render/ueb/Symbols", "[render][UEB][Symbol]") {
   UEBRenderer r;
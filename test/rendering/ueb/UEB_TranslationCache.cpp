@@ -0,0 +1,119 @@
+/**
+ * @file UEB_TranslationCache.cpp
+ *
+ * @copyright Copyright 2015 Anthony Tibbs
+ * This project is released under the GNU General Public License.
+*/
+
+#include <sstream>
+#include <boost/lexical_cast.hpp>
+#include <boost/make_shared.hpp>
+
+#include "mttest.h"
+#include "BrailleTranslationCache.h"
+#include "MathInterpreter.h"
+#include "MathRenderPipeline.h"
+#include "MathSourceFile.h"
+#include "UEBRenderer.h"
+
+// =========================================================================
+namespace {
+  std::string renderWithCache (const MathDocument &doc,
+			       const boost::shared_ptr<BrailleTranslationCache> &cache,
+			       const unsigned lineLength)
+  {
+    UEBRenderer r;
+    r.setTranslationCache (cache);
+    if (lineLength)
+      r.enableLineWrapping (lineLength);
+    return r.renderDocument (doc);
+  }
+}
+
+TEST_CASE("render/ueb/TranslationCache", "[render][UEB][TranslationCache]") {
+  const std::string input =
+    "1. x + 1 = 3\n"
+    "&&\n"
+    "Show your work, and simplify (where possible).\n"
+    "$$\n"
+    "2. x + 2 = 4\n"
+    "&&\n"
+    "Show your work, and simplify (where possible).\n"
+    "$$\n";
+  MathSourceFile src;
+  src.loadFromBuffer (input);
+  MathDocument doc;
+  MathInterpreter interpreter (src, doc);
+  interpreter.interpret();
+
+  boost::shared_ptr<BrailleTranslationCache> noCache;
+
+  SECTION("cached text gives the same braille as translating it") {
+    boost::shared_ptr<BrailleTranslationCache> cache = boost::make_shared<BrailleTranslationCache>();
+
+    CHECK (renderWithCache (doc, cache, 0) == renderWithCache (doc, noCache, 0));
+    CHECK (renderWithCache (doc, cache, 0) == renderWithCache (doc, noCache, 0));
+
+    BrailleTranslationCache::Statistics stats = cache->getStatistics();
+    CHECK (stats.entries == 3); // "1.", "2." and the sentence
+    CHECK (stats.misses == 3);
+    CHECK (stats.hits == 5);
+  }
+  SECTION("wrapping hints are kept with cached text") {
+    boost::shared_ptr<BrailleTranslationCache> cache = boost::make_shared<BrailleTranslationCache>();
+
+    for (unsigned lineLength = 0; lineLength <= 24; lineLength += 8) {
+      CAPTURE(lineLength);
+      CHECK (renderWithCache (doc, cache, lineLength) == renderWithCache (doc, noCache, lineLength));
+    }
+    CHECK (cache->getStatistics().entries == 6);
+  }
+  SECTION("the cache may be shared by renderers on other threads") {
+    boost::shared_ptr<BrailleTranslationCache> cache = boost::make_shared<BrailleTranslationCache>();
+
+    UEBRenderer first, second;
+    first.setTranslationCache (cache);
+    second.setTranslationCache (cache);
+    second.enableLineWrapping (16);
+    std::ostringstream firstOutput, secondOutput;
+
+    std::string repeated;
+    for (int copy = 0; copy < 20; copy++)
+      repeated += input;
+    MathSourceFile repeatedSrc;
+    repeatedSrc.loadFromBuffer (repeated);
+    MathDocument unused;
+    MathInterpreter repeatedInterpreter (repeatedSrc, unused);
+
+    MathRenderPipeline pipeline (4);
+    pipeline.addRenderer (first, firstOutput);
+    pipeline.addRenderer (second, secondOutput);
+    repeatedInterpreter.interpret (pipeline);
+    pipeline.finish();
+
+    MathDocument expected;
+    MathInterpreter expectedInterpreter (repeatedSrc, expected);
+    expectedInterpreter.interpret();
+    CHECK (firstOutput.str() == renderWithCache (expected, noCache, 0));
+    CHECK (secondOutput.str() == renderWithCache (expected, noCache, 16));
+    CHECK (cache->getStatistics().hits > 0);
+  }
+  SECTION("memory use is bounded") {
+    boost::shared_ptr<BrailleTranslationCache> cache = boost::make_shared<BrailleTranslationCache>(2048);
+
+    std::string numbered;
+    for (int n = 1; n <= 100; n++)
+      numbered += boost::lexical_cast<std::string>(n) + ". x\n";
+    MathSourceFile numberedSrc;
+    numberedSrc.loadFromBuffer (numbered);
+    MathDocument numberedDoc;
+    MathInterpreter numberedInterpreter (numberedSrc, numberedDoc);
+    numberedInterpreter.interpret();
+    renderWithCache (numberedDoc, cache, 0);
+
+    BrailleTranslationCache::Statistics stats = cache->getStatistics();
+    CHECK (stats.bytesUsed <= 2048);
+    CHECK (stats.evictions > 0);
+    CHECK (stats.entries + stats.evictions == 100);
+  }
+}
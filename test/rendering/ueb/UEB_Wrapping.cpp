@@ -0,0 +1,80 @@
+/**
+ * @file UEB_Wrapping.cpp
+ *
+ * @copyright Copyright 2015 Anthony Tibbs
+ * This project is released under the GNU General Public License.
+*/
+
+#include "mttest.h"
+#include "MathInterpreter.h"
+#include "MathSourceFile.h"
+#include "UEBRenderer.h"
+
+// =========================================================================
+// Places to break lines are kept alongside the braille rather than in it,
+// so wrapping must only ever add line breaks and runover indentation.
+namespace {
+  std::string renderWrapped (const std::string &input, const unsigned lineLength)
+  {
+    MathSourceFile src;
+    src.loadFromBuffer (input);
+
+    MathDocument document;
+    MathInterpreter interpreter (src, document);
+    interpreter.interpret();
+
+    UEBRenderer r;
+    if (lineLength)
+      r.enableLineWrapping (lineLength);
+    return r.renderDocument (document);
+  }
+}
+
+TEST_CASE("render/ueb/Wrapping", "[render][UEB][Wrapping]") {
+  const std::string math = "x + y + z = 12345 + 3/4 + a^2 - b_1 = 7\n";
+
+  SECTION("lines that fit are left as they are") {
+    const std::string doc = math + "&&\nThe quick brown fox (and the lazy dog).\n$$\n(1 + 2) = 3";
+    const std::string unwrapped = renderWrapped (doc, 0);
+
+    CHECK (unwrapped.find ("<|@") == std::string::npos);
+    CHECK (renderWrapped (doc, 500) == unwrapped);
+  }
+  SECTION("math is broken at the best place and runover lines are indented") {
+    CHECK (renderWrapped (math, 24) ==
+	   "x\"6y\"6z \"7 #ABCDE\"6#C/\n"
+	   "  #D\"6;a9#B\"-;b5#A \"7\n"
+	   "  #G\n");
+    CHECK (renderWrapped (math, 16) ==
+	   "x\"6y\"6z \"7\n"
+	   "  #ABCDE\"6#C/#D\n"
+	   "  \"6;a9#B\"-;b5\n"
+	   "  #A \"7 #G\n");
+  }
+  SECTION("very short lines") {
+    CHECK (renderWrapped ("x = 12 + y\n", 3) ==
+	   "x \"\n  7\n  #\n  A\n  B\n  \"\n  6\n  y\n  \n");
+  }
+  SECTION("lines are wrapped the same however they are streamed") {
+    const std::string doc = math + math + "&&\nSome text\n$$\n" + math;
+    const std::string wrapped = renderWrapped (doc, 16);
+
+    MathSourceFile src;
+    src.loadFromBuffer (doc);
+    MathDocument document;
+    MathInterpreter interpreter (src, document);
+    interpreter.interpret();
+
+    UEBRenderer r;
+    r.enableLineWrapping (16);
+    std::string streamed = r.beginDocument();
+    for (MDEVector::const_iterator it = document.getDocument().begin();
+	 it != document.getDocument().end(); ++it) {
+      MDEVector single (1, *it);
+      r.renderLines (single, streamed);
+    }
+    streamed += r.endDocument();
+
+    CHECK (streamed == wrapped);
+  }
+}
@@ -0,0 +1,77 @@
+/**
+ * @file Util_CharClass.cpp
+ *
+ * @copyright Copyright 2015 Anthony Tibbs
+ * This project is released under the GNU General Public License.
+*/
+
+#include "mttest.h"
+#include "CharClass.h"
+#include "LaTeXRenderer.h"
+#include "utility.h"
+
+// =========================================================================
+// Small classes are scanned a block at a time and large ones a character
+// at a time, so each check is made with both, and at positions inside and
+// after the first blocks.
+TEST_CASE("utility/CharClass", "[utility][CharClass]") {
+  const CharClass small ("#_^");
+  const CharClass large ("#_^abcdefghijklmnop");
+
+  SECTION("membership") {
+    CHECK (small.contains ('#'));
+    CHECK_FALSE (small.contains ('a'));
+    CHECK (large.contains ('p'));
+    CHECK_FALSE (large.contains ('\0'));
+    CHECK_FALSE (CharClass().contains ('\xff'));
+    CHECK (CharClass("\xff").contains ('\xff'));
+    CHECK (CharClass().empty());
+    CHECK (CharClass(small).add ('-').contains ('-'));
+  }
+  SECTION("find") {
+    std::string subject (40, ' ');
+    CHECK (small.find (subject) == std::string::npos);
+    CHECK (large.find (subject) == std::string::npos);
+
+    for (size_t at = 0; at < subject.length(); at++) {
+      std::string s = subject;
+      s [at] = '^';
+      CHECK (small.find (s) == at);
+      CHECK (large.find (s) == at);
+      CHECK (small.find (s, at + 1) == std::string::npos);
+      CHECK (large.find (s, at + 1) == std::string::npos);
+    }
+
+    CHECK (small.find ("a_b^c", 2) == 3);
+    CHECK (small.find ("abc", 5) == std::string::npos);
+  }
+  SECTION("findNot and matchesAll") {
+    CHECK (small.findNot ("#_^#x") == 4);
+    CHECK (small.findNot ("#_^#") == std::string::npos);
+    CHECK (small.matchesAll (""));
+    CHECK (small.matchesAll ("^^__##"));
+    CHECK_FALSE (small.matchesAll ("^^_ _##"));
+  }
+  SECTION("presentIn") {
+    const CharClass found = large.presentIn ("a cab ^");
+    CHECK (found.contains ('a'));
+    CHECK (found.contains ('b'));
+    CHECK (found.contains ('^'));
+    CHECK_FALSE (found.contains ('#'));
+    CHECK_FALSE (found.contains (' '));
+    CHECK (large.presentIn ("xyz").empty());
+  }
+  SECTION("containsOnly") {
+    CHECK (containsOnly ("1,234.5", "0123456789,."));
+    CHECK_FALSE (containsOnly ("1,234.5x", "0123456789,."));
+    CHECK (containsOnly ("1,234.5", CharClass("0123456789,.")));
+  }
+  SECTION("makeLaTeXSafe") {
+    CHECK (LaTeXRenderer::makeLaTeXSafe ("plain text") == "plain text");
+    CHECK (LaTeXRenderer::makeLaTeXSafe ("") == "");
+    CHECK (LaTeXRenderer::makeLaTeXSafe ("#1 a_b^c {x} \\") ==
+	   "\\#1 a\\underline b\\^{}c \\lbrace x\\rbrace  \\backslash ");
+    CHECK (LaTeXRenderer::makeLaTeXSafe (std::string(20, 'x') + "{" + std::string(20, 'y')) ==
+	   std::string(20, 'x') + "\\lbrace " + std::string(20, 'y'));
+  }
+}
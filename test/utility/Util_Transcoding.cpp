@@ -0,0 +1,84 @@
+/**
+ * @file Util_Transcoding.cpp
+ *
+ * @copyright Copyright 2015 Anthony Tibbs
+ * This project is released under the GNU General Public License.
+*/
+
+#include <string>
+#include <vector>
+
+#include "mttest.h"
+#include "liblouis-mt.h"
+
+// =========================================================================
+// Text is converted between UTF-8 and liblouis' UTF-16 at the liblouis
+// boundary.  Runs of ASCII are converted a block at a time, so each check
+// is made with the interesting characters inside and after the first
+// blocks.
+namespace {
+  std::vector<ll_widechar> toWide (const std::string &s)
+  {
+    std::vector<ll_widechar> wide (s.length() + 1);
+    unsigned length;
+    REQUIRE (strToWideCharString (s, &wide [0], wide.size(), length));
+    CHECK (wide [length] == 0);
+    wide.resize (length);
+    return wide;
+  }
+
+  std::string fromWide (const std::vector<ll_widechar> &wide)
+  {
+    std::string s = "prefix";
+    wideCharStringToStr (wide.empty() ? NULL : &wide [0], wide.size(), s);
+    REQUIRE (s.compare (0, 6, "prefix") == 0);
+    return s.substr (6);
+  }
+}
+
+TEST_CASE("utility/Transcoding", "[utility][Transcoding]") {
+  SECTION("ASCII is converted unchanged") {
+    for (size_t length = 0; length <= 70; length++) {
+      std::string s;
+      for (size_t n = 0; n < length; n++)
+	s += (char)(' ' + (n * 7) % 95);
+
+      const std::vector<ll_widechar> wide = toWide (s);
+      REQUIRE (wide.size() == length);
+      for (size_t n = 0; n < length; n++)
+	CHECK (wide [n] == (ll_widechar)s [n]);
+      CHECK (fromWide (wide) == s);
+    }
+  }
+  SECTION("accented letters and other characters") {
+    for (size_t padding = 0; padding <= 40; padding += 20) {
+      const std::string ascii (padding, 'x');
+      // e-acute, the euro sign, and U+1F600 (a surrogate pair in UTF-16)
+      const std::string s = ascii + "Jos\xC3\xA9 pays 3\xE2\x82\xAC \xF0\x9F\x98\x80" + ascii;
+      const std::vector<ll_widechar> wide = toWide (s);
+
+      REQUIRE (wide.size() == 2 * padding + 15);
+      CHECK (wide [padding + 3] == 0xE9);
+      CHECK (wide [padding + 11] == 0x20AC);
+      CHECK (wide [padding + 13] == 0xD83D);
+      CHECK (wide [padding + 14] == 0xDE00);
+      CHECK (fromWide (wide) == s);
+    }
+  }
+  SECTION("malformed input is replaced rather than passed on") {
+    const std::vector<ll_widechar> wide = toWide ("a\xC3" "b\xC0\xAF" "c\xED\xA0\x80");
+    const ll_widechar expected[] = { 'a', 0xFFFD, 'b', 0xFFFD, 0xFFFD, 'c', 0xFFFD, 0xFFFD, 0xFFFD };
+    CHECK (wide == std::vector<ll_widechar>(expected, expected + 9));
+
+    const ll_widechar unpaired[] = { 'a', 0xD83D, 'b', 0xDE00 };
+    CHECK (fromWide (std::vector<ll_widechar>(unpaired, unpaired + 4)) == "a\xEF\xBF\xBD" "b\xEF\xBF\xBD");
+  }
+  SECTION("text that does not fit is refused") {
+    ll_widechar buffer [8];
+    unsigned length;
+    CHECK (strToWideCharString ("1234567", buffer, 8, length));
+    CHECK (length == 7);
+    CHECK_FALSE (strToWideCharString ("12345678", buffer, 8, length));
+    CHECK_FALSE (strToWideCharString ("123456\xF0\x9F\x98\x80", buffer, 8, length));
+  }
+}